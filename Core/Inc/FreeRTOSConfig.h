@@ -68,7 +68,7 @@
 #define configTICK_RATE_HZ                       ((TickType_t)1000)
 #define configMAX_PRIORITIES                     ( 56 )
 #define configMINIMAL_STACK_SIZE                 ((uint16_t)128)
-#define configTOTAL_HEAP_SIZE                    ((size_t)15360)
+#define configTOTAL_HEAP_SIZE                    ((size_t)4096)  /* 测试盒任务和队列已静态分配(can_testbox_mem.h) */
 #define configMAX_TASK_NAME_LEN                  ( 16 )
 #define configUSE_TRACE_FACILITY                 1
 #define configUSE_16_BIT_TICKS                   0
@@ -168,6 +168,25 @@ standard names. */
 
 /* USER CODE BEGIN Defines */
 /* Section where parameter definitions can be added (for instance, to override default ones in FreeRTOS.h) */
+/* 空闲时停止tick睡眠，TIM1 HAL时基在睡眠前后挂起并补偿(can_testbox_power.c) */
+#define configUSE_TICKLESS_IDLE                  1
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP    2
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+void CAN_Power_SuppressTicksAndSleep(uint32_t expected_idle_ticks);
+void CAN_Power_PreSleep(uint32_t *idle_ticks);
+void CAN_Power_PostSleep(uint32_t *idle_ticks);
+#endif
+#define portSUPPRESS_TICKS_AND_SLEEP(xExpectedIdleTime)  CAN_Power_SuppressTicksAndSleep(xExpectedIdleTime)
+#define configPRE_SLEEP_PROCESSING(x)            CAN_Power_PreSleep(&(x))
+#define configPOST_SLEEP_PROCESSING(x)           CAN_Power_PostSleep(&(x))
+/* 任务运行时统计，计数器使用TIM2 1MHz时间戳(can_testbox_rtstats.c) */
+#define configGENERATE_RUN_TIME_STATS            1
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+void CAN_RtStats_ConfigureTimer(void);
+uint32_t CAN_RtStats_GetCounter(void);
+#endif
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() CAN_RtStats_ConfigureTimer()
+#define portGET_RUN_TIME_COUNTER_VALUE()         CAN_RtStats_GetCounter()
 /* USER CODE END Defines */
 
 #endif /* FREERTOS_CONFIG_H */
@@ -87,6 +87,7 @@ typedef enum {
 #define CAN_DATA_REQUEST_PERIOD     3000    // 数据请求周期
 #define CAN_STATUS_PERIOD           2000    // 状态消息周期
 #define CAN_TIMEOUT_PERIOD          5000    // 超时判断周期
+#define CAN_DATA_RESPONSE_TIMEOUT   500     // 数据应答超时
 
 /* 消息数据长度定义 */
 #define CAN_HEARTBEAT_LEN           4       // 心跳消息长度
@@ -96,6 +97,10 @@ typedef enum {
 #define CAN_CONTROL_LEN             4       // 控制消息长度
 #define CAN_ACK_LEN                 4       // ACK应答消息长度
 
+/* 数据请求类型(同时作为往返时延统计的请求类型) */
+#define CAN_DATA_REQ_TYPE_STATUS    0x01    // 请求系统状态
+#define CAN_DATA_REQ_TYPE_TIMESTAMP 0x02    // 请求时间戳
+
 /* 消息标识符定义 */
 #define CAN_HEARTBEAT_MAGIC         0xAA55  // 心跳魔数
 #define CAN_DATA_REQ_MAGIC          0x1234  // 数据请求魔数
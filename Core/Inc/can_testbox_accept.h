@@ -0,0 +1,140 @@
+/**
+ * @file can_testbox_accept.h
+ * @brief 片内CAN软件接收过滤(标准帧位图 + 扩展帧散列集合)
+ * @version 1.0
+ * @date 2024
+ *
+ * 硬件过滤器组很快用完，CAN1/CAN2实际按全部接收配置，总线满载时每帧都要
+ * 走完整的接收处理和串口打印。本模块在接收中断读取FIFO之前做软件过滤：
+ * - 标准帧: 2048位(256字节)位图，一次访存判定
+ * - 扩展帧: 开放寻址散列集合(负载率不超过1/2)，通常一到两次访存判定
+ * - 只读取FIFO邮箱的标识符寄存器，拒收的报文直接释放FIFO，不拷贝数据、
+ *   不进入任何后续处理(网关、抓包、统计、打印)，按拒收原因计数
+ * 未启用的通道只有一次标志判断，行为与原来一致。
+ */
+
+#ifndef __CAN_TESTBOX_ACCEPT_H
+#define __CAN_TESTBOX_ACCEPT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can_testbox_api.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ========================= 配置宏定义 ========================= */
+
+#define CAN_ACCEPT_CH_COUNT         2     // 片内CAN通道数(CAN1、CAN2)
+#define CAN_ACCEPT_EXT_MAX          32    // 每通道扩展帧ID数
+#define CAN_ACCEPT_EXT_SLOTS        64    // 扩展帧散列槽位(2的幂，不小于EXT_MAX的2倍)
+
+/* ========================= 选项定义 ========================= */
+
+#define CAN_ACCEPT_FLAG_EXT_PASS    0x01  // 扩展帧全部接收(不查集合)
+#define CAN_ACCEPT_FLAG_NO_REMOTE   0x02  // 拒收远程帧
+
+/* ========================= 控制操作定义 ========================= */
+
+#define CAN_ACCEPT_CTRL_CONFIG      0x00  // 启用/禁用与选项(通道、启用、选项)
+#define CAN_ACCEPT_CTRL_STD_RANGE   0x01  // 标准帧ID区间接收/拒收(通道、接收、起始、结束)
+#define CAN_ACCEPT_CTRL_EXT_ADD     0x02  // 添加扩展帧ID(通道、ID)
+#define CAN_ACCEPT_CTRL_EXT_REMOVE  0x03  // 删除扩展帧ID(通道、ID)
+#define CAN_ACCEPT_CTRL_CLEAR       0x04  // 清空位图与集合(通道)
+#define CAN_ACCEPT_CTRL_STATUS      0x05  // 读取统计(通道)
+#define CAN_ACCEPT_CTRL_RESET_STATS 0x06  // 清空统计(通道)
+
+/* ========================= 数据结构定义 ========================= */
+
+/**
+ * @brief 软件接收过滤统计
+ */
+typedef struct {
+    uint32_t enabled;                       // 是否启用
+    uint32_t flags;                         // CAN_ACCEPT_FLAG_xxx
+    uint32_t ext_count;                     // 扩展帧ID数
+    uint32_t accepted;                      // 接收帧数
+    uint32_t rejected_std;                  // 标准帧ID不在位图中
+    uint32_t rejected_ext;                  // 扩展帧ID不在集合中
+    uint32_t rejected_remote;               // 远程帧
+} CAN_Accept_Stats_t;
+
+/* ========================= API接口声明 ========================= */
+
+/**
+ * @brief 初始化软件接收过滤(全部通道禁用，注册串口命令)
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Accept_Init(void);
+
+/**
+ * @brief 启用/禁用通道过滤
+ * @param ch: 通道编号(CAN_TESTBOX_CH_CAN1/CAN_TESTBOX_CH_CAN2)
+ * @param enable: 是否启用
+ * @param flags: CAN_ACCEPT_FLAG_xxx
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Accept_Configure(CAN_TestBox_ChannelId_t ch, bool enable, uint8_t flags);
+
+/**
+ * @brief 设置标准帧ID区间
+ * @param ch: 通道编号
+ * @param first: 起始ID
+ * @param last: 结束ID(含，不超过0x7FF)
+ * @param accept: true为接收，false为拒收
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Accept_SetStdRange(CAN_TestBox_ChannelId_t ch, uint16_t first, uint16_t last, bool accept);
+
+/**
+ * @brief 添加扩展帧ID
+ * @param ch: 通道编号
+ * @param id: 扩展帧ID
+ * @return CAN_TestBox_Status_t: 返回状态，集合满返回CAN_TESTBOX_QUEUE_FULL
+ */
+CAN_TestBox_Status_t CAN_Accept_AddExt(CAN_TestBox_ChannelId_t ch, uint32_t id);
+
+/**
+ * @brief 删除扩展帧ID
+ * @param ch: 通道编号
+ * @param id: 扩展帧ID
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Accept_RemoveExt(CAN_TestBox_ChannelId_t ch, uint32_t id);
+
+/**
+ * @brief 清空位图与集合(启用时拒收全部报文)
+ * @param ch: 通道编号
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Accept_Clear(CAN_TestBox_ChannelId_t ch);
+
+/**
+ * @brief 按FIFO输出邮箱的标识符判定是否接收(在接收中断中、读取FIFO之前调用)
+ * @param hcan: CAN句柄
+ * @param ch: 通道编号
+ * @param fifo: CAN_RX_FIFO0/CAN_RX_FIFO1
+ * @return bool: true表示接收，应继续读取；false表示已拒收并释放FIFO
+ */
+bool CAN_Accept_Filter(CAN_HandleTypeDef *hcan, CAN_TestBox_ChannelId_t ch, uint32_t fifo);
+
+/**
+ * @brief 获取统计
+ * @param ch: 通道编号
+ * @param stats: 统计指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Accept_GetStats(CAN_TestBox_ChannelId_t ch, CAN_Accept_Stats_t *stats);
+
+/**
+ * @brief 清空统计
+ * @param ch: 通道编号
+ */
+void CAN_Accept_ResetStats(CAN_TestBox_ChannelId_t ch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_TESTBOX_ACCEPT_H */
@@ -56,12 +56,34 @@ extern "C" {
 
 // 发送队列配置宏
 #define CAN_TESTBOX_SEND_QUEUE_SIZE     50    // 发送队列大小
-#define CAN_TESTBOX_RECEIVE_QUEUE_SIZE  100   // 接收队列大小
+#define CAN_TESTBOX_RECEIVE_QUEUE_SIZE  125   // 接收队列大小(16字节紧凑帧，与原100×20字节占用相同)
 #define CAN_TESTBOX_MAX_PERIODIC_MSGS   20    // 最大周期消息数量
 
 // 过滤器配置宏
 #define CAN_TESTBOX_FILTER_COUNT_MAX    14    // 最大过滤器数量
 
+// 多通道配置宏
+#define CAN_TESTBOX_CHANNEL_RX_QUEUE_SIZE  40 // 非默认通道接收队列大小
+
+// 发送日志配置宏
+#define CAN_TESTBOX_TXLOG_SUBMIT        0     // 提交时输出(默认，原有格式)
+#define CAN_TESTBOX_TXLOG_CONFIRM       1     // 片内CAN发送完成后输出，带完成时间戳与入队时延
+#define CAN_TESTBOX_TXCONF_RING_SIZE    32    // 发送确认日志环大小(2的幂)
+
+// 发送确认控制操作(串口命令0x22)
+#define CAN_TESTBOX_TXCONF_CTRL_STATUS  0x00  // 读取日志模式与抖动统计
+#define CAN_TESTBOX_TXCONF_CTRL_LOG     0x01  // 设置发送日志模式
+#define CAN_TESTBOX_TXCONF_CTRL_CLEAR   0x02  // 清空抖动统计与日志丢弃数
+
+// 周期报文相位配置宏
+#define CAN_TESTBOX_PHASE_AUTO          0xFFFFFFFFUL // 相位值: 取消手动相位，恢复自动分配
+#define CAN_TESTBOX_PHASE_SLOTS         128   // 自动分配的候选相位数上限(ms)，限制单次分配的运算量
+
+// 周期报文相位控制操作(串口命令0x23)
+#define CAN_TESTBOX_PHASE_CTRL_STATUS   0x00  // 读取相位表与发送队列深度峰值(通道)
+#define CAN_TESTBOX_PHASE_CTRL_SET      0x01  // 手动设置相位(通道、句柄、相位)
+#define CAN_TESTBOX_PHASE_CTRL_AUTO     0x02  // 允许/禁止自动分配相位
+
 /* ========================= 数据结构定义 ========================= */
 
 /**
@@ -73,21 +95,51 @@ typedef struct {
     uint8_t  data[8];              // 数据内容
     bool     is_extended;           // 是否为扩展帧
     bool     is_remote;             // 是否为远程帧
+    uint8_t  channel;               // 接收通道(CAN_TestBox_ChannelId_t)，发送时忽略
     uint32_t timestamp;             // 时间戳(ms)
 } CAN_TestBox_Message_t;
 
+/**
+ * @brief 内部紧凑帧(16字节，队列/环形缓冲区/周期表使用)
+ * @note  对外接口仍使用CAN_TestBox_Message_t，仅在接口边界转换，
+ *        打包/解包函数见can_testbox_frame.h
+ */
+typedef struct {
+    uint32_t id_flags;              // bit0-28 ID, bit30 远程帧, bit31 扩展帧
+    uint32_t meta;                  // bit0-3 DLC, bit4-5 通道, bit6-31 时间戳低26位(ms)
+    uint32_t data[2];               // 数据内容(8字节)
+} CAN_TestBox_Frame_t;
+
 /**
  * @brief 周期消息配置结构体
  */
 typedef struct {
-    CAN_TestBox_Message_t message;  // 消息内容
+    CAN_TestBox_Frame_t frame;      // 消息内容(紧凑帧)
     uint32_t period_ms;             // 发送周期(ms)
     bool     enabled;               // 是否启用
     uint32_t send_count;            // 已发送次数
-    uint32_t last_send_time;        // 上次发送时间
+    uint32_t last_send_time;        // 上次发送时间(调度格点，始终满足 ≡ phase_ms (mod period_ms))
+    uint32_t phase_ms;              // 相位偏移(ms)：到期时刻按系统时钟满足 t ≡ phase_ms (mod period_ms)
+    bool     phase_manual;          // 相位为手动设置(修改周期时保留，不重新分配)
+    bool     phase_pending;         // 自动相位待分配(在测试盒任务中计算，之前按临时相位调度)
+    uint32_t last_send_us;          // 上次发送硬件时间戳(us)，周期抖动统计用
+    bool     timing_valid;          // last_send_us有效(启动或修改周期后首帧置位)
+    uint32_t last_wire_us;          // 上次发送完成时间戳(us)，上线抖动统计用(发送完成中断写)
+    bool     wire_valid;            // last_wire_us有效(启动或修改周期后首次发送完成置位)
     uint8_t  handle_id;             // 句柄ID
 } CAN_TestBox_PeriodicMsg_t;
 
+/**
+ * @brief 周期报文抖动统计
+ * @note  偏差为相邻两次发送的实际间隔与设定周期之差的绝对值。调度抖动按
+ *        提交给发送仲裁的时刻计算，上线抖动按发送完成时刻计算
+ */
+typedef struct {
+    uint32_t samples;               // 样本数
+    uint32_t sum_us;                // 偏差累计(us)
+    uint32_t max_us;                // 最大偏差(us)
+} CAN_TestBox_Jitter_t;
+
 /**
  * @brief 连续帧发送配置结构体
  */
@@ -97,6 +149,7 @@ typedef struct {
     uint16_t interval_ms;           // 发送间隔(ms)
     bool     auto_increment_id;     // 是否自动递增ID
     bool     auto_increment_data;   // 是否自动递增数据
+    uint8_t  gen_set;               // 负载生成器组(0为不使用)
 } CAN_TestBox_BurstMsg_t;
 
 /**
@@ -114,8 +167,8 @@ typedef struct {
  */
 typedef struct {
     uint32_t tx_total_count;        // 总发送帧数
-    uint32_t tx_success_count;      // 发送成功帧数
-    uint32_t tx_error_count;        // 发送错误帧数
+    uint32_t tx_success_count;      // 发送成功帧数(片内CAN在发送完成时计数)
+    uint32_t tx_error_count;        // 发送错误帧数(含仲裁丢失/发送错误)
     uint32_t rx_total_count;        // 总接收帧数
     uint32_t rx_valid_count;        // 有效接收帧数
     uint32_t rx_error_count;        // 接收错误帧数
@@ -146,6 +199,29 @@ typedef enum {
  */
 typedef void (*CAN_TestBox_RxCallback_t)(const CAN_TestBox_Message_t *message);
 
+/**
+ * @brief 通道编号
+ */
+typedef enum {
+    CAN_TESTBOX_CH_CAN1 = 0,        // 片内CAN1
+    CAN_TESTBOX_CH_CAN2,            // 片内CAN2
+    CAN_TESTBOX_CH_EXT,             // 外部控制器(MCP2515)
+    CAN_TESTBOX_CH_COUNT
+} CAN_TestBox_ChannelId_t;
+
+/**
+ * @brief 通道句柄(指向内部通道上下文)
+ */
+typedef struct CAN_TestBox_ChannelCtx *CAN_TestBox_Channel_t;
+
+/**
+ * @brief 外部控制器操作接口
+ */
+typedef struct {
+    CAN_TestBox_Status_t (*send)(const CAN_TestBox_Frame_t *frame);      // 发送(不可阻塞，帧已校验)
+    uint32_t (*get_bus_status)(void);                                    // 总线状态，可为NULL
+} CAN_TestBox_ChannelOps_t;
+
 /* ========================= API接口声明 ========================= */
 
 /**
@@ -283,6 +359,20 @@ CAN_TestBox_Status_t CAN_TestBox_SendBurstFramesQuick(uint32_t id, uint8_t dlc,
  */
 CAN_TestBox_Status_t CAN_TestBox_SetRxCallback(CAN_TestBox_RxCallback_t callback);
 
+/**
+ * @brief 从接收队列获取消息
+ * @param message: 消息指针
+ * @param timeout_ms: 超时时间(ms)
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_TestBox_ReceiveMessage(CAN_TestBox_Message_t *message, uint32_t timeout_ms);
+
+/**
+ * @brief 清空接收队列
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_TestBox_ClearRxQueue(void);
+
 /* ========================= 5. 过滤器管理接口 ========================= */
 
 /**
@@ -373,17 +463,263 @@ CAN_TestBox_Status_t CAN_TestBox_SelfTest(void);
 /* ========================= 9. 任务管理接口 ========================= */
 
 /**
- * @brief CAN测试盒主任务(需要在主循环或RTOS任务中调用)
+ * @brief CAN测试盒主任务(需要在主循环或RTOS任务中调用，到期时刻由CAN_TestBox_GetIdleTime给出)
  * @return void
  */
 void CAN_TestBox_Task(void);
 
+/**
+ * @brief 计算距下一个周期报文到期的时间(事件驱动任务的等待超时)
+ * @param max_ms: 上限(ms)，无到期项时返回该值
+ * @return uint32_t: 距下一次到期的时间(ms)，0表示已有报文到期
+ */
+uint32_t CAN_TestBox_GetIdleTime(uint32_t max_ms);
+
+/**
+ * @brief 获取所有通道周期报文的发送抖动统计
+ * @param jitter: 统计指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_TestBox_GetPeriodicJitter(CAN_TestBox_Jitter_t *jitter);
+
+/**
+ * @brief 清空周期报文发送抖动统计
+ */
+void CAN_TestBox_ResetPeriodicJitter(void);
+
+/**
+ * @brief 获取所有片内通道周期报文的上线抖动统计(按发送完成时间戳)
+ * @param jitter: 统计指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_TestBox_GetPeriodicWireJitter(CAN_TestBox_Jitter_t *jitter);
+
+/**
+ * @brief 清空周期报文上线抖动统计
+ */
+void CAN_TestBox_ResetPeriodicWireJitter(void);
+
+/**
+ * @brief 注册测试盒串口命令(发送确认、周期报文相位，在CAN_Cmd_Init之后调用)
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_TestBox_CmdInit(void);
+
+/**
+ * @brief 允许/禁止自动分配周期报文相位(默认允许)
+ * @param enable: true为按已有周期报文的重合负载选择相位；false为原行为，
+ *                首帧在启动一个周期后发送
+ * @note  只影响此后启动或修改周期的报文
+ */
+void CAN_TestBox_SetAutoPhase(bool enable);
+
+/**
+ * @brief 设置发送日志模式
+ * @param mode: CAN_TESTBOX_TXLOG_SUBMIT/CAN_TESTBOX_TXLOG_CONFIRM
+ * @return CAN_TestBox_Status_t: 返回状态
+ * @note  确认模式只影响片内CAN；外部控制器发送为同步完成，仍在提交时输出
+ */
+CAN_TestBox_Status_t CAN_TestBox_SetTxLogMode(uint8_t mode);
+
 /**
  * @brief 获取任务运行状态
  * @return bool: true-运行中, false-已停止
  */
 bool CAN_TestBox_IsRunning(void);
 
+/**
+ * @brief 查询是否有周期报文正在调度
+ * @return bool: true-任一运行中且非静默的通道存在使能的周期报文
+ */
+bool CAN_TestBox_HasActivePeriodic(void);
+
+/* ========================= 10. 多通道接口 ========================= */
+/*
+ * 每个通道拥有独立的接收队列、周期消息表、统计信息和接收回调，
+ * 所有通道共用CAN_TestBox_Task()调度与同一日志输出。
+ * 上面的无通道参数接口作用于CAN_TestBox_Init()打开的默认通道。
+ */
+
+/**
+ * @brief 打开片内bxCAN通道
+ * @param id: 通道编号(CAN_TESTBOX_CH_CAN1/CAN_TESTBOX_CH_CAN2)
+ * @param hcan: CAN句柄指针(过滤器需在打开前配置)
+ * @param channel: 返回的通道句柄指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ * @note  控制器已由其他模块启动(如CAN2静默监听)时不再重复启动；控制器处于静默
+ *        模式(CAN2未被网关切换为正常模式)时只接收，发送与启动周期报文返回BUSY，
+ *        已启动的周期报文暂停调度
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelOpen(CAN_TestBox_ChannelId_t id, CAN_HandleTypeDef *hcan, CAN_TestBox_Channel_t *channel);
+
+/**
+ * @brief 打开外部控制器通道
+ * @param id: 通道编号
+ * @param ops: 控制器操作接口(需静态存储)
+ * @param channel: 返回的通道句柄指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ * @note  外部驱动收到报文后调用CAN_TestBox_ChannelInput()送入通道
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelOpenExternal(CAN_TestBox_ChannelId_t id, const CAN_TestBox_ChannelOps_t *ops, CAN_TestBox_Channel_t *channel);
+
+/**
+ * @brief 关闭通道
+ * @param channel: 通道句柄
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelClose(CAN_TestBox_Channel_t channel);
+
+/**
+ * @brief 按编号获取已打开的通道
+ * @param id: 通道编号
+ * @return CAN_TestBox_Channel_t: 通道句柄，未打开返回NULL
+ */
+CAN_TestBox_Channel_t CAN_TestBox_GetChannel(CAN_TestBox_ChannelId_t id);
+
+/**
+ * @brief 获取通道编号
+ * @param channel: 通道句柄
+ * @return CAN_TestBox_ChannelId_t: 通道编号
+ */
+CAN_TestBox_ChannelId_t CAN_TestBox_ChannelGetId(CAN_TestBox_Channel_t channel);
+
+/**
+ * @brief 发送单帧事件报文
+ * @param channel: 通道句柄
+ * @param message: 消息指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelSendSingleFrame(CAN_TestBox_Channel_t channel, const CAN_TestBox_Message_t *message);
+
+/**
+ * @brief 启动周期性消息发送
+ * @param channel: 通道句柄
+ * @param message: 消息指针
+ * @param period_ms: 发送周期(ms)
+ * @param handle_id: 返回的句柄ID指针(通道内有效)
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelStartPeriodicMessage(CAN_TestBox_Channel_t channel, const CAN_TestBox_Message_t *message, uint32_t period_ms, uint8_t *handle_id);
+
+/**
+ * @brief 停止周期性消息发送
+ * @param channel: 通道句柄
+ * @param handle_id: 句柄ID
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelStopPeriodicMessage(CAN_TestBox_Channel_t channel, uint8_t handle_id);
+
+/**
+ * @brief 修改周期性消息的发送周期
+ * @param channel: 通道句柄
+ * @param handle_id: 句柄ID
+ * @param new_period_ms: 新的发送周期(ms)
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelModifyPeriodicPeriod(CAN_TestBox_Channel_t channel, uint8_t handle_id, uint32_t new_period_ms);
+
+/**
+ * @brief 修改周期性消息的数据内容
+ * @param channel: 通道句柄
+ * @param handle_id: 句柄ID
+ * @param new_data: 新的数据指针
+ * @param dlc: 数据长度
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelModifyPeriodicData(CAN_TestBox_Channel_t channel, uint8_t handle_id, const uint8_t *new_data, uint8_t dlc);
+
+/**
+ * @brief 手动设置周期性消息的相位偏移
+ * @param channel: 通道句柄
+ * @param handle_id: 句柄ID
+ * @param phase_ms: 相位(ms，按周期取模)，CAN_TESTBOX_PHASE_AUTO为恢复自动分配
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelSetPeriodicPhase(CAN_TestBox_Channel_t channel, uint8_t handle_id, uint32_t phase_ms);
+
+/**
+ * @brief 停止通道所有周期性消息
+ * @param channel: 通道句柄
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelStopAllPeriodicMessages(CAN_TestBox_Channel_t channel);
+
+/**
+ * @brief 发送连续帧报文
+ * @param channel: 通道句柄
+ * @param burst_config: 连续帧配置指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelSendBurstFrames(CAN_TestBox_Channel_t channel, const CAN_TestBox_BurstMsg_t *burst_config);
+
+/**
+ * @brief 设置通道接收回调函数
+ * @param channel: 通道句柄
+ * @param callback: 回调函数指针，NULL表示写入接收队列
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelSetRxCallback(CAN_TestBox_Channel_t channel, CAN_TestBox_RxCallback_t callback);
+
+/**
+ * @brief 从通道接收队列获取消息
+ * @param channel: 通道句柄
+ * @param message: 消息指针
+ * @param timeout_ms: 超时时间(ms)
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelReceiveMessage(CAN_TestBox_Channel_t channel, CAN_TestBox_Message_t *message, uint32_t timeout_ms);
+
+/**
+ * @brief 清空通道接收队列
+ * @param channel: 通道句柄
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelClearRxQueue(CAN_TestBox_Channel_t channel);
+
+/**
+ * @brief 获取通道统计信息
+ * @param channel: 通道句柄
+ * @param stats: 统计信息指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelGetStatistics(CAN_TestBox_Channel_t channel, CAN_TestBox_Statistics_t *stats);
+
+/**
+ * @brief 重置通道统计信息
+ * @param channel: 通道句柄
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelResetStatistics(CAN_TestBox_Channel_t channel);
+
+/**
+ * @brief 启动/停止通道
+ * @param channel: 通道句柄
+ * @param enable: true-启动, false-停止
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelEnable(CAN_TestBox_Channel_t channel, bool enable);
+
+/**
+ * @brief 获取通道总线状态
+ * @param channel: 通道句柄
+ * @return uint32_t: 总线状态(bxCAN为ESR寄存器值)
+ */
+uint32_t CAN_TestBox_ChannelGetBusStatus(CAN_TestBox_Channel_t channel);
+
+/**
+ * @brief 外部控制器接收报文送入通道(可在中断中调用)
+ * @param channel: 通道句柄
+ * @param message: 接收到的消息指针
+ */
+void CAN_TestBox_ChannelInput(CAN_TestBox_Channel_t channel, const CAN_TestBox_Message_t *message);
+
+/**
+ * @brief 外部控制器接收紧凑帧送入通道(可在中断中调用)
+ * @param channel: 通道句柄
+ * @param frame: 接收到的紧凑帧指针
+ */
+void CAN_TestBox_ChannelInputFrame(CAN_TestBox_Channel_t channel, const CAN_TestBox_Frame_t *frame);
+
 /* ========================= 内部处理函数 ========================= */
 
 /**
@@ -395,6 +731,13 @@ bool CAN_TestBox_IsRunning(void);
  */
 void CAN_TestBox_ProcessRxMessage(CAN_HandleTypeDef *hcan, CAN_RxHeaderTypeDef *rx_header, uint8_t *rx_data);
 
+/**
+ * @brief CAN TestBox发送完成处理函数
+ * @note 在CAN发送邮箱完成中断中调用此函数唤醒等待重试的周期报文
+ * @param hcan CAN句柄指针
+ */
+void CAN_TestBox_ProcessTxComplete(CAN_HandleTypeDef *hcan);
+
 /**
  * @brief CAN TestBox错误处理函数
  * @note 在CAN错误中断中调用此函数处理错误
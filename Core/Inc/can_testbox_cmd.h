@@ -0,0 +1,172 @@
+/**
+ * @file can_testbox_cmd.h
+ * @brief CAN测试盒串口帧命令通道
+ * @version 1.0
+ * @date 2024
+ *
+ * 在原有单字节PEPS指令之外提供带长度和校验的二进制帧命令：
+ * - 请求帧: 0x55 | CMD | LEN | PAYLOAD[LEN] | SUM
+ * - 应答帧: 0xA5 0x5A | CMD|0x80 | LEN_L LEN_H | PAYLOAD[LEN] | SUM
+ * - SUM为帧头之后所有字节的8位累加和
+ * - 帧头0x55不属于单字节指令集，非帧数据仍交给PEPS单字节指令处理
+ * - 串口中断中只做帧解析，命令处理在CAN测试盒任务中执行
+ * - 各模块通过CAN_Cmd_Register()注册自己的命令处理函数
+ *
+ * 详细协议见 文档/屏幕uart通讯协议.md
+ */
+
+#ifndef __CAN_TESTBOX_CMD_H
+#define __CAN_TESTBOX_CMD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can_testbox_api.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ========================= 配置宏定义 ========================= */
+
+#define CAN_CMD_FRAME_HEADER            0x55  // 请求帧头
+#define CAN_CMD_RESP_HEADER0            0xA5  // 应答帧头字节0
+#define CAN_CMD_RESP_HEADER1            0x5A  // 应答帧头字节1
+#define CAN_CMD_RESP_FLAG               0x80  // 应答命令字标志
+#define CAN_CMD_MAX_PAYLOAD             64    // 请求负载最大长度
+#define CAN_CMD_MAX_HANDLERS            32    // 可注册命令数量(各模块初始化时注册，满时注册失败并输出错误)
+#define CAN_CMD_BYTE_TIMEOUT_MS         50    // 帧内字节间隔超时(ms)
+
+/* ========================= 命令字定义 ========================= */
+
+#define CAN_CMD_ID_PING                 0x01  // 链路测试，原样返回负载
+#define CAN_CMD_ID_IDSTATS_DUMP         0x10  // 导出按ID统计表
+#define CAN_CMD_ID_IDSTATS_RESET        0x11  // 清空按ID统计表
+#define CAN_CMD_ID_ERRSTATS_GET         0x12  // 读取错误统计与错误时间序列
+#define CAN_CMD_ID_FORMAT_BENCH         0x13  // 日志格式化基准测试
+#define CAN_CMD_ID_MEM_REPORT           0x14  // 读取内存使用报告
+#define CAN_CMD_ID_EVENT_STATS          0x15  // 读取测试盒任务唤醒统计
+#define CAN_CMD_ID_POWER_CTRL           0x16  // 低功耗控制与周期抖动报告
+#define CAN_CMD_ID_RTSTATS_GET          0x17  // 读取任务CPU占用与栈水位
+#define CAN_CMD_ID_LATENCY_GET          0x18  // 读取接收链路时延直方图
+#define CAN_CMD_ID_SEQ_WRITE            0x19  // 写入测试序列脚本片段
+#define CAN_CMD_ID_SEQ_CTRL             0x1A  // 测试序列运行/中止/保存/载入/状态
+#define CAN_CMD_ID_PEPS_SCENARIO        0x1B  // PEPS场景启动/中止/状态
+#define CAN_CMD_ID_REQRESP_GET          0x1C  // 读取请求/应答往返时延统计
+#define CAN_CMD_ID_RLINK_CTRL           0x1D  // 可靠链路状态/配置/测试
+#define CAN_CMD_ID_E2E_CTRL             0x1E  // E2E保护绑定/接收校验统计
+#define CAN_CMD_ID_GEN_CTRL             0x1F  // 负载生成器配置/绑定/统计
+#define CAN_CMD_ID_ACCEPT_CTRL          0x20  // 软件接收过滤配置/统计
+#define CAN_CMD_ID_TXARB_CTRL           0x21  // 发送仲裁分类统计/抢占开关
+#define CAN_CMD_ID_TXCONF_CTRL          0x22  // 发送确认日志/周期报文上线抖动
+#define CAN_CMD_ID_PHASE_CTRL           0x23  // 周期报文相位/发送队列深度峰值
+#define CAN_CMD_ID_GATEWAY_CTRL         0x24  // 网关路由配置/启停/路由统计
+#define CAN_CMD_ID_MONITOR_CTRL         0x25  // 抓包启停/过滤器/串口输出/统计
+#define CAN_CMD_ID_CYCLEMON_CTRL        0x26  // 周期监控项添加/删除/统计/事件输出
+
+/* ========================= 应答状态码 ========================= */
+
+#define CAN_CMD_RESULT_OK               0x00  // 成功
+#define CAN_CMD_RESULT_UNKNOWN_CMD      0x01  // 未知命令
+#define CAN_CMD_RESULT_BAD_LENGTH       0x02  // 负载长度错误
+#define CAN_CMD_RESULT_BAD_PARAM        0x03  // 参数错误
+#define CAN_CMD_RESULT_FAILED           0x04  // 执行失败
+
+/* ========================= 数据结构定义 ========================= */
+
+/**
+ * @brief 命令处理函数(在任务上下文中调用)
+ * @param cmd: 命令字
+ * @param payload: 请求负载
+ * @param len: 负载长度
+ * @note  处理函数负责发送应答帧
+ */
+typedef void (*CAN_Cmd_Handler_t)(uint8_t cmd, const uint8_t *payload, uint8_t len);
+
+/**
+ * @brief 帧解析统计
+ */
+typedef struct {
+    uint32_t frame_count;           // 收到的完整帧数
+    uint32_t checksum_error_count;  // 校验错误帧数
+    uint32_t length_error_count;    // 长度超限帧数
+    uint32_t timeout_count;         // 帧内超时次数
+    uint32_t overrun_count;         // 上一帧未处理又收到新帧的次数
+    uint32_t unknown_cmd_count;     // 未注册命令数
+} CAN_Cmd_Stats_t;
+
+/* ========================= API接口声明 ========================= */
+
+/**
+ * @brief 初始化帧命令通道
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Cmd_Init(void);
+
+/**
+ * @brief 注册命令处理函数
+ * @param cmd: 命令字(0x00-0x7F)
+ * @param handler: 处理函数
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Cmd_Register(uint8_t cmd, CAN_Cmd_Handler_t handler);
+
+/**
+ * @brief 串口接收字节输入(在串口接收中断中调用)
+ * @param byte: 接收到的字节
+ * @return bool: true-字节属于帧命令已被消费，false-交由单字节指令处理
+ */
+bool CAN_Cmd_InputByte(uint8_t byte);
+
+/**
+ * @brief 执行已接收的帧命令(在CAN测试盒任务中周期调用)
+ */
+void CAN_Cmd_Process(void);
+
+/**
+ * @brief 发送完整应答帧
+ * @param cmd: 请求命令字
+ * @param payload: 应答负载
+ * @param len: 负载长度
+ */
+void CAN_Cmd_SendResponse(uint8_t cmd, const uint8_t *payload, uint16_t len);
+
+/**
+ * @brief 发送单字节状态应答
+ * @param cmd: 请求命令字
+ * @param result: CAN_CMD_RESULT_xxx
+ */
+void CAN_Cmd_SendResult(uint8_t cmd, uint8_t result);
+
+/**
+ * @brief 分段发送应答帧: 开始(写出帧头和总长度)
+ * @param cmd: 请求命令字
+ * @param total_len: 负载总长度
+ * @note  用于大数据量导出，负载通过CAN_Cmd_ResponseWrite分段写出，
+ *        写出总长度必须等于total_len，最后调用CAN_Cmd_ResponseEnd
+ */
+void CAN_Cmd_ResponseBegin(uint8_t cmd, uint16_t total_len);
+
+/**
+ * @brief 分段发送应答帧: 写出负载
+ * @param data: 数据指针
+ * @param len: 数据长度
+ */
+void CAN_Cmd_ResponseWrite(const void *data, uint16_t len);
+
+/**
+ * @brief 分段发送应答帧: 结束(写出校验和)
+ */
+void CAN_Cmd_ResponseEnd(void);
+
+/**
+ * @brief 获取帧解析统计
+ * @param stats: 统计信息指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Cmd_GetStats(CAN_Cmd_Stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_TESTBOX_CMD_H */
@@ -0,0 +1,205 @@
+/**
+ * @file can_testbox_cyclemon.h
+ * @brief CAN按ID周期监控(丢帧/迟到/过早检测)
+ * @version 1.0
+ * @date 2024
+ *
+ * 为每个被监控的通道+ID(CAN1或CAN2)配置期望周期、容差和超时：
+ * - 接收中断中按ID哈希查找监控项，用TIM2硬件时间戳计算帧间隔，
+ *   超出[周期-容差, 周期+容差]记为过早/迟到
+ * - 超时检测使用哈希时间轮(1ms一格)，每个监控项始终只挂在一个槽位上，
+ *   收到报文时中断中不操作时间轮，到期时再按最近接收时间延后(惰性重排)，
+ *   每个tick的开销与监控项总数无关
+ * - 超时未收到报文记为丢失，恢复接收时产生恢复事件
+ * - 事件经环形缓冲区转交任务上下文，调用事件钩子(可用于触发抓包)并计数
+ * - 串口帧命令添加/删除监控项、读取统计与开关事件串口输出
+ */
+
+#ifndef __CAN_TESTBOX_CYCLEMON_H
+#define __CAN_TESTBOX_CYCLEMON_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can_testbox_api.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ========================= 配置宏定义 ========================= */
+
+#define CAN_CYCLEMON_MAX_MONITORS       128   // 最大监控项数量
+#define CAN_CYCLEMON_HASH_SIZE          256   // ID查找哈希表容量(2的幂，不小于监控项数量的2倍)
+#define CAN_CYCLEMON_WHEEL_BITS         8     // 时间轮槽位数 = 2^N (每槽1ms)
+#define CAN_CYCLEMON_EVENT_QUEUE_SIZE   32    // 事件缓冲区深度(必须为2的幂)
+#define CAN_CYCLEMON_DEFAULT_TIMEOUT_X  3     // 未配置超时时默认超时 = 周期 * N
+#define CAN_CYCLEMON_PERIOD_MAX_MS      (0xFFFFFFFFU / 1000U) // 周期+容差上限(按us比较不溢出)
+
+#define CAN_CYCLEMON_INVALID_HANDLE     0xFFFF
+
+/* ========================= 控制操作定义 ========================= */
+
+#define CAN_CYCLEMON_CTRL_STATUS        0x00  // 读取监控项统计(句柄)
+#define CAN_CYCLEMON_CTRL_ADD           0x01  // 添加监控项(扩展帧、ID、周期、容差、超时[、通道])
+#define CAN_CYCLEMON_CTRL_REMOVE        0x02  // 删除监控项(句柄)
+#define CAN_CYCLEMON_CTRL_CLEAR         0x03  // 删除所有监控项
+#define CAN_CYCLEMON_CTRL_OUTPUT        0x04  // 事件串口输出开关(使能)
+#define CAN_CYCLEMON_CTRL_RESET_STATS   0x05  // 清空全部统计
+
+/* ========================= 数据结构定义 ========================= */
+
+/**
+ * @brief 监控项配置
+ */
+typedef struct {
+    uint8_t  channel;               // 接收通道(CAN_TESTBOX_CH_CAN1/CAN_TESTBOX_CH_CAN2)
+    uint32_t id;                    // 报文ID
+    bool     is_extended;           // 扩展帧标志
+    uint32_t period_ms;             // 期望周期(ms)
+    uint32_t tolerance_ms;          // 周期容差(ms)
+    uint32_t timeout_ms;            // 丢失判定超时(ms)，0表示使用默认值
+} CAN_CycleMon_Config_t;
+
+/**
+ * @brief 监控状态
+ */
+typedef enum {
+    CAN_CYCLEMON_STATE_WAIT_FIRST = 0,  // 尚未收到首帧
+    CAN_CYCLEMON_STATE_OK,              // 正常接收
+    CAN_CYCLEMON_STATE_MISSING          // 已判定丢失
+} CAN_CycleMon_State_t;
+
+/**
+ * @brief 事件类型
+ */
+typedef enum {
+    CAN_CYCLEMON_EVENT_EARLY = 0,       // 帧间隔小于周期-容差
+    CAN_CYCLEMON_EVENT_LATE,            // 帧间隔大于周期+容差
+    CAN_CYCLEMON_EVENT_MISSING,         // 超时未收到
+    CAN_CYCLEMON_EVENT_RECOVERED        // 丢失后恢复接收
+} CAN_CycleMon_EventType_t;
+
+/**
+ * @brief 监控事件
+ */
+typedef struct {
+    CAN_CycleMon_EventType_t type;  // 事件类型
+    uint16_t handle;                // 监控项句柄
+    uint8_t  channel;               // 接收通道
+    uint32_t id;                    // 报文ID
+    bool     is_extended;           // 扩展帧标志
+    uint32_t interval_us;           // 触发事件的帧间隔(us)，丢失事件为0
+    uint32_t timestamp_us;          // 事件时间戳(us)
+} CAN_CycleMon_Event_t;
+
+/**
+ * @brief 监控项统计
+ */
+typedef struct {
+    CAN_CycleMon_State_t state;     // 当前状态
+    uint32_t rx_count;              // 接收帧数
+    uint32_t early_count;           // 过早次数
+    uint32_t late_count;            // 迟到次数
+    uint32_t missing_count;         // 丢失次数(每个超时周期计一次)
+    uint32_t recovered_count;       // 恢复次数
+    uint32_t last_interval_us;      // 最近帧间隔(us)
+    uint32_t min_interval_us;       // 最小帧间隔(us)
+    uint32_t max_interval_us;       // 最大帧间隔(us)
+} CAN_CycleMon_Stats_t;
+
+/**
+ * @brief 事件钩子(在任务上下文中调用)
+ * @param event: 事件指针
+ */
+typedef void (*CAN_CycleMon_EventHook_t)(const CAN_CycleMon_Event_t *event);
+
+/* ========================= API接口声明 ========================= */
+
+/**
+ * @brief 初始化周期监控模块(注册串口命令)
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_CycleMon_Init(void);
+
+/**
+ * @brief 添加监控项
+ * @param config: 配置指针
+ * @param handle: 输出句柄
+ * @return CAN_TestBox_Status_t: 返回状态(同一通道同一ID重复添加返回ALREADY_EXISTS，
+ *         周期+容差超过CAN_CYCLEMON_PERIOD_MAX_MS或默认超时溢出返回INVALID_PARAM)
+ */
+CAN_TestBox_Status_t CAN_CycleMon_Add(const CAN_CycleMon_Config_t *config, uint16_t *handle);
+
+/**
+ * @brief 删除监控项
+ * @param handle: 监控项句柄
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_CycleMon_Remove(uint16_t handle);
+
+/**
+ * @brief 删除所有监控项
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_CycleMon_Clear(void);
+
+/**
+ * @brief 获取监控项统计
+ * @param handle: 监控项句柄
+ * @param stats: 统计信息指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_CycleMon_GetStats(uint16_t handle, CAN_CycleMon_Stats_t *stats);
+
+/**
+ * @brief 重置所有监控项统计
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_CycleMon_ResetStats(void);
+
+/**
+ * @brief 设置事件钩子
+ * @param hook: 钩子函数，NULL表示不回调
+ */
+void CAN_CycleMon_SetEventHook(CAN_CycleMon_EventHook_t hook);
+
+/**
+ * @brief 使能/禁用事件串口输出
+ * @param enable: true-使能
+ */
+void CAN_CycleMon_SetOutput(bool enable);
+
+/**
+ * @brief 获取事件缓冲区溢出丢弃的事件数
+ * @return uint32_t: 丢弃事件数
+ */
+uint32_t CAN_CycleMon_GetEventOverflowCount(void);
+
+/**
+ * @brief 周期监控任务处理(在CAN测试盒任务中调用)
+ * @note  推进时间轮检测丢失，并分发事件
+ */
+void CAN_CycleMon_Process(void);
+
+/**
+ * @brief 计算距下一个监控项到期的时间(事件驱动任务的等待超时)
+ * @param max_ms: 上限(ms)，时间轮为空时返回该值
+ * @return uint32_t: 距下一次到期的时间(ms)，0表示需要立即处理
+ */
+uint32_t CAN_CycleMon_GetIdleTime(uint32_t max_ms);
+
+/* ========================= 中断处理函数 ========================= */
+
+/**
+ * @brief 接收报文周期检查(在CAN接收中断中调用)
+ * @param ch: 接收通道(CAN_TESTBOX_CH_CAN1/CAN_TESTBOX_CH_CAN2)
+ * @param rx_header: 接收消息头指针
+ * @param rx_timestamp_us: 进入接收中断时的硬件时间戳(us)
+ */
+void CAN_CycleMon_ProcessRx(CAN_TestBox_ChannelId_t ch, const CAN_RxHeaderTypeDef *rx_header, uint32_t rx_timestamp_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_TESTBOX_CYCLEMON_H */
@@ -0,0 +1,190 @@
+/**
+ * @file can_testbox_e2e.h
+ * @brief 周期报文E2E保护(滚动计数器 + CRC8 + 数据ID)
+ * @version 1.0
+ * @date 2024
+ *
+ * 按AUTOSAR E2E Profile 1的方式保护报文：
+ * - 计数器占用某字节的高/低4位，每次发送成功后加1，超过最大值回0
+ * - CRC8对数据ID(低字节在前)与除CRC字节外的全部数据计算，
+ *   支持SAE J1850(多项式0x1D)与CRC8H2F(多项式0x2F)，初值与结果异或均为0xFF
+ * - 发送端: 周期报文槽位绑定保护参数，发送时在帧副本上写入计数器与CRC，
+ *   未绑定的槽位只有一次位判断的开销
+ * - 接收端: 按通道+ID登记保护参数，接收路径中校验CRC与计数器连续性，
+ *   按原因累计错误计数
+ * CRC使用256字节常量表逐字节查表(片内CRC外设只支持CRC32，不适用)。
+ */
+
+#ifndef __CAN_TESTBOX_E2E_H
+#define __CAN_TESTBOX_E2E_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can_testbox_api.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ========================= 配置宏定义 ========================= */
+
+#define CAN_E2E_RX_MAX              16    // 接收校验登记数
+#define CAN_E2E_RX_HASH_SIZE        16    // 接收散列桶数(2的幂)
+
+/* ========================= 参数取值定义 ========================= */
+
+#define CAN_E2E_CRC_J1850           0x00  // CRC8 SAE J1850，多项式0x1D
+#define CAN_E2E_CRC_8H2F            0x01  // CRC8H2F，多项式0x2F
+
+#define CAN_E2E_NIBBLE_LOW          0x00  // 计数器位于低4位
+#define CAN_E2E_NIBBLE_HIGH         0x01  // 计数器位于高4位
+
+#define CAN_E2E_DATAID_BOTH         0x00  // 数据ID两个字节参与CRC
+#define CAN_E2E_DATAID_LOW          0x01  // 仅数据ID低字节参与CRC
+#define CAN_E2E_DATAID_NONE         0x02  // 数据ID不参与CRC
+
+/* ========================= 控制操作定义 ========================= */
+
+#define CAN_E2E_CTRL_ATTACH_TX      0x00  // 周期报文绑定保护(通道、句柄、参数)
+#define CAN_E2E_CTRL_DETACH_TX      0x01  // 周期报文解除保护(通道、句柄)
+#define CAN_E2E_CTRL_ADD_RX         0x02  // 登记接收校验(通道、扩展帧、ID、参数)
+#define CAN_E2E_CTRL_REMOVE_RX      0x03  // 删除接收校验(登记编号)
+#define CAN_E2E_CTRL_GET_RX         0x04  // 读取接收校验统计
+#define CAN_E2E_CTRL_CLEAR          0x05  // 清空接收校验统计
+
+/* ========================= 数据结构定义 ========================= */
+
+/**
+ * @brief 保护参数
+ */
+typedef struct {
+    uint8_t crc_type;                       // CAN_E2E_CRC_xxx
+    uint8_t crc_byte;                       // CRC所在字节(0~7)
+    uint8_t counter_byte;                   // 计数器所在字节(0~7，不能与CRC字节相同)
+    uint8_t counter_nibble;                 // CAN_E2E_NIBBLE_xxx
+    uint8_t counter_max;                    // 计数器最大值(1~15，Profile 1为14)
+    uint8_t max_delta;                      // 接收端允许的最大计数增量(1表示不允许丢帧)
+    uint8_t data_id_mode;                   // CAN_E2E_DATAID_xxx
+    uint16_t data_id;                       // 数据ID
+} CAN_E2E_Profile_t;
+
+/**
+ * @brief 接收校验结果
+ */
+typedef enum {
+    CAN_E2E_RX_OK = 0,                      // 校验通过
+    CAN_E2E_RX_INITIAL,                     // 首帧(CRC正确，计数器作为基准)
+    CAN_E2E_RX_REPEATED,                    // 计数器未变化
+    CAN_E2E_RX_WRONG_SEQUENCE,              // 计数器增量超过max_delta
+    CAN_E2E_RX_CRC_ERROR,                   // CRC错误
+    CAN_E2E_RX_LENGTH_ERROR                 // 数据长度不足
+} CAN_E2E_RxResult_t;
+
+/**
+ * @brief 单个接收校验登记的统计
+ */
+typedef struct {
+    uint32_t ok;                            // 校验通过帧数(含首帧)
+    uint32_t crc_errors;                    // CRC错误帧数
+    uint32_t repeated;                      // 计数器重复帧数
+    uint32_t wrong_sequence;                // 计数器跳变超限帧数
+    uint32_t lost;                          // 由计数器增量推算的丢帧数
+    uint32_t length_errors;                 // 长度不足帧数
+    uint32_t last_result;                   // 最近一帧结果(CAN_E2E_RxResult_t)
+} CAN_E2E_RxStats_t;
+
+/* ========================= API接口声明 ========================= */
+
+/**
+ * @brief 初始化E2E保护(注册串口命令)
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_E2E_Init(void);
+
+/**
+ * @brief 计算CRC8
+ * @param crc_type: CAN_E2E_CRC_xxx
+ * @param crc: 初值(首段传0xFF，分段计算时传上一段未异或的结果)
+ * @param data: 数据
+ * @param len: 长度
+ * @return uint8_t: 未做结果异或的CRC
+ */
+uint8_t CAN_E2E_Crc8(uint8_t crc_type, uint8_t crc, const uint8_t *data, uint8_t len);
+
+/**
+ * @brief 周期报文槽位绑定保护参数(计数器从0开始)
+ * @param ch: 通道编号
+ * @param handle: 周期报文句柄
+ * @param profile: 保护参数
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_E2E_AttachTx(CAN_TestBox_ChannelId_t ch, uint8_t handle, const CAN_E2E_Profile_t *profile);
+
+/**
+ * @brief 周期报文槽位解除保护(停止周期报文时自动调用)
+ * @param ch: 通道编号
+ * @param handle: 周期报文句柄
+ */
+void CAN_E2E_DetachTx(CAN_TestBox_ChannelId_t ch, uint8_t handle);
+
+/**
+ * @brief 发送前生成受保护的帧副本(在周期发送路径中调用)
+ * @param ch: 通道编号
+ * @param handle: 周期报文句柄
+ * @param frame: 周期表中的原始帧
+ * @param out: 写入计数器与CRC后的帧
+ * @return bool: true表示槽位受保护，应发送out
+ */
+bool CAN_E2E_ProtectTx(CAN_TestBox_ChannelId_t ch, uint8_t handle,
+                       const CAN_TestBox_Frame_t *frame, CAN_TestBox_Frame_t *out);
+
+/**
+ * @brief 受保护帧发送成功后推进计数器
+ * @param ch: 通道编号
+ * @param handle: 周期报文句柄
+ */
+void CAN_E2E_ConfirmTx(CAN_TestBox_ChannelId_t ch, uint8_t handle);
+
+/**
+ * @brief 登记接收校验
+ * @param ch: 通道编号
+ * @param id: 报文ID
+ * @param is_extended: 是否扩展帧
+ * @param profile: 保护参数
+ * @param index: 返回的登记编号，可为NULL
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_E2E_AddRx(CAN_TestBox_ChannelId_t ch, uint32_t id, bool is_extended,
+                                   const CAN_E2E_Profile_t *profile, uint8_t *index);
+
+/**
+ * @brief 删除接收校验
+ * @param index: 登记编号
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_E2E_RemoveRx(uint8_t index);
+
+/**
+ * @brief 接收帧校验(在接收路径中调用，可在中断中调用)
+ * @param frame: 接收帧(已设置通道)
+ */
+void CAN_E2E_CheckRx(const CAN_TestBox_Frame_t *frame);
+
+/**
+ * @brief 获取接收校验统计
+ * @param index: 登记编号
+ * @param stats: 统计指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_E2E_GetRxStats(uint8_t index, CAN_E2E_RxStats_t *stats);
+
+/**
+ * @brief 清空全部接收校验统计(计数器基准同时复位)
+ */
+void CAN_E2E_ResetRxStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_TESTBOX_E2E_H */
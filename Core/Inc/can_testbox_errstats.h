@@ -0,0 +1,190 @@
+/**
+ * @file can_testbox_errstats.h
+ * @brief CAN错误帧与错误计数器分析、总线关闭恢复策略
+ * @version 1.0
+ * @date 2024
+ *
+ * 针对片内bxCAN(CAN1/CAN2)：
+ * - 每次错误中断采样TEC/REC及错误类型(填充/格式/应答/隐性位/显性位/CRC)，
+ *   带硬件时间戳写入时间序列环形缓冲区
+ * - 跟踪主动错误/错误警告/错误被动/总线关闭状态转换及时间戳
+ *   (进入更高错误状态由中断捕获，回落由任务轮询ESR捕获)
+ * - 可配置的总线关闭恢复策略: 硬件自动恢复(ABOM)、手动恢复、延时软件恢复
+ */
+
+#ifndef __CAN_TESTBOX_ERRSTATS_H
+#define __CAN_TESTBOX_ERRSTATS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can_testbox_api.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ========================= 配置宏定义 ========================= */
+
+#define CAN_ERRSTATS_CHANNEL_COUNT      2     // 片内CAN通道数(CAN1/CAN2)
+#define CAN_ERRSTATS_SAMPLE_COUNT       128   // 每通道时间序列深度(必须为2的幂)
+#define CAN_ERRSTATS_DUMP_MAX_SAMPLES   64    // 串口单次导出最大采样数
+#define CAN_ERRSTATS_POLL_MS            10    // 非主动错误状态下的ESR轮询间隔(ms)
+
+/* ========================= 数据结构定义 ========================= */
+
+/**
+ * @brief 错误状态(按严重程度递增)
+ */
+typedef enum {
+    CAN_ERRSTATS_STATE_ACTIVE = 0,      // 主动错误
+    CAN_ERRSTATS_STATE_WARNING,         // 错误警告(TEC或REC >= 96)
+    CAN_ERRSTATS_STATE_PASSIVE,         // 错误被动(TEC或REC > 127)
+    CAN_ERRSTATS_STATE_BUS_OFF,         // 总线关闭(TEC > 255)
+    CAN_ERRSTATS_STATE_COUNT
+} CAN_ErrStats_State_t;
+
+/**
+ * @brief 错误类型(与ESR.LEC编码一致)
+ */
+typedef enum {
+    CAN_ERRSTATS_LEC_NONE = 0,          // 无错误
+    CAN_ERRSTATS_LEC_STUFF,             // 填充错误
+    CAN_ERRSTATS_LEC_FORM,              // 格式错误
+    CAN_ERRSTATS_LEC_ACK,               // 应答错误
+    CAN_ERRSTATS_LEC_BIT1,              // 隐性位错误
+    CAN_ERRSTATS_LEC_BIT0,              // 显性位错误
+    CAN_ERRSTATS_LEC_CRC,               // CRC错误
+    CAN_ERRSTATS_LEC_COUNT
+} CAN_ErrStats_Lec_t;
+
+/**
+ * @brief 总线关闭恢复策略
+ */
+typedef enum {
+    CAN_ERRSTATS_RECOVERY_MANUAL = 0,   // 手动恢复(调用CAN_ErrStats_RecoverBusOff)
+    CAN_ERRSTATS_RECOVERY_HW_AUTO,      // 硬件自动恢复(MCR.ABOM)
+    CAN_ERRSTATS_RECOVERY_SW_DELAYED    // 总线关闭持续指定时间后由任务重启控制器
+} CAN_ErrStats_RecoveryMode_t;
+
+/**
+ * @brief 恢复策略配置
+ */
+typedef struct {
+    CAN_ErrStats_RecoveryMode_t mode;   // 恢复方式
+    uint32_t delay_ms;                  // 延时软件恢复: 进入总线关闭后等待时间(ms)
+    uint32_t max_attempts;              // 延时软件恢复: 连续恢复次数上限，0表示不限
+} CAN_ErrStats_RecoveryPolicy_t;
+
+/**
+ * @brief 采样标志位
+ */
+#define CAN_ERRSTATS_SAMPLE_FLAG_TRANSITION   0x01U // 本采样为状态转换
+#define CAN_ERRSTATS_SAMPLE_FLAG_RECOVERY     0x02U // 本采样为软件恢复动作
+
+/**
+ * @brief 时间序列采样(8字节)
+ */
+typedef struct {
+    uint32_t timestamp_us;          // 硬件时间戳(us)
+    uint8_t  tec;                   // 发送错误计数
+    uint8_t  rec;                   // 接收错误计数
+    uint8_t  lec;                   // CAN_ErrStats_Lec_t
+    uint8_t  state : 4;             // CAN_ErrStats_State_t
+    uint8_t  flags : 4;             // CAN_ERRSTATS_SAMPLE_FLAG_xxx
+} CAN_ErrStats_Sample_t;
+
+/**
+ * @brief 通道错误统计
+ */
+typedef struct {
+    uint32_t error_irq_count;                           // 错误中断次数
+    uint32_t lec_count[CAN_ERRSTATS_LEC_COUNT];         // 按错误类型计数
+    uint32_t state_enter_count[CAN_ERRSTATS_STATE_COUNT]; // 进入各状态次数
+    uint32_t state_enter_us[CAN_ERRSTATS_STATE_COUNT];  // 最近一次进入各状态的时间(us)
+    uint32_t bus_off_total_ms;                          // 累计总线关闭时长(ms)
+    uint32_t recovery_count;                            // 软件恢复次数
+    uint32_t recovery_fail_count;                       // 软件恢复失败次数
+    uint32_t sample_overwrite_count;                    // 时间序列覆盖的采样数
+    CAN_ErrStats_State_t state;                         // 当前状态
+    uint8_t  tec;                                       // 当前TEC
+    uint8_t  rec;                                       // 当前REC
+    uint8_t  max_tec;                                   // TEC峰值
+    uint8_t  max_rec;                                   // REC峰值
+} CAN_ErrStats_Stats_t;
+
+/* ========================= API接口声明 ========================= */
+
+/**
+ * @brief 初始化错误分析模块并使能CAN1/CAN2错误中断
+ * @return CAN_TestBox_Status_t: 返回状态
+ * @note  默认策略为手动恢复(与CubeMX配置AutoBusOff = DISABLE一致)
+ */
+CAN_TestBox_Status_t CAN_ErrStats_Init(void);
+
+/**
+ * @brief 设置总线关闭恢复策略
+ * @param hcan: CAN句柄指针
+ * @param policy: 策略配置指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_ErrStats_SetRecoveryPolicy(CAN_HandleTypeDef *hcan, const CAN_ErrStats_RecoveryPolicy_t *policy);
+
+/**
+ * @brief 立即从总线关闭恢复(重启控制器)
+ * @param hcan: CAN句柄指针
+ * @return CAN_TestBox_Status_t: 返回状态(未处于总线关闭时直接返回OK)
+ */
+CAN_TestBox_Status_t CAN_ErrStats_RecoverBusOff(CAN_HandleTypeDef *hcan);
+
+/**
+ * @brief 获取通道错误统计
+ * @param hcan: CAN句柄指针
+ * @param stats: 统计信息指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_ErrStats_GetStats(CAN_HandleTypeDef *hcan, CAN_ErrStats_Stats_t *stats);
+
+/**
+ * @brief 读取时间序列采样(按时间先后，读取后移除)
+ * @param hcan: CAN句柄指针
+ * @param samples: 采样数组
+ * @param max_count: 数组容量
+ * @return uint32_t: 实际读取条数
+ */
+uint32_t CAN_ErrStats_ReadSamples(CAN_HandleTypeDef *hcan, CAN_ErrStats_Sample_t *samples, uint32_t max_count);
+
+/**
+ * @brief 重置通道统计与时间序列
+ * @param hcan: CAN句柄指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_ErrStats_Reset(CAN_HandleTypeDef *hcan);
+
+/**
+ * @brief 错误分析任务处理(在CAN测试盒任务中调用)
+ * @note  轮询ESR捕获错误状态回落，执行延时软件恢复
+ */
+void CAN_ErrStats_Process(void);
+
+/**
+ * @brief 计算距下一次错误状态轮询的时间(事件驱动任务的等待超时)
+ * @param max_ms: 上限(ms)，全部通道处于主动错误状态时返回该值
+ * @return uint32_t: 距下一次轮询的时间(ms)
+ */
+uint32_t CAN_ErrStats_GetIdleTime(uint32_t max_ms);
+
+/* ========================= 中断处理函数 ========================= */
+
+/**
+ * @brief 错误中断采样(在CAN错误回调中最后调用)
+ * @param hcan: CAN句柄指针
+ * @param timestamp_us: 硬件时间戳(us)
+ * @note  采样后清除HAL累积的错误码，使下一次回调只反映新错误
+ */
+void CAN_ErrStats_ProcessError(CAN_HandleTypeDef *hcan, uint32_t timestamp_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_TESTBOX_ERRSTATS_H */
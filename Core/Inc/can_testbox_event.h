@@ -0,0 +1,93 @@
+/**
+ * @file can_testbox_event.h
+ * @brief CAN测试盒任务事件通知
+ * @version 1.0
+ * @date 2024
+ *
+ * 测试盒任务不再以1ms周期轮询，而是阻塞等待线程标志(FreeRTOS任务通知)：
+ * - 调度: 等待超时即调度定时器，取下一个周期报文/周期监控槽位的到期时间；
+ *   周期表变更时发出通知以重新计算
+ * - 发送完成: 周期报文因邮箱满发送失败后，由发送邮箱空中断唤醒重试
+ * - 命令: 串口帧命令接收完成
+ * - 接收: 需要任务输出的接收事件(合并报文流、周期监控事件)
+ * 没有任何到期项时最长等待CAN_EVENT_IDLE_MAX_MS；错误状态回落检测和
+ * 延时恢复仅在通道非主动错误状态时按CAN_ERRSTATS_POLL_MS轮询，
+ * 保证空闲时tickless可长时间睡眠。
+ */
+
+#ifndef __CAN_TESTBOX_EVENT_H
+#define __CAN_TESTBOX_EVENT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can_testbox_api.h"
+#include "cmsis_os.h"
+#include <stdint.h>
+
+/* ========================= 配置宏定义 ========================= */
+
+#define CAN_EVENT_IDLE_MAX_MS       1000  // 无到期项时的最长等待(ms)
+
+/* ========================= 事件定义 ========================= */
+
+#define CAN_EVENT_SCHEDULE          (1UL << 0)  // 周期表变更
+#define CAN_EVENT_TX_DONE           (1UL << 1)  // 发送邮箱空闲
+#define CAN_EVENT_CMD               (1UL << 2)  // 串口帧命令待执行
+#define CAN_EVENT_RX                (1UL << 3)  // 接收事件待输出
+#define CAN_EVENT_ALL               (CAN_EVENT_SCHEDULE | CAN_EVENT_TX_DONE | CAN_EVENT_CMD | CAN_EVENT_RX)
+
+/* ========================= 数据结构定义 ========================= */
+
+/**
+ * @brief 任务唤醒统计
+ */
+typedef struct {
+    uint32_t wakeups;               // 总唤醒次数
+    uint32_t timeouts;              // 超时唤醒次数(调度定时器到期)
+    uint32_t schedule_count;        // 周期表变更唤醒次数
+    uint32_t tx_done_count;         // 发送完成唤醒次数
+    uint32_t cmd_count;             // 命令唤醒次数
+    uint32_t rx_count;              // 接收事件唤醒次数
+} CAN_Event_Stats_t;
+
+/* ========================= API接口声明 ========================= */
+
+/**
+ * @brief 初始化事件通知(注册串口命令)
+ * @param task: 接收通知的测试盒任务
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Event_Init(osThreadId_t task);
+
+/**
+ * @brief 通知测试盒任务(可在中断中调用)
+ * @param events: 事件位(CAN_EVENT_xxx)
+ */
+void CAN_Event_Notify(uint32_t events);
+
+/**
+ * @brief 等待事件或超时(仅在测试盒任务中调用)
+ * @param timeout_ms: 最长等待时间(ms)，0表示不等待
+ * @return uint32_t: 收到的事件位，超时返回0
+ */
+uint32_t CAN_Event_Wait(uint32_t timeout_ms);
+
+/**
+ * @brief 获取任务唤醒统计
+ * @param stats: 统计指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Event_GetStats(CAN_Event_Stats_t *stats);
+
+/**
+ * @brief 清空任务唤醒统计
+ */
+void CAN_Event_ResetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_TESTBOX_EVENT_H */
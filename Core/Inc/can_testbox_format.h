@@ -0,0 +1,145 @@
+/**
+ * @file can_testbox_format.h
+ * @brief CAN报文日志快速格式化(无动态分配、查表实现)
+ * @version 1.0
+ * @date 2024
+ *
+ * 替代逐字节printf("%02X")的收发日志输出：
+ * - 报文ID、数据、时间戳通过查表渲染到调用者提供的缓冲区，
+ *   不经过newlib的vfprintf，不使用堆和可重入结构
+ * - 单字节十六进制转换为一次256项表查找，每帧耗时只与DLC相关
+ * - 每帧整行通过一次串口发送输出
+ * - 输出文本与原printf格式逐字节一致:
+ *   "<TAG> ID:0x%03X, Data:XX XX ... [END]\r\n"，远程帧数据区为"RTR"
+ */
+
+#ifndef __CAN_TESTBOX_FORMAT_H
+#define __CAN_TESTBOX_FORMAT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can_testbox_api.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ========================= 配置宏定义 ========================= */
+
+#define CAN_FORMAT_LINE_MAX             96    // 单行日志缓冲区大小
+#define CAN_FORMAT_TAG_MAX              16    // 日志标签最大长度
+#define CAN_FORMAT_STD_ID_DIGITS        3     // 标准帧ID最少十六进制位数
+#define CAN_FORMAT_EXT_ID_DIGITS        8     // 扩展帧ID最少十六进制位数
+#define CAN_FORMAT_BENCH_ITERATIONS     64    // 基准测试每种DLC的重复次数
+
+/* ========================= 数据结构定义 ========================= */
+
+/**
+ * @brief 格式化基准测试结果(每帧平均内核周期数)
+ */
+typedef struct {
+    uint32_t printf_cycles;         // 原printf逐字节方式(渲染到缓冲区)
+    uint32_t format_cycles;         // 查表格式化方式
+    uint32_t frames;                // 测量帧数
+    bool     identical;             // 两种方式输出是否逐字节一致
+} CAN_Format_Bench_t;
+
+/* ========================= API接口声明 ========================= */
+
+/**
+ * @brief 初始化格式化模块(使能周期计数器并注册基准测试命令)
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Format_Init(void);
+
+/**
+ * @brief 追加字符串
+ * @param p: 写入位置
+ * @param str: 字符串
+ * @param max_len: 最多写入字符数
+ * @return char*: 写入后的位置
+ */
+char *CAN_Format_Str(char *p, const char *str, uint32_t max_len);
+
+/**
+ * @brief 追加十进制无符号数(等价于"%lu")
+ * @param p: 写入位置
+ * @param value: 数值
+ * @return char*: 写入后的位置
+ */
+char *CAN_Format_Dec(char *p, uint32_t value);
+
+/**
+ * @brief 追加大写十六进制数(等价于"%0*X")
+ * @param p: 写入位置
+ * @param value: 数值
+ * @param min_digits: 最少位数，不足补0
+ * @return char*: 写入后的位置
+ */
+char *CAN_Format_Hex(char *p, uint32_t value, uint8_t min_digits);
+
+/**
+ * @brief 追加时间戳(等价于"%02lu:%02lu:%02lu.%03lu")
+ * @param p: 写入位置
+ * @param timestamp_ms: 时间(ms)
+ * @return char*: 写入后的位置
+ */
+char *CAN_Format_Timestamp(char *p, uint32_t timestamp_ms);
+
+/**
+ * @brief 追加报文主体" ID:0x..., Data:XX XX [END]\r\n"
+ * @param p: 写入位置
+ * @param id: 报文ID
+ * @param id_digits: ID最少十六进制位数
+ * @param data: 数据指针
+ * @param dlc: 数据长度(超过8按8处理)
+ * @param is_remote: 远程帧标志(数据区输出"RTR")
+ * @return char*: 写入后的位置
+ */
+char *CAN_Format_FrameBody(char *p, uint32_t id, uint8_t id_digits,
+                           const uint8_t *data, uint8_t dlc, bool is_remote);
+
+/**
+ * @brief 格式化完整报文日志行"<TAG> ID:0x%03X, Data:... [END]\r\n"
+ * @param buffer: 输出缓冲区(不小于CAN_FORMAT_LINE_MAX)
+ * @param tag: 日志标签，如"[TX]"
+ * @param id: 报文ID
+ * @param data: 数据指针
+ * @param dlc: 数据长度
+ * @param is_remote: 远程帧标志
+ * @return uint32_t: 输出长度(不含结尾'\0')
+ */
+uint32_t CAN_Format_Frame(char *buffer, const char *tag, uint32_t id,
+                          const uint8_t *data, uint8_t dlc, bool is_remote);
+
+/**
+ * @brief 格式化并输出一行报文日志(一次串口发送)
+ * @param tag: 日志标签
+ * @param id: 报文ID
+ * @param data: 数据指针
+ * @param dlc: 数据长度
+ * @param is_remote: 远程帧标志
+ */
+void CAN_Format_PrintFrame(const char *tag, uint32_t id,
+                           const uint8_t *data, uint8_t dlc, bool is_remote);
+
+/**
+ * @brief 输出已格式化的日志行(一次串口发送)
+ * @param buffer: 数据指针
+ * @param len: 长度
+ */
+void CAN_Format_Output(const char *buffer, uint32_t len);
+
+/**
+ * @brief 运行格式化基准测试(DLC 0~8及远程帧，各重复CAN_FORMAT_BENCH_ITERATIONS次)
+ * @param result: 测试结果指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ * @note  仅测量渲染耗时，不包含串口发送时间
+ */
+CAN_TestBox_Status_t CAN_Format_Benchmark(CAN_Format_Bench_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_TESTBOX_FORMAT_H */
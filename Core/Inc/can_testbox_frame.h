@@ -0,0 +1,184 @@
+/**
+ * @file can_testbox_frame.h
+ * @brief CAN测试盒内部紧凑帧打包/解包
+ * @version 1.0
+ * @date 2024
+ *
+ * CAN_TestBox_Message_t中ID、DLC、两个bool标志与时间戳之间存在填充，
+ * 每帧20字节。内部队列、环形缓冲区和周期表改用16字节的CAN_TestBox_Frame_t：
+ * - 第0字: ID(29位) + 远程帧标志 + 扩展帧标志
+ * - 第1字: DLC(4位) + 通道(2位) + 时间戳低26位(ms，约18.6小时回绕)
+ * - 第2~3字: 8字节数据，按字对齐
+ * 同样的RAM可多缓存约25%的帧，整帧复制为两组LDM/STM。
+ * 时间戳在解包时以当前系统时间为参考恢复为32位，
+ * 只要帧在缓冲区中停留不超过回绕周期即与原值一致。
+ */
+
+#ifndef __CAN_TESTBOX_FRAME_H
+#define __CAN_TESTBOX_FRAME_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can_testbox_api.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/* ========================= 位域定义 ========================= */
+
+#define CAN_FRAME_ID_MASK           0x1FFFFFFFU     // ID位
+#define CAN_FRAME_FLAG_RTR          (1UL << 30)     // 远程帧
+#define CAN_FRAME_FLAG_IDE          (1UL << 31)     // 扩展帧
+
+#define CAN_FRAME_DLC_MASK          0x0FU           // DLC位
+#define CAN_FRAME_CH_POS            4U              // 通道位置
+#define CAN_FRAME_CH_MASK           0x03U           // 通道位宽掩码
+#define CAN_FRAME_TS_POS            6U              // 时间戳位置
+#define CAN_FRAME_TS_MASK           0x03FFFFFFU     // 时间戳位宽掩码(26位)
+
+_Static_assert(sizeof(CAN_TestBox_Frame_t) == 16, "CAN_TestBox_Frame_t must be 16 bytes");
+_Static_assert(CAN_TESTBOX_CH_COUNT <= (CAN_FRAME_CH_MASK + 1U), "channel field too narrow");
+
+/* ========================= 打包/解包函数 ========================= */
+
+/**
+ * @brief 按字段打包紧凑帧
+ * @param frame: 输出帧
+ * @param id: 报文ID
+ * @param is_extended: 扩展帧标志
+ * @param is_remote: 远程帧标志
+ * @param dlc: 数据长度(0~8)
+ * @param data: 8字节数据
+ * @param channel: 通道(CAN_TestBox_ChannelId_t)
+ * @param timestamp_ms: 时间戳(ms)
+ */
+static inline void CAN_Frame_Pack(CAN_TestBox_Frame_t *frame, uint32_t id, bool is_extended, bool is_remote,
+                                  uint8_t dlc, const uint8_t *data, uint8_t channel, uint32_t timestamp_ms)
+{
+    frame->id_flags = (id & CAN_FRAME_ID_MASK) |
+                      (is_remote ? CAN_FRAME_FLAG_RTR : 0U) |
+                      (is_extended ? CAN_FRAME_FLAG_IDE : 0U);
+    frame->meta = ((uint32_t)dlc & CAN_FRAME_DLC_MASK) |
+                  (((uint32_t)channel & CAN_FRAME_CH_MASK) << CAN_FRAME_CH_POS) |
+                  ((timestamp_ms & CAN_FRAME_TS_MASK) << CAN_FRAME_TS_POS);
+    memcpy(frame->data, data, 8);
+}
+
+/**
+ * @brief 由接口消息打包紧凑帧
+ */
+static inline void CAN_Frame_FromMessage(CAN_TestBox_Frame_t *frame, const CAN_TestBox_Message_t *message)
+{
+    CAN_Frame_Pack(frame, message->id, message->is_extended, message->is_remote,
+                   message->dlc, message->data, message->channel, message->timestamp);
+}
+
+/**
+ * @brief 获取报文ID
+ */
+static inline uint32_t CAN_Frame_GetId(const CAN_TestBox_Frame_t *frame)
+{
+    return frame->id_flags & CAN_FRAME_ID_MASK;
+}
+
+/**
+ * @brief 是否为扩展帧
+ */
+static inline bool CAN_Frame_IsExtended(const CAN_TestBox_Frame_t *frame)
+{
+    return (frame->id_flags & CAN_FRAME_FLAG_IDE) != 0U;
+}
+
+/**
+ * @brief 是否为远程帧
+ */
+static inline bool CAN_Frame_IsRemote(const CAN_TestBox_Frame_t *frame)
+{
+    return (frame->id_flags & CAN_FRAME_FLAG_RTR) != 0U;
+}
+
+/**
+ * @brief 获取数据长度
+ */
+static inline uint8_t CAN_Frame_GetDlc(const CAN_TestBox_Frame_t *frame)
+{
+    return (uint8_t)(frame->meta & CAN_FRAME_DLC_MASK);
+}
+
+/**
+ * @brief 设置数据长度
+ */
+static inline void CAN_Frame_SetDlc(CAN_TestBox_Frame_t *frame, uint8_t dlc)
+{
+    frame->meta = (frame->meta & ~CAN_FRAME_DLC_MASK) | ((uint32_t)dlc & CAN_FRAME_DLC_MASK);
+}
+
+/**
+ * @brief 获取通道
+ */
+static inline uint8_t CAN_Frame_GetChannel(const CAN_TestBox_Frame_t *frame)
+{
+    return (uint8_t)((frame->meta >> CAN_FRAME_CH_POS) & CAN_FRAME_CH_MASK);
+}
+
+/**
+ * @brief 设置通道
+ */
+static inline void CAN_Frame_SetChannel(CAN_TestBox_Frame_t *frame, uint8_t channel)
+{
+    frame->meta = (frame->meta & ~(CAN_FRAME_CH_MASK << CAN_FRAME_CH_POS)) |
+                  (((uint32_t)channel & CAN_FRAME_CH_MASK) << CAN_FRAME_CH_POS);
+}
+
+/**
+ * @brief 恢复32位时间戳
+ * @param frame: 帧指针
+ * @param now_ms: 当前系统时间(ms)，须不早于帧时间戳
+ * @return uint32_t: 时间戳(ms)
+ */
+static inline uint32_t CAN_Frame_GetTimestamp(const CAN_TestBox_Frame_t *frame, uint32_t now_ms)
+{
+    uint32_t stamp = frame->meta >> CAN_FRAME_TS_POS;
+    return now_ms - ((now_ms - stamp) & CAN_FRAME_TS_MASK);
+}
+
+/**
+ * @brief 获取数据指针
+ */
+static inline uint8_t *CAN_Frame_Data(CAN_TestBox_Frame_t *frame)
+{
+    return (uint8_t *)frame->data;
+}
+
+/**
+ * @brief 获取只读数据指针
+ */
+static inline const uint8_t *CAN_Frame_ConstData(const CAN_TestBox_Frame_t *frame)
+{
+    return (const uint8_t *)frame->data;
+}
+
+/**
+ * @brief 解包为接口消息
+ * @param message: 输出消息
+ * @param frame: 紧凑帧
+ * @param now_ms: 当前系统时间(ms)，用于恢复时间戳
+ */
+static inline void CAN_Frame_ToMessage(CAN_TestBox_Message_t *message, const CAN_TestBox_Frame_t *frame, uint32_t now_ms)
+{
+    message->id = CAN_Frame_GetId(frame);
+    message->dlc = CAN_Frame_GetDlc(frame);
+    memcpy(message->data, frame->data, 8);
+    message->is_extended = CAN_Frame_IsExtended(frame);
+    message->is_remote = CAN_Frame_IsRemote(frame);
+    message->channel = CAN_Frame_GetChannel(frame);
+    message->timestamp = CAN_Frame_GetTimestamp(frame, now_ms);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_TESTBOX_FRAME_H */
@@ -0,0 +1,203 @@
+/**
+ * @file can_testbox_gateway.h
+ * @brief CAN1 <-> CAN2 网关转发模块
+ * @version 1.0
+ * @date 2024
+ *
+ * 本模块实现CAN1与CAN2之间基于路由表的报文转发：
+ * - 路由匹配: 源通道 + ID/掩码 + 帧类型，按表顺序首个匹配生效
+ * - ID重映射: 按掩码替换目标ID的部分位
+ * - 数据变换: 按字节与/异或掩码，或用户回调
+ * - 转发全程在接收中断内完成(RX ISR -> 目标邮箱/发送队列)，无任务切换
+ * - 每条路由独立统计，转发时延使用TIM2硬件时间戳测量
+ *
+ * 注意: 网关启动后CAN2切换为正常模式(可发送)，与CAN2静默监听互斥。上电时CAN2
+ * 不被任何一方占用，由串口帧命令启动网关或CAN2监听；网关停止后CAN2恢复静默
+ * 模式，启动前已运行的CAN2恢复运行
+ */
+
+#ifndef __CAN_TESTBOX_GATEWAY_H
+#define __CAN_TESTBOX_GATEWAY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can_testbox_api.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ========================= 配置宏定义 ========================= */
+
+#define CAN_GATEWAY_MAX_ROUTES          16    // 最大路由条目数
+#define CAN_GATEWAY_TX_QUEUE_SIZE       32    // 每个目标通道的软件发送队列深度
+#define CAN_GATEWAY_LATENCY_TARGET_US   50    // 转发时延目标(us)
+
+// 硬件过滤器分配: CAN1使用4~13号(0~2号被PEPS过滤器占用，3号为可靠链路)，CAN2使用14~27号
+#define CAN_GATEWAY_CAN1_FILTER_START   4
+#define CAN_GATEWAY_CAN2_FILTER_START   14
+#define CAN_GATEWAY_FILTERS_PER_PORT    10
+
+/* ========================= 控制操作定义 ========================= */
+
+#define CAN_GATEWAY_CTRL_STATUS         0x00  // 读取运行状态与路由位图
+#define CAN_GATEWAY_CTRL_ROUTE_ADD      0x01  // 添加路由(匹配、重映射、掩码变换)
+#define CAN_GATEWAY_CTRL_ROUTE_REMOVE   0x02  // 移除路由(索引)
+#define CAN_GATEWAY_CTRL_ROUTE_CLEAR    0x03  // 清空路由
+#define CAN_GATEWAY_CTRL_START          0x04  // 启动网关
+#define CAN_GATEWAY_CTRL_STOP           0x05  // 停止网关
+#define CAN_GATEWAY_CTRL_ROUTE_STATS    0x06  // 读取路由统计(索引)
+#define CAN_GATEWAY_CTRL_RESET_STATS    0x07  // 清空全部路由统计
+
+/* ========================= 数据结构定义 ========================= */
+
+/**
+ * @brief 网关端口
+ */
+typedef enum {
+    CAN_GATEWAY_PORT_CAN1 = 0,
+    CAN_GATEWAY_PORT_CAN2,
+    CAN_GATEWAY_PORT_COUNT
+} CAN_Gateway_Port_t;
+
+/**
+ * @brief 数据变换类型
+ */
+typedef enum {
+    CAN_GATEWAY_XFORM_NONE = 0,     // 不变换
+    CAN_GATEWAY_XFORM_MASK,         // data[i] = (data[i] & and_mask[i]) ^ xor_mask[i]
+    CAN_GATEWAY_XFORM_CALLBACK      // 用户回调(在中断中执行，必须短小)
+} CAN_Gateway_Transform_t;
+
+/**
+ * @brief 用户数据变换回调
+ * @param id: 目标ID(可修改)
+ * @param data: 数据(可修改)
+ * @param dlc: 数据长度(可修改，不超过8)
+ */
+typedef void (*CAN_Gateway_TransformFn_t)(uint32_t *id, uint8_t *data, uint8_t *dlc);
+
+/**
+ * @brief 路由配置结构体
+ */
+typedef struct {
+    CAN_Gateway_Port_t src_port;        // 源通道
+    CAN_Gateway_Port_t dst_port;        // 目标通道
+    uint32_t match_id;                  // 匹配ID
+    uint32_t match_mask;                // 匹配掩码(1=参与比较)
+    bool     is_extended;               // 匹配扩展帧/标准帧
+    bool     remap_enable;              // 是否重映射ID
+    uint32_t remap_id;                  // 重映射ID
+    uint32_t remap_mask;                // 重映射掩码(1=使用remap_id对应位)
+    CAN_Gateway_Transform_t transform;  // 数据变换类型
+    uint8_t  and_mask[8];               // 与掩码(XFORM_MASK)
+    uint8_t  xor_mask[8];               // 异或掩码(XFORM_MASK)
+    CAN_Gateway_TransformFn_t transform_fn; // 变换回调(XFORM_CALLBACK)
+} CAN_Gateway_Route_t;
+
+/**
+ * @brief 路由统计结构体
+ */
+typedef struct {
+    uint32_t matched_count;         // 匹配帧数
+    uint32_t forwarded_count;       // 成功装入邮箱帧数
+    uint32_t queued_count;          // 邮箱满时进入软件队列帧数
+    uint32_t dropped_count;         // 队列满丢弃帧数
+    uint32_t latency_min_us;        // 最小转发时延(us)
+    uint32_t latency_max_us;        // 最大转发时延(us)
+    uint32_t latency_last_us;       // 最近一次转发时延(us)
+    uint64_t latency_sum_us;        // 时延累计(us)，用于求平均
+    uint32_t latency_over_target;   // 超过CAN_GATEWAY_LATENCY_TARGET_US的帧数
+} CAN_Gateway_RouteStats_t;
+
+/* ========================= API接口声明 ========================= */
+
+/**
+ * @brief 初始化网关模块(清空路由表和统计，注册串口命令)
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Gateway_Init(void);
+
+/**
+ * @brief 添加路由
+ * @param route: 路由配置指针
+ * @param route_index: 返回的路由索引指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ * @note  网关运行中添加路由时会同步更新硬件过滤器
+ */
+CAN_TestBox_Status_t CAN_Gateway_AddRoute(const CAN_Gateway_Route_t *route, uint8_t *route_index);
+
+/**
+ * @brief 移除路由
+ * @param route_index: 路由索引
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Gateway_RemoveRoute(uint8_t route_index);
+
+/**
+ * @brief 清空所有路由
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Gateway_ClearRoutes(void);
+
+/**
+ * @brief 启动网关(CAN2切换为正常模式并启动，配置路由过滤器)
+ * @return CAN_TestBox_Status_t: 返回状态(CAN2监听中返回BUSY)
+ */
+CAN_TestBox_Status_t CAN_Gateway_Start(void);
+
+/**
+ * @brief 停止网关(CAN2恢复静默模式，启动前已运行时重新启动)
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Gateway_Stop(void);
+
+/**
+ * @brief 网关是否运行中
+ * @return bool: true-运行中
+ */
+bool CAN_Gateway_IsActive(void);
+
+/**
+ * @brief 获取路由统计
+ * @param route_index: 路由索引
+ * @param stats: 统计信息指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Gateway_GetRouteStats(uint8_t route_index, CAN_Gateway_RouteStats_t *stats);
+
+/**
+ * @brief 重置所有路由统计
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Gateway_ResetStats(void);
+
+/**
+ * @brief 通过串口打印所有路由统计
+ */
+void CAN_Gateway_PrintStats(void);
+
+/* ========================= 中断处理函数 ========================= */
+
+/**
+ * @brief 网关接收处理(在CAN接收中断中调用)
+ * @param hcan: CAN句柄指针
+ * @param rx_header: 接收消息头指针
+ * @param rx_data: 接收数据指针
+ * @param rx_timestamp_us: 进入接收中断时的硬件时间戳(us)
+ * @return bool: true-报文已被某条路由匹配
+ */
+bool CAN_Gateway_ProcessRx(CAN_HandleTypeDef *hcan, const CAN_RxHeaderTypeDef *rx_header,
+                           const uint8_t *rx_data, uint32_t rx_timestamp_us);
+
+/**
+ * @brief 网关发送邮箱空闲处理(在CAN发送完成/中止/错误回调中调用)
+ * @param hcan: CAN句柄指针
+ */
+void CAN_Gateway_ProcessTxComplete(CAN_HandleTypeDef *hcan);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_TESTBOX_GATEWAY_H */
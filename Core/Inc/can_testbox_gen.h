@@ -0,0 +1,176 @@
+/**
+ * @file can_testbox_gen.h
+ * @brief 周期/连续帧负载生成器(计数、三角波、正弦、伪随机、翻转、回放)
+ * @version 1.0
+ * @date 2024
+ *
+ * 周期报文原本只能发送固定负载，连续帧只有逐字节加1。本模块把若干信号
+ * 生成器组成"生成器组"，绑定到周期报文槽位或在连续帧中引用：
+ * - 信号按Intel(小端)位布局写入: 起始位0~63、位长1~32
+ * - 发送前按当前状态写入负载，发送成功后才推进状态，邮箱满重试时
+ *   重发相同的值；E2E保护在生成之后计算
+ * - 字节通道: 最多8个字节按各自步长同时递增，用Cortex-M4 SIMD
+ *   (__UADD8)一次处理4个字节，无DSP扩展时退化为SWAR位运算
+ * 同一生成器组绑定到多处时共享状态。
+ */
+
+#ifndef __CAN_TESTBOX_GEN_H
+#define __CAN_TESTBOX_GEN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can_testbox_api.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ========================= 配置宏定义 ========================= */
+
+#define CAN_GEN_SET_MAX             16    // 生成器组数(编号1~16，0表示不使用)
+#define CAN_GEN_SIGNALS_PER_SET     4     // 每组信号生成器数
+#define CAN_GEN_REPLAY_MAX          64    // 回放值池大小(u32)
+
+/* ========================= 生成器类型定义 ========================= */
+
+#define CAN_GEN_TYPE_NONE           0x00  // 未使用
+#define CAN_GEN_TYPE_COUNTER        0x01  // min起每帧加step，超过max回到min
+#define CAN_GEN_TYPE_RAMP           0x02  // 在min~max间以step往返(三角波)
+#define CAN_GEN_TYPE_SINE           0x03  // min + max*sin(相位)，step为每帧相位增量(1/65536周)
+#define CAN_GEN_TYPE_LFSR           0x04  // 32位Galois LFSR伪随机，step为种子(0取默认)
+#define CAN_GEN_TYPE_TOGGLE         0x05  // 在min与max间翻转，每值保持step帧(0按1)
+#define CAN_GEN_TYPE_REPLAY         0x06  // 依次回放值池[min, min+max)中的值
+
+/* ========================= 控制操作定义 ========================= */
+
+#define CAN_GEN_CTRL_SET_SIGNAL     0x00  // 配置组内信号生成器
+#define CAN_GEN_CTRL_SET_LANES      0x01  // 配置组内字节通道
+#define CAN_GEN_CTRL_CLEAR_SET      0x02  // 清空生成器组
+#define CAN_GEN_CTRL_BIND           0x03  // 周期报文绑定生成器组(0为解除)
+#define CAN_GEN_CTRL_REPLAY_WRITE   0x04  // 写入回放值池
+#define CAN_GEN_CTRL_RESET_STATE    0x05  // 生成器组状态回到初值
+#define CAN_GEN_CTRL_STATUS         0x06  // 读取执行统计
+
+/* ========================= 数据结构定义 ========================= */
+
+/**
+ * @brief 信号生成器配置
+ */
+typedef struct {
+    uint8_t type;                           // CAN_GEN_TYPE_xxx
+    uint8_t start_bit;                      // Intel起始位(0~63)
+    uint8_t length;                         // 位长(1~32)，起始位+位长不超过64
+    uint32_t min;                           // 下限/正弦偏置/回放起始下标
+    uint32_t max;                           // 上限/正弦幅值/回放个数
+    uint32_t step;                          // 步长/相位增量/种子/保持帧数
+} CAN_Gen_Signal_t;
+
+/**
+ * @brief 执行统计
+ */
+typedef struct {
+    uint32_t evaluations;                   // 生成次数
+    uint32_t advances;                      // 状态推进次数
+    uint32_t cycles_max;                    // 单次生成最大CPU周期
+    uint32_t cycles_avg;                    // 单次生成平均CPU周期
+} CAN_Gen_Stats_t;
+
+/* ========================= API接口声明 ========================= */
+
+/**
+ * @brief 初始化负载生成器(注册串口命令)
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Gen_Init(void);
+
+/**
+ * @brief 配置组内信号生成器(状态回到初值)
+ * @param set: 生成器组编号(1~CAN_GEN_SET_MAX)
+ * @param index: 组内序号(0~CAN_GEN_SIGNALS_PER_SET-1)
+ * @param signal: 生成器配置，type为CAN_GEN_TYPE_NONE时删除
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Gen_SetSignal(uint8_t set, uint8_t index, const CAN_Gen_Signal_t *signal);
+
+/**
+ * @brief 配置组内字节通道
+ * @param set: 生成器组编号
+ * @param mask: 参与的字节(位i对应字节i)
+ * @param init: 8字节初值
+ * @param step: 8字节步长(模256)
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Gen_SetLanes(uint8_t set, uint8_t mask, const uint8_t *init, const uint8_t *step);
+
+/**
+ * @brief 清空生成器组(已有绑定保持，但不再改写负载)
+ * @param set: 生成器组编号
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Gen_ClearSet(uint8_t set);
+
+/**
+ * @brief 生成器组状态回到初值
+ * @param set: 生成器组编号
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Gen_ResetState(uint8_t set);
+
+/**
+ * @brief 写入回放值池
+ * @param offset: 起始下标
+ * @param values: 值
+ * @param count: 个数
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Gen_WriteReplay(uint8_t offset, const uint32_t *values, uint8_t count);
+
+/**
+ * @brief 周期报文槽位绑定生成器组(停止周期报文时自动解除)
+ * @param ch: 通道编号
+ * @param handle: 周期报文句柄
+ * @param set: 生成器组编号，0为解除
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Gen_BindPeriodic(CAN_TestBox_ChannelId_t ch, uint8_t handle, uint8_t set);
+
+/**
+ * @brief 获取周期报文槽位绑定的生成器组
+ * @param ch: 通道编号
+ * @param handle: 周期报文句柄
+ * @return uint8_t: 生成器组编号，0表示未绑定
+ */
+uint8_t CAN_Gen_GetBinding(CAN_TestBox_ChannelId_t ch, uint8_t handle);
+
+/**
+ * @brief 按当前状态写入负载(不推进状态)
+ * @param set: 生成器组编号，0直接返回
+ * @param data: 8字节负载
+ */
+void CAN_Gen_Apply(uint8_t set, uint8_t *data);
+
+/**
+ * @brief 发送成功后推进生成器组状态
+ * @param set: 生成器组编号，0直接返回
+ */
+void CAN_Gen_Advance(uint8_t set);
+
+/**
+ * @brief 字节通道逐字节相加(模256)，4字节一组用SIMD处理
+ * @param data: 8字节负载(4字节对齐)
+ * @param step: 8字节步长(4字节对齐)
+ */
+void CAN_Gen_AddBytes(uint32_t *data, const uint32_t *step);
+
+/**
+ * @brief 获取执行统计
+ * @param stats: 统计指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Gen_GetStats(CAN_Gen_Stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_TESTBOX_GEN_H */
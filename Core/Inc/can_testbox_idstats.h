@@ -0,0 +1,132 @@
+/**
+ * @file can_testbox_idstats.h
+ * @brief CAN按ID实时统计表
+ * @version 1.0
+ * @date 2024
+ *
+ * 为CAN1/CAN2接收的每个ID分别维护一条统计记录(类似CANoe Statistics窗口)：
+ * - 帧计数、最近一帧数据与DLC
+ * - 帧间隔最小/平均/最大值及抖动(基于TIM2硬件时间戳，单位us)
+ *
+ * 存储结构(内存固定，无动态分配)：
+ * - CAN1标准帧: 2048项直接索引表，放在CCM RAM(占满64KB，无法再为CAN2复制一份)
+ * - CAN1扩展帧: 开放寻址哈希表(线性探测，探测次数有上限)，表满的ID计入溢出
+ * - CAN2: 标准帧与扩展帧共用一张开放寻址哈希表，表满的ID同样计入溢出
+ * 每张表只由对应通道的接收中断写入。
+ *
+ * 接收中断中的更新为固定步数；任务中读取快照无需停止接收，
+ * 读取时通过前后比较帧计数检测并重试被中断打断的拷贝。
+ */
+
+#ifndef __CAN_TESTBOX_IDSTATS_H
+#define __CAN_TESTBOX_IDSTATS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can_testbox_api.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ========================= 配置宏定义 ========================= */
+
+#define CAN_IDSTATS_STD_COUNT           2048  // 标准帧ID数量
+#define CAN_IDSTATS_EXT_SIZE            128   // 扩展帧哈希表容量(必须为2的幂)
+#define CAN_IDSTATS_CAN2_SIZE           128   // CAN2哈希表容量(必须为2的幂)
+#define CAN_IDSTATS_EXT_MAX_PROBE       8     // 扩展帧哈希最大探测次数
+#define CAN_IDSTATS_JITTER_SHIFT        3     // 抖动平滑系数(1/8)
+
+/* ========================= 数据结构定义 ========================= */
+
+/**
+ * @brief 单个ID统计快照
+ */
+typedef struct {
+    uint8_t  channel;               // 接收通道(CAN_TESTBOX_CH_CAN1/CAN_TESTBOX_CH_CAN2)
+    uint32_t id;                    // 报文ID
+    bool     is_extended;           // 扩展帧标志
+    bool     is_remote;             // 最近一帧是否为远程帧
+    uint8_t  dlc;                   // 最近一帧DLC
+    uint8_t  data[8];               // 最近一帧数据
+    uint32_t count;                 // 帧计数
+    uint32_t last_timestamp_us;     // 最近一帧时间戳(us)
+    uint32_t min_interval_us;       // 最小帧间隔(us)，不足两帧时为0
+    uint32_t avg_interval_us;       // 平均帧间隔(us)
+    uint32_t max_interval_us;       // 最大帧间隔(us)
+    uint32_t jitter_us;             // 帧间隔相对平均值的平滑偏差(us)
+} CAN_IdStats_Snapshot_t;
+
+/**
+ * @brief 统计表概要
+ */
+typedef struct {
+    uint32_t std_active_count;      // 有记录的标准帧ID数
+    uint32_t ext_active_count;      // 有记录的扩展帧ID数
+    uint32_t can2_active_count;     // 有记录的CAN2 ID数(标准帧与扩展帧)
+    uint32_t ext_overflow_count;    // 哈希表已满未记录的帧数(CAN1扩展帧与CAN2)
+    uint32_t total_frame_count;     // 记录的总帧数
+} CAN_IdStats_Summary_t;
+
+/**
+ * @brief 遍历回调
+ * @param snapshot: 单个ID统计快照
+ * @param context: 用户参数
+ */
+typedef void (*CAN_IdStats_Visitor_t)(const CAN_IdStats_Snapshot_t *snapshot, void *context);
+
+/* ========================= API接口声明 ========================= */
+
+/**
+ * @brief 初始化统计表并注册串口导出命令
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_IdStats_Init(void);
+
+/**
+ * @brief 获取单个ID统计快照
+ * @param ch: 接收通道(CAN_TESTBOX_CH_CAN1/CAN_TESTBOX_CH_CAN2)
+ * @param id: 报文ID
+ * @param is_extended: 扩展帧标志
+ * @param snapshot: 快照输出指针
+ * @return CAN_TestBox_Status_t: 返回状态(无记录返回NOT_FOUND)
+ */
+CAN_TestBox_Status_t CAN_IdStats_Get(CAN_TestBox_ChannelId_t ch, uint32_t id, bool is_extended, CAN_IdStats_Snapshot_t *snapshot);
+
+/**
+ * @brief 遍历所有有记录的ID(CAN1标准帧按ID升序，其后为CAN1扩展帧，最后为CAN2)
+ * @param visitor: 遍历回调
+ * @param context: 用户参数
+ * @return uint32_t: 遍历的ID数量
+ */
+uint32_t CAN_IdStats_ForEach(CAN_IdStats_Visitor_t visitor, void *context);
+
+/**
+ * @brief 获取统计表概要
+ * @param summary: 概要输出指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_IdStats_GetSummary(CAN_IdStats_Summary_t *summary);
+
+/**
+ * @brief 清空统计表
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_IdStats_Reset(void);
+
+/* ========================= 中断处理函数 ========================= */
+
+/**
+ * @brief 更新ID统计(在CAN接收中断中调用)
+ * @param ch: 接收通道(CAN_TESTBOX_CH_CAN1/CAN_TESTBOX_CH_CAN2)
+ * @param rx_header: 接收消息头指针
+ * @param rx_data: 接收数据指针
+ * @param rx_timestamp_us: 进入接收中断时的硬件时间戳(us)
+ */
+void CAN_IdStats_Update(CAN_TestBox_ChannelId_t ch, const CAN_RxHeaderTypeDef *rx_header, const uint8_t *rx_data, uint32_t rx_timestamp_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_TESTBOX_IDSTATS_H */
@@ -0,0 +1,137 @@
+/**
+ * @file can_testbox_latency.h
+ * @brief CAN测试盒接收链路时延直方图
+ * @version 1.0
+ * @date 2024
+ *
+ * 在接收中断入口记录DWT周期数，之后各探针按与入口的差值累计直方图：
+ * - FIFO读出: HAL_CAN_GetRxMessage返回后
+ * - 分发: 测试盒通道调用接收回调或放入接收队列前
+ * - 消费: CAN_TestBox_ReceiveMessage从接收队列取出后(入口时间随帧保存在
+ *   与接收队列同步的影子环中)
+ * 直方图按对数分桶，每2倍区间分2个桶(相对分辨率约41%)，覆盖1周期~25秒，
+ * 百分位取所在桶上界(不超过最大值)。bxCAN无硬件接收时间戳，以中断入口
+ * 近似报文到达时刻。外部控制器通道(MCP2515)不参与统计。
+ */
+
+#ifndef __CAN_TESTBOX_LATENCY_H
+#define __CAN_TESTBOX_LATENCY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can_testbox_api.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ========================= 配置宏定义 ========================= */
+
+#define CAN_LATENCY_BUCKETS         64    // 直方图桶数(32个2倍区间×2)
+
+/* ========================= 数据结构定义 ========================= */
+
+/**
+ * @brief 时延统计阶段(均从接收中断入口起算)
+ */
+typedef enum {
+    CAN_LATENCY_STAGE_FIFO_READ = 0,        // FIFO读出
+    CAN_LATENCY_STAGE_DISPATCH,             // 分发到回调/接收队列
+    CAN_LATENCY_STAGE_CONSUMER,             // 消费者出队
+    CAN_LATENCY_STAGE_COUNT
+} CAN_Latency_Stage_t;
+
+/**
+ * @brief 单阶段直方图
+ */
+typedef struct {
+    uint32_t count;                         // 样本数
+    uint32_t max_cycles;                    // 最大值(CPU周期)
+    uint32_t buckets[CAN_LATENCY_BUCKETS];  // 各桶计数
+} CAN_Latency_Hist_t;
+
+/**
+ * @brief 单阶段摘要
+ */
+typedef struct {
+    uint32_t count;                         // 样本数
+    uint32_t p50_ns;                        // 中位数(ns)
+    uint32_t p99_ns;                        // 99百分位(ns)
+    uint32_t max_ns;                        // 最大值(ns)
+} CAN_Latency_Summary_t;
+
+/* ========================= API接口声明 ========================= */
+
+/**
+ * @brief 初始化时延统计(注册串口命令)
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Latency_Init(void);
+
+/**
+ * @brief 接收中断入口(在CANx_RX0中断处理函数开头调用)
+ * @param ch: 通道编号(仅片内CAN)
+ */
+void CAN_Latency_IrqEntry(CAN_TestBox_ChannelId_t ch);
+
+/**
+ * @brief 接收中断出口(在CANx_RX0中断处理函数末尾调用)
+ * @param ch: 通道编号(仅片内CAN)
+ */
+void CAN_Latency_IrqExit(CAN_TestBox_ChannelId_t ch);
+
+/**
+ * @brief 获取当前接收中断的入口周期数
+ * @param ch: 通道编号
+ * @return uint32_t: 入口周期数，不在接收中断中返回0
+ */
+uint32_t CAN_Latency_GetEntry(CAN_TestBox_ChannelId_t ch);
+
+/**
+ * @brief 按入口周期数记录一个样本
+ * @param stage: 统计阶段
+ * @param entry_cycles: 入口周期数，为0时忽略
+ */
+void CAN_Latency_Record(CAN_Latency_Stage_t stage, uint32_t entry_cycles);
+
+/**
+ * @brief 在接收中断中记录当前阶段
+ * @param ch: 通道编号
+ * @param stage: 统计阶段
+ */
+void CAN_Latency_Mark(CAN_TestBox_ChannelId_t ch, CAN_Latency_Stage_t stage);
+
+/**
+ * @brief 获取阶段直方图
+ * @param stage: 统计阶段
+ * @param hist: 直方图指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Latency_GetHistogram(CAN_Latency_Stage_t stage, CAN_Latency_Hist_t *hist);
+
+/**
+ * @brief 获取全部阶段直方图，可在同一临界区内清空
+ * @param hist: 直方图数组(CAN_LATENCY_STAGE_COUNT个)
+ * @param clear: 是否清空，读取与清空之间不会丢失样本
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Latency_Snapshot(CAN_Latency_Hist_t *hist, bool clear);
+
+/**
+ * @brief 获取阶段摘要(p50/p99/max)
+ * @param stage: 统计阶段
+ * @param summary: 摘要指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Latency_GetSummary(CAN_Latency_Stage_t stage, CAN_Latency_Summary_t *summary);
+
+/**
+ * @brief 清空全部阶段直方图
+ */
+void CAN_Latency_Reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_TESTBOX_LATENCY_H */
@@ -0,0 +1,140 @@
+/**
+ * @file can_testbox_mcp2515.h
+ * @brief MCP2515外部CAN控制器驱动(中断 + SPI DMA)
+ * @version 1.0
+ * @date 2024
+ *
+ * 本模块将MCP2515作为测试盒的第三个CAN通道：
+ * - INT引脚下降沿触发EXTI中断，运行时无任务轮询SPI
+ * - 使用READ RX BUFFER / LOAD TX BUFFER快速指令，省去地址字节
+ * - 所有SPI事务通过DMA完成，由DMA完成中断驱动状态机推进
+ * - 3个发送缓冲区与2个接收缓冲区(RXB0溢出滚动至RXB1)同时在用
+ * - 独立的发送/接收队列与统计信息
+ *
+ * 硬件连接(SPI1):
+ * - SCK: PB3, MISO: PB4, MOSI: PB5
+ * - CS:  PA4 (软件片选)
+ * - INT: PB10 (低电平有效，EXTI10)
+ * - 晶振: 8MHz
+ */
+
+#ifndef __CAN_TESTBOX_MCP2515_H
+#define __CAN_TESTBOX_MCP2515_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can_testbox_api.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ========================= 配置宏定义 ========================= */
+
+// 引脚配置
+#define CAN_MCP2515_CS_PORT             GPIOA
+#define CAN_MCP2515_CS_PIN              GPIO_PIN_4
+#define CAN_MCP2515_INT_PORT            GPIOB
+#define CAN_MCP2515_INT_PIN             GPIO_PIN_10
+#define CAN_MCP2515_INT_IRQn            EXTI15_10_IRQn
+
+// SPI时钟: APB2 84MHz / 16 = 5.25MHz (MCP2515最高10MHz)
+#define CAN_MCP2515_SPI_PRESCALER       SPI_BAUDRATEPRESCALER_16
+
+// 位时序(8MHz晶振, 500kbps, 8TQ, 采样点62.5%)
+#define CAN_MCP2515_CNF1_500K           0x00
+#define CAN_MCP2515_CNF2_500K           0x90
+#define CAN_MCP2515_CNF3_500K           0x02
+
+// 队列配置
+#define CAN_MCP2515_TX_QUEUE_SIZE       40    // 发送队列深度(16字节紧凑帧)
+#define CAN_MCP2515_RX_QUEUE_SIZE       80    // 接收队列深度(16字节紧凑帧)
+
+/* ========================= 数据结构定义 ========================= */
+
+/**
+ * @brief MCP2515通道统计
+ */
+typedef struct {
+    CAN_TestBox_Statistics_t common;    // 与测试盒一致的通用统计
+    uint32_t int_count;                 // INT中断次数
+    uint32_t spi_transfer_count;        // SPI DMA事务数
+    uint32_t spi_error_count;           // SPI错误次数
+    uint32_t rx_overflow_count;         // 接收缓冲区溢出次数(EFLG.RXnOVR)
+    uint32_t rx_queue_full_count;       // 接收队列满丢弃帧数
+    uint32_t tx_queue_full_count;       // 发送队列满拒绝帧数
+    uint8_t  last_eflg;                 // 最近一次EFLG寄存器值
+} CAN_MCP2515_Stats_t;
+
+/* ========================= API接口声明 ========================= */
+
+/**
+ * @brief 初始化MCP2515通道
+ * @return CAN_TestBox_Status_t: 返回状态
+ * @note  在调度器启动前调用，初始化期间使用阻塞SPI配置寄存器，
+ *        完成后切换为中断+DMA运行
+ */
+CAN_TestBox_Status_t CAN_MCP2515_Init(void);
+
+/**
+ * @brief MCP2515通道是否已初始化
+ * @return bool: true-已初始化
+ */
+bool CAN_MCP2515_IsReady(void);
+
+/**
+ * @brief 发送报文(放入发送队列，由DMA状态机装入空闲发送缓冲区)
+ * @param message: 消息指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ * @note  可在任务和中断中调用
+ */
+CAN_TestBox_Status_t CAN_MCP2515_SendMessage(const CAN_TestBox_Message_t *message);
+
+/**
+ * @brief 从接收队列读取报文
+ * @param message: 消息指针
+ * @param timeout_ms: 超时时间(ms)
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_MCP2515_ReceiveMessage(CAN_TestBox_Message_t *message, uint32_t timeout_ms);
+
+/**
+ * @brief 设置接收回调函数(在中断中调用，设置后不再写入接收队列)
+ * @param callback: 回调函数指针，NULL表示使用接收队列
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_MCP2515_SetRxCallback(CAN_TestBox_RxCallback_t callback);
+
+/**
+ * @brief 获取通道统计
+ * @param stats: 统计信息指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_MCP2515_GetStatistics(CAN_MCP2515_Stats_t *stats);
+
+/**
+ * @brief 重置通道统计
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_MCP2515_ResetStatistics(void);
+
+/**
+ * @brief 将MCP2515注册为测试盒外部通道(CAN_TESTBOX_CH_EXT)
+ * @param channel: 输出通道句柄，可为NULL
+ * @return CAN_TestBox_Status_t: 返回状态
+ * @note  注册后接收报文经通道分发(通道接收队列/回调)，
+ *        CAN_MCP2515_SetRxCallback设置的回调将被替换
+ */
+CAN_TestBox_Status_t CAN_MCP2515_AttachChannel(CAN_TestBox_Channel_t *channel);
+
+/* ========================= 中断处理 ========================= */
+
+// SPI1 DMA句柄(DMA2 Stream0/Stream3 通道3)，供stm32f4xx_it.c中的中断入口使用
+extern DMA_HandleTypeDef hdma_spi1_rx;
+extern DMA_HandleTypeDef hdma_spi1_tx;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_TESTBOX_MCP2515_H */
@@ -0,0 +1,110 @@
+/**
+ * @file can_testbox_mem.h
+ * @brief CAN测试盒静态内存规划
+ * @version 1.0
+ * @date 2024
+ *
+ * 测试盒的任务、队列及大块缓冲区全部静态分配，不占用FreeRTOS堆：
+ * - 任务控制块/任务栈/队列控制块/队列存储区放入主SRAM中的RTOS对象池
+ *   (.rtos_pool，由链接脚本集中放置在.bss之后并导出_srtos_pool/_ertos_pool)
+ * - 大块统计缓冲区放入CCM RAM(.ccmbss)，CCM不可被DMA访问
+ * - 各对象大小全部由编译期配置决定，超出RAM/CCM容量时链接失败
+ * - 运行时可通过串口帧命令0x14读取内存报告，编译后可运行mem_report.bat
+ *   从elf中列出各段和池中对象的占用
+ */
+
+#ifndef __CAN_TESTBOX_MEM_H
+#define __CAN_TESTBOX_MEM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can_testbox_api.h"
+#include "cmsis_os.h"
+#include <stdint.h>
+
+/* ========================= 配置宏定义 ========================= */
+
+#define CAN_TESTBOX_TASK_STACK_WORDS            1024  // CAN测试盒任务栈(字)
+#define CAN_TESTBOX_DEFAULT_TASK_STACK_WORDS    128   // 默认任务栈(字)
+#define CAN_TESTBOX_SEQ_TASK_STACK_WORDS        384   // 测试序列任务栈(字)
+
+/* ========================= 段放置宏定义 ========================= */
+
+// 主SRAM中的RTOS对象池(不加载、不清零，由FreeRTOS在创建对象时初始化)
+#define CAN_TESTBOX_RTOS_POOL       __attribute__((section(".rtos_pool"), aligned(8)))
+
+// CCM RAM中的大块数据缓冲区(不清零，使用模块需在初始化时自行清零)
+#define CAN_TESTBOX_CCM_BSS         __attribute__((section(".ccmbss")))
+
+/**
+ * @brief 在RTOS对象池中定义任务控制块和任务栈
+ * @param var: 变量名前缀
+ * @param stack_words: 栈大小(字，必须为偶数以保证8字节对齐)
+ */
+#define CAN_TESTBOX_STATIC_TASK(var, stack_words) \
+    static StaticTask_t var##_tcb CAN_TESTBOX_RTOS_POOL; \
+    static uint64_t var##_stack[(stack_words) / 2U] CAN_TESTBOX_RTOS_POOL
+
+/**
+ * @brief 静态任务的osThreadAttr_t内存字段
+ */
+#define CAN_TESTBOX_STATIC_TASK_MEM(var) \
+    .cb_mem = &var##_tcb, .cb_size = sizeof(var##_tcb), \
+    .stack_mem = var##_stack, .stack_size = sizeof(var##_stack)
+
+/**
+ * @brief 在RTOS对象池中定义队列控制块和存储区
+ * @param var: 变量名前缀
+ * @param count: 队列深度
+ * @param item_size: 单项大小(字节)
+ */
+#define CAN_TESTBOX_STATIC_QUEUE(var, count, item_size) \
+    static StaticQueue_t var##_cb CAN_TESTBOX_RTOS_POOL; \
+    static uint8_t var##_storage[(count) * (item_size)] CAN_TESTBOX_RTOS_POOL
+
+/**
+ * @brief 静态队列的osMessageQueueAttr_t内存字段
+ */
+#define CAN_TESTBOX_STATIC_QUEUE_MEM(var) \
+    .cb_mem = &var##_cb, .cb_size = sizeof(var##_cb), \
+    .mq_mem = var##_storage, .mq_size = sizeof(var##_storage)
+
+/* ========================= 数据结构定义 ========================= */
+
+/**
+ * @brief 内存使用报告(字节)
+ */
+typedef struct {
+    uint32_t ram_total;             // 主SRAM容量
+    uint32_t ram_data;              // .data
+    uint32_t ram_bss;               // .bss(含FreeRTOS堆)
+    uint32_t rtos_pool;             // RTOS对象池
+    uint32_t ccm_total;             // CCM RAM容量
+    uint32_t ccm_used;              // CCM已用(.ccmram + .ccmbss)
+    uint32_t heap_total;            // FreeRTOS堆容量
+    uint32_t heap_free;             // FreeRTOS堆当前剩余
+    uint32_t heap_min_free;         // FreeRTOS堆历史最小剩余
+} CAN_Mem_Report_t;
+
+/* ========================= API接口声明 ========================= */
+
+/**
+ * @brief 初始化内存报告模块(注册串口命令)
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Mem_Init(void);
+
+/**
+ * @brief 获取内存使用报告
+ * @param report: 报告指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Mem_GetReport(CAN_Mem_Report_t *report);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_TESTBOX_MEM_H */
@@ -0,0 +1,204 @@
+/**
+ * @file can_testbox_monitor.h
+ * @brief CAN多通道监听与时间排序合并模块
+ * @version 1.0
+ * @date 2024
+ *
+ * 本模块将CAN1与CAN2作为两个独立的抓包通道：
+ * - CAN1: 复用测试盒已启动的CAN1接收中断
+ * - CAN2: 静默模式(只听不发)独立运行，可监听另一网段或经收发器回读本机发送报文
+ * - 每个通道独立的环形缓冲区、统计信息和软件过滤器
+ * - 所有报文使用TIM2硬件时间戳，合并器按时间顺序输出带通道标记的单一报文流
+ *
+ * 上电时不抓包，由串口帧命令启动各通道抓包、配置过滤器与串口输出。
+ * 注意: CAN2静默监听与网关转发互斥(网关需要CAN2工作在正常模式)
+ */
+
+#ifndef __CAN_TESTBOX_MONITOR_H
+#define __CAN_TESTBOX_MONITOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can_testbox_api.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ========================= 配置宏定义 ========================= */
+
+#define CAN_MONITOR_RING_SIZE           128   // 每通道环形缓冲区深度(必须为2的幂)
+#define CAN_MONITOR_MAX_FILTERS         8     // 每通道软件过滤器数量
+#define CAN_MONITOR_MERGE_HOLDOFF_US    1000  // 合并等待时间(us)，超过后不再等待其他通道
+#define CAN_MONITOR_PRINT_BATCH         16    // 每次处理最多输出的报文数
+#define CAN_MONITOR_CAN2_FILTER_BANK    27    // CAN2监听使用的硬件过滤器(全接收)
+
+/* ========================= 控制操作定义 ========================= */
+
+#define CAN_MONITOR_CTRL_STATUS         0x00  // 读取通道状态与统计(通道)
+#define CAN_MONITOR_CTRL_START          0x01  // 启动通道抓包(通道)
+#define CAN_MONITOR_CTRL_STOP           0x02  // 停止通道抓包(通道)
+#define CAN_MONITOR_CTRL_OUTPUT         0x03  // 合并报文流串口输出开关(使能)
+#define CAN_MONITOR_CTRL_FILTER_ADD     0x04  // 添加软件过滤器(通道、扩展帧、ID、掩码)
+#define CAN_MONITOR_CTRL_FILTER_CLEAR   0x05  // 清除软件过滤器(通道)
+#define CAN_MONITOR_CTRL_RESET_STATS    0x06  // 清空全部通道统计
+
+/* ========================= 数据结构定义 ========================= */
+
+/**
+ * @brief 监听通道
+ */
+typedef enum {
+    CAN_MONITOR_CH_CAN1 = 0,
+    CAN_MONITOR_CH_CAN2,
+    CAN_MONITOR_CH_COUNT
+} CAN_Monitor_Channel_t;
+
+/**
+ * @brief 报文标志位
+ */
+#define CAN_MONITOR_FLAG_EXT            0x01U // 扩展帧
+#define CAN_MONITOR_FLAG_RTR            0x02U // 远程帧
+
+/**
+ * @brief 抓包记录
+ */
+typedef struct {
+    uint32_t timestamp_us;          // 硬件时间戳(us)
+    uint32_t id;                    // 报文ID
+    uint8_t  channel;               // 通道(CAN_Monitor_Channel_t)
+    uint8_t  dlc;                   // 数据长度
+    uint8_t  flags;                 // CAN_MONITOR_FLAG_xxx
+    uint8_t  reserved;
+    uint8_t  data[8];               // 数据
+} CAN_Monitor_Record_t;
+
+/**
+ * @brief 软件过滤器
+ */
+typedef struct {
+    uint32_t id;                    // 匹配ID
+    uint32_t mask;                  // 匹配掩码(1=参与比较)
+    bool     is_extended;           // 扩展帧/标准帧
+} CAN_Monitor_Filter_t;
+
+/**
+ * @brief 通道统计
+ */
+typedef struct {
+    uint32_t rx_count;              // 收到帧数
+    uint32_t accepted_count;        // 通过过滤器帧数
+    uint32_t filtered_count;        // 被过滤帧数
+    uint32_t overflow_count;        // 缓冲区满丢弃帧数
+    uint32_t std_count;             // 标准帧数
+    uint32_t ext_count;             // 扩展帧数
+    uint32_t rtr_count;             // 远程帧数
+    uint32_t max_depth;             // 缓冲区最大深度
+    uint32_t last_timestamp_us;     // 最近一帧时间戳(us)
+} CAN_Monitor_Stats_t;
+
+/* ========================= API接口声明 ========================= */
+
+/**
+ * @brief 初始化监听模块(注册串口命令)
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Monitor_Init(void);
+
+/**
+ * @brief 启动通道监听
+ * @param channel: 通道
+ * @return CAN_TestBox_Status_t: 返回状态(CAN2在网关运行时返回BUSY)
+ */
+CAN_TestBox_Status_t CAN_Monitor_Start(CAN_Monitor_Channel_t channel);
+
+/**
+ * @brief 停止通道监听(CAN2在启动监听前已运行时保持运行)
+ * @param channel: 通道
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Monitor_Stop(CAN_Monitor_Channel_t channel);
+
+/**
+ * @brief 通道是否正在监听
+ * @param channel: 通道
+ * @return bool: true-监听中
+ */
+bool CAN_Monitor_IsActive(CAN_Monitor_Channel_t channel);
+
+/**
+ * @brief 添加通道软件过滤器(无过滤器时全部接收)
+ * @param channel: 通道
+ * @param filter: 过滤器配置指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Monitor_AddFilter(CAN_Monitor_Channel_t channel, const CAN_Monitor_Filter_t *filter);
+
+/**
+ * @brief 清除通道所有软件过滤器
+ * @param channel: 通道
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Monitor_ClearFilters(CAN_Monitor_Channel_t channel);
+
+/**
+ * @brief 读取单个通道的下一条记录
+ * @param channel: 通道
+ * @param record: 记录指针
+ * @return CAN_TestBox_Status_t: 返回状态(无数据返回QUEUE_EMPTY)
+ */
+CAN_TestBox_Status_t CAN_Monitor_ReadChannel(CAN_Monitor_Channel_t channel, CAN_Monitor_Record_t *record);
+
+/**
+ * @brief 按时间顺序读取合并报文流
+ * @param records: 记录数组
+ * @param max_count: 数组容量
+ * @return uint32_t: 实际读取条数
+ * @note  某通道缓冲区为空时，其他通道的记录需等待CAN_MONITOR_MERGE_HOLDOFF_US
+ *        后才会输出，以保证该通道迟到的更早报文不会乱序
+ */
+uint32_t CAN_Monitor_ReadMerged(CAN_Monitor_Record_t *records, uint32_t max_count);
+
+/**
+ * @brief 获取通道统计
+ * @param channel: 通道
+ * @param stats: 统计信息指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Monitor_GetStats(CAN_Monitor_Channel_t channel, CAN_Monitor_Stats_t *stats);
+
+/**
+ * @brief 重置所有通道统计
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Monitor_ResetStats(void);
+
+/**
+ * @brief 使能/禁用合并报文流的串口输出
+ * @param enable: true-使能
+ */
+void CAN_Monitor_SetOutput(bool enable);
+
+/**
+ * @brief 监听模块任务处理(在CAN测试盒任务中调用)
+ * @note  使能串口输出时按时间顺序打印合并报文流，抓到新记录时通知任务
+ */
+void CAN_Monitor_Process(void);
+
+/* ========================= 中断处理函数 ========================= */
+
+/**
+ * @brief 抓包接收处理(在CAN接收中断中调用)
+ * @param hcan: CAN句柄指针
+ * @param rx_header: 接收消息头指针
+ * @param rx_data: 接收数据指针
+ * @param rx_timestamp_us: 进入接收中断时的硬件时间戳(us)
+ */
+void CAN_Monitor_CaptureRx(CAN_HandleTypeDef *hcan, const CAN_RxHeaderTypeDef *rx_header,
+                           const uint8_t *rx_data, uint32_t rx_timestamp_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_TESTBOX_MONITOR_H */
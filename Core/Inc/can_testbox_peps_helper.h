@@ -63,6 +63,10 @@ extern "C" {
 #define PEPS_CMD_KEY_POS_FULL_TEST  0xF3  // 钥匙位置完整数据
 #define PEPS_CMD_BSI_FULL_TEST      0xF4  // BSI完整测试数据
 
+// 场景指令 (0xF5-0xF6)
+#define PEPS_CMD_SCENARIO_KEY_CYCLE 0xF5  // 钥匙插拔场景
+#define PEPS_CMD_SCENARIO_WAKEUP    0xF6  // 唤醒场景
+
 // 系统控制指令 (0xFF-0x00)
 #define PEPS_CMD_STOP_ALL           0xFF  // 停止所有周期报文
 #define PEPS_CMD_SYSTEM_RESET       0x00  // 系统复位
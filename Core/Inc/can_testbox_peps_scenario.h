@@ -0,0 +1,155 @@
+/**
+ * @file can_testbox_peps_scenario.h
+ * @brief PEPS场景状态机(表驱动，硬件定时切换)
+ * @version 1.0
+ * @date 2024
+ *
+ * 单字节指令只能静态地开/关0x05B、0x401、0x442、0x036，钥匙插拔、唤醒等
+ * 完整流程需要按时间依次改变这几帧的内容。本模块将流程描述为状态表：
+ * - 每个状态有进入/退出报文集合(启动或更新某路周期报文的数据、停止某路报文)
+ * - 停留时间到期后转移到下一状态，到期时刻由TIM2比较通道1闹钟产生，
+ *   以计划时刻而非处理时刻为下一状态计时基准，误差不累积
+ * - 状态可等待接收某个标准帧ID(如0x05A)后转移
+ * 场景由串口帧命令0x1B或单字节指令0xF5/0xF6启动，状态转移在CAN测试盒
+ * 任务中执行。新增场景只需在场景表中添加状态表。
+ */
+
+#ifndef __CAN_TESTBOX_PEPS_SCENARIO_H
+#define __CAN_TESTBOX_PEPS_SCENARIO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can_testbox_api.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ========================= 配置宏定义 ========================= */
+
+#define PEPS_SCN_STATE_END          0xFFU     // 转移目标: 场景结束
+#define PEPS_SCN_RX_NONE            0xFFFFU   // 不等待接收报文
+
+/* ========================= 场景编号 ========================= */
+
+#define PEPS_SCN_KEY_CYCLE          0x00      // 钥匙插入->在位->拔出->不在位
+#define PEPS_SCN_WAKEUP             0x01      // 等待0x05A唤醒->SCW唤醒->钥匙在位->休眠
+#define PEPS_SCN_COUNT              0x02
+
+/* ========================= 控制操作定义 ========================= */
+
+#define PEPS_SCN_CTRL_START         0x00      // 启动场景(后跟场景编号)
+#define PEPS_SCN_CTRL_STOP          0x01      // 中止场景
+#define PEPS_SCN_CTRL_STATUS        0x02      // 读取运行状态
+
+/* ========================= 数据结构定义 ========================= */
+
+/**
+ * @brief 场景使用的周期报文槽位
+ */
+typedef enum {
+    PEPS_SCN_SLOT_SCW1 = 0,                 // 0x05B, 200ms
+    PEPS_SCN_SLOT_SCW2,                     // 0x401, 500ms
+    PEPS_SCN_SLOT_KEY_POS,                  // 0x442, 100ms
+    PEPS_SCN_SLOT_BSI,                      // 0x036, 100ms
+    PEPS_SCN_SLOT_COUNT
+} PEPS_Scenario_Slot_t;
+
+/**
+ * @brief 报文动作
+ */
+typedef enum {
+    PEPS_SCN_ACT_SEND = 0,                  // 启动周期发送，已在发送时只更新数据(保持相位)
+    PEPS_SCN_ACT_STOP                       // 停止周期发送
+} PEPS_Scenario_Action_t;
+
+/**
+ * @brief 进入/退出报文集合中的一项
+ */
+typedef struct {
+    uint8_t slot;                           // PEPS_Scenario_Slot_t
+    uint8_t action;                         // PEPS_Scenario_Action_t
+    uint8_t data[8];                        // 发送数据
+} PEPS_Scenario_Frame_t;
+
+/**
+ * @brief 场景状态
+ */
+typedef struct {
+    const char *name;                       // 状态名(日志输出)
+    const PEPS_Scenario_Frame_t *entry;     // 进入报文集合
+    uint8_t entry_count;
+    const PEPS_Scenario_Frame_t *exit;      // 退出报文集合
+    uint8_t exit_count;
+    uint16_t dwell_ms;                      // 停留时间，0表示不定时转移
+    uint8_t timeout_next;                   // 停留到期后的下一状态
+    uint16_t rx_id;                         // 等待的标准帧ID，PEPS_SCN_RX_NONE表示不等待
+    uint8_t rx_next;                        // 收到等待报文后的下一状态
+} PEPS_Scenario_State_t;
+
+/**
+ * @brief 场景定义(从第0个状态开始)
+ */
+typedef struct {
+    const char *name;
+    const PEPS_Scenario_State_t *states;
+    uint8_t state_count;
+} PEPS_Scenario_Def_t;
+
+/**
+ * @brief 场景运行状态
+ */
+typedef struct {
+    uint32_t running;                       // 是否运行中
+    uint32_t scenario;                      // 当前/最近场景编号
+    uint32_t state;                         // 当前状态编号(结束后为PEPS_SCN_STATE_END)
+    uint32_t transitions;                   // 已执行的状态转移次数
+    uint32_t elapsed_us;                    // 自场景开始的时间(结束后为总时长)
+    uint32_t late_max_us;                   // 转移执行相对计划时刻的最大延迟
+} PEPS_Scenario_Status_t;
+
+/* ========================= API接口声明 ========================= */
+
+/**
+ * @brief 初始化PEPS场景状态机(注册串口命令)
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t PEPS_Scenario_Init(void);
+
+/**
+ * @brief 请求启动场景(正在运行的场景先中止)
+ * @param scenario: 场景编号
+ * @return CAN_TestBox_Status_t: 返回状态
+ * @note  可在中断中调用，实际启动在CAN测试盒任务中执行
+ */
+CAN_TestBox_Status_t PEPS_Scenario_Start(uint8_t scenario);
+
+/**
+ * @brief 请求中止场景并停止场景启动的全部周期报文
+ * @note  可在中断中调用
+ */
+void PEPS_Scenario_Stop(void);
+
+/**
+ * @brief 获取运行状态
+ * @param status: 状态指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t PEPS_Scenario_GetStatus(PEPS_Scenario_Status_t *status);
+
+/**
+ * @brief 报文输入(在CAN接收路径中调用，可在中断中调用)
+ * @param frame: 接收帧
+ */
+void PEPS_Scenario_InputFrame(const CAN_TestBox_Frame_t *frame);
+
+/**
+ * @brief 执行到期的状态转移(在CAN测试盒任务中调用)
+ */
+void PEPS_Scenario_Process(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_TESTBOX_PEPS_SCENARIO_H */
@@ -0,0 +1,95 @@
+/**
+ * @file can_testbox_power.h
+ * @brief CAN测试盒低功耗空闲(tickless idle)
+ * @version 1.0
+ * @date 2024
+ *
+ * FreeRTOS开启configUSE_TICKLESS_IDLE后，空闲时停止SysTick并以WFI睡眠，
+ * 直到下一个任务到期(测试盒任务按下一个周期报文到期时刻等待)、CAN接收中断
+ * 或串口字节到达。HAL时基使用TIM1独立产生1ms中断，若不处理会每1ms唤醒一次：
+ * - 睡眠前关闭TIM1更新中断，记录TIM1计数相位和TIM2微秒时间戳
+ * - 唤醒后按TIM2经过的时间补偿睡眠期间错过的TIM1更新次数，再恢复中断，
+ *   HAL_GetTick()与不睡眠时保持一致，TIM1相位不变
+ * - 仅使用睡眠模式(WFI)，TIM2时间戳、CAN、串口和DMA在睡眠中保持运行
+ * 运行时可关闭tickless对比周期报文发送抖动(串口帧命令0x16)。
+ */
+
+#ifndef __CAN_TESTBOX_POWER_H
+#define __CAN_TESTBOX_POWER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can_testbox_api.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ========================= 数据结构定义 ========================= */
+
+/**
+ * @brief 低功耗与周期抖动报告
+ */
+typedef struct {
+    uint32_t tickless_enabled;      // 1-tickless已使能
+    uint32_t sleep_count;           // 睡眠次数
+    uint32_t sleep_total_us;        // 累计睡眠时间(us)
+    uint32_t sleep_max_us;          // 单次最长睡眠(us)
+    uint32_t tick_compensated;      // 睡眠期间补偿的HAL tick数
+    uint32_t measure_ms;            // 统计时长(ms)
+    uint32_t jitter_samples;        // 周期报文抖动样本数
+    uint32_t jitter_avg_us;         // 平均偏差(us)
+    uint32_t jitter_max_us;         // 最大偏差(us)
+} CAN_Power_Report_t;
+
+/* ========================= API接口声明 ========================= */
+
+/**
+ * @brief 初始化低功耗模块(注册串口命令)
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Power_Init(void);
+
+/**
+ * @brief 使能/禁用tickless空闲
+ * @param enable: true-空闲时停止tick睡眠, false-保持1kHz tick
+ */
+void CAN_Power_SetTickless(bool enable);
+
+/**
+ * @brief 获取低功耗与周期抖动报告
+ * @param report: 报告指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Power_GetReport(CAN_Power_Report_t *report);
+
+/**
+ * @brief 清空睡眠统计与周期抖动统计
+ */
+void CAN_Power_ResetStats(void);
+
+/* ========================= FreeRTOS钩子 ========================= */
+
+/**
+ * @brief 空闲任务停止tick睡眠(portSUPPRESS_TICKS_AND_SLEEP)
+ * @param expected_idle_ticks: 预计空闲tick数
+ */
+void CAN_Power_SuppressTicksAndSleep(uint32_t expected_idle_ticks);
+
+/**
+ * @brief 睡眠前处理(configPRE_SLEEP_PROCESSING，关中断状态下调用)
+ * @param idle_ticks: 预计空闲tick数，置0则跳过WFI
+ */
+void CAN_Power_PreSleep(uint32_t *idle_ticks);
+
+/**
+ * @brief 唤醒后处理(configPOST_SLEEP_PROCESSING，关中断状态下调用)
+ * @param idle_ticks: 预计空闲tick数
+ */
+void CAN_Power_PostSleep(uint32_t *idle_ticks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_TESTBOX_POWER_H */
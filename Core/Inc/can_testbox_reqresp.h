@@ -0,0 +1,209 @@
+/**
+ * @file can_testbox_reqresp.h
+ * @brief CAN测试盒请求/应答匹配与往返时延统计
+ * @version 1.0
+ * @date 2024
+ *
+ * 发送请求前登记期望的应答(通道、ID/掩码、负载判定函数、超时)，接收中断
+ * 直接在待决表中查找并以中断入口时间戳计算往返时延(RTT，us)：
+ * - 待决表按应答ID散列，掩码覆盖全部ID位的期望放入散列桶，部分掩码的
+ *   期望放入通配链表，接收时只比较同桶与通配链表中的项
+ * - 同一ID的多个期望按登记顺序匹配，可用判定函数按负载区分
+ * - 匹配与超时结果在CAN测试盒任务中回调，回调不在中断中执行
+ * - 按请求类型累计请求数、应答数、超时数与RTT对数直方图(每2倍一个桶)
+ * 登记时给出请求报文(通道、ID)的期望，由发送仲裁的确认回调在请求发送完成时
+ * 记录起点，RTT不含测试盒自身的发送排队与邮箱等待；未给出请求或经外部控制器
+ * 发送时从登记时刻起算。超时始终从登记时刻起算。
+ */
+
+#ifndef __CAN_TESTBOX_REQRESP_H
+#define __CAN_TESTBOX_REQRESP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can_testbox_api.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ========================= 配置宏定义 ========================= */
+
+#define CAN_REQRESP_PENDING_MAX     16    // 同时待决的请求数
+#define CAN_REQRESP_HASH_SIZE       16    // 散列桶数(2的幂)
+#define CAN_REQRESP_TYPE_MAX        8     // 请求类型数
+#define CAN_REQRESP_BUCKETS         32    // RTT直方图桶数
+
+#define CAN_REQRESP_CH_ANY          0xFFU       // 匹配任意通道
+#define CAN_REQRESP_MASK_EXACT      0xFFFFFFFFU // ID全部位参与比较
+#define CAN_REQRESP_INVALID_HANDLE  0xFFU
+
+/* ========================= 数据结构定义 ========================= */
+
+/**
+ * @brief 请求结果
+ */
+typedef enum {
+    CAN_REQRESP_RESULT_MATCHED = 0,         // 收到匹配应答
+    CAN_REQRESP_RESULT_TIMEOUT,             // 超时
+    CAN_REQRESP_RESULT_CANCELLED            // 已取消(不回调)
+} CAN_ReqResp_Result_t;
+
+/**
+ * @brief 应答负载判定函数(在接收中断中调用，须简短)
+ * @param data: 应答数据
+ * @param dlc: 数据长度
+ * @param context: 登记时的上下文
+ * @return bool: true表示是期望的应答
+ */
+typedef bool (*CAN_ReqResp_Predicate_t)(const uint8_t *data, uint8_t dlc, void *context);
+
+/**
+ * @brief 结果回调(在CAN测试盒任务中调用)
+ * @param handle: 请求句柄
+ * @param result: 请求结果
+ * @param rtt_us: 往返时延(us)，超时时为等待时长
+ * @param data: 应答数据，超时时为NULL
+ * @param dlc: 应答数据长度
+ * @param context: 登记时的上下文
+ */
+typedef void (*CAN_ReqResp_Callback_t)(uint8_t handle, CAN_ReqResp_Result_t result, uint32_t rtt_us,
+                                       const uint8_t *data, uint8_t dlc, void *context);
+
+/**
+ * @brief 期望的应答
+ */
+typedef struct {
+    uint8_t channel;                        // 应答通道，CAN_REQRESP_CH_ANY匹配任意通道
+    uint8_t type;                           // 请求类型(RTT按类型统计)
+    bool is_extended;                       // 应答是否为扩展帧
+    uint32_t id;                            // 应答ID
+    uint32_t mask;                          // ID掩码，CAN_REQRESP_MASK_EXACT为精确匹配
+    uint32_t timeout_ms;                    // 超时时间(ms)
+    CAN_ReqResp_Predicate_t predicate;      // 负载判定，NULL表示不判定
+    CAN_ReqResp_Callback_t callback;        // 结果回调，可为NULL
+    void *context;                          // 判定与回调上下文
+    bool has_request;                       // true: RTT从下列请求报文的发送完成时刻起算
+    uint8_t request_channel;                // 请求发送通道(片内CAN)
+    bool request_extended;                  // 请求是否为扩展帧
+    uint32_t request_id;                    // 请求ID
+} CAN_ReqResp_Expect_t;
+
+/**
+ * @brief 单个请求类型的统计
+ */
+typedef struct {
+    uint32_t requests;                      // 请求数
+    uint32_t matched;                       // 收到应答数
+    uint32_t timeouts;                      // 超时数
+    uint32_t rtt_min_us;                    // 最小RTT
+    uint32_t rtt_max_us;                    // 最大RTT
+    uint64_t rtt_sum_us;                    // RTT累计
+    uint32_t buckets[CAN_REQRESP_BUCKETS];  // RTT直方图: 桶0为0us，桶i为[2^(i-1), 2^i)us
+} CAN_ReqResp_TypeStats_t;
+
+/**
+ * @brief 单个请求类型的摘要
+ */
+typedef struct {
+    uint32_t requests;                      // 请求数
+    uint32_t matched;                       // 收到应答数
+    uint32_t timeouts;                      // 超时数
+    uint32_t rtt_min_us;                    // 最小RTT
+    uint32_t rtt_avg_us;                    // 平均RTT
+    uint32_t rtt_p50_us;                    // 中位数(所在桶上界)
+    uint32_t rtt_p99_us;                    // 99百分位(所在桶上界)
+    uint32_t rtt_max_us;                    // 最大RTT
+} CAN_ReqResp_Summary_t;
+
+/* ========================= API接口声明 ========================= */
+
+/**
+ * @brief 初始化请求/应答匹配(注册串口命令)
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_ReqResp_Init(void);
+
+/**
+ * @brief 登记期望的应答并开始计时(由调用者随后自行发送请求)
+ * @param expect: 期望的应答
+ * @param handle: 返回的请求句柄，可为NULL
+ * @return CAN_TestBox_Status_t: 返回状态，待决表满返回CAN_TESTBOX_QUEUE_FULL
+ */
+CAN_TestBox_Status_t CAN_ReqResp_Arm(const CAN_ReqResp_Expect_t *expect, uint8_t *handle);
+
+/**
+ * @brief 登记期望的应答并通过测试盒通道发送请求
+ * @param channel: 发送通道
+ * @param request: 请求报文
+ * @param expect: 期望的应答
+ * @param handle: 返回的请求句柄，可为NULL
+ * @return CAN_TestBox_Status_t: 返回状态，发送失败时已撤销登记
+ */
+CAN_TestBox_Status_t CAN_ReqResp_SendAndAwait(CAN_TestBox_Channel_t channel, const CAN_TestBox_Message_t *request,
+                                              const CAN_ReqResp_Expect_t *expect, uint8_t *handle);
+
+/**
+ * @brief 取消待决请求(不回调；仍在等待的请求不计入请求数)
+ * @param handle: 请求句柄
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_ReqResp_Cancel(uint8_t handle);
+
+/**
+ * @brief 接收报文匹配(在CAN接收中断中调用)
+ * @param ch: 接收通道
+ * @param header: 接收报文头
+ * @param data: 接收数据
+ * @param rx_timestamp_us: 接收中断入口时间戳
+ * @return bool: 是否匹配了待决请求
+ */
+bool CAN_ReqResp_ProcessRx(CAN_TestBox_ChannelId_t ch, const CAN_RxHeaderTypeDef *header,
+                           const uint8_t *data, uint32_t rx_timestamp_us);
+
+/**
+ * @brief 请求发送完成(发送仲裁的确认回调，在中断中调用)
+ * @note  按登记顺序把发送完成时间戳记为同通道、同ID且尚未发出的最早请求的RTT起点
+ */
+void CAN_ReqResp_ProcessTxConfirm(CAN_TestBox_ChannelId_t ch, uint8_t tx_class, uint8_t tag,
+                                  const CAN_TestBox_Frame_t *frame, uint32_t enqueue_us,
+                                  uint32_t done_us, bool sent);
+
+/**
+ * @brief 分发匹配结果并处理超时(在CAN测试盒任务中调用)
+ */
+void CAN_ReqResp_Process(void);
+
+/**
+ * @brief 计算距最近一个超时的等待时间
+ * @param max_ms: 上限
+ * @return uint32_t: 等待时间(ms)
+ */
+uint32_t CAN_ReqResp_GetIdleTime(uint32_t max_ms);
+
+/**
+ * @brief 获取请求类型统计
+ * @param type: 请求类型
+ * @param stats: 统计指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_ReqResp_GetStats(uint8_t type, CAN_ReqResp_TypeStats_t *stats);
+
+/**
+ * @brief 获取请求类型摘要
+ * @param type: 请求类型
+ * @param summary: 摘要指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_ReqResp_GetSummary(uint8_t type, CAN_ReqResp_Summary_t *summary);
+
+/**
+ * @brief 清空全部类型统计(不影响待决请求)
+ */
+void CAN_ReqResp_ResetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_TESTBOX_REQRESP_H */
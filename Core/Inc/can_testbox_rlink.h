@@ -0,0 +1,180 @@
+/**
+ * @file can_testbox_rlink.h
+ * @brief 双节点可靠链路(序号、滑动窗口、累计/选择确认、超时重传)
+ * @version 1.0
+ * @date 2024
+ *
+ * 原有双节点报文每帧在接收中断中同步回一帧ACK，ACK不携带序号，发送方
+ * 无法知道哪些报文仍未确认，实际上是停等方式。本模块在CAN1上提供独立的
+ * 可靠数据通道：
+ * - 数据帧: 字节0为序号(模256)，其后最多7字节负载
+ * - 确认帧: 字节0为累计确认(期望的下一个序号)，字节1~4为其后32个序号的
+ *   选择确认位图(小端，位i对应序号 累计确认+1+i)，字节5为接收方通告窗口
+ * - 发送窗口可配置(1~32)，实际窗口取配置窗口与对端通告窗口的较小值
+ * - 按平滑RTT计算重传超时(RTO)，超时未确认的报文重传并退避RTO；
+ *   选择确认显示其后已有CAN_RLINK_DUP_THRESH帧到达的空洞立即快速重传
+ * - 接收端乱序缓存并按序交付，连续CAN_RLINK_ACK_EVERY帧合并一次确认，
+ *   乱序、重复或缓存不足时立即确认
+ * - 对端重启后序号从0重新开始：同步状态下序号不会落在接收窗口之外且距已
+ *   交付序号超过CAN_RLINK_WINDOW_MAX，累计确认也不会超出在途范围；连续
+ *   CAN_RLINK_RESYNC_THRESH帧出现这种不可能的序号/确认时，接收端以该帧序号
+ *   为新起点，发送端把未确认与排队数据按对端期望的序号重新编号并全部重发
+ * 发送直接装入邮箱，不逐帧打印日志，且至少保留一个邮箱给其他报文。
+ * 确认帧ID小于数据帧ID，总线仲裁时优先。原有报文类型仍使用停等ACK。
+ */
+
+#ifndef __CAN_TESTBOX_RLINK_H
+#define __CAN_TESTBOX_RLINK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can_testbox_api.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ========================= 报文ID定义 ========================= */
+
+#define CAN_RLINK_TX_ACK_ID         0x180     // 本节点发出的确认帧
+#define CAN_RLINK_TX_DATA_ID        0x181     // 本节点发出的数据帧
+#define CAN_RLINK_RX_ACK_ID         0x190     // 对端(WCMCU-230)发出的确认帧
+#define CAN_RLINK_RX_DATA_ID        0x191     // 对端(WCMCU-230)发出的数据帧
+
+/* ========================= 配置宏定义 ========================= */
+
+#define CAN_RLINK_PAYLOAD_MAX       7         // 每帧负载字节数
+#define CAN_RLINK_TX_RING           64        // 发送环(排队+在途)，2的幂且不超过128
+#define CAN_RLINK_RX_QUEUE          64        // 已按序交付、待应用读取的帧数
+#define CAN_RLINK_WINDOW_MAX        32        // 最大窗口(受选择确认位图宽度限制)
+#define CAN_RLINK_WINDOW_DEFAULT    16        // 默认发送窗口
+#define CAN_RLINK_ACK_EVERY         4         // 按序到达时每N帧确认一次
+#define CAN_RLINK_DUP_THRESH        3         // 空洞之后已确认N帧时快速重传
+#define CAN_RLINK_TX_MAILBOX_RESERVE 1        // 数据帧至少保留的空闲邮箱数
+#define CAN_RLINK_RESYNC_THRESH     4         // 连续N帧序号/确认不可能出现时自动重同步
+
+#define CAN_RLINK_RTO_INIT_US       20000U    // 初始重传超时
+#define CAN_RLINK_RTO_MIN_US        2000U     // 重传超时下限
+#define CAN_RLINK_RTO_MAX_US        200000U   // 重传超时上限(含退避)
+
+/* ========================= 控制操作定义 ========================= */
+
+#define CAN_RLINK_CTRL_STATUS       0x00      // 读取窗口与重传统计
+#define CAN_RLINK_CTRL_CONFIG       0x01      // 配置窗口(u8)与接收丢弃模式(u8)
+#define CAN_RLINK_CTRL_CLEAR        0x02      // 清空统计
+#define CAN_RLINK_CTRL_BULK         0x03      // 连续发送N帧测试数据(u32，0为停止)
+#define CAN_RLINK_CTRL_RESET        0x04      // 复位双向序号(对端须同时复位)
+
+/* ========================= 数据结构定义 ========================= */
+
+/**
+ * @brief 可靠链路统计
+ */
+typedef struct {
+    uint32_t window;                        // 配置的发送窗口
+    uint32_t peer_window;                   // 对端最近通告的接收窗口
+    uint32_t in_flight;                     // 当前在途(已发送未确认)帧数
+    uint32_t in_flight_max;                 // 在途帧数峰值
+    uint32_t in_flight_avg_x100;            // 每次新发送时在途帧数的平均值(x100)
+    uint32_t queued;                        // 排队未发送帧数
+    uint32_t tx_frames;                     // 首次发送帧数
+    uint32_t acked_frames;                  // 已确认帧数
+    uint32_t acked_bytes;                   // 已确认负载字节数
+    uint32_t retransmits;                   // 重传帧数(含快速重传)
+    uint32_t fast_retransmits;              // 快速重传帧数
+    uint32_t rto_expiries;                  // 超时到期帧数
+    uint32_t srtt_us;                       // 平滑往返时延
+    uint32_t rto_us;                        // 当前重传超时
+    uint32_t acks_sent;                     // 发出确认帧数
+    uint32_t acks_received;                 // 收到确认帧数
+    uint32_t rx_delivered;                  // 按序交付帧数
+    uint32_t rx_out_of_order;               // 乱序到达(已缓存)帧数
+    uint32_t rx_duplicates;                 // 重复到达帧数
+    uint32_t rx_missing;                    // 接收端发现的序号空洞(丢失)数
+    uint32_t rx_dropped;                    // 超出接收窗口而丢弃的帧数
+    uint32_t rx_queue_depth;                // 待应用读取的帧数
+    uint32_t bulk_remaining;                // 测试数据剩余帧数
+    uint32_t elapsed_ms;                    // 自统计清空以来的时间
+    uint32_t rx_resyncs;                    // 接收端按对端新序号自动重同步次数
+    uint32_t tx_resyncs;                    // 发送端按对端累计确认自动重新编号次数
+} CAN_RLink_Stats_t;
+
+/* ========================= API接口声明 ========================= */
+
+/**
+ * @brief 初始化可靠链路(注册串口命令)
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_RLink_Init(void);
+
+/**
+ * @brief 复位双向序号并丢弃全部排队、在途与未读数据(统计保留)
+ */
+void CAN_RLink_Reset(void);
+
+/**
+ * @brief 设置发送窗口
+ * @param window: 窗口大小(1~CAN_RLINK_WINDOW_MAX)
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_RLink_SetWindow(uint8_t window);
+
+/**
+ * @brief 提交一帧数据
+ * @param data: 负载
+ * @param len: 负载长度(0~CAN_RLINK_PAYLOAD_MAX)
+ * @return CAN_TestBox_Status_t: 返回状态，发送环满返回CAN_TESTBOX_QUEUE_FULL
+ */
+CAN_TestBox_Status_t CAN_RLink_Send(const uint8_t *data, uint8_t len);
+
+/**
+ * @brief 读取一帧按序交付的数据
+ * @param data: 数据缓冲区(至少CAN_RLINK_PAYLOAD_MAX字节)
+ * @param len: 返回的负载长度
+ * @return CAN_TestBox_Status_t: 返回状态，无数据返回CAN_TESTBOX_QUEUE_EMPTY
+ */
+CAN_TestBox_Status_t CAN_RLink_Receive(uint8_t *data, uint8_t *len);
+
+/**
+ * @brief 可靠链路报文接收(在CAN1接收中断中调用)
+ * @param header: 接收报文头
+ * @param data: 接收数据
+ * @return bool: true表示是可靠链路报文，已处理
+ */
+bool CAN_RLink_ProcessRx(const CAN_RxHeaderTypeDef *header, const uint8_t *data);
+
+/**
+ * @brief 发送邮箱空闲时继续发送(在发送完成中断中调用)
+ * @param hcan: CAN句柄
+ */
+void CAN_RLink_ProcessTxComplete(CAN_HandleTypeDef *hcan);
+
+/**
+ * @brief 超时重传、延迟确认与测试数据补充(在CAN测试盒任务中调用)
+ */
+void CAN_RLink_Process(void);
+
+/**
+ * @brief 计算距最近一个重传超时的等待时间
+ * @param max_ms: 上限
+ * @return uint32_t: 等待时间(ms)
+ */
+uint32_t CAN_RLink_GetIdleTime(uint32_t max_ms);
+
+/**
+ * @brief 获取统计
+ * @param stats: 统计指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_RLink_GetStats(CAN_RLink_Stats_t *stats);
+
+/**
+ * @brief 清空统计
+ */
+void CAN_RLink_ResetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_TESTBOX_RLINK_H */
@@ -0,0 +1,102 @@
+/**
+ * @file can_testbox_rtstats.h
+ * @brief CAN测试盒任务运行时统计
+ * @version 1.0
+ * @date 2024
+ *
+ * 开启configGENERATE_RUN_TIME_STATS，运行时计数器直接使用TIM2 1MHz时间戳：
+ * - DWT周期计数器168MHz下25.6秒回绕，任务累计时间会在两次读取之间溢出；
+ *   TIM2为32位1us，约71.6分钟回绕，只要两次读取间隔小于回绕周期，
+ *   按差值计算的占用率不受回绕影响
+ * - 外设中断入口/出口记录DWT周期数(只统计最外层，嵌套不重复计入)，
+ *   得到中断占用率；中断时间同时计入被打断任务的运行时间
+ * - 串口帧命令0x17返回本次与上次读取之间各任务CPU占用、栈历史最小剩余、
+ *   FreeRTOS堆剩余与历史最小剩余
+ */
+
+#ifndef __CAN_TESTBOX_RTSTATS_H
+#define __CAN_TESTBOX_RTSTATS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can_testbox_api.h"
+#include <stdint.h>
+
+/* ========================= 配置宏定义 ========================= */
+
+#define CAN_RTSTATS_MAX_TASKS       8     // 可统计任务数
+#define CAN_RTSTATS_NAME_LEN        16    // 应答中任务名长度(与configMAX_TASK_NAME_LEN一致)
+
+/* ========================= 数据结构定义 ========================= */
+
+/**
+ * @brief 单任务统计
+ */
+typedef struct {
+    char     name[CAN_RTSTATS_NAME_LEN];    // 任务名(不足补0)
+    uint8_t  state;                         // eTaskState
+    uint8_t  priority;                      // 当前优先级
+    uint16_t cpu_bp;                        // 统计窗口内CPU占用(0.01%)
+    uint32_t stack_free_min;                // 栈历史最小剩余(字节)
+} CAN_RtStats_Task_t;
+
+/**
+ * @brief 系统统计
+ */
+typedef struct {
+    uint32_t window_us;                     // 统计窗口(us)
+    uint16_t isr_bp;                        // 窗口内外设中断占用(0.01%)
+    uint32_t heap_free;                     // FreeRTOS堆当前剩余(字节)
+    uint32_t heap_min_free;                 // FreeRTOS堆历史最小剩余(字节)
+    uint8_t  task_count;                    // 任务数
+    CAN_RtStats_Task_t tasks[CAN_RTSTATS_MAX_TASKS];
+} CAN_RtStats_Report_t;
+
+/* ========================= API接口声明 ========================= */
+
+/**
+ * @brief 初始化运行时统计(注册串口命令)
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_RtStats_Init(void);
+
+/**
+ * @brief 采集统计并开始新的统计窗口
+ * @param report: 报告指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ * @note  仅在任务中调用
+ */
+CAN_TestBox_Status_t CAN_RtStats_Sample(CAN_RtStats_Report_t *report);
+
+/* ========================= FreeRTOS/中断钩子 ========================= */
+
+/**
+ * @brief 配置运行时计数器(portCONFIGURE_TIMER_FOR_RUN_TIME_STATS)
+ */
+void CAN_RtStats_ConfigureTimer(void);
+
+/**
+ * @brief 读取运行时计数器(portGET_RUN_TIME_COUNTER_VALUE)
+ * @return uint32_t: 当前计数(us)
+ */
+uint32_t CAN_RtStats_GetCounter(void);
+
+/**
+ * @brief 外设中断入口(在中断处理函数开头调用)
+ * @return uint32_t: 入口周期数，传给CAN_RtStats_IsrExit
+ */
+uint32_t CAN_RtStats_IsrEnter(void);
+
+/**
+ * @brief 外设中断出口(在中断处理函数末尾调用)
+ * @param start: CAN_RtStats_IsrEnter的返回值
+ */
+void CAN_RtStats_IsrExit(uint32_t start);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_TESTBOX_RTSTATS_H */
@@ -0,0 +1,192 @@
+/**
+ * @file can_testbox_seq.h
+ * @brief CAN测试盒测试序列虚拟机
+ * @version 1.0
+ * @date 2024
+ *
+ * 测试场景不再编译进单字节指令分支，而是以字节码脚本经串口帧命令下载到RAM，
+ * 可保存到Flash扇区1并在上电时自动载入。脚本在独立任务中执行，发送、等待
+ * 和断言均在本地完成，无需与上位机往返，结束后主动上报通过/失败与计时结果。
+ *
+ * 指令格式: 操作码(u8) + 操作数(小端)，跳转目标为脚本内字节偏移(u16)
+ * | 操作码 | 助记符  | 操作数                                              |
+ * | 0x00   | END     | -                          序列通过                 |
+ * | 0x01   | SEND    | ch, id(u32), dlc, data[dlc] 发送单帧                |
+ * | 0x02   | PSTART  | slot, ch, id(u32), dlc, period(u16 ms), data[dlc]   |
+ * | 0x03   | PSTOP   | slot                                                |
+ * | 0x04   | WAIT    | ch, id(u32), mask(u32), timeout(u16 ms) 置条件标志  |
+ * | 0x05   | CHECK   | data[8], mask[8]  校验最近等到的报文，置条件标志    |
+ * | 0x06   | ASSERT  | -                          条件标志为0则失败        |
+ * | 0x07   | DELAY   | us(u32)                                             |
+ * | 0x08   | SETR    | reg, value(u16)            计数寄存器赋值           |
+ * | 0x09   | DJNZ    | reg, target(u16)           减1非0跳转(循环)         |
+ * | 0x0A   | JMP     | target(u16)                                         |
+ * | 0x0B   | JZ      | target(u16)                条件标志为0跳转          |
+ * | 0x0C   | JNZ     | target(u16)                条件标志非0跳转          |
+ * | 0x0D   | SIGNAL  | slot, start_bit, bit_len, value(u32) 改周期报文信号 |
+ * | 0x0E   | FAIL    | code                       序列失败                 |
+ * | 0x0F   | MARK    | -                          记录相对开始的时间       |
+ * ID的bit31表示扩展帧；WAIT的ch为0xFF时匹配任意通道，mask同样作用于bit31。
+ * WAIT成功记录等待时长，超时记录0xFFFFFFFF；MARK记录相对开始时间，
+ * 两者按执行顺序存入计时结果(最多CAN_SEQ_TIMING_MAX项)。
+ * 脚本结束时停止由PSTART启动的全部周期报文。
+ */
+
+#ifndef __CAN_TESTBOX_SEQ_H
+#define __CAN_TESTBOX_SEQ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can_testbox_api.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ========================= 配置宏定义 ========================= */
+
+#define CAN_SEQ_SCRIPT_MAX          1024  // 脚本最大长度(字节)
+#define CAN_SEQ_SLOT_MAX            8     // 脚本可用周期报文槽位数
+#define CAN_SEQ_REG_MAX             4     // 计数寄存器数
+#define CAN_SEQ_TIMING_MAX          16    // 计时结果项数
+
+// 脚本保存位置: Flash扇区1(16KB)，链接脚本中已从FLASH区域中划出；
+// 选用小扇区以缩短擦除时间(典型约0.25秒，128KB扇区需1~2秒)
+#define CAN_SEQ_FLASH_ADDR          0x08004000U
+#define CAN_SEQ_FLASH_SECTOR        FLASH_SECTOR_1
+#define CAN_SEQ_FLASH_MAGIC         0x31514553U   // "SEQ1"
+
+/* ========================= 操作码定义 ========================= */
+
+#define CAN_SEQ_OP_END              0x00
+#define CAN_SEQ_OP_SEND             0x01
+#define CAN_SEQ_OP_PSTART           0x02
+#define CAN_SEQ_OP_PSTOP            0x03
+#define CAN_SEQ_OP_WAIT             0x04
+#define CAN_SEQ_OP_CHECK            0x05
+#define CAN_SEQ_OP_ASSERT           0x06
+#define CAN_SEQ_OP_DELAY            0x07
+#define CAN_SEQ_OP_SETR             0x08
+#define CAN_SEQ_OP_DJNZ             0x09
+#define CAN_SEQ_OP_JMP              0x0A
+#define CAN_SEQ_OP_JZ               0x0B
+#define CAN_SEQ_OP_JNZ              0x0C
+#define CAN_SEQ_OP_SIGNAL           0x0D
+#define CAN_SEQ_OP_FAIL             0x0E
+#define CAN_SEQ_OP_MARK             0x0F
+
+/* ========================= 控制操作定义 ========================= */
+
+#define CAN_SEQ_CTRL_RUN            0x00  // 运行RAM中的脚本
+#define CAN_SEQ_CTRL_STOP           0x01  // 中止运行
+#define CAN_SEQ_CTRL_SAVE           0x02  // 保存到Flash
+#define CAN_SEQ_CTRL_LOAD           0x03  // 从Flash载入
+#define CAN_SEQ_CTRL_STATUS         0x04  // 读取运行状态与结果
+
+/* ========================= 数据结构定义 ========================= */
+
+/**
+ * @brief 序列运行状态
+ */
+typedef enum {
+    CAN_SEQ_STATE_IDLE = 0,                 // 未运行
+    CAN_SEQ_STATE_RUNNING,                  // 运行中
+    CAN_SEQ_STATE_PASS,                     // 通过
+    CAN_SEQ_STATE_FAIL,                     // 失败
+    CAN_SEQ_STATE_ABORTED                   // 被中止
+} CAN_Seq_State_t;
+
+/**
+ * @brief 失败原因
+ */
+typedef enum {
+    CAN_SEQ_ERR_NONE = 0,
+    CAN_SEQ_ERR_ASSERT,                     // 断言失败
+    CAN_SEQ_ERR_BAD_OPCODE,                 // 非法操作码
+    CAN_SEQ_ERR_BAD_OPERAND,                // 操作数越界(寄存器/槽位/通道/跳转目标)
+    CAN_SEQ_ERR_TRUNCATED,                  // 指令超出脚本末尾
+    CAN_SEQ_ERR_SEND,                       // 发送失败
+    CAN_SEQ_ERR_PERIODIC,                   // 周期报文启动/修改失败
+    CAN_SEQ_ERR_USER = 0x80                 // FAIL指令(低7位为用户代码)
+} CAN_Seq_Error_t;
+
+/**
+ * @brief 序列运行结果
+ */
+typedef struct {
+    uint32_t state;                         // CAN_Seq_State_t
+    uint32_t error;                         // CAN_Seq_Error_t
+    uint32_t pc;                            // 结束时的指令偏移
+    uint32_t steps;                         // 已执行指令数
+    uint32_t duration_us;                   // 运行时长(us)
+    uint32_t timing_count;                  // 计时结果项数
+    uint32_t timings[CAN_SEQ_TIMING_MAX];   // 计时结果(us)
+} CAN_Seq_Result_t;
+
+/* ========================= API接口声明 ========================= */
+
+/**
+ * @brief 初始化测试序列虚拟机(创建执行任务、注册串口命令、载入Flash中的脚本)
+ * @return CAN_TestBox_Status_t: 返回状态
+ * @note  在内核初始化之后、调度器启动之前调用
+ */
+CAN_TestBox_Status_t CAN_Seq_Init(void);
+
+/**
+ * @brief 写入脚本片段
+ * @param offset: 写入偏移，为0时重新开始一个脚本
+ * @param data: 数据
+ * @param len: 长度
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Seq_Write(uint16_t offset, const uint8_t *data, uint16_t len);
+
+/**
+ * @brief 开始运行RAM中的脚本
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Seq_Run(void);
+
+/**
+ * @brief 中止运行
+ */
+void CAN_Seq_Stop(void);
+
+/**
+ * @brief 将RAM中的脚本保存到Flash
+ * @return CAN_TestBox_Status_t: 返回状态
+ * @note  擦除16KB扇区典型约0.25秒(最长0.5秒)，期间从Flash取指暂停，任务与中断均停顿；
+ *        序列运行、周期报文调度、网关转发或PEPS场景进行中返回CAN_TESTBOX_BUSY
+ */
+CAN_TestBox_Status_t CAN_Seq_Save(void);
+
+/**
+ * @brief 从Flash载入脚本到RAM
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Seq_Load(void);
+
+/**
+ * @brief 获取运行结果
+ * @param result: 结果指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_Seq_GetResult(CAN_Seq_Result_t *result);
+
+/**
+ * @brief 报文输入(在CAN接收路径中调用，可在中断中调用)
+ * @param frame: 接收帧(已标记通道)
+ */
+void CAN_Seq_InputFrame(const CAN_TestBox_Frame_t *frame);
+
+/**
+ * @brief 上报运行结果(在CAN测试盒任务中调用)
+ * @note  序列结束后发送一次0x1A应答帧
+ */
+void CAN_Seq_Process(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_TESTBOX_SEQ_H */
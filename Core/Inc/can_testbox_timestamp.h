@@ -0,0 +1,113 @@
+/**
+ * @file can_testbox_timestamp.h
+ * @brief CAN测试盒硬件微秒时间戳
+ * @version 1.0
+ * @date 2024
+ *
+ * 使用32位定时器TIM2作为1MHz自由运行计数器，为网关转发、通道监听等
+ * 模块提供统一的硬件时间基准：
+ * - 分辨率1us，约71.6分钟回绕一次
+ * - 读取仅需一次寄存器访问，可在中断中直接使用
+ * - 时间差使用无符号减法计算，天然处理回绕
+ * - 比较通道1提供单次定时闹钟，到期在TIM2中断中回调(优先级5，可调用
+ *   FreeRTOS FromISR接口)
+ */
+
+#ifndef __CAN_TESTBOX_TIMESTAMP_H
+#define __CAN_TESTBOX_TIMESTAMP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f4xx_hal.h"
+#include <stdint.h>
+
+/* ========================= 配置宏定义 ========================= */
+
+// 时间戳计数频率(Hz)
+#define CAN_TIMESTAMP_FREQ_HZ       1000000U
+
+// 定时闹钟中断优先级(不高于configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY)
+#define CAN_TIMESTAMP_ALARM_IRQ_PRIORITY  5U
+
+/* ========================= 类型定义 ========================= */
+
+/**
+ * @brief 定时闹钟回调(在TIM2中断中执行)
+ */
+typedef void (*CAN_Timestamp_AlarmCallback_t)(void);
+
+/* ========================= API接口声明 ========================= */
+
+/**
+ * @brief 初始化硬件时间戳定时器(TIM2, 1MHz, 32位自由运行)
+ * @return HAL_StatusTypeDef: HAL状态
+ */
+HAL_StatusTypeDef CAN_Timestamp_Init(void);
+
+/**
+ * @brief 设置单次定时闹钟(比较通道1)
+ * @param at_us: 到期时刻(时间戳，us)，已过去时立即触发
+ * @param callback: 到期回调，替换尚未触发的旧闹钟
+ * @note  到期时刻须在当前时间之后约35分钟以内(计数器半周期)
+ */
+void CAN_Timestamp_SetAlarm(uint32_t at_us, CAN_Timestamp_AlarmCallback_t callback);
+
+/**
+ * @brief 取消尚未触发的定时闹钟
+ */
+void CAN_Timestamp_CancelAlarm(void);
+
+/**
+ * @brief TIM2中断处理(在TIM2_IRQHandler中调用)
+ */
+void CAN_Timestamp_IRQHandler(void);
+
+/**
+ * @brief 获取当前硬件时间戳
+ * @return uint32_t: 当前时间(us)
+ */
+static inline uint32_t CAN_Timestamp_GetUs(void)
+{
+    return TIM2->CNT;
+}
+
+/**
+ * @brief 计算两个时间戳之间的间隔(自动处理回绕)
+ * @param start_us: 起始时间(us)
+ * @param end_us: 结束时间(us)
+ * @return uint32_t: 时间间隔(us)
+ */
+static inline uint32_t CAN_Timestamp_Elapsed(uint32_t start_us, uint32_t end_us)
+{
+    return end_us - start_us;
+}
+
+/**
+ * @brief 使能DWT内核周期计数器(用于性能基准测量)
+ * @note  可重复调用，已使能时不复位计数值
+ */
+static inline void CAN_Timestamp_CycleCounterInit(void)
+{
+    if ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0U) {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0U;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+}
+
+/**
+ * @brief 获取内核周期计数(SYSCLK周期，168MHz下约25.6秒回绕)
+ * @return uint32_t: 当前周期计数
+ */
+static inline uint32_t CAN_Timestamp_GetCycles(void)
+{
+    return DWT->CYCCNT;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_TESTBOX_TIMESTAMP_H */
@@ -0,0 +1,181 @@
+/**
+ * @file can_testbox_txarb.h
+ * @brief 片内CAN发送仲裁(优先级分类排队 + 邮箱抢占)
+ * @version 1.0
+ * @date 2024
+ *
+ * 周期调度、连续帧、单帧与双节点协议报文原本各自直接装入三个发送邮箱，
+ * 邮箱满即失败，大量连续帧会推迟周期报文。本模块为CAN1/CAN2各维护一组
+ * 按优先级分类的发送队列：
+ * - 分类之间按类别优先，同一分类内按总线仲裁顺序(ID越小越先)排队，
+ *   相同ID先进先出
+ * - 邮箱空闲时按优先级依次装入；邮箱已满且等待中的报文优先于某个邮箱中的
+ *   报文时，中止该邮箱，被中止的报文回到队列(保留入队时间)
+ * - 发送控制器工作在按ID优先模式(TransmitFifoPriority=DISABLE)，
+ *   邮箱中ID最小的报文先上总线
+ * - 带标签提交(周期报文以句柄为标签)时，同标签的上一实例若仍在队列中则
+ *   原位覆盖；若已装入邮箱但尚未开始发送则中止该邮箱，由新实例顶替。
+ *   总线上始终是最新数据，被顶替的实例计入替换数，与实际ECU行为一致
+ * - 按分类统计入队到发送完成的时延、抢占次数、替换次数与队列峰值
+ * - 每帧结束(发送完成或失败)时通过确认回调上报报文、分类、标签、入队时间
+ *   与完成时间戳(发送完成中断入口捕获的TIM2微秒计数)
+ * 控制器配置为单次发送(不自动重发)，仲裁丢失或发送错误的报文与原来一样丢弃，
+ * 只计入失败数。网关与可靠链路仍使用各自的队列直接装入邮箱(网关的转发时延
+ * 按装入邮箱时刻统计，可靠链路自带窗口、重传与邮箱保留)，仲裁器不会中止
+ * 它们的报文；二者只在CAN_TxArb_ExternalFreeLevel()允许时装入。
+ */
+
+#ifndef __CAN_TESTBOX_TXARB_H
+#define __CAN_TESTBOX_TXARB_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can_testbox_api.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* ========================= 配置宏定义 ========================= */
+
+#define CAN_TXARB_CH_COUNT          2     // 片内CAN通道数(CAN1、CAN2)
+#define CAN_TXARB_QUEUE_DEPTH       CAN_TESTBOX_MAX_PERIODIC_MSGS // 每分类容量(排队+已装入邮箱)，周期报文每句柄至多一帧
+#define CAN_TXARB_CONFIRM_MAX       2     // 发送确认回调数(测试盒统计、请求/应答计时)
+
+/* ========================= 发送分类定义 ========================= */
+
+#define CAN_TXARB_CLASS_CONTROL     0     // 双节点协议报文(ACK、心跳等)
+#define CAN_TXARB_CLASS_PERIODIC    1     // 周期调度报文(含PEPS)
+#define CAN_TXARB_CLASS_NORMAL      2     // 单帧、自检
+#define CAN_TXARB_CLASS_BULK        3     // 连续帧
+#define CAN_TXARB_CLASS_COUNT       4
+
+/* ========================= 控制操作定义 ========================= */
+
+#define CAN_TXARB_CTRL_STATUS       0x00  // 读取分类统计(通道)
+#define CAN_TXARB_CTRL_CLEAR        0x01  // 清空统计(通道)
+#define CAN_TXARB_CTRL_CONFIG       0x02  // 允许/禁止邮箱抢占(通道、允许)
+
+/* ========================= 数据结构定义 ========================= */
+
+/**
+ * @brief 单个分类的统计
+ */
+typedef struct {
+    uint32_t submitted;                     // 入队帧数
+    uint32_t sent;                          // 发送完成帧数
+    uint32_t preempted;                     // 被更高优先级报文中止后重新排队的次数
+    uint32_t replaced;                      // 未发出即被同标签新实例替换的次数
+    uint32_t failed;                        // 仲裁丢失/发送错误(单次发送模式，不重发)
+    uint32_t dropped;                       // 分类已满被拒绝的帧数
+    uint32_t queued;                        // 当前排队(未装入邮箱)帧数
+    uint32_t queue_peak;                    // 排队帧数峰值
+    uint32_t latency_avg_us;                // 入队到发送完成的平均时延
+    uint32_t latency_max_us;                // 入队到发送完成的最大时延
+} CAN_TxArb_ClassStats_t;
+
+/**
+ * @brief 发送确认回调(在中断中、仲裁器临界区内调用，须短小)
+ * @param ch: 通道编号
+ * @param tx_class: 发送分类
+ * @param tag: 替换标签
+ * @param frame: 报文
+ * @param enqueue_us: 入队时间(us)
+ * @param done_us: 结束时间(us)
+ * @param sent: true为发送完成，false为仲裁丢失/发送错误
+ */
+typedef void (*CAN_TxArb_ConfirmCallback_t)(CAN_TestBox_ChannelId_t ch, uint8_t tx_class, uint8_t tag,
+                                            const CAN_TestBox_Frame_t *frame, uint32_t enqueue_us,
+                                            uint32_t done_us, bool sent);
+
+/* ========================= API接口声明 ========================= */
+
+/**
+ * @brief 初始化发送仲裁(允许抢占，注册串口命令)
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_TxArb_Init(void);
+
+/**
+ * @brief 提交一帧(可在中断中调用)
+ * @param ch: 通道编号(CAN_TESTBOX_CH_CAN1/CAN_TESTBOX_CH_CAN2)
+ * @param tx_class: 发送分类(CAN_TXARB_CLASS_xxx)
+ * @param tag: 替换标签，同分类内同标签未发出的报文被本帧替换；0为不替换
+ * @param frame: 报文
+ * @return CAN_TestBox_Status_t: 返回状态，分类已满返回CAN_TESTBOX_QUEUE_FULL
+ */
+CAN_TestBox_Status_t CAN_TxArb_Submit(CAN_TestBox_ChannelId_t ch, uint8_t tx_class, uint8_t tag,
+                                      const CAN_TestBox_Frame_t *frame);
+
+/**
+ * @brief 注册发送确认回调(重复注册同一回调无效果)
+ * @param callback: 回调函数
+ * @return CAN_TestBox_Status_t: 返回状态，回调表满返回CAN_TESTBOX_QUEUE_FULL
+ */
+CAN_TestBox_Status_t CAN_TxArb_AddConfirmCallback(CAN_TxArb_ConfirmCallback_t callback);
+
+/**
+ * @brief 邮箱发送完成(在发送完成中断中调用)
+ * @param hcan: CAN句柄
+ * @param mailbox: CAN_TX_MAILBOX0/1/2
+ * @param done_us: 发送完成时间戳(中断入口处的CAN_Timestamp_GetUs())
+ */
+void CAN_TxArb_ProcessTxComplete(CAN_HandleTypeDef *hcan, uint32_t mailbox, uint32_t done_us);
+
+/**
+ * @brief 邮箱中止完成(在中止回调中调用)
+ * @param hcan: CAN句柄
+ * @param mailbox: CAN_TX_MAILBOX0/1/2
+ */
+void CAN_TxArb_ProcessAbort(CAN_HandleTypeDef *hcan, uint32_t mailbox);
+
+/**
+ * @brief 回收因仲裁丢失/发送错误而结束的邮箱(在错误回调中调用)
+ * @param hcan: CAN句柄
+ */
+void CAN_TxArb_ProcessError(CAN_HandleTypeDef *hcan);
+
+/**
+ * @brief 允许/禁止邮箱抢占
+ * @param ch: 通道编号
+ * @param enable: 是否允许
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_TxArb_SetPreemption(CAN_TestBox_ChannelId_t ch, bool enable);
+
+/**
+ * @brief 获取分类统计
+ * @param ch: 通道编号
+ * @param tx_class: 发送分类
+ * @param stats: 统计指针
+ * @return CAN_TestBox_Status_t: 返回状态
+ */
+CAN_TestBox_Status_t CAN_TxArb_GetStats(CAN_TestBox_ChannelId_t ch, uint8_t tx_class, CAN_TxArb_ClassStats_t *stats);
+
+/**
+ * @brief 获取全部分类待发送帧数(排队+已装入邮箱)的峰值
+ * @param ch: 通道编号
+ * @return uint32_t: 峰值，随统计一起清空
+ */
+uint32_t CAN_TxArb_GetDepthPeak(CAN_TestBox_ChannelId_t ch);
+
+/**
+ * @brief 不经仲裁直接装入邮箱的模块(网关、可靠链路)可用的空闲邮箱数
+ * @param hcan: CAN句柄
+ * @return uint32_t: 可装入的邮箱数；有邮箱结束状态待处理或HAL将装入的邮箱
+ *         仍由仲裁器持有时为0，仲裁器有报文排队时保留一个邮箱
+ * @note  须在临界区内调用，并在同一临界区内装入
+ */
+uint32_t CAN_TxArb_ExternalFreeLevel(CAN_HandleTypeDef *hcan);
+
+/**
+ * @brief 清空统计(不影响排队报文)
+ * @param ch: 通道编号
+ */
+void CAN_TxArb_ResetStats(CAN_TestBox_ChannelId_t ch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CAN_TESTBOX_TXARB_H */
@@ -63,6 +63,10 @@ void CAN2_RX0_IRQHandler(void);
 void CAN2_RX1_IRQHandler(void);
 void CAN2_SCE_IRQHandler(void);
 /* USER CODE BEGIN EFP */
+void DMA2_Stream0_IRQHandler(void);
+void DMA2_Stream3_IRQHandler(void);
+void EXTI15_10_IRQHandler(void);
+void TIM2_IRQHandler(void);
 
 /* USER CODE END EFP */
 
@@ -19,6 +19,19 @@
 #include "can.h"
 #include "cmsis_os.h"
 #include "cmsis_os.h"
+#include "can_testbox_gateway.h"
+#include "can_testbox_monitor.h"
+#include "can_testbox_timestamp.h"
+#include "can_testbox_latency.h"
+#include "can_testbox_idstats.h"
+#include "can_testbox_cyclemon.h"
+#include "can_testbox_errstats.h"
+#include "can_testbox_format.h"
+#include "can_testbox_reqresp.h"
+#include "can_testbox_rlink.h"
+#include "can_testbox_accept.h"
+#include "can_testbox_txarb.h"
+#include "can_testbox_frame.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
@@ -33,11 +46,8 @@ extern CAN_HandleTypeDef hcan1;
 /* Private variables ---------------------------------------------------------*/
 
 /* CAN handle and message structures */
-static CAN_TxHeaderTypeDef TxHeader;
 static CAN_RxHeaderTypeDef RxHeader;
-static uint8_t TxData[8];
 static uint8_t RxData[8];
-static uint32_t TxMailbox;
 
 /* Statistics */
 static CAN_DualNode_Stats_t can_stats = {0};
@@ -62,6 +72,7 @@ static void CAN_ConfigFilter(void);
 static void CAN_UpdateTxStats(void);
 static void CAN_UpdateRxStats(void);
 static void CAN_UpdateErrorStats(void);
+static bool CAN_DataResponseMatch(const uint8_t *data, uint8_t dlc, void *context);
 
 /* Exported functions --------------------------------------------------------*/
 
@@ -141,6 +152,7 @@ HAL_StatusTypeDef CAN_DualNode_DeInit(void)
 HAL_StatusTypeDef CAN_SendToWCMCU(uint32_t id, uint8_t* data, uint8_t len)
 {
     HAL_StatusTypeDef status;
+    uint8_t tx_data[8] = {0};
     
     // Check parameters
     if (data == NULL || len > 8)
@@ -148,19 +160,13 @@ HAL_StatusTypeDef CAN_SendToWCMCU(uint32_t id, uint8_t* data, uint8_t len)
         return HAL_ERROR;
     }
     
-    // Configure transmit header
-    TxHeader.StdId = id;
-    TxHeader.ExtId = 0x00;
-    TxHeader.RTR = CAN_RTR_DATA;
-    TxHeader.IDE = CAN_ID_STD;
-    TxHeader.DLC = len;
-    TxHeader.TransmitGlobalTime = DISABLE;
-    
     // Copy data
-    memcpy(TxData, data, len);
+    memcpy(tx_data, data, len);
     
-    // Send message
-    status = HAL_CAN_AddTxMessage(&hcan1, &TxHeader, TxData, &TxMailbox);
+    // 双节点协议报文(ACK、心跳等)按最高发送分类排队，可在接收中断中调用
+    CAN_TestBox_Frame_t frame;
+    CAN_Frame_Pack(&frame, id, false, false, len, tx_data, CAN_TESTBOX_CH_CAN1, HAL_GetTick());
+    status = (CAN_TxArb_Submit(CAN_TESTBOX_CH_CAN1, CAN_TXARB_CLASS_CONTROL, 0, &frame) == CAN_TESTBOX_OK) ? HAL_OK : HAL_BUSY;
     
     if (status == HAL_OK)
     {
@@ -219,6 +225,8 @@ HAL_StatusTypeDef CAN_SendHeartbeat(void)
 HAL_StatusTypeDef CAN_SendDataRequest(uint8_t req_type, uint8_t req_param)
 {
     uint8_t request_data[CAN_DATA_REQUEST_LEN];
+    uint8_t handle = CAN_REQRESP_INVALID_HANDLE;
+    HAL_StatusTypeDef status;
     
     // Construct request data
     request_data[0] = req_type;   // Request type
@@ -227,7 +235,31 @@ HAL_StatusTypeDef CAN_SendDataRequest(uint8_t req_type, uint8_t req_param)
     data_request_counter++;
     can_stats.data_req_count++;
     
-    return CAN_SendToWCMCU(CAN_DATA_REQUEST_ID, request_data, CAN_DATA_REQUEST_LEN);
+    // 登记期望的应答(0x300且首字节为请求类型)，按请求类型统计往返时延
+    CAN_ReqResp_Expect_t expect = {
+        .channel = CAN_TESTBOX_CH_CAN1,
+        .type = req_type,
+        .is_extended = false,
+        .id = CAN_DATA_RESPONSE_ID,
+        .mask = CAN_REQRESP_MASK_EXACT,
+        .timeout_ms = CAN_DATA_RESPONSE_TIMEOUT,
+        .predicate = CAN_DataResponseMatch,
+        .callback = NULL,
+        .context = (void *)(uintptr_t)req_type,
+        .has_request = true,
+        .request_channel = CAN_TESTBOX_CH_CAN1,
+        .request_extended = false,
+        .request_id = CAN_DATA_REQUEST_ID
+    };
+    (void)CAN_ReqResp_Arm(&expect, &handle);
+    
+    status = CAN_SendToWCMCU(CAN_DATA_REQUEST_ID, request_data, CAN_DATA_REQUEST_LEN);
+    if (status != HAL_OK && handle != CAN_REQRESP_INVALID_HANDLE)
+    {
+        CAN_ReqResp_Cancel(handle);
+    }
+    
+    return status;
 }
 
 /**
@@ -725,16 +757,31 @@ void CAN_PrintNodeStatus(void)
 
 /**
   * @brief  Get communication success rate
+  * @note   按请求/应答匹配结果计算：已应答/(已应答+超时)，待决请求不计入
   * @retval Success rate (percentage)
   */
 float CAN_GetSuccessRate(void)
 {
-    if (can_stats.tx_count == 0)
+    const uint8_t req_types[] = { CAN_DATA_REQ_TYPE_STATUS, CAN_DATA_REQ_TYPE_TIMESTAMP };
+    CAN_ReqResp_Summary_t summary;
+    uint32_t matched = 0;
+    uint32_t finished = 0;
+    
+    for (uint8_t i = 0; i < sizeof(req_types); i++)
+    {
+        if (CAN_ReqResp_GetSummary(req_types[i], &summary) == CAN_TESTBOX_OK)
+        {
+            matched += summary.matched;
+            finished += summary.matched + summary.timeouts;
+        }
+    }
+    
+    if (finished == 0)
     {
         return 0.0f;
     }
     
-    return (float)can_stats.rx_count / can_stats.tx_count * 100.0f;
+    return (float)matched / finished * 100.0f;
 }
 
 /**
@@ -843,16 +890,14 @@ void CAN_PeriodicCheck(void)
   */
 void CAN_PrintMessage(const char* prefix, uint32_t id, uint8_t* data, uint8_t len)
 {
-    printf("[%s] ID:0x%03X, Data:", prefix, (unsigned int)id);
-    for(int i = 0; i < len; i++)
-    {
-        if (i == len - 1) {
-            printf("%02X", data[i]);  // 最后一个字节不加空格
-        } else {
-            printf("%02X ", data[i]); // 其他字节后面加空格
-        }
-    }
-    printf(" [END]\r\n");
+    char line[CAN_FORMAT_LINE_MAX];
+    char *p = line;
+
+    *p++ = '[';
+    p = CAN_Format_Str(p, prefix, CAN_FORMAT_TAG_MAX);
+    *p++ = ']';
+    p = CAN_Format_FrameBody(p, id, CAN_FORMAT_STD_ID_DIGITS, data, len, false);
+    CAN_Format_Output(line, (uint32_t)(p - line));
 }
 
 /**
@@ -892,14 +937,20 @@ bool CAN_VerifyChecksum(uint8_t* data, uint8_t len, uint16_t checksum)
   */
 void CAN_FormatTimestamp(uint32_t timestamp, char* buffer, size_t size)
 {
-    uint32_t seconds = timestamp / 1000;
-    uint32_t milliseconds = timestamp % 1000;
-    uint32_t minutes = seconds / 60;
-    seconds = seconds % 60;
-    uint32_t hours = minutes / 60;
-    minutes = minutes % 60;
-    
-    snprintf(buffer, size, "%02lu:%02lu:%02lu.%03lu", hours, minutes, seconds, milliseconds);
+    char text[24];
+    size_t len;
+
+    if (buffer == NULL || size == 0) {
+        return;
+    }
+
+    // 与snprintf语义一致: 缓冲区不足时截断并保证以'\0'结尾
+    len = (size_t)(CAN_Format_Timestamp(text, timestamp) - text);
+    if (len >= size) {
+        len = size - 1;
+    }
+    memcpy(buffer, text, len);
+    buffer[len] = '\0';
 }
 
 /* Private functions ---------------------------------------------------------*/
@@ -957,6 +1008,18 @@ static void CAN_UpdateErrorStats(void)
     can_stats.error_count++;
 }
 
+/**
+  * @brief  Data response predicate (called in CAN RX interrupt)
+  * @param  data: Response data
+  * @param  dlc: Data length
+  * @param  context: Expected request type
+  * @retval true if the response answers the request type
+  */
+static bool CAN_DataResponseMatch(const uint8_t *data, uint8_t dlc, void *context)
+{
+    return (dlc >= 1) && (data[0] == (uint8_t)(uintptr_t)context);
+}
+
 /* Interrupt Callbacks -------------------------------------------------------*/
 
 /**
@@ -966,23 +1029,41 @@ static void CAN_UpdateErrorStats(void)
   */
 void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef *hcan)
 {
+    // 进入中断立即记录硬件时间戳，用于网关转发时延统计
+    uint32_t rx_timestamp_us = CAN_Timestamp_GetUs();
+
     if (hcan->Instance == CAN1)
     {
-        if (HAL_CAN_GetRxMessage(hcan, CAN_RX_FIFO0, &RxHeader, RxData) == HAL_OK)
+        // 软件接收过滤: 拒收的报文直接释放FIFO，不读取数据也不做后续处理
+        if (CAN_Accept_Filter(hcan, CAN_TESTBOX_CH_CAN1, CAN_RX_FIFO0) &&
+            HAL_CAN_GetRxMessage(hcan, CAN_RX_FIFO0, &RxHeader, RxData) == HAL_OK)
         {
-            // Print CAN1 received message with new format
-            printf("[RX] ID:0x%03X, Data:", (unsigned int)RxHeader.StdId);
-            for (int i = 0; i < RxHeader.DLC && i < 8; i++) {
-                if (i == RxHeader.DLC - 1 || i == 7) {
-                    printf("%02X", RxData[i]);  // 最后一个字节不加空格
-                } else {
-                    printf("%02X ", RxData[i]); // 其他字节后面加空格
-                }
-            }
-            printf(" [END]\r\n");
+            CAN_Latency_Mark(CAN_TESTBOX_CH_CAN1, CAN_LATENCY_STAGE_FIFO_READ);
+
+            // 网关转发必须先于串口打印，否则阻塞打印会拉长转发时延
+            CAN_Gateway_ProcessRx(hcan, &RxHeader, RxData, rx_timestamp_us);
+            
+            // 抓包记录(带硬件时间戳)
+            CAN_Monitor_CaptureRx(hcan, &RxHeader, RxData, rx_timestamp_us);
+            
+            // 按ID统计(计数/帧间隔/抖动)
+            CAN_IdStats_Update(CAN_TESTBOX_CH_CAN1, &RxHeader, RxData, rx_timestamp_us);
+            
+            // 周期监控(过早/迟到/丢失)
+            CAN_CycleMon_ProcessRx(CAN_TESTBOX_CH_CAN1, &RxHeader, rx_timestamp_us);
             
-            // Process dual node communication message
-            CAN_ProcessReceivedMessage(&RxHeader, RxData);
+            // 请求/应答匹配(往返时延以中断入口时间戳计)
+            CAN_ReqResp_ProcessRx(CAN_TESTBOX_CH_CAN1, &RxHeader, RxData, rx_timestamp_us);
+            
+            // 可靠链路报文在中断中直接处理，不逐帧打印，也不走停等ACK
+            if (!CAN_RLink_ProcessRx(&RxHeader, RxData))
+            {
+                // Print CAN1 received message with new format
+                CAN_Format_PrintFrame("[RX]", RxHeader.StdId, RxData, (uint8_t)RxHeader.DLC, false);
+                
+                // Process dual node communication message
+                CAN_ProcessReceivedMessage(&RxHeader, RxData);
+            }
             
             // 已移除循环测试模块，保留双节点业务处理
             
@@ -993,6 +1074,26 @@ void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef *hcan)
             CAN_TestBox_ProcessRxMessage(hcan, &RxHeader, RxData);
         }
     }
+    else if (hcan->Instance == CAN2)
+    {
+        // 软件接收过滤: 拒收的报文直接释放FIFO，不读取数据也不做后续处理
+        if (CAN_Accept_Filter(hcan, CAN_TESTBOX_CH_CAN2, CAN_RX_FIFO0) &&
+            HAL_CAN_GetRxMessage(hcan, CAN_RX_FIFO0, &RxHeader, RxData) == HAL_OK)
+        {
+            CAN_Latency_Mark(CAN_TESTBOX_CH_CAN2, CAN_LATENCY_STAGE_FIFO_READ);
+
+            // CAN2在网关模式下转发，在静默监听模式下抓包
+            CAN_Gateway_ProcessRx(hcan, &RxHeader, RxData, rx_timestamp_us);
+            CAN_Monitor_CaptureRx(hcan, &RxHeader, RxData, rx_timestamp_us);
+            CAN_IdStats_Update(CAN_TESTBOX_CH_CAN2, &RxHeader, RxData, rx_timestamp_us);
+            CAN_CycleMon_ProcessRx(CAN_TESTBOX_CH_CAN2, &RxHeader, rx_timestamp_us);
+            CAN_ReqResp_ProcessRx(CAN_TESTBOX_CH_CAN2, &RxHeader, RxData, rx_timestamp_us);
+
+            // CAN2测试盒通道
+            extern void CAN_TestBox_ProcessRxMessage(CAN_HandleTypeDef *hcan, CAN_RxHeaderTypeDef *rx_header, uint8_t *rx_data);
+            CAN_TestBox_ProcessRxMessage(hcan, &RxHeader, RxData);
+        }
+    }
 }
 
 /**
@@ -1002,10 +1103,26 @@ void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef *hcan)
   */
 void HAL_CAN_TxMailbox0CompleteCallback(CAN_HandleTypeDef *hcan)
 {
+    // 发送确认时间戳: 在中断入口捕获，不计入后续网关/可靠链路处理耗时
+    uint32_t done_us = CAN_Timestamp_GetUs();
+
     if (hcan->Instance == CAN1)
     {
         // Transmission complete handling
     }
+    
+    // 发送仲裁: 发送确认、统计分类时延并装入下一帧
+    // (先于网关/可靠链路，释放仲裁器持有的邮箱后它们才能装入)
+    CAN_TxArb_ProcessTxComplete(hcan, CAN_TX_MAILBOX0, done_us);
+
+    // 邮箱空闲，继续发送网关排队报文
+    CAN_Gateway_ProcessTxComplete(hcan);
+
+    // 可靠链路重传与窗口内新数据
+    CAN_RLink_ProcessTxComplete(hcan);
+
+    // 唤醒等待重试的周期报文
+    CAN_TestBox_ProcessTxComplete(hcan);
 }
 
 /**
@@ -1015,10 +1132,26 @@ void HAL_CAN_TxMailbox0CompleteCallback(CAN_HandleTypeDef *hcan)
   */
 void HAL_CAN_TxMailbox1CompleteCallback(CAN_HandleTypeDef *hcan)
 {
+    // 发送确认时间戳: 在中断入口捕获，不计入后续网关/可靠链路处理耗时
+    uint32_t done_us = CAN_Timestamp_GetUs();
+
     if (hcan->Instance == CAN1)
     {
         // Transmission complete handling
     }
+    
+    // 发送仲裁: 发送确认、统计分类时延并装入下一帧
+    // (先于网关/可靠链路，释放仲裁器持有的邮箱后它们才能装入)
+    CAN_TxArb_ProcessTxComplete(hcan, CAN_TX_MAILBOX1, done_us);
+
+    // 邮箱空闲，继续发送网关排队报文
+    CAN_Gateway_ProcessTxComplete(hcan);
+
+    // 可靠链路重传与窗口内新数据
+    CAN_RLink_ProcessTxComplete(hcan);
+
+    // 唤醒等待重试的周期报文
+    CAN_TestBox_ProcessTxComplete(hcan);
 }
 
 /**
@@ -1028,10 +1161,68 @@ void HAL_CAN_TxMailbox1CompleteCallback(CAN_HandleTypeDef *hcan)
   */
 void HAL_CAN_TxMailbox2CompleteCallback(CAN_HandleTypeDef *hcan)
 {
+    // 发送确认时间戳: 在中断入口捕获，不计入后续网关/可靠链路处理耗时
+    uint32_t done_us = CAN_Timestamp_GetUs();
+
     if (hcan->Instance == CAN1)
     {
         // Transmission complete handling
     }
+    
+    // 发送仲裁: 发送确认、统计分类时延并装入下一帧
+    // (先于网关/可靠链路，释放仲裁器持有的邮箱后它们才能装入)
+    CAN_TxArb_ProcessTxComplete(hcan, CAN_TX_MAILBOX2, done_us);
+
+    // 邮箱空闲，继续发送网关排队报文
+    CAN_Gateway_ProcessTxComplete(hcan);
+
+    // 可靠链路重传与窗口内新数据
+    CAN_RLink_ProcessTxComplete(hcan);
+
+    // 唤醒等待重试的周期报文
+    CAN_TestBox_ProcessTxComplete(hcan);
+}
+
+/**
+  * @brief  CAN transmit mailbox 0 abort callback
+  * @param  hcan: CAN句柄指针
+  * @retval None
+  */
+void HAL_CAN_TxMailbox0AbortCallback(CAN_HandleTypeDef *hcan)
+{
+    // 被发送仲裁抢占的报文回到队列，装入更高优先级的报文
+    CAN_TxArb_ProcessAbort(hcan, CAN_TX_MAILBOX0);
+
+    // 仲裁器未再占用的邮箱继续发送网关排队报文
+    CAN_Gateway_ProcessTxComplete(hcan);
+}
+
+/**
+  * @brief  CAN transmit mailbox 1 abort callback
+  * @param  hcan: CAN句柄指针
+  * @retval None
+  */
+void HAL_CAN_TxMailbox1AbortCallback(CAN_HandleTypeDef *hcan)
+{
+    // 被发送仲裁抢占的报文回到队列，装入更高优先级的报文
+    CAN_TxArb_ProcessAbort(hcan, CAN_TX_MAILBOX1);
+
+    // 仲裁器未再占用的邮箱继续发送网关排队报文
+    CAN_Gateway_ProcessTxComplete(hcan);
+}
+
+/**
+  * @brief  CAN transmit mailbox 2 abort callback
+  * @param  hcan: CAN句柄指针
+  * @retval None
+  */
+void HAL_CAN_TxMailbox2AbortCallback(CAN_HandleTypeDef *hcan)
+{
+    // 被发送仲裁抢占的报文回到队列，装入更高优先级的报文
+    CAN_TxArb_ProcessAbort(hcan, CAN_TX_MAILBOX2);
+
+    // 仲裁器未再占用的邮箱继续发送网关排队报文
+    CAN_Gateway_ProcessTxComplete(hcan);
 }
 
 /**
@@ -1041,6 +1232,8 @@ void HAL_CAN_TxMailbox2CompleteCallback(CAN_HandleTypeDef *hcan)
   */
 void HAL_CAN_ErrorCallback(CAN_HandleTypeDef *hcan)
 {
+    uint32_t error_timestamp_us = CAN_Timestamp_GetUs();
+    
     if (hcan->Instance == CAN1)
     {
         uint32_t error_code = HAL_CAN_GetError(hcan);
@@ -1054,6 +1247,22 @@ void HAL_CAN_ErrorCallback(CAN_HandleTypeDef *hcan)
         extern void CAN_TestBox_ProcessError(CAN_HandleTypeDef *hcan);
         CAN_TestBox_ProcessError(hcan);
     }
+    else if (hcan->Instance == CAN2)
+    {
+        // CAN2测试盒通道错误统计
+        extern void CAN_TestBox_ProcessError(CAN_HandleTypeDef *hcan);
+        CAN_TestBox_ProcessError(hcan);
+    }
+    
+    // 发送仲裁回收以仲裁丢失/发送错误结束的邮箱
+    CAN_TxArb_ProcessError(hcan);
+
+    // 回收的邮箱可供网关与可靠链路继续装入
+    CAN_Gateway_ProcessTxComplete(hcan);
+    CAN_RLink_ProcessTxComplete(hcan);
+    
+    // 错误计数器/错误类型采样，最后调用(会清除HAL累积错误码)
+    CAN_ErrStats_ProcessError(hcan, error_timestamp_us);
 }
 
 /**
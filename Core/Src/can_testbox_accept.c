@@ -0,0 +1,396 @@
+/**
+ * @file can_testbox_accept.c
+ * @brief 片内CAN软件接收过滤实现
+ * @version 1.0
+ * @date 2024
+ */
+
+#include "can_testbox_accept.h"
+#include "can_testbox_cmd.h"
+#include <string.h>
+
+/* ========================= 私有宏定义 ========================= */
+
+#define CAN_ACCEPT_EXT_EMPTY        0xFFFFFFFFU // 空槽位(扩展帧ID只有29位，不会冲突)
+#define CAN_ACCEPT_HASH_SHIFT       26U         // 32 - log2(CAN_ACCEPT_EXT_SLOTS)
+
+_Static_assert((1UL << (32U - CAN_ACCEPT_HASH_SHIFT)) == CAN_ACCEPT_EXT_SLOTS, "hash shift does not match slot count");
+
+/* ========================= 私有类型定义 ========================= */
+
+/**
+ * @brief 单通道过滤表
+ */
+typedef struct {
+    volatile bool enabled;
+    uint8_t flags;
+    uint8_t ext_count;
+    uint32_t std_bitmap[2048U / 32U];       // 位i对应标准帧ID i
+    uint32_t ext_slots[CAN_ACCEPT_EXT_SLOTS];
+    uint32_t accepted;
+    uint32_t rejected_std;
+    uint32_t rejected_ext;
+    uint32_t rejected_remote;
+} CAN_Accept_Table_t;
+
+/* ========================= 私有变量定义 ========================= */
+
+static CAN_Accept_Table_t g_tables[CAN_ACCEPT_CH_COUNT];
+
+/* ========================= 私有函数声明 ========================= */
+
+static uint32_t CAN_Accept_Hash(uint32_t id);
+static bool CAN_Accept_FindExt(const CAN_Accept_Table_t *table, uint32_t id);
+static uint32_t CAN_Accept_ReadU32(const uint8_t *p);
+static void CAN_Accept_HandleCtrl(uint8_t cmd, const uint8_t *payload, uint8_t len);
+
+/* ========================= 公共API实现 ========================= */
+
+/**
+ * @brief 初始化软件接收过滤
+ */
+CAN_TestBox_Status_t CAN_Accept_Init(void)
+{
+    memset(g_tables, 0, sizeof(g_tables));
+    for (uint8_t ch = 0; ch < CAN_ACCEPT_CH_COUNT; ch++) {
+        memset(g_tables[ch].ext_slots, 0xFF, sizeof(g_tables[ch].ext_slots));
+    }
+
+    if (CAN_Cmd_Register(CAN_CMD_ID_ACCEPT_CTRL, CAN_Accept_HandleCtrl) != CAN_TESTBOX_OK) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 启用/禁用通道过滤
+ */
+CAN_TestBox_Status_t CAN_Accept_Configure(CAN_TestBox_ChannelId_t ch, bool enable, uint8_t flags)
+{
+    if (ch >= CAN_ACCEPT_CH_COUNT) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    g_tables[ch].flags = flags;
+    g_tables[ch].enabled = enable;
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 设置标准帧ID区间
+ */
+CAN_TestBox_Status_t CAN_Accept_SetStdRange(CAN_TestBox_ChannelId_t ch, uint16_t first, uint16_t last, bool accept)
+{
+    if (ch >= CAN_ACCEPT_CH_COUNT || first > last || last > 0x7FFU) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    uint32_t *bitmap = g_tables[ch].std_bitmap;
+
+    // 单字读改写，与中断中的读取无需互斥
+    for (uint32_t id = first; id <= last; id++) {
+        if (accept) {
+            bitmap[id >> 5] |= (1U << (id & 31U));
+        } else {
+            bitmap[id >> 5] &= ~(1U << (id & 31U));
+        }
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 添加扩展帧ID
+ */
+CAN_TestBox_Status_t CAN_Accept_AddExt(CAN_TestBox_ChannelId_t ch, uint32_t id)
+{
+    if (ch >= CAN_ACCEPT_CH_COUNT || id > 0x1FFFFFFFU) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    CAN_Accept_Table_t *table = &g_tables[ch];
+
+    if (CAN_Accept_FindExt(table, id)) {
+        return CAN_TESTBOX_OK;
+    }
+    if (table->ext_count >= CAN_ACCEPT_EXT_MAX) {
+        return CAN_TESTBOX_QUEUE_FULL;
+    }
+
+    // 线性探测到第一个空槽位，单字写入对中断查找是原子的
+    uint32_t slot = CAN_Accept_Hash(id);
+    while (table->ext_slots[slot] != CAN_ACCEPT_EXT_EMPTY) {
+        slot = (slot + 1U) & (CAN_ACCEPT_EXT_SLOTS - 1U);
+    }
+    table->ext_slots[slot] = id;
+    table->ext_count++;
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 删除扩展帧ID
+ * @note  删除后把同一探测链上后续的项前移，查找不需要墓碑标记
+ */
+CAN_TestBox_Status_t CAN_Accept_RemoveExt(CAN_TestBox_ChannelId_t ch, uint32_t id)
+{
+    // 超出29位的ID可能等于空槽位标记，探测会把空槽误当作命中
+    if (ch >= CAN_ACCEPT_CH_COUNT || id > 0x1FFFFFFFU) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    CAN_Accept_Table_t *table = &g_tables[ch];
+    uint32_t slot = CAN_Accept_Hash(id);
+
+    while (table->ext_slots[slot] != id) {
+        if (table->ext_slots[slot] == CAN_ACCEPT_EXT_EMPTY) {
+            return CAN_TESTBOX_NOT_FOUND;
+        }
+        slot = (slot + 1U) & (CAN_ACCEPT_EXT_SLOTS - 1U);
+    }
+
+    // 前移过程中探测链短暂不完整，须与接收中断互斥
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint32_t hole = slot;
+    uint32_t next = (slot + 1U) & (CAN_ACCEPT_EXT_SLOTS - 1U);
+    while (table->ext_slots[next] != CAN_ACCEPT_EXT_EMPTY) {
+        uint32_t home = CAN_Accept_Hash(table->ext_slots[next]);
+        // home不在(hole, next]循环区间内时，该项可以前移到hole
+        if (((next - home) & (CAN_ACCEPT_EXT_SLOTS - 1U)) >= ((next - hole) & (CAN_ACCEPT_EXT_SLOTS - 1U))) {
+            table->ext_slots[hole] = table->ext_slots[next];
+            hole = next;
+        }
+        next = (next + 1U) & (CAN_ACCEPT_EXT_SLOTS - 1U);
+    }
+    table->ext_slots[hole] = CAN_ACCEPT_EXT_EMPTY;
+    table->ext_count--;
+
+    __set_PRIMASK(primask);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 清空位图与集合
+ */
+CAN_TestBox_Status_t CAN_Accept_Clear(CAN_TestBox_ChannelId_t ch)
+{
+    if (ch >= CAN_ACCEPT_CH_COUNT) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    CAN_Accept_Table_t *table = &g_tables[ch];
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset(table->std_bitmap, 0, sizeof(table->std_bitmap));
+    memset(table->ext_slots, 0xFF, sizeof(table->ext_slots));
+    table->ext_count = 0;
+    __set_PRIMASK(primask);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 按FIFO输出邮箱的标识符判定是否接收
+ * @note  只读取RIR寄存器；拒收时直接置RFOM释放邮箱，不读取数据寄存器
+ */
+bool CAN_Accept_Filter(CAN_HandleTypeDef *hcan, CAN_TestBox_ChannelId_t ch, uint32_t fifo)
+{
+    CAN_Accept_Table_t *table = &g_tables[ch];
+
+    if (!table->enabled) {
+        return true;
+    }
+
+    uint32_t rir = hcan->Instance->sFIFOMailBox[fifo].RIR;
+
+    if ((rir & CAN_RI0R_RTR) != 0U && (table->flags & CAN_ACCEPT_FLAG_NO_REMOTE) != 0U) {
+        table->rejected_remote++;
+    } else if ((rir & CAN_RI0R_IDE) == 0U) {
+        uint32_t id = rir >> CAN_RI0R_STID_Pos;
+        if ((table->std_bitmap[id >> 5] & (1U << (id & 31U))) != 0U) {
+            table->accepted++;
+            return true;
+        }
+        table->rejected_std++;
+    } else {
+        if ((table->flags & CAN_ACCEPT_FLAG_EXT_PASS) != 0U ||
+            CAN_Accept_FindExt(table, rir >> CAN_RI0R_EXID_Pos)) {
+            table->accepted++;
+            return true;
+        }
+        table->rejected_ext++;
+    }
+
+    // 释放FIFO输出邮箱
+    if (fifo == CAN_RX_FIFO0) {
+        hcan->Instance->RF0R = CAN_RF0R_RFOM0;
+    } else {
+        hcan->Instance->RF1R = CAN_RF1R_RFOM1;
+    }
+
+    return false;
+}
+
+/**
+ * @brief 获取统计
+ */
+CAN_TestBox_Status_t CAN_Accept_GetStats(CAN_TestBox_ChannelId_t ch, CAN_Accept_Stats_t *stats)
+{
+    if (ch >= CAN_ACCEPT_CH_COUNT || stats == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    const CAN_Accept_Table_t *table = &g_tables[ch];
+
+    stats->enabled = table->enabled ? 1U : 0U;
+    stats->flags = table->flags;
+    stats->ext_count = table->ext_count;
+    stats->accepted = table->accepted;
+    stats->rejected_std = table->rejected_std;
+    stats->rejected_ext = table->rejected_ext;
+    stats->rejected_remote = table->rejected_remote;
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 清空统计
+ */
+void CAN_Accept_ResetStats(CAN_TestBox_ChannelId_t ch)
+{
+    if (ch >= CAN_ACCEPT_CH_COUNT) {
+        return;
+    }
+
+    CAN_Accept_Table_t *table = &g_tables[ch];
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    table->accepted = 0;
+    table->rejected_std = 0;
+    table->rejected_ext = 0;
+    table->rejected_remote = 0;
+    __set_PRIMASK(primask);
+}
+
+/* ========================= 私有函数实现 ========================= */
+
+/**
+ * @brief 扩展帧ID散列(Fibonacci散列取高位)
+ */
+static uint32_t CAN_Accept_Hash(uint32_t id)
+{
+    return (id * 0x9E3779B1U) >> CAN_ACCEPT_HASH_SHIFT;
+}
+
+/**
+ * @brief 在扩展帧集合中查找
+ */
+static bool CAN_Accept_FindExt(const CAN_Accept_Table_t *table, uint32_t id)
+{
+    uint32_t slot = CAN_Accept_Hash(id);
+
+    for (;;) {
+        uint32_t entry = table->ext_slots[slot];
+        if (entry == id) {
+            return true;
+        }
+        if (entry == CAN_ACCEPT_EXT_EMPTY) {
+            return false;
+        }
+        slot = (slot + 1U) & (CAN_ACCEPT_EXT_SLOTS - 1U);
+    }
+}
+
+/**
+ * @brief 读取小端u32
+ */
+static uint32_t CAN_Accept_ReadU32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief 串口命令: 软件接收过滤配置/统计
+ */
+static void CAN_Accept_HandleCtrl(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    CAN_Accept_Stats_t stats;
+    CAN_TestBox_Status_t status;
+
+    if (len < 2U) {
+        CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+        return;
+    }
+
+    CAN_TestBox_ChannelId_t ch = (CAN_TestBox_ChannelId_t)payload[1];
+
+    switch (payload[0]) {
+        case CAN_ACCEPT_CTRL_CONFIG:
+            // 通道、启用、选项
+            if (len != 4U) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+                return;
+            }
+            status = CAN_Accept_Configure(ch, payload[2] != 0U, payload[3]);
+            break;
+
+        case CAN_ACCEPT_CTRL_STD_RANGE:
+            // 通道、接收、起始ID(u16)、结束ID(u16)
+            if (len != 7U) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+                return;
+            }
+            status = CAN_Accept_SetStdRange(ch, (uint16_t)(payload[3] | (payload[4] << 8)),
+                                            (uint16_t)(payload[5] | (payload[6] << 8)), payload[2] != 0U);
+            break;
+
+        case CAN_ACCEPT_CTRL_EXT_ADD:
+        case CAN_ACCEPT_CTRL_EXT_REMOVE:
+            // 通道、ID(u32)
+            if (len != 6U) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+                return;
+            }
+            if (payload[0] == CAN_ACCEPT_CTRL_EXT_ADD) {
+                status = CAN_Accept_AddExt(ch, CAN_Accept_ReadU32(&payload[2]));
+            } else {
+                status = CAN_Accept_RemoveExt(ch, CAN_Accept_ReadU32(&payload[2]));
+            }
+            break;
+
+        case CAN_ACCEPT_CTRL_CLEAR:
+            status = CAN_Accept_Clear(ch);
+            break;
+
+        case CAN_ACCEPT_CTRL_STATUS:
+            if (CAN_Accept_GetStats(ch, &stats) != CAN_TESTBOX_OK) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_PARAM);
+                return;
+            }
+            CAN_Cmd_SendResponse(cmd, (const uint8_t *)&stats, sizeof(stats));
+            return;
+
+        case CAN_ACCEPT_CTRL_RESET_STATS:
+            if (ch >= CAN_ACCEPT_CH_COUNT) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_PARAM);
+                return;
+            }
+            CAN_Accept_ResetStats(ch);
+            status = CAN_TESTBOX_OK;
+            break;
+
+        default:
+            CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_PARAM);
+            return;
+    }
+
+    CAN_Cmd_SendResult(cmd, (status == CAN_TESTBOX_OK) ? CAN_CMD_RESULT_OK :
+                            (status == CAN_TESTBOX_QUEUE_FULL) ? CAN_CMD_RESULT_FAILED : CAN_CMD_RESULT_BAD_PARAM);
+}
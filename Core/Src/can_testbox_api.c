@@ -7,105 +7,165 @@
 
 #include "can_testbox_api.h"
 #include "cmsis_os.h"
+#include "can_testbox_format.h"
+#include "can_testbox_mem.h"
+#include "can_testbox_frame.h"
+#include "can_testbox_event.h"
+#include "can_testbox_timestamp.h"
+#include "can_testbox_latency.h"
+#include "can_testbox_seq.h"
+#include "can_testbox_peps_scenario.h"
+#include "can_testbox_e2e.h"
+#include "can_testbox_gen.h"
+#include "can_testbox_txarb.h"
+#include "can_testbox_cmd.h"
 #include <string.h>
 #include <stdio.h>
 
+/* ========================= 私有类型定义 ========================= */
+
+/**
+ * @brief 通道上下文
+ */
+struct CAN_TestBox_ChannelCtx {
+    CAN_TestBox_ChannelId_t id;                 // 通道编号
+    CAN_HandleTypeDef *hcan;                    // bxCAN句柄，外部控制器为NULL
+    const CAN_TestBox_ChannelOps_t *ops;        // 外部控制器操作接口
+    bool initialized;                           // 初始化标志
+    bool running;                               // 运行状态标志
+    osMessageQueueId_t receive_queue;           // 接收队列
+    CAN_TestBox_PeriodicMsg_t periodic_messages[CAN_TESTBOX_MAX_PERIODIC_MSGS]; // 周期性消息数组
+    uint8_t periodic_msg_count;
+    CAN_TestBox_Filter_t filters[CAN_TESTBOX_FILTER_COUNT_MAX];                // 过滤器数组
+    uint8_t filter_count;
+    CAN_TestBox_Statistics_t statistics;        // 统计信息
+    CAN_TestBox_RxCallback_t rx_callback;       // 接收回调函数
+    uint32_t start_time;                        // 启动时间
+    bool bus_off;                               // 上次轮询时是否处于总线关闭
+    volatile bool tx_blocked;                   // 周期报文因邮箱满发送失败，等待发送完成通知
+    uint32_t *rx_entry;                         // 接收队列影子环(入队帧的中断入口周期数)，外部控制器为NULL
+    uint32_t rx_entry_head;                     // 影子环写位置(仅接收中断写)
+    uint32_t rx_entry_tail;                     // 影子环读位置(仅出队时写)
+};
+
 /* ========================= 私有变量定义 ========================= */
 
-// CAN句柄
-static CAN_HandleTypeDef *g_hcan = NULL;
+// 通道上下文
+static struct CAN_TestBox_ChannelCtx g_channels[CAN_TESTBOX_CH_COUNT];
 
-// 初始化标志
-static bool g_initialized = false;
+// 默认通道(无通道参数的接口使用)
+static CAN_TestBox_Channel_t g_default_channel = NULL;
 
-// 运行状态标志
-static bool g_running = false;
+// 周期报文发送抖动统计(仅在测试盒任务中访问)
+static CAN_TestBox_Jitter_t g_periodic_jitter;
 
-// 接收队列
-static osMessageQueueId_t g_receive_queue = NULL;
-static const osMessageQueueAttr_t g_receive_queue_attr = {
-    .name = "CANTestBoxReceiveQueue"
-};
+// 周期报文上线抖动统计(仅在发送完成中断中更新)
+static CAN_TestBox_Jitter_t g_periodic_wire_jitter;
+
+/**
+ * @brief 发送确认日志项
+ */
+typedef struct {
+    CAN_TestBox_Frame_t frame;
+    uint32_t done_us;                           // 发送完成时间戳
+    uint32_t latency_us;                        // 入队到发送完成的时延
+    uint8_t ch;
+} CAN_TestBox_TxConfirm_t;
+
+// 发送确认日志环(发送完成中断在仲裁器临界区内写入，测试盒任务读出)
+static CAN_TestBox_TxConfirm_t g_tx_confirm_ring[CAN_TESTBOX_TXCONF_RING_SIZE];
+static volatile uint32_t g_tx_confirm_head = 0;
+static volatile uint32_t g_tx_confirm_tail = 0;
+static uint32_t g_tx_confirm_dropped = 0;
+
+// 发送日志模式
+static volatile uint8_t g_tx_log_mode = CAN_TESTBOX_TXLOG_SUBMIT;
+
+// 周期报文自动分配相位
+static bool g_auto_phase = true;
 
-// 周期性消息数组
-static CAN_TestBox_PeriodicMsg_t g_periodic_messages[CAN_TESTBOX_MAX_PERIODIC_MSGS];
-static uint8_t g_periodic_msg_count = 0;
+// 接收队列静态存储(CAN1使用默认深度，其余通道使用通道深度)
+CAN_TESTBOX_STATIC_QUEUE(g_rx_queue_can1, CAN_TESTBOX_RECEIVE_QUEUE_SIZE, sizeof(CAN_TestBox_Frame_t));
+CAN_TESTBOX_STATIC_QUEUE(g_rx_queue_can2, CAN_TESTBOX_CHANNEL_RX_QUEUE_SIZE, sizeof(CAN_TestBox_Frame_t));
+CAN_TESTBOX_STATIC_QUEUE(g_rx_queue_ext, CAN_TESTBOX_CHANNEL_RX_QUEUE_SIZE, sizeof(CAN_TestBox_Frame_t));
 
-// 过滤器数组
-static CAN_TestBox_Filter_t g_filters[CAN_TESTBOX_FILTER_COUNT_MAX];
-static uint8_t g_filter_count = 0;
+// 接收队列影子环，与片内CAN接收队列同步入队/出队，用于统计消费时延
+#define CAN_TESTBOX_RX_ENTRY_RING   128U
+_Static_assert(CAN_TESTBOX_RECEIVE_QUEUE_SIZE <= CAN_TESTBOX_RX_ENTRY_RING &&
+               CAN_TESTBOX_CHANNEL_RX_QUEUE_SIZE <= CAN_TESTBOX_RX_ENTRY_RING, "rx entry ring too small");
+static uint32_t g_rx_entry[CAN_TESTBOX_CH_EXT][CAN_TESTBOX_RX_ENTRY_RING];
 
-// 统计信息
-static CAN_TestBox_Statistics_t g_statistics = {0};
+// 接收队列属性
+static const osMessageQueueAttr_t g_receive_queue_attr[CAN_TESTBOX_CH_COUNT] = {
+    { .name = "CANTestBoxReceiveQueue", CAN_TESTBOX_STATIC_QUEUE_MEM(g_rx_queue_can1) },
+    { .name = "CANTestBoxReceiveQueue2", CAN_TESTBOX_STATIC_QUEUE_MEM(g_rx_queue_can2) },
+    { .name = "CANTestBoxReceiveQueueExt", CAN_TESTBOX_STATIC_QUEUE_MEM(g_rx_queue_ext) }
+};
 
-// 接收回调函数
-static CAN_TestBox_RxCallback_t g_rx_callback = NULL;
+// 发送日志前缀，CAN1保持原有格式
+static const char * const g_tx_log_tag[CAN_TESTBOX_CH_COUNT] = {
+    "[TX]",
+    "[CAN2-TX]",
+    "[EXT-TX]"
+};
 
-// 系统时钟
-static uint32_t g_system_start_time = 0;
+// 发送确认日志前缀(仅片内CAN)
+static const char * const g_tx_confirm_tag[CAN_TESTBOX_CH_EXT] = {
+    "[TXC]",
+    "[CAN2-TXC]"
+};
 
 /* ========================= 私有函数声明 ========================= */
 
-static CAN_TestBox_Status_t CAN_TestBox_SendMessage_Internal(const CAN_TestBox_Message_t *message);
-static void CAN_TestBox_ProcessPeriodicMessages(void);
-static void CAN_TestBox_UpdateStatistics(void);
+static CAN_TestBox_Status_t CAN_TestBox_ChannelSetup(CAN_TestBox_ChannelId_t id, uint32_t queue_size);
+static CAN_TestBox_Status_t CAN_TestBox_SendMessage_Internal(CAN_TestBox_Channel_t channel, const CAN_TestBox_Frame_t *frame,
+                                                             uint8_t tx_class, uint8_t tx_tag);
+static void CAN_TestBox_LogTx(CAN_TestBox_Channel_t channel, const CAN_TestBox_Frame_t *frame);
+static void CAN_TestBox_ProcessTxConfirm(CAN_TestBox_ChannelId_t ch, uint8_t tx_class, uint8_t tag,
+                                         const CAN_TestBox_Frame_t *frame, uint32_t enqueue_us,
+                                         uint32_t done_us, bool sent);
+static void CAN_TestBox_FlushTxConfirm(void);
+static void CAN_TestBox_HandleTxConfirmCtrl(uint8_t cmd, const uint8_t *payload, uint8_t len);
+static uint32_t CAN_TestBox_Gcd(uint32_t a, uint32_t b);
+static uint32_t CAN_TestBox_FrameBits(const CAN_TestBox_Frame_t *frame);
+static uint32_t CAN_TestBox_AssignPhase(CAN_TestBox_Channel_t channel, uint8_t index);
+static void CAN_TestBox_RequestPhase(CAN_TestBox_PeriodicMsg_t *periodic, uint32_t now);
+static void CAN_TestBox_ResolvePhase(CAN_TestBox_Channel_t channel, uint8_t index, uint32_t now);
+static void CAN_TestBox_AnchorPeriodic(CAN_TestBox_PeriodicMsg_t *periodic, uint32_t now);
+static void CAN_TestBox_HandlePhaseCtrl(uint8_t cmd, const uint8_t *payload, uint8_t len);
+static void CAN_TestBox_ProcessPeriodicMessages(CAN_TestBox_Channel_t channel);
+static void CAN_TestBox_UpdateStatistics(CAN_TestBox_Channel_t channel);
 static uint32_t CAN_TestBox_GetTick(void);
 static CAN_TestBox_Status_t CAN_TestBox_ValidateMessage(const CAN_TestBox_Message_t *message);
+static CAN_TestBox_Channel_t CAN_TestBox_FindChannelByHandle(CAN_HandleTypeDef *hcan);
+static bool CAN_TestBox_ChannelIsSilent(CAN_TestBox_Channel_t channel);
 
 /* ========================= 公共API实现 ========================= */
 
 /**
  * @brief 初始化CAN测试盒
+ * @note  打开hcan对应的片内通道并设为默认通道
  */
 CAN_TestBox_Status_t CAN_TestBox_Init(CAN_HandleTypeDef *hcan)
 {
     if (hcan == NULL) {
         return CAN_TESTBOX_INVALID_PARAM;
     }
-    
-    if (g_initialized) {
+
+    if (g_default_channel != NULL) {
         return CAN_TESTBOX_ALREADY_EXISTS;
     }
-    
-    // 保存CAN句柄
-    g_hcan = hcan;
-    
-    // 创建接收队列
-    g_receive_queue = osMessageQueueNew(CAN_TESTBOX_RECEIVE_QUEUE_SIZE, sizeof(CAN_TestBox_Message_t), &g_receive_queue_attr);
-    if (g_receive_queue == NULL) {
-        return CAN_TESTBOX_ERROR;
-    }
-    
-    // 初始化周期性消息数组
-    memset(g_periodic_messages, 0, sizeof(g_periodic_messages));
-    g_periodic_msg_count = 0;
-    
-    // 初始化过滤器数组
-    memset(g_filters, 0, sizeof(g_filters));
-    g_filter_count = 0;
-    
-    // 重置统计信息
-    memset(&g_statistics, 0, sizeof(g_statistics));
-    
-    // 记录启动时间
-    g_system_start_time = CAN_TestBox_GetTick();
-    
-    // 启动CAN
-    if (HAL_CAN_Start(g_hcan) != HAL_OK) {
-        osMessageQueueDelete(g_receive_queue);
-        return CAN_TESTBOX_ERROR;
-    }
-    
-    // 激活CAN接收中断
-    if (HAL_CAN_ActivateNotification(g_hcan, CAN_IT_RX_FIFO0_MSG_PENDING | CAN_IT_ERROR) != HAL_OK) {
-        HAL_CAN_Stop(g_hcan);
-        osMessageQueueDelete(g_receive_queue);
-        return CAN_TESTBOX_ERROR;
+
+    CAN_TestBox_ChannelId_t id = (hcan->Instance == CAN2) ? CAN_TESTBOX_CH_CAN2 : CAN_TESTBOX_CH_CAN1;
+    CAN_TestBox_Channel_t channel;
+
+    CAN_TestBox_Status_t status = CAN_TestBox_ChannelOpen(id, hcan, &channel);
+    if (status != CAN_TESTBOX_OK) {
+        return status;
     }
-    
-    g_initialized = true;
-    g_running = true;
-    
+
+    g_default_channel = channel;
+
     // 不打印初始化成功信息 (Don't print initialization success message)
     return CAN_TESTBOX_OK;
 }
@@ -115,28 +175,15 @@ CAN_TestBox_Status_t CAN_TestBox_Init(CAN_HandleTypeDef *hcan)
  */
 CAN_TestBox_Status_t CAN_TestBox_DeInit(void)
 {
-    if (!g_initialized) {
+    if (g_default_channel == NULL) {
         return CAN_TESTBOX_NOT_INITIALIZED;
     }
-    
-    // 停止所有周期性消息
-    CAN_TestBox_StopAllPeriodicMessages();
-    
-    // 停止CAN
-    HAL_CAN_Stop(g_hcan);
-    
-    // 删除队列
-    if (g_receive_queue != NULL) {
-        osMessageQueueDelete(g_receive_queue);
-        g_receive_queue = NULL;
-    }
-    
-    g_initialized = false;
-    g_running = false;
-    g_hcan = NULL;
-    
+
+    CAN_TestBox_Status_t status = CAN_TestBox_ChannelClose(g_default_channel);
+    g_default_channel = NULL;
+
     // 不打印反初始化信息 (Don't print deinitialization information)
-    return CAN_TESTBOX_OK;
+    return status;
 }
 
 /* ========================= 1. 单帧事件报文发送接口 ========================= */
@@ -146,22 +193,7 @@ CAN_TestBox_Status_t CAN_TestBox_DeInit(void)
  */
 CAN_TestBox_Status_t CAN_TestBox_SendSingleFrame(const CAN_TestBox_Message_t *message)
 {
-    if (!g_initialized || !g_running) {
-        return CAN_TESTBOX_NOT_INITIALIZED;
-    }
-    
-    if (message == NULL) {
-        return CAN_TESTBOX_INVALID_PARAM;
-    }
-    
-    // 验证消息参数
-    CAN_TestBox_Status_t status = CAN_TestBox_ValidateMessage(message);
-    if (status != CAN_TESTBOX_OK) {
-        return status;
-    }
-    
-    // 直接发送
-    return CAN_TestBox_SendMessage_Internal(message);
+    return CAN_TestBox_ChannelSendSingleFrame(g_default_channel, message);
 }
 
 /**
@@ -172,7 +204,7 @@ CAN_TestBox_Status_t CAN_TestBox_SendSingleFrameQuick(uint32_t id, uint8_t dlc,
     if (data == NULL || dlc > 8) {
         return CAN_TESTBOX_INVALID_PARAM;
     }
-    
+
     CAN_TestBox_Message_t message = {
         .id = id,
         .dlc = dlc,
@@ -180,9 +212,9 @@ CAN_TestBox_Status_t CAN_TestBox_SendSingleFrameQuick(uint32_t id, uint8_t dlc,
         .is_remote = false,
         .timestamp = CAN_TestBox_GetTick()
     };
-    
+
     memcpy(message.data, data, dlc);
-    
+
     return CAN_TestBox_SendSingleFrame(&message);
 }
 
@@ -193,50 +225,7 @@ CAN_TestBox_Status_t CAN_TestBox_SendSingleFrameQuick(uint32_t id, uint8_t dlc,
  */
 CAN_TestBox_Status_t CAN_TestBox_StartPeriodicMessage(const CAN_TestBox_Message_t *message, uint32_t period_ms, uint8_t *handle_id)
 {
-    if (!g_initialized || !g_running) {
-        return CAN_TESTBOX_NOT_INITIALIZED;
-    }
-    
-    if (message == NULL || handle_id == NULL || period_ms == 0) {
-        return CAN_TESTBOX_INVALID_PARAM;
-    }
-    
-    if (g_periodic_msg_count >= CAN_TESTBOX_MAX_PERIODIC_MSGS) {
-        return CAN_TESTBOX_QUEUE_FULL;
-    }
-    
-    // 验证消息参数
-    CAN_TestBox_Status_t status = CAN_TestBox_ValidateMessage(message);
-    if (status != CAN_TESTBOX_OK) {
-        return status;
-    }
-    
-    // 查找空闲槽位
-    uint8_t index = 0;
-    for (index = 0; index < CAN_TESTBOX_MAX_PERIODIC_MSGS; index++) {
-        if (!g_periodic_messages[index].enabled) {
-            break;
-        }
-    }
-    
-    if (index >= CAN_TESTBOX_MAX_PERIODIC_MSGS) {
-        return CAN_TESTBOX_QUEUE_FULL;
-    }
-    
-    // 配置周期性消息
-    g_periodic_messages[index].message = *message;
-    g_periodic_messages[index].period_ms = period_ms;
-    g_periodic_messages[index].enabled = true;
-    g_periodic_messages[index].send_count = 0;
-    g_periodic_messages[index].last_send_time = CAN_TestBox_GetTick();
-    g_periodic_messages[index].handle_id = index;
-    
-    *handle_id = index;
-    g_periodic_msg_count++;
-    
-    // 不打印周期性消息启动信息 (Don't print periodic message start information)
-    
-    return CAN_TESTBOX_OK;
+    return CAN_TestBox_ChannelStartPeriodicMessage(g_default_channel, message, period_ms, handle_id);
 }
 
 /**
@@ -244,24 +233,7 @@ CAN_TestBox_Status_t CAN_TestBox_StartPeriodicMessage(const CAN_TestBox_Message_
  */
 CAN_TestBox_Status_t CAN_TestBox_StopPeriodicMessage(uint8_t handle_id)
 {
-    if (!g_initialized) {
-        return CAN_TESTBOX_NOT_INITIALIZED;
-    }
-    
-    if (handle_id >= CAN_TESTBOX_MAX_PERIODIC_MSGS) {
-        return CAN_TESTBOX_INVALID_PARAM;
-    }
-    
-    if (!g_periodic_messages[handle_id].enabled) {
-        return CAN_TESTBOX_NOT_FOUND;
-    }
-    
-    g_periodic_messages[handle_id].enabled = false;
-    g_periodic_msg_count--;
-    
-    // 不打印周期性消息停止信息 (Don't print periodic message stop information)
-    
-    return CAN_TESTBOX_OK;
+    return CAN_TestBox_ChannelStopPeriodicMessage(g_default_channel, handle_id);
 }
 
 /**
@@ -269,21 +241,7 @@ CAN_TestBox_Status_t CAN_TestBox_StopPeriodicMessage(uint8_t handle_id)
  */
 CAN_TestBox_Status_t CAN_TestBox_ModifyPeriodicPeriod(uint8_t handle_id, uint32_t new_period_ms)
 {
-    if (!g_initialized) {
-        return CAN_TESTBOX_NOT_INITIALIZED;
-    }
-    
-    if (handle_id >= CAN_TESTBOX_MAX_PERIODIC_MSGS || new_period_ms == 0) {
-        return CAN_TESTBOX_INVALID_PARAM;
-    }
-    
-    if (!g_periodic_messages[handle_id].enabled) {
-        return CAN_TESTBOX_NOT_FOUND;
-    }
-    
-    g_periodic_messages[handle_id].period_ms = new_period_ms;
-    
-    return CAN_TESTBOX_OK;
+    return CAN_TestBox_ChannelModifyPeriodicPeriod(g_default_channel, handle_id, new_period_ms);
 }
 
 /**
@@ -291,22 +249,7 @@ CAN_TestBox_Status_t CAN_TestBox_ModifyPeriodicPeriod(uint8_t handle_id, uint32_
  */
 CAN_TestBox_Status_t CAN_TestBox_ModifyPeriodicData(uint8_t handle_id, const uint8_t *new_data, uint8_t dlc)
 {
-    if (!g_initialized) {
-        return CAN_TESTBOX_NOT_INITIALIZED;
-    }
-    
-    if (handle_id >= CAN_TESTBOX_MAX_PERIODIC_MSGS || new_data == NULL || dlc > 8) {
-        return CAN_TESTBOX_INVALID_PARAM;
-    }
-    
-    if (!g_periodic_messages[handle_id].enabled) {
-        return CAN_TESTBOX_NOT_FOUND;
-    }
-    
-    g_periodic_messages[handle_id].message.dlc = dlc;
-    memcpy(g_periodic_messages[handle_id].message.data, new_data, dlc);
-    
-    return CAN_TESTBOX_OK;
+    return CAN_TestBox_ChannelModifyPeriodicData(g_default_channel, handle_id, new_data, dlc);
 }
 
 /**
@@ -314,19 +257,7 @@ CAN_TestBox_Status_t CAN_TestBox_ModifyPeriodicData(uint8_t handle_id, const uin
  */
 CAN_TestBox_Status_t CAN_TestBox_StopAllPeriodicMessages(void)
 {
-    if (!g_initialized) {
-        return CAN_TESTBOX_NOT_INITIALIZED;
-    }
-    
-    for (uint8_t i = 0; i < CAN_TESTBOX_MAX_PERIODIC_MSGS; i++) {
-        g_periodic_messages[i].enabled = false;
-    }
-    
-    g_periodic_msg_count = 0;
-    
-    // 不打印所有周期性消息停止信息 (Don't print all periodic messages stop information)
-    
-    return CAN_TESTBOX_OK;
+    return CAN_TestBox_ChannelStopAllPeriodicMessages(g_default_channel);
 }
 
 /* ========================= 3. 连续帧报文发送接口 ========================= */
@@ -336,65 +267,19 @@ CAN_TestBox_Status_t CAN_TestBox_StopAllPeriodicMessages(void)
  */
 CAN_TestBox_Status_t CAN_TestBox_SendBurstFrames(const CAN_TestBox_BurstMsg_t *burst_config)
 {
-    if (!g_initialized || !g_running) {
-        return CAN_TESTBOX_NOT_INITIALIZED;
-    }
-    
-    if (burst_config == NULL || burst_config->burst_count == 0 || burst_config->burst_count > CAN_TESTBOX_BURST_COUNT_MAX) {
-        return CAN_TESTBOX_INVALID_PARAM;
-    }
-    
-    // 验证消息参数
-    CAN_TestBox_Status_t status = CAN_TestBox_ValidateMessage(&burst_config->message);
-    if (status != CAN_TESTBOX_OK) {
-        return status;
-    }
-    
-    CAN_TestBox_Message_t current_msg = burst_config->message;
-    
-    // 不打印发送连续帧信息 (Don't print burst frames sending information)
-    
-    for (uint16_t i = 0; i < burst_config->burst_count; i++) {
-        // 发送当前消息
-        status = CAN_TestBox_SendMessage_Internal(&current_msg);
-        if (status != CAN_TESTBOX_OK) {
-            // 不打印连续帧发送失败信息 (Don't print burst frame send failure information)
-            return status;
-        }
-        
-        // 自动递增ID
-        if (burst_config->auto_increment_id) {
-            current_msg.id++;
-        }
-        
-        // 自动递增数据
-        if (burst_config->auto_increment_data && current_msg.dlc > 0) {
-            for (uint8_t j = 0; j < current_msg.dlc; j++) {
-                current_msg.data[j]++;
-            }
-        }
-        
-        // 发送间隔延时
-        if (i < burst_config->burst_count - 1 && burst_config->interval_ms > 0) {
-            osDelay(burst_config->interval_ms);
-        }
-    }
-    
-    // 不打印连续帧完成信息 (Don't print burst frames completion information)
-    
-    return CAN_TESTBOX_OK;
+    return CAN_TestBox_ChannelSendBurstFrames(g_default_channel, burst_config);
 }
 
 /**
  * @brief 发送连续帧报文(快速接口)
  */
-CAN_TestBox_Status_t CAN_TestBox_SendBurstFramesQuick(uint32_t id, uint8_t dlc, const uint8_t *data, 
+CAN_TestBox_Status_t CAN_TestBox_SendBurstFramesQuick(uint32_t id, uint8_t dlc, const uint8_t *data,
                                                       uint16_t burst_count, uint16_t interval_ms, bool auto_increment_id)
 {
     if (data == NULL || dlc > 8 || burst_count == 0) {
         return CAN_TESTBOX_INVALID_PARAM;
     }
-    
+
     CAN_TestBox_BurstMsg_t burst_config = {
         .message = {
             .id = id,
@@ -408,9 +293,9 @@ CAN_TestBox_Status_t CAN_TestBox_SendBurstFramesQuick(uint32_t id, uint8_t dlc,
         .auto_increment_id = auto_increment_id,
         .auto_increment_data = false
     };
-    
+
     memcpy(burst_config.message.data, data, dlc);
-    
+
     return CAN_TestBox_SendBurstFrames(&burst_config);
 }
 
@@ -421,8 +306,7 @@ CAN_TestBox_Status_t CAN_TestBox_SendBurstFramesQuick(uint32_t id, uint8_t dlc,
  */
 CAN_TestBox_Status_t CAN_TestBox_SetRxCallback(CAN_TestBox_RxCallback_t callback)
 {
-    g_rx_callback = callback;
-    return CAN_TESTBOX_OK;
+    return CAN_TestBox_ChannelSetRxCallback(g_default_channel, callback);
 }
 
 /**
@@ -430,23 +314,7 @@ CAN_TestBox_Status_t CAN_TestBox_SetRxCallback(CAN_TestBox_RxCallback_t callback
  */
 CAN_TestBox_Status_t CAN_TestBox_ReceiveMessage(CAN_TestBox_Message_t *message, uint32_t timeout_ms)
 {
-    if (!g_initialized) {
-        return CAN_TESTBOX_NOT_INITIALIZED;
-    }
-    
-    if (message == NULL) {
-        return CAN_TESTBOX_INVALID_PARAM;
-    }
-    
-    osStatus_t status = osMessageQueueGet(g_receive_queue, message, NULL, timeout_ms);
-    
-    if (status == osOK) {
-        return CAN_TESTBOX_OK;
-    } else if (status == osErrorTimeout) {
-        return CAN_TESTBOX_TIMEOUT;
-    } else {
-        return CAN_TESTBOX_ERROR;
-    }
+    return CAN_TestBox_ChannelReceiveMessage(g_default_channel, message, timeout_ms);
 }
 
 /**
@@ -454,16 +322,7 @@ CAN_TestBox_Status_t CAN_TestBox_ReceiveMessage(CAN_TestBox_Message_t *message,
  */
 CAN_TestBox_Status_t CAN_TestBox_ClearRxQueue(void)
 {
-    if (!g_initialized) {
-        return CAN_TESTBOX_NOT_INITIALIZED;
-    }
-    
-    CAN_TestBox_Message_t dummy_msg;
-    while (osMessageQueueGet(g_receive_queue, &dummy_msg, NULL, 0) == osOK) {
-        // 清空队列
-    }
-    
-    return CAN_TESTBOX_OK;
+    return CAN_TestBox_ChannelClearRxQueue(g_default_channel);
 }
 
 /* ========================= 6. 统计信息接口 ========================= */
@@ -473,20 +332,7 @@ CAN_TestBox_Status_t CAN_TestBox_ClearRxQueue(void)
  */
 CAN_TestBox_Status_t CAN_TestBox_GetStatistics(CAN_TestBox_Statistics_t *stats)
 {
-    if (!g_initialized) {
-        return CAN_TESTBOX_NOT_INITIALIZED;
-    }
-    
-    if (stats == NULL) {
-        return CAN_TESTBOX_INVALID_PARAM;
-    }
-    
-    // 更新运行时间
-    g_statistics.uptime_ms = CAN_TestBox_GetTick() - g_system_start_time;
-    
-    *stats = g_statistics;
-    
-    return CAN_TESTBOX_OK;
+    return CAN_TestBox_ChannelGetStatistics(g_default_channel, stats);
 }
 
 /**
@@ -494,14 +340,7 @@ CAN_TestBox_Status_t CAN_TestBox_GetStatistics(CAN_TestBox_Statistics_t *stats)
  */
 CAN_TestBox_Status_t CAN_TestBox_ResetStatistics(void)
 {
-    if (!g_initialized) {
-        return CAN_TESTBOX_NOT_INITIALIZED;
-    }
-    
-    memset(&g_statistics, 0, sizeof(g_statistics));
-    g_system_start_time = CAN_TestBox_GetTick();
-    
-    return CAN_TESTBOX_OK;
+    return CAN_TestBox_ChannelResetStatistics(g_default_channel);
 }
 
 /* ========================= 7. 配置管理接口 ========================= */
@@ -511,19 +350,7 @@ CAN_TestBox_Status_t CAN_TestBox_ResetStatistics(void)
  */
 CAN_TestBox_Status_t CAN_TestBox_Enable(bool enable)
 {
-    if (!g_initialized) {
-        return CAN_TESTBOX_NOT_INITIALIZED;
-    }
-    
-    g_running = enable;
-    
-    if (enable) {
-        // 不打印启用信息 (Don't print enable information)
-    } else {
-        // 不打印禁用信息 (Don't print disable information)
-    }
-    
-    return CAN_TESTBOX_OK;
+    return CAN_TestBox_ChannelEnable(g_default_channel, enable);
 }
 
 /* ========================= 8. 诊断和调试接口 ========================= */
@@ -533,11 +360,7 @@ CAN_TestBox_Status_t CAN_TestBox_Enable(bool enable)
  */
 uint32_t CAN_TestBox_GetBusStatus(void)
 {
-    if (!g_initialized || g_hcan == NULL) {
-        return 0xFFFFFFFF;
-    }
-    
-    return g_hcan->Instance->ESR;
+    return CAN_TestBox_ChannelGetBusStatus(g_default_channel);
 }
 
 /**
@@ -545,7 +368,11 @@ uint32_t CAN_TestBox_GetBusStatus(void)
  */
 uint32_t CAN_TestBox_GetLastError(void)
 {
-    return g_statistics.last_error_code;
+    if (g_default_channel == NULL) {
+        return 0;
+    }
+
+    return g_default_channel->statistics.last_error_code;
 }
 
 /**
@@ -553,29 +380,25 @@ uint32_t CAN_TestBox_GetLastError(void)
  */
 CAN_TestBox_Status_t CAN_TestBox_SelfTest(void)
 {
-    if (!g_initialized) {
+    if (g_default_channel == NULL || !g_default_channel->initialized) {
         return CAN_TESTBOX_NOT_INITIALIZED;
     }
-    
+
     // 不打印自检开始信息 (Don't print self test start information)
-    
+
     // 发送自检消息
-    CAN_TestBox_Message_t test_msg = {
-        .id = 0x7FF,
-        .dlc = 8,
-        .data = {0x55, 0xAA, 0x55, 0xAA, 0x55, 0xAA, 0x55, 0xAA},
-        .is_extended = false,
-        .is_remote = false
-    };
-    
-    CAN_TestBox_Status_t status = CAN_TestBox_SendMessage_Internal(&test_msg);
-    
+    static const uint8_t test_data[8] = {0x55, 0xAA, 0x55, 0xAA, 0x55, 0xAA, 0x55, 0xAA};
+    CAN_TestBox_Frame_t test_frame;
+    CAN_Frame_Pack(&test_frame, 0x7FF, false, false, 8, test_data, g_default_channel->id, CAN_TestBox_GetTick());
+
+    CAN_TestBox_Status_t status = CAN_TestBox_SendMessage_Internal(g_default_channel, &test_frame, CAN_TXARB_CLASS_NORMAL, 0);
+
     if (status == CAN_TESTBOX_OK) {
         // 不打印自检通过信息 (Don't print self test pass information)
     } else {
         // 不打印自检失败信息 (Don't print self test fail information)
     }
-    
+
     return status;
 }
 
@@ -583,227 +406,1453 @@ CAN_TestBox_Status_t CAN_TestBox_SelfTest(void)
 
 /**
  * @brief CAN测试盒主任务
+ * @note  所有已打开通道共用同一调度
  */
 void CAN_TestBox_Task(void)
 {
-    if (!g_initialized || !g_running) {
-        return;
-    }
-    
-    // 处理周期性消息
-    CAN_TestBox_ProcessPeriodicMessages();
-    
-    // 更新统计信息
-    CAN_TestBox_UpdateStatistics();
-}
-
-/**
- * @brief 获取任务运行状态
- */
-bool CAN_TestBox_IsRunning(void)
-{
-    return g_running;
-}
+    // 输出已确认发送的报文
+    CAN_TestBox_FlushTxConfirm();
 
-/* ========================= 私有函数实现 ========================= */
+    for (uint8_t i = 0; i < CAN_TESTBOX_CH_COUNT; i++) {
+        CAN_TestBox_Channel_t channel = &g_channels[i];
 
-/**
- * @brief 内部消息发送函数
- */
-static CAN_TestBox_Status_t CAN_TestBox_SendMessage_Internal(const CAN_TestBox_Message_t *message)
-{
-    CAN_TxHeaderTypeDef tx_header;
-    uint32_t tx_mailbox;
-    
-    // 配置发送头
-    if (message->is_extended) {
-        tx_header.IDE = CAN_ID_EXT;
-        tx_header.ExtId = message->id;
-    } else {
-        tx_header.IDE = CAN_ID_STD;
-        tx_header.StdId = message->id;
-    }
-    
-    tx_header.RTR = message->is_remote ? CAN_RTR_REMOTE : CAN_RTR_DATA;
-    tx_header.DLC = message->dlc;
-    tx_header.TransmitGlobalTime = DISABLE;
-    
-    // 发送消息
-    HAL_StatusTypeDef hal_status = HAL_CAN_AddTxMessage(g_hcan, &tx_header, (uint8_t*)message->data, &tx_mailbox);
-    
-    if (hal_status == HAL_OK) {
-        g_statistics.tx_total_count++;
-        g_statistics.tx_success_count++;
-        
-        // 按照用户要求的格式打印发送日志
-        printf("[TX] ID:0x%03X, Data:", (unsigned int)message->id);
-        
-        if (!message->is_remote) {
-            for (int i = 0; i < message->dlc; i++) {
-                printf("%02X", message->data[i]);
-                if (i < message->dlc - 1) printf(" ");
-            }
-        } else {
-            printf("RTR");
+        if (!channel->initialized || !channel->running) {
+            continue;
         }
-        
-        printf(" [END]\r\n");
-        
-        return CAN_TESTBOX_OK;
-    } else {
-        g_statistics.tx_total_count++;
-        g_statistics.tx_error_count++;
-        g_statistics.last_error_code = hal_status;
-        
-        // 打印发送错误信息
-        printf("[CAN-ERROR] Failed to send message - ID:0x%03X, Error:%d\r\n", 
-               (unsigned int)message->id, 
-               hal_status);
-        
-        return CAN_TESTBOX_ERROR;
+
+        // 处理周期性消息
+        CAN_TestBox_ProcessPeriodicMessages(channel);
+
+        // 更新统计信息
+        CAN_TestBox_UpdateStatistics(channel);
     }
 }
 
 /**
- * @brief 处理周期性消息
+ * @brief 计算距下一个周期报文到期的时间
+ * @note  只在测试盒任务中调用，结果作为事件等待超时
  */
-static void CAN_TestBox_ProcessPeriodicMessages(void)
+uint32_t CAN_TestBox_GetIdleTime(uint32_t max_ms)
 {
-    uint32_t current_time = CAN_TestBox_GetTick();
-    
-    for (uint8_t i = 0; i < CAN_TESTBOX_MAX_PERIODIC_MSGS; i++) {
-        if (!g_periodic_messages[i].enabled) {
+    uint32_t now = CAN_TestBox_GetTick();
+    uint32_t idle = max_ms;
+
+    for (uint8_t i = 0; i < CAN_TESTBOX_CH_COUNT; i++) {
+        CAN_TestBox_Channel_t channel = &g_channels[i];
+
+        // 静默中的通道不调度周期报文，恢复正常模式后按相位格点继续
+        if (!channel->initialized || !channel->running || CAN_TestBox_ChannelIsSilent(channel)) {
             continue;
         }
-        
-        // 检查是否到达发送时间
-        if (current_time - g_periodic_messages[i].last_send_time >= g_periodic_messages[i].period_ms) {
-            // 发送消息
-            CAN_TestBox_Status_t status = CAN_TestBox_SendMessage_Internal(&g_periodic_messages[i].message);
-            
-            if (status == CAN_TESTBOX_OK) {
-                g_periodic_messages[i].send_count++;
-                g_periodic_messages[i].last_send_time = current_time;
+
+        for (uint8_t j = 0; j < CAN_TESTBOX_MAX_PERIODIC_MSGS; j++) {
+            const CAN_TestBox_PeriodicMsg_t *periodic = &channel->periodic_messages[j];
+
+            if (!periodic->enabled) {
+                continue;
+            }
+
+            uint32_t elapsed = now - periodic->last_send_time;
+            uint32_t remaining = (elapsed >= periodic->period_ms) ? 0U : (periodic->period_ms - elapsed);
+
+            // 已到期但邮箱满：等待发送完成通知，最迟1ms后重试
+            if (remaining == 0U && channel->tx_blocked) {
+                remaining = 1U;
+            }
+
+            if (remaining < idle) {
+                idle = remaining;
             }
         }
     }
+
+    return idle;
 }
 
 /**
- * @brief 更新统计信息
+ * @brief 获取周期报文发送抖动统计
  */
-static void CAN_TestBox_UpdateStatistics(void)
+CAN_TestBox_Status_t CAN_TestBox_GetPeriodicJitter(CAN_TestBox_Jitter_t *jitter)
 {
-    // 更新运行时间
-    g_statistics.uptime_ms = CAN_TestBox_GetTick() - g_system_start_time;
-    
-    // 检查CAN错误状态
-    if (g_hcan != NULL) {
-        uint32_t esr = g_hcan->Instance->ESR;
-        if (esr & CAN_ESR_BOFF) {
-            g_statistics.bus_error_count++;
-        }
+    if (jitter == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
     }
+
+    *jitter = g_periodic_jitter;
+
+    return CAN_TESTBOX_OK;
 }
 
 /**
- * @brief 获取系统时钟
+ * @brief 清空周期报文发送抖动统计
  */
-static uint32_t CAN_TestBox_GetTick(void)
+void CAN_TestBox_ResetPeriodicJitter(void)
 {
-    return HAL_GetTick();
+    memset(&g_periodic_jitter, 0, sizeof(g_periodic_jitter));
 }
 
 /**
- * @brief 验证消息参数
+ * @brief 获取周期报文上线抖动统计
  */
-static CAN_TestBox_Status_t CAN_TestBox_ValidateMessage(const CAN_TestBox_Message_t *message)
+CAN_TestBox_Status_t CAN_TestBox_GetPeriodicWireJitter(CAN_TestBox_Jitter_t *jitter)
 {
-    if (message == NULL) {
-        return CAN_TESTBOX_INVALID_PARAM;
-    }
-    
-    if (message->dlc > 8) {
+    if (jitter == NULL) {
         return CAN_TESTBOX_INVALID_PARAM;
     }
-    
-    if (message->is_extended) {
-        if (message->id > 0x1FFFFFFF) {
-            return CAN_TESTBOX_INVALID_PARAM;
-        }
-    } else {
-        if (message->id > 0x7FF) {
-            return CAN_TESTBOX_INVALID_PARAM;
-        }
-    }
-    
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *jitter = g_periodic_wire_jitter;
+    __set_PRIMASK(primask);
+
     return CAN_TESTBOX_OK;
 }
 
-/* ========================= CAN中断回调函数 ========================= */
+/**
+ * @brief 清空周期报文上线抖动统计
+ */
+void CAN_TestBox_ResetPeriodicWireJitter(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset(&g_periodic_wire_jitter, 0, sizeof(g_periodic_wire_jitter));
+    __set_PRIMASK(primask);
+}
 
 /**
- * @brief CAN TestBox接收处理函数
- * @note 在CAN接收中断中调用此函数处理接收到的消息
+ * @brief 注册测试盒串口命令
  */
-void CAN_TestBox_ProcessRxMessage(CAN_HandleTypeDef *hcan, CAN_RxHeaderTypeDef *rx_header, uint8_t *rx_data)
+CAN_TestBox_Status_t CAN_TestBox_CmdInit(void)
 {
-    if (hcan != g_hcan || !g_initialized) {
-        return;
+    if (CAN_Cmd_Register(CAN_CMD_ID_TXCONF_CTRL, CAN_TestBox_HandleTxConfirmCtrl) != CAN_TESTBOX_OK ||
+        CAN_Cmd_Register(CAN_CMD_ID_PHASE_CTRL, CAN_TestBox_HandlePhaseCtrl) != CAN_TESTBOX_OK) {
+        return CAN_TESTBOX_ERROR;
     }
-    
-    CAN_TestBox_Message_t rx_message;
-    
-    // 填充消息结构体
-    if (rx_header->IDE == CAN_ID_EXT) {
-        rx_message.id = rx_header->ExtId;
-        rx_message.is_extended = true;
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 允许/禁止自动分配周期报文相位
+ */
+void CAN_TestBox_SetAutoPhase(bool enable)
+{
+    g_auto_phase = enable;
+}
+
+/**
+ * @brief 设置发送日志模式
+ */
+CAN_TestBox_Status_t CAN_TestBox_SetTxLogMode(uint8_t mode)
+{
+    if (mode > CAN_TESTBOX_TXLOG_CONFIRM) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    g_tx_log_mode = mode;
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 获取任务运行状态
+ */
+bool CAN_TestBox_IsRunning(void)
+{
+    return (g_default_channel != NULL) && g_default_channel->running;
+}
+
+/**
+ * @brief 查询是否有周期报文正在调度
+ */
+bool CAN_TestBox_HasActivePeriodic(void)
+{
+    for (uint8_t i = 0; i < CAN_TESTBOX_CH_COUNT; i++) {
+        CAN_TestBox_Channel_t channel = &g_channels[i];
+
+        if (!channel->initialized || !channel->running || CAN_TestBox_ChannelIsSilent(channel)) {
+            continue;
+        }
+
+        for (uint8_t j = 0; j < CAN_TESTBOX_MAX_PERIODIC_MSGS; j++) {
+            if (channel->periodic_messages[j].enabled) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/* ========================= 10. 多通道接口 ========================= */
+
+/**
+ * @brief 打开片内bxCAN通道
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelOpen(CAN_TestBox_ChannelId_t id, CAN_HandleTypeDef *hcan, CAN_TestBox_Channel_t *channel)
+{
+    if (hcan == NULL || channel == NULL || id >= CAN_TESTBOX_CH_COUNT) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    uint32_t queue_size = (id == CAN_TESTBOX_CH_CAN1) ? CAN_TESTBOX_RECEIVE_QUEUE_SIZE : CAN_TESTBOX_CHANNEL_RX_QUEUE_SIZE;
+    CAN_TestBox_Status_t status = CAN_TestBox_ChannelSetup(id, queue_size);
+    if (status != CAN_TESTBOX_OK) {
+        return status;
+    }
+
+    CAN_TestBox_Channel_t ctx = &g_channels[id];
+    ctx->hcan = hcan;
+
+    // 启动CAN(已被其他模块启动时跳过)
+    if (hcan->State == HAL_CAN_STATE_READY) {
+        if (HAL_CAN_Start(hcan) != HAL_OK) {
+            osMessageQueueDelete(ctx->receive_queue);
+            return CAN_TESTBOX_ERROR;
+        }
+    }
+
+    // 激活CAN接收中断，发送邮箱空中断用于唤醒等待重试的周期报文
+    if (HAL_CAN_ActivateNotification(hcan, CAN_IT_RX_FIFO0_MSG_PENDING | CAN_IT_TX_MAILBOX_EMPTY | CAN_IT_ERROR) != HAL_OK) {
+        HAL_CAN_Stop(hcan);
+        osMessageQueueDelete(ctx->receive_queue);
+        return CAN_TESTBOX_ERROR;
+    }
+
+    ctx->initialized = true;
+    ctx->running = true;
+    *channel = ctx;
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 打开外部控制器通道
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelOpenExternal(CAN_TestBox_ChannelId_t id, const CAN_TestBox_ChannelOps_t *ops, CAN_TestBox_Channel_t *channel)
+{
+    if (ops == NULL || ops->send == NULL || channel == NULL || id >= CAN_TESTBOX_CH_COUNT) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    CAN_TestBox_Status_t status = CAN_TestBox_ChannelSetup(id, CAN_TESTBOX_CHANNEL_RX_QUEUE_SIZE);
+    if (status != CAN_TESTBOX_OK) {
+        return status;
+    }
+
+    CAN_TestBox_Channel_t ctx = &g_channels[id];
+    ctx->ops = ops;
+    ctx->initialized = true;
+    ctx->running = true;
+    *channel = ctx;
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 关闭通道
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelClose(CAN_TestBox_Channel_t channel)
+{
+    if (channel == NULL || !channel->initialized) {
+        return CAN_TESTBOX_NOT_INITIALIZED;
+    }
+
+    // 停止所有周期性消息
+    CAN_TestBox_ChannelStopAllPeriodicMessages(channel);
+
+    channel->initialized = false;
+    channel->running = false;
+
+    // 停止CAN
+    if (channel->hcan != NULL) {
+        HAL_CAN_Stop(channel->hcan);
+    }
+
+    // 删除队列
+    if (channel->receive_queue != NULL) {
+        osMessageQueueDelete(channel->receive_queue);
+        channel->receive_queue = NULL;
+    }
+
+    channel->hcan = NULL;
+    channel->ops = NULL;
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 按编号获取已打开的通道
+ */
+CAN_TestBox_Channel_t CAN_TestBox_GetChannel(CAN_TestBox_ChannelId_t id)
+{
+    if (id >= CAN_TESTBOX_CH_COUNT || !g_channels[id].initialized) {
+        return NULL;
+    }
+
+    return &g_channels[id];
+}
+
+/**
+ * @brief 获取通道编号
+ */
+CAN_TestBox_ChannelId_t CAN_TestBox_ChannelGetId(CAN_TestBox_Channel_t channel)
+{
+    return (channel != NULL) ? channel->id : CAN_TESTBOX_CH_COUNT;
+}
+
+/**
+ * @brief 发送单帧事件报文
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelSendSingleFrame(CAN_TestBox_Channel_t channel, const CAN_TestBox_Message_t *message)
+{
+    if (channel == NULL || !channel->initialized || !channel->running) {
+        return CAN_TESTBOX_NOT_INITIALIZED;
+    }
+
+    if (message == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    // 验证消息参数
+    CAN_TestBox_Status_t status = CAN_TestBox_ValidateMessage(message);
+    if (status != CAN_TESTBOX_OK) {
+        return status;
+    }
+
+    // 打包为紧凑帧后直接发送
+    CAN_TestBox_Frame_t frame;
+    CAN_Frame_FromMessage(&frame, message);
+
+    return CAN_TestBox_SendMessage_Internal(channel, &frame, CAN_TXARB_CLASS_NORMAL, 0);
+}
+
+/**
+ * @brief 启动周期性消息发送
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelStartPeriodicMessage(CAN_TestBox_Channel_t channel, const CAN_TestBox_Message_t *message, uint32_t period_ms, uint8_t *handle_id)
+{
+    if (channel == NULL || !channel->initialized || !channel->running) {
+        return CAN_TESTBOX_NOT_INITIALIZED;
+    }
+
+    if (message == NULL || handle_id == NULL || period_ms == 0) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    if (channel->periodic_msg_count >= CAN_TESTBOX_MAX_PERIODIC_MSGS) {
+        return CAN_TESTBOX_QUEUE_FULL;
+    }
+
+    if (CAN_TestBox_ChannelIsSilent(channel)) {
+        return CAN_TESTBOX_BUSY;
+    }
+
+    // 验证消息参数
+    CAN_TestBox_Status_t status = CAN_TestBox_ValidateMessage(message);
+    if (status != CAN_TESTBOX_OK) {
+        return status;
+    }
+
+    // 查找空闲槽位
+    uint8_t index = 0;
+    for (index = 0; index < CAN_TESTBOX_MAX_PERIODIC_MSGS; index++) {
+        if (!channel->periodic_messages[index].enabled) {
+            break;
+        }
+    }
+
+    if (index >= CAN_TESTBOX_MAX_PERIODIC_MSGS) {
+        return CAN_TESTBOX_QUEUE_FULL;
+    }
+
+    // 配置周期性消息
+    CAN_TestBox_PeriodicMsg_t *periodic = &channel->periodic_messages[index];
+    CAN_Frame_FromMessage(&periodic->frame, message);
+    periodic->period_ms = period_ms;
+    periodic->enabled = true;
+    periodic->send_count = 0;
+    periodic->phase_manual = false;
+    CAN_TestBox_RequestPhase(periodic, CAN_TestBox_GetTick());
+    CAN_TestBox_AnchorPeriodic(periodic, CAN_TestBox_GetTick());
+    periodic->timing_valid = false;
+    periodic->wire_valid = false;
+    periodic->handle_id = index;
+
+    *handle_id = index;
+    channel->periodic_msg_count++;
+
+    // 任务可能正按旧的到期时间等待
+    CAN_Event_Notify(CAN_EVENT_SCHEDULE);
+
+    // 不打印周期性消息启动信息 (Don't print periodic message start information)
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 停止周期性消息发送
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelStopPeriodicMessage(CAN_TestBox_Channel_t channel, uint8_t handle_id)
+{
+    if (channel == NULL || !channel->initialized) {
+        return CAN_TESTBOX_NOT_INITIALIZED;
+    }
+
+    if (handle_id >= CAN_TESTBOX_MAX_PERIODIC_MSGS) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    if (!channel->periodic_messages[handle_id].enabled) {
+        return CAN_TESTBOX_NOT_FOUND;
+    }
+
+    channel->periodic_messages[handle_id].enabled = false;
+    channel->periodic_msg_count--;
+    CAN_E2E_DetachTx(channel->id, handle_id);
+    CAN_Gen_BindPeriodic(channel->id, handle_id, 0);
+
+    // 不打印周期性消息停止信息 (Don't print periodic message stop information)
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 修改周期性消息的发送周期
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelModifyPeriodicPeriod(CAN_TestBox_Channel_t channel, uint8_t handle_id, uint32_t new_period_ms)
+{
+    if (channel == NULL || !channel->initialized) {
+        return CAN_TESTBOX_NOT_INITIALIZED;
+    }
+
+    if (handle_id >= CAN_TESTBOX_MAX_PERIODIC_MSGS || new_period_ms == 0) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    if (!channel->periodic_messages[handle_id].enabled) {
+        return CAN_TESTBOX_NOT_FOUND;
+    }
+
+    CAN_TestBox_PeriodicMsg_t *periodic = &channel->periodic_messages[handle_id];
+    uint32_t now = CAN_TestBox_GetTick();
+
+    // 手动相位按新周期取模保留，其余重新分配
+    periodic->period_ms = new_period_ms;
+    if (periodic->phase_manual) {
+        periodic->phase_ms %= new_period_ms;
+    } else {
+        CAN_TestBox_RequestPhase(periodic, now);
+    }
+    CAN_TestBox_AnchorPeriodic(periodic, now);
+    periodic->timing_valid = false;
+    periodic->wire_valid = false;
+    CAN_Event_Notify(CAN_EVENT_SCHEDULE);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 手动设置周期性消息的相位偏移
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelSetPeriodicPhase(CAN_TestBox_Channel_t channel, uint8_t handle_id, uint32_t phase_ms)
+{
+    if (channel == NULL || !channel->initialized) {
+        return CAN_TESTBOX_NOT_INITIALIZED;
+    }
+
+    if (handle_id >= CAN_TESTBOX_MAX_PERIODIC_MSGS) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    if (!channel->periodic_messages[handle_id].enabled) {
+        return CAN_TESTBOX_NOT_FOUND;
+    }
+
+    CAN_TestBox_PeriodicMsg_t *periodic = &channel->periodic_messages[handle_id];
+    uint32_t now = CAN_TestBox_GetTick();
+
+    if (phase_ms == CAN_TESTBOX_PHASE_AUTO) {
+        periodic->phase_manual = false;
+        CAN_TestBox_RequestPhase(periodic, now);
+    } else {
+        periodic->phase_manual = true;
+        periodic->phase_pending = false;
+        periodic->phase_ms = phase_ms % periodic->period_ms;
+    }
+
+    CAN_TestBox_AnchorPeriodic(periodic, now);
+    periodic->timing_valid = false;
+    periodic->wire_valid = false;
+    CAN_Event_Notify(CAN_EVENT_SCHEDULE);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 修改周期性消息的数据内容
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelModifyPeriodicData(CAN_TestBox_Channel_t channel, uint8_t handle_id, const uint8_t *new_data, uint8_t dlc)
+{
+    if (channel == NULL || !channel->initialized) {
+        return CAN_TESTBOX_NOT_INITIALIZED;
+    }
+
+    if (handle_id >= CAN_TESTBOX_MAX_PERIODIC_MSGS || new_data == NULL || dlc > 8) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    if (!channel->periodic_messages[handle_id].enabled) {
+        return CAN_TESTBOX_NOT_FOUND;
+    }
+
+    CAN_Frame_SetDlc(&channel->periodic_messages[handle_id].frame, dlc);
+    memcpy(CAN_Frame_Data(&channel->periodic_messages[handle_id].frame), new_data, dlc);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 停止通道所有周期性消息
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelStopAllPeriodicMessages(CAN_TestBox_Channel_t channel)
+{
+    if (channel == NULL || !channel->initialized) {
+        return CAN_TESTBOX_NOT_INITIALIZED;
+    }
+
+    for (uint8_t i = 0; i < CAN_TESTBOX_MAX_PERIODIC_MSGS; i++) {
+        channel->periodic_messages[i].enabled = false;
+        CAN_E2E_DetachTx(channel->id, i);
+        CAN_Gen_BindPeriodic(channel->id, i, 0);
+    }
+
+    channel->periodic_msg_count = 0;
+
+    // 不打印所有周期性消息停止信息 (Don't print all periodic messages stop information)
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 发送连续帧报文
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelSendBurstFrames(CAN_TestBox_Channel_t channel, const CAN_TestBox_BurstMsg_t *burst_config)
+{
+    if (channel == NULL || !channel->initialized || !channel->running) {
+        return CAN_TESTBOX_NOT_INITIALIZED;
+    }
+
+    if (burst_config == NULL || burst_config->burst_count == 0 || burst_config->burst_count > CAN_TESTBOX_BURST_COUNT_MAX) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    // 验证消息参数
+    CAN_TestBox_Status_t status = CAN_TestBox_ValidateMessage(&burst_config->message);
+    if (status != CAN_TESTBOX_OK) {
+        return status;
+    }
+
+    CAN_TestBox_Frame_t current_frame;
+    CAN_Frame_FromMessage(&current_frame, &burst_config->message);
+    uint8_t dlc = CAN_Frame_GetDlc(&current_frame);
+    static const uint32_t data_ones[2] = {0x01010101U, 0x01010101U};
+
+    // 不打印发送连续帧信息 (Don't print burst frames sending information)
+
+    for (uint16_t i = 0; i < burst_config->burst_count; i++) {
+        // 生成器组写入负载
+        CAN_Gen_Apply(burst_config->gen_set, CAN_Frame_Data(&current_frame));
+
+        // 发送当前消息
+        status = CAN_TestBox_SendMessage_Internal(channel, &current_frame, CAN_TXARB_CLASS_BULK, 0);
+        if (status != CAN_TESTBOX_OK) {
+            // 不打印连续帧发送失败信息 (Don't print burst frame send failure information)
+            return status;
+        }
+        CAN_Gen_Advance(burst_config->gen_set);
+
+        // 自动递增ID
+        if (burst_config->auto_increment_id) {
+            current_frame.id_flags = (current_frame.id_flags & ~CAN_FRAME_ID_MASK) |
+                                     ((current_frame.id_flags + 1U) & CAN_FRAME_ID_MASK);
+        }
+
+        // 自动递增数据(8字节一起加1，DLC之外的字节不发送)
+        if (burst_config->auto_increment_data && dlc > 0) {
+            CAN_Gen_AddBytes(current_frame.data, data_ones);
+        }
+
+        // 发送间隔延时
+        if (i < burst_config->burst_count - 1 && burst_config->interval_ms > 0) {
+            osDelay(burst_config->interval_ms);
+        }
+    }
+
+    // 不打印连续帧完成信息 (Don't print burst frames completion information)
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 设置通道接收回调函数
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelSetRxCallback(CAN_TestBox_Channel_t channel, CAN_TestBox_RxCallback_t callback)
+{
+    if (channel == NULL) {
+        return CAN_TESTBOX_NOT_INITIALIZED;
+    }
+
+    channel->rx_callback = callback;
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 从通道接收队列获取消息
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelReceiveMessage(CAN_TestBox_Channel_t channel, CAN_TestBox_Message_t *message, uint32_t timeout_ms)
+{
+    if (channel == NULL || !channel->initialized) {
+        return CAN_TESTBOX_NOT_INITIALIZED;
+    }
+
+    if (message == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    CAN_TestBox_Frame_t frame;
+    osStatus_t status = osMessageQueueGet(channel->receive_queue, &frame, NULL, timeout_ms);
+
+    if (status == osOK) {
+        if (channel->rx_entry != NULL) {
+            CAN_Latency_Record(CAN_LATENCY_STAGE_CONSUMER,
+                               channel->rx_entry[channel->rx_entry_tail++ & (CAN_TESTBOX_RX_ENTRY_RING - 1U)]);
+        }
+        CAN_Frame_ToMessage(message, &frame, CAN_TestBox_GetTick());
+        return CAN_TESTBOX_OK;
+    } else if (status == osErrorTimeout) {
+        return CAN_TESTBOX_TIMEOUT;
+    } else {
+        return CAN_TESTBOX_ERROR;
+    }
+}
+
+/**
+ * @brief 清空通道接收队列
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelClearRxQueue(CAN_TestBox_Channel_t channel)
+{
+    if (channel == NULL || !channel->initialized) {
+        return CAN_TESTBOX_NOT_INITIALIZED;
+    }
+
+    CAN_TestBox_Frame_t dummy_frame;
+    while (osMessageQueueGet(channel->receive_queue, &dummy_frame, NULL, 0) == osOK) {
+        // 清空队列，影子环同步出队
+        channel->rx_entry_tail++;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 获取通道统计信息
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelGetStatistics(CAN_TestBox_Channel_t channel, CAN_TestBox_Statistics_t *stats)
+{
+    if (channel == NULL || !channel->initialized) {
+        return CAN_TESTBOX_NOT_INITIALIZED;
+    }
+
+    if (stats == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    // 收发计数在中断中更新(片内CAN发送成功/错误数在发送确认中累加)，整体拷贝须关中断
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    channel->statistics.uptime_ms = CAN_TestBox_GetTick() - channel->start_time;
+    *stats = channel->statistics;
+    __set_PRIMASK(primask);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 重置通道统计信息
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelResetStatistics(CAN_TestBox_Channel_t channel)
+{
+    if (channel == NULL || !channel->initialized) {
+        return CAN_TESTBOX_NOT_INITIALIZED;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset(&channel->statistics, 0, sizeof(channel->statistics));
+    channel->start_time = CAN_TestBox_GetTick();
+    __set_PRIMASK(primask);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 启动/停止通道
+ */
+CAN_TestBox_Status_t CAN_TestBox_ChannelEnable(CAN_TestBox_Channel_t channel, bool enable)
+{
+    if (channel == NULL || !channel->initialized) {
+        return CAN_TESTBOX_NOT_INITIALIZED;
+    }
+
+    channel->running = enable;
+    CAN_Event_Notify(CAN_EVENT_SCHEDULE);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 获取通道总线状态
+ */
+uint32_t CAN_TestBox_ChannelGetBusStatus(CAN_TestBox_Channel_t channel)
+{
+    if (channel == NULL || !channel->initialized) {
+        return 0xFFFFFFFF;
+    }
+
+    if (channel->hcan != NULL) {
+        return channel->hcan->Instance->ESR;
+    }
+
+    if (channel->ops != NULL && channel->ops->get_bus_status != NULL) {
+        return channel->ops->get_bus_status();
+    }
+
+    return 0;
+}
+
+/**
+ * @brief 外部控制器接收报文送入通道
+ */
+void CAN_TestBox_ChannelInput(CAN_TestBox_Channel_t channel, const CAN_TestBox_Message_t *message)
+{
+    if (message == NULL) {
+        return;
+    }
+
+    CAN_TestBox_Frame_t frame;
+    CAN_Frame_FromMessage(&frame, message);
+
+    CAN_TestBox_ChannelInputFrame(channel, &frame);
+}
+
+/**
+ * @brief 外部控制器接收紧凑帧送入通道
+ */
+void CAN_TestBox_ChannelInputFrame(CAN_TestBox_Channel_t channel, const CAN_TestBox_Frame_t *frame)
+{
+    if (channel == NULL || !channel->initialized || frame == NULL) {
+        return;
+    }
+
+    CAN_TestBox_Frame_t rx_frame = *frame;
+    CAN_Frame_SetChannel(&rx_frame, (uint8_t)channel->id);
+
+    // 更新统计信息
+    channel->statistics.rx_total_count++;
+    channel->statistics.rx_valid_count++;
+
+    CAN_Latency_Mark(channel->id, CAN_LATENCY_STAGE_DISPATCH);
+
+    // 测试序列等待匹配(未布置时仅一次判断)
+    CAN_Seq_InputFrame(&rx_frame);
+
+    // PEPS场景等待的触发报文
+    PEPS_Scenario_InputFrame(&rx_frame);
+
+    // E2E接收校验(未登记时仅一次判断)
+    CAN_E2E_CheckRx(&rx_frame);
+
+    // 仅当没有设置回调时才添加到接收队列，回调在接口边界解包
+    if (channel->rx_callback == NULL) {
+        if (osMessageQueuePut(channel->receive_queue, &rx_frame, 0, 0) != osOK) {
+            // 队列满，丢弃消息
+        } else if (channel->rx_entry != NULL) {
+            channel->rx_entry[channel->rx_entry_head++ & (CAN_TESTBOX_RX_ENTRY_RING - 1U)] =
+                CAN_Latency_GetEntry(channel->id);
+        }
+    } else {
+        CAN_TestBox_Message_t rx_message;
+        CAN_Frame_ToMessage(&rx_message, &rx_frame, CAN_TestBox_GetTick());
+        channel->rx_callback(&rx_message);
+    }
+}
+
+/* ========================= 私有函数实现 ========================= */
+
+/**
+ * @brief 初始化通道上下文并创建接收队列
+ */
+static CAN_TestBox_Status_t CAN_TestBox_ChannelSetup(CAN_TestBox_ChannelId_t id, uint32_t queue_size)
+{
+    CAN_TestBox_Channel_t ctx = &g_channels[id];
+
+    if (ctx->initialized) {
+        return CAN_TESTBOX_ALREADY_EXISTS;
+    }
+
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->id = id;
+    ctx->rx_entry = (id < CAN_TESTBOX_CH_EXT) ? g_rx_entry[id] : NULL;
+
+    // 片内CAN发送成功数与上线抖动按发送仲裁的发送确认统计
+    if (id < CAN_TESTBOX_CH_EXT) {
+        CAN_TxArb_AddConfirmCallback(CAN_TestBox_ProcessTxConfirm);
+    }
+
+    // 创建接收队列
+    ctx->receive_queue = osMessageQueueNew(queue_size, sizeof(CAN_TestBox_Frame_t), &g_receive_queue_attr[id]);
+    if (ctx->receive_queue == NULL) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    // 记录启动时间
+    ctx->start_time = CAN_TestBox_GetTick();
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 内部消息发送函数
+ * @param tx_class: 发送分类(CAN_TXARB_CLASS_xxx)，片内CAN按分类排队
+ * @param tx_tag: 替换标签(周期报文为句柄+1)，0为不替换
+ */
+static CAN_TestBox_Status_t CAN_TestBox_SendMessage_Internal(CAN_TestBox_Channel_t channel, const CAN_TestBox_Frame_t *frame,
+                                                             uint8_t tx_class, uint8_t tx_tag)
+{
+    CAN_TestBox_Status_t status;
+    uint32_t error_code = 0;
+    bool confirmed = (channel->hcan != NULL);
+
+    // 静默模式的控制器不能发起发送，装入邮箱的报文永远不会完成
+    if (CAN_TestBox_ChannelIsSilent(channel)) {
+        return CAN_TESTBOX_BUSY;
+    }
+
+    if (confirmed) {
+        // 交给发送仲裁排队，按分类优先级与ID装入邮箱
+        status = CAN_TxArb_Submit(channel->id, tx_class, tx_tag, frame);
+        error_code = status;
+    } else {
+        status = channel->ops->send(frame);
+        error_code = status;
+    }
+
+    channel->statistics.tx_total_count++;
+
+    if (status == CAN_TESTBOX_OK) {
+        // 片内CAN排队成功后由发送完成中断计入成功数
+        if (!confirmed) {
+            channel->statistics.tx_success_count++;
+        }
+
+        if (!confirmed || g_tx_log_mode == CAN_TESTBOX_TXLOG_SUBMIT) {
+            CAN_TestBox_LogTx(channel, frame);
+        }
+
+        return CAN_TESTBOX_OK;
+    } else {
+        // 发送错误数也在发送确认中断中累加
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        channel->statistics.tx_error_count++;
+        __set_PRIMASK(primask);
+        channel->statistics.last_error_code = error_code;
+
+        // 打印发送错误信息
+        printf("[CAN-ERROR] Failed to send message - ID:0x%03X, Error:%d\r\n",
+               (unsigned int)CAN_Frame_GetId(frame),
+               (int)error_code);
+
+        return CAN_TESTBOX_ERROR;
+    }
+}
+
+/**
+ * @brief 统一发送日志输出
+ */
+static void CAN_TestBox_LogTx(CAN_TestBox_Channel_t channel, const CAN_TestBox_Frame_t *frame)
+{
+    // 按照用户要求的格式打印发送日志(查表格式化，整行一次输出)
+    CAN_Format_PrintFrame(g_tx_log_tag[channel->id], CAN_Frame_GetId(frame),
+                          CAN_Frame_ConstData(frame), CAN_Frame_GetDlc(frame), CAN_Frame_IsRemote(frame));
+}
+
+/**
+ * @brief 发送确认(发送仲裁回调，在中断中、仲裁器临界区内执行)
+ * @note  计入发送成功/错误数；周期报文按相邻两次发送完成的间隔统计上线抖动；
+ *        确认日志模式下把报文、完成时间戳与入队时延写入日志环
+ */
+static void CAN_TestBox_ProcessTxConfirm(CAN_TestBox_ChannelId_t ch, uint8_t tx_class, uint8_t tag,
+                                         const CAN_TestBox_Frame_t *frame, uint32_t enqueue_us,
+                                         uint32_t done_us, bool sent)
+{
+    CAN_TestBox_Channel_t channel = &g_channels[ch];
+
+    if (!channel->initialized) {
+        return;
+    }
+
+    if (!sent) {
+        channel->statistics.tx_error_count++;
+        return;
+    }
+
+    channel->statistics.tx_success_count++;
+
+    // 周期报文以句柄+1为标签
+    if (tx_class == CAN_TXARB_CLASS_PERIODIC && tag != 0U && tag <= CAN_TESTBOX_MAX_PERIODIC_MSGS) {
+        CAN_TestBox_PeriodicMsg_t *periodic = &channel->periodic_messages[tag - 1U];
+
+        if (periodic->enabled) {
+            if (periodic->wire_valid) {
+                uint32_t interval_us = done_us - periodic->last_wire_us;
+                uint32_t period_us = periodic->period_ms * 1000U;
+                uint32_t deviation = (interval_us > period_us) ? (interval_us - period_us) : (period_us - interval_us);
+
+                g_periodic_wire_jitter.samples++;
+                g_periodic_wire_jitter.sum_us += deviation;
+                if (deviation > g_periodic_wire_jitter.max_us) {
+                    g_periodic_wire_jitter.max_us = deviation;
+                }
+            }
+            periodic->last_wire_us = done_us;
+            periodic->wire_valid = true;
+        }
+    }
+
+    if (g_tx_log_mode != CAN_TESTBOX_TXLOG_CONFIRM) {
+        return;
+    }
+
+    if (g_tx_confirm_head - g_tx_confirm_tail >= CAN_TESTBOX_TXCONF_RING_SIZE) {
+        g_tx_confirm_dropped++;
+        return;
+    }
+
+    CAN_TestBox_TxConfirm_t *item = &g_tx_confirm_ring[g_tx_confirm_head & (CAN_TESTBOX_TXCONF_RING_SIZE - 1U)];
+    item->frame = *frame;
+    item->done_us = done_us;
+    item->latency_us = done_us - enqueue_us;
+    item->ch = (uint8_t)ch;
+    g_tx_confirm_head++;
+
+    CAN_Event_Notify(CAN_EVENT_TX_DONE);
+}
+
+/**
+ * @brief 输出发送确认日志"<TAG> <完成时间>us +<时延>us ID:..., Data:... [END]"
+ */
+static void CAN_TestBox_FlushTxConfirm(void)
+{
+    while (g_tx_confirm_tail != g_tx_confirm_head) {
+        CAN_TestBox_TxConfirm_t item = g_tx_confirm_ring[g_tx_confirm_tail & (CAN_TESTBOX_TXCONF_RING_SIZE - 1U)];
+        g_tx_confirm_tail++;
+
+        char line[CAN_FORMAT_LINE_MAX];
+        char *p = CAN_Format_Str(line, g_tx_confirm_tag[item.ch], CAN_FORMAT_TAG_MAX);
+        *p++ = ' ';
+        p = CAN_Format_Dec(p, item.done_us);
+        p = CAN_Format_Str(p, "us +", 4);
+        p = CAN_Format_Dec(p, item.latency_us);
+        p = CAN_Format_Str(p, "us", 2);
+        p = CAN_Format_FrameBody(p, CAN_Frame_GetId(&item.frame),
+                                 CAN_Frame_IsExtended(&item.frame) ? CAN_FORMAT_EXT_ID_DIGITS : CAN_FORMAT_STD_ID_DIGITS,
+                                 CAN_Frame_ConstData(&item.frame), CAN_Frame_GetDlc(&item.frame),
+                                 CAN_Frame_IsRemote(&item.frame));
+        CAN_Format_Output(line, (uint32_t)(p - line));
+    }
+}
+
+/**
+ * @brief 串口命令: 发送确认日志与周期报文抖动
+ */
+static void CAN_TestBox_HandleTxConfirmCtrl(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    if (len < 1U) {
+        CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+        return;
+    }
+
+    switch (payload[0]) {
+        case CAN_TESTBOX_TXCONF_CTRL_STATUS: {
+            // 应答: 日志模式(u8)、日志丢弃数，调度抖动与上线抖动各(样本数、平均、最大)
+            CAN_TestBox_Jitter_t sched;
+            CAN_TestBox_Jitter_t wire;
+            uint32_t values[7];
+            uint8_t mode = g_tx_log_mode;
+
+            CAN_TestBox_GetPeriodicJitter(&sched);
+            CAN_TestBox_GetPeriodicWireJitter(&wire);
+            values[0] = g_tx_confirm_dropped;
+            values[1] = sched.samples;
+            values[2] = (sched.samples > 0U) ? (sched.sum_us / sched.samples) : 0U;
+            values[3] = sched.max_us;
+            values[4] = wire.samples;
+            values[5] = (wire.samples > 0U) ? (wire.sum_us / wire.samples) : 0U;
+            values[6] = wire.max_us;
+
+            CAN_Cmd_ResponseBegin(cmd, (uint16_t)(1U + sizeof(values)));
+            CAN_Cmd_ResponseWrite(&mode, 1);
+            CAN_Cmd_ResponseWrite(values, sizeof(values));
+            CAN_Cmd_ResponseEnd();
+            break;
+        }
+
+        case CAN_TESTBOX_TXCONF_CTRL_LOG:
+            if (len != 2U) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+                break;
+            }
+            CAN_Cmd_SendResult(cmd, (CAN_TestBox_SetTxLogMode(payload[1]) == CAN_TESTBOX_OK) ?
+                               CAN_CMD_RESULT_OK : CAN_CMD_RESULT_BAD_PARAM);
+            break;
+
+        case CAN_TESTBOX_TXCONF_CTRL_CLEAR:
+            CAN_TestBox_ResetPeriodicJitter();
+            CAN_TestBox_ResetPeriodicWireJitter();
+            g_tx_confirm_dropped = 0;
+            CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_OK);
+            break;
+
+        default:
+            CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_PARAM);
+            break;
+    }
+}
+
+/**
+ * @brief 串口命令: 周期报文相位
+ */
+static void CAN_TestBox_HandlePhaseCtrl(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    if (len < 2U) {
+        CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+        return;
+    }
+
+    if (payload[0] == CAN_TESTBOX_PHASE_CTRL_AUTO) {
+        CAN_TestBox_SetAutoPhase(payload[1] != 0U);
+        CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_OK);
+        return;
+    }
+
+    if (payload[1] >= CAN_TESTBOX_CH_COUNT || !g_channels[payload[1]].initialized) {
+        CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_PARAM);
+        return;
+    }
+
+    CAN_TestBox_Channel_t channel = &g_channels[payload[1]];
+
+    switch (payload[0]) {
+        case CAN_TESTBOX_PHASE_CTRL_STATUS: {
+            // 应答: 自动分配开关(u8)、发送队列深度峰值、手动相位句柄位图，随后各句柄相位(未启用为0xFFFFFFFF)
+            uint8_t auto_phase = g_auto_phase ? 1U : 0U;
+            uint32_t header[2];
+
+            header[0] = CAN_TxArb_GetDepthPeak(channel->id);
+            header[1] = 0;
+            for (uint8_t i = 0; i < CAN_TESTBOX_MAX_PERIODIC_MSGS; i++) {
+                if (channel->periodic_messages[i].enabled && channel->periodic_messages[i].phase_manual) {
+                    header[1] |= (1UL << i);
+                }
+            }
+
+            CAN_Cmd_ResponseBegin(cmd, (uint16_t)(1U + sizeof(header) + CAN_TESTBOX_MAX_PERIODIC_MSGS * sizeof(uint32_t)));
+            CAN_Cmd_ResponseWrite(&auto_phase, 1);
+            CAN_Cmd_ResponseWrite(header, sizeof(header));
+            for (uint8_t i = 0; i < CAN_TESTBOX_MAX_PERIODIC_MSGS; i++) {
+                uint32_t phase = channel->periodic_messages[i].enabled ? channel->periodic_messages[i].phase_ms
+                                                                       : CAN_TESTBOX_PHASE_AUTO;
+                CAN_Cmd_ResponseWrite(&phase, sizeof(phase));
+            }
+            CAN_Cmd_ResponseEnd();
+            break;
+        }
+
+        case CAN_TESTBOX_PHASE_CTRL_SET: {
+            if (len != 7U) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+                break;
+            }
+            uint32_t phase;
+            memcpy(&phase, &payload[3], sizeof(phase));
+            CAN_Cmd_SendResult(cmd, (CAN_TestBox_ChannelSetPeriodicPhase(channel, payload[2], phase) == CAN_TESTBOX_OK) ?
+                               CAN_CMD_RESULT_OK : CAN_CMD_RESULT_BAD_PARAM);
+            break;
+        }
+
+        default:
+            CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_PARAM);
+            break;
+    }
+}
+
+/**
+ * @brief 最大公约数
+ */
+static uint32_t CAN_TestBox_Gcd(uint32_t a, uint32_t b)
+{
+    while (b != 0U) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+
+    return a;
+}
+
+/**
+ * @brief 报文在总线上的最长位数(含最坏位填充与帧间隔)
+ */
+static uint32_t CAN_TestBox_FrameBits(const CAN_TestBox_Frame_t *frame)
+{
+    uint32_t data_bits = CAN_Frame_IsRemote(frame) ? 0U : 8U * CAN_Frame_GetDlc(frame);
+
+    // 标准帧: 34位可填充 + 13位固定；扩展帧: 54位可填充 + 13位固定，最坏每4位插入1位
+    if (CAN_Frame_IsExtended(frame)) {
+        return 67U + data_bits + (54U + data_bits - 1U) / 4U;
+    }
+
+    return 47U + data_bits + (34U + data_bits - 1U) / 4U;
+}
+
+/**
+ * @brief 请求自动分配相位
+ * @note  启动/修改周期的接口可能在串口接收中断(PEPS辅助命令)或多个任务中调用，
+ *        这里只按now取模给出临时相位并置待分配标志，代价计算推迟到测试盒任务。
+ *        自动分配关闭时临时相位即为最终相位，首帧在一个周期后发送
+ */
+static void CAN_TestBox_RequestPhase(CAN_TestBox_PeriodicMsg_t *periodic, uint32_t now)
+{
+    periodic->phase_ms = now % periodic->period_ms;
+    periodic->phase_pending = g_auto_phase;
+}
+
+/**
+ * @brief 在测试盒任务中完成待分配的相位并重新确定调度格点
+ * @note  计算期间句柄可能被中断重新配置，周期或待分配标志变化时丢弃结果，下一轮重算
+ */
+static void CAN_TestBox_ResolvePhase(CAN_TestBox_Channel_t channel, uint8_t index, uint32_t now)
+{
+    CAN_TestBox_PeriodicMsg_t *periodic = &channel->periodic_messages[index];
+    uint32_t period = periodic->period_ms;
+    uint32_t phase = CAN_TestBox_AssignPhase(channel, index);
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (periodic->enabled && periodic->phase_pending && periodic->period_ms == period) {
+        periodic->phase_ms = phase;
+        periodic->phase_pending = false;
+        CAN_TestBox_AnchorPeriodic(periodic, now);
+    }
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 为周期报文选择相位
+ * @note  到期时刻为 t ≡ 相位 (mod 周期)。与周期为Q、相位为φ的已有报文，在两者周期的
+ *        最小公倍数(超周期)内，候选相位x与φ模gcd(P,Q)同余时恰好重合一次，即本报文
+ *        每次发送中有gcd/Q的比例与其落在同一毫秒，按已有报文的位数加权计入代价。
+ *        代价只依赖x模各gcd，候选范围为各gcd的最小公倍数(整除P)，且不超过
+ *        CAN_TESTBOX_PHASE_SLOTS个：每个已有报文按步长gcd把代价累加到占用表中
+ *        与其同余的槽位，再取代价最小(相同取最小)的槽位，运算量与周期长度无关。
+ *        只由CAN_TestBox_ResolvePhase()在测试盒任务中调用
+ */
+static uint32_t CAN_TestBox_AssignPhase(CAN_TestBox_Channel_t channel, uint8_t index)
+{
+    // 槽位占用代价(只有测试盒任务访问，不占任务栈)
+    static uint32_t occupancy[CAN_TESTBOX_PHASE_SLOTS];
+
+    const CAN_TestBox_PeriodicMsg_t *self = &channel->periodic_messages[index];
+    uint32_t period = self->period_ms;
+    uint32_t span = 1;
+
+    // 候选范围: 各gcd的最小公倍数，超过槽位数时截断
+    for (uint8_t j = 0; j < CAN_TESTBOX_MAX_PERIODIC_MSGS; j++) {
+        const CAN_TestBox_PeriodicMsg_t *other = &channel->periodic_messages[j];
+
+        // 尚未分配的句柄稍后分配时会计入本报文
+        if (j == index || !other->enabled || other->phase_pending) {
+            continue;
+        }
+
+        uint32_t g = CAN_TestBox_Gcd(period, other->period_ms);
+        span = span / CAN_TestBox_Gcd(span, g) * g;
+        if (span >= CAN_TESTBOX_PHASE_SLOTS) {
+            span = CAN_TESTBOX_PHASE_SLOTS;
+            break;
+        }
+    }
+
+    memset(occupancy, 0, span * sizeof(occupancy[0]));
+
+    for (uint8_t j = 0; j < CAN_TESTBOX_MAX_PERIODIC_MSGS; j++) {
+        const CAN_TestBox_PeriodicMsg_t *other = &channel->periodic_messages[j];
+
+        if (j == index || !other->enabled || other->phase_pending) {
+            continue;
+        }
+
+        uint32_t g = CAN_TestBox_Gcd(period, other->period_ms);
+        // 重合比例gcd/Q，按1/256位定点
+        uint32_t weight = (uint32_t)(((uint64_t)CAN_TestBox_FrameBits(&other->frame) * g << 8) / other->period_ms);
+
+        for (uint32_t x = other->phase_ms % g; x < span; x += g) {
+            occupancy[x] += weight;
+        }
+    }
+
+    uint32_t best_phase = 0;
+
+    for (uint32_t x = 1; x < span && occupancy[best_phase] != 0U; x++) {
+        if (occupancy[x] < occupancy[best_phase]) {
+            best_phase = x;
+        }
+    }
+
+    return best_phase;
+}
+
+/**
+ * @brief 按相位确定调度格点: 首帧在now之后第一个满足相位的时刻发送(恰为now时推迟一个周期)
+ */
+static void CAN_TestBox_AnchorPeriodic(CAN_TestBox_PeriodicMsg_t *periodic, uint32_t now)
+{
+    uint32_t period = periodic->period_ms;
+    uint32_t delay = (periodic->phase_ms + period - now % period) % period;
+
+    if (delay == 0U) {
+        delay = period;
+    }
+
+    periodic->last_send_time = now + delay - period;
+}
+
+/**
+ * @brief 处理周期性消息
+ */
+static void CAN_TestBox_ProcessPeriodicMessages(CAN_TestBox_Channel_t channel)
+{
+    uint32_t current_time = CAN_TestBox_GetTick();
+    bool blocked = false;
+
+    if (CAN_TestBox_ChannelIsSilent(channel)) {
+        channel->tx_blocked = false;
+        return;
+    }
+
+    for (uint8_t i = 0; i < CAN_TESTBOX_MAX_PERIODIC_MSGS; i++) {
+        CAN_TestBox_PeriodicMsg_t *periodic = &channel->periodic_messages[i];
+
+        if (!periodic->enabled) {
+            continue;
+        }
+
+        // 启动/修改周期时推迟的相位分配
+        if (periodic->phase_pending) {
+            CAN_TestBox_ResolvePhase(channel, i, current_time);
+        }
+
+        // 检查是否到达发送时间
+        if (current_time - periodic->last_send_time >= periodic->period_ms) {
+            // 绑定了生成器组的槽位先按当前状态写入负载
+            uint8_t gen_set = CAN_Gen_GetBinding(channel->id, i);
+            CAN_Gen_Apply(gen_set, CAN_Frame_Data(&periodic->frame));
+
+            // 绑定了E2E保护的槽位发送写入计数器与CRC的副本
+            CAN_TestBox_Frame_t e2e_frame;
+            bool e2e = CAN_E2E_ProtectTx(channel->id, i, &periodic->frame, &e2e_frame);
+
+            // 发送消息: 以句柄为替换标签，上一实例仍未发出时被本实例原位替换
+            CAN_TestBox_Status_t status = CAN_TestBox_SendMessage_Internal(channel, e2e ? &e2e_frame : &periodic->frame,
+                                                                           CAN_TXARB_CLASS_PERIODIC, (uint8_t)(i + 1U));
+
+            if (status == CAN_TESTBOX_OK) {
+                uint32_t now_us = CAN_Timestamp_GetUs();
+
+                if (e2e) {
+                    CAN_E2E_ConfirmTx(channel->id, i);
+                }
+                CAN_Gen_Advance(gen_set);
+
+                // 实际发送间隔相对设定周期的偏差
+                if (periodic->timing_valid) {
+                    uint32_t interval_us = now_us - periodic->last_send_us;
+                    uint32_t period_us = periodic->period_ms * 1000U;
+                    uint32_t deviation = (interval_us > period_us) ? (interval_us - period_us) : (period_us - interval_us);
+
+                    g_periodic_jitter.samples++;
+                    g_periodic_jitter.sum_us += deviation;
+                    if (deviation > g_periodic_jitter.max_us) {
+                        g_periodic_jitter.max_us = deviation;
+                    }
+                }
+
+                periodic->send_count++;
+
+                // 按相位格点推进，不随唤醒延迟漂移；落后超过一个周期(如邮箱长时间满)
+                // 时跳到当前所在格点，不补发
+                periodic->last_send_time += periodic->period_ms;
+                if (current_time - periodic->last_send_time >= periodic->period_ms) {
+                    periodic->last_send_time = current_time - (current_time - periodic->last_send_time) % periodic->period_ms;
+                }
+                periodic->last_send_us = now_us;
+                periodic->timing_valid = true;
+            } else {
+                blocked = true;
+            }
+        }
+    }
+
+    channel->tx_blocked = blocked;
+}
+
+/**
+ * @brief 更新统计信息
+ */
+static void CAN_TestBox_UpdateStatistics(CAN_TestBox_Channel_t channel)
+{
+    // 更新运行时间
+    channel->statistics.uptime_ms = CAN_TestBox_GetTick() - channel->start_time;
+
+    // 检查CAN错误状态，仅在进入总线关闭时计数一次
+    if (channel->hcan != NULL) {
+        bool bus_off = (channel->hcan->Instance->ESR & CAN_ESR_BOFF) != 0;
+        if (bus_off && !channel->bus_off) {
+            channel->statistics.bus_error_count++;
+        }
+        channel->bus_off = bus_off;
+    }
+}
+
+/**
+ * @brief 获取系统时钟
+ */
+static uint32_t CAN_TestBox_GetTick(void)
+{
+    return HAL_GetTick();
+}
+
+/**
+ * @brief 验证消息参数
+ */
+static CAN_TestBox_Status_t CAN_TestBox_ValidateMessage(const CAN_TestBox_Message_t *message)
+{
+    if (message == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    if (message->dlc > 8) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    if (message->is_extended) {
+        if (message->id > 0x1FFFFFFF) {
+            return CAN_TESTBOX_INVALID_PARAM;
+        }
     } else {
-        rx_message.id = rx_header->StdId;
-        rx_message.is_extended = false;
-    }
-    
-    rx_message.dlc = rx_header->DLC;
-    rx_message.is_remote = (rx_header->RTR == CAN_RTR_REMOTE);
-    rx_message.timestamp = CAN_TestBox_GetTick();
-    
-    // 复制数据
-    for (uint8_t i = 0; i < rx_message.dlc && i < 8; i++) {
-        rx_message.data[i] = rx_data[i];
-    }
-    
-    // 更新统计信息
-    g_statistics.rx_total_count++;
-    g_statistics.rx_valid_count++;
-    
-    // 仅当没有设置回调时才添加到接收队列
-    if (g_rx_callback == NULL) {
-        if (osMessageQueuePut(g_receive_queue, &rx_message, 0, 0) != osOK) {
-            // 队列满，丢弃消息
+        if (message->id > 0x7FF) {
+            return CAN_TESTBOX_INVALID_PARAM;
+        }
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 按CAN句柄查找已打开的片内通道
+ */
+static CAN_TestBox_Channel_t CAN_TestBox_FindChannelByHandle(CAN_HandleTypeDef *hcan)
+{
+    for (uint8_t i = 0; i < CAN_TESTBOX_CH_COUNT; i++) {
+        if (g_channels[i].initialized && g_channels[i].hcan == hcan) {
+            return &g_channels[i];
         }
     }
-    
-    // 调用回调函数
-    if (g_rx_callback != NULL) {
-        g_rx_callback(&rx_message);
+
+    return NULL;
+}
+
+/**
+ * @brief 片内CAN通道是否处于静默模式(CAN2未被网关切换为正常模式时)
+ */
+static bool CAN_TestBox_ChannelIsSilent(CAN_TestBox_Channel_t channel)
+{
+    return channel->hcan != NULL &&
+           (channel->hcan->Init.Mode == CAN_MODE_SILENT || channel->hcan->Init.Mode == CAN_MODE_SILENT_LOOPBACK);
+}
+
+/* ========================= CAN中断回调函数 ========================= */
+
+/**
+ * @brief CAN TestBox接收处理函数
+ * @note 在CAN接收中断中调用此函数处理接收到的消息，按句柄分发到对应通道
+ */
+void CAN_TestBox_ProcessRxMessage(CAN_HandleTypeDef *hcan, CAN_RxHeaderTypeDef *rx_header, uint8_t *rx_data)
+{
+    CAN_TestBox_Channel_t channel = CAN_TestBox_FindChannelByHandle(hcan);
+    if (channel == NULL) {
+        return;
     }
-    
+
+    CAN_TestBox_Frame_t rx_frame;
+    bool is_extended = (rx_header->IDE == CAN_ID_EXT);
+    uint8_t dlc = (rx_header->DLC > 8U) ? 8U : (uint8_t)rx_header->DLC;
+
+    // 直接由接收头打包为紧凑帧(rx_data为HAL的8字节接收缓冲区)
+    CAN_Frame_Pack(&rx_frame, is_extended ? rx_header->ExtId : rx_header->StdId,
+                   is_extended, rx_header->RTR == CAN_RTR_REMOTE, dlc, rx_data,
+                   (uint8_t)channel->id, CAN_TestBox_GetTick());
+
+    CAN_TestBox_ChannelInputFrame(channel, &rx_frame);
+
     // 不打印接收信息 (Don't print reception information)
 }
 
+/**
+ * @brief CAN TestBox发送完成处理函数
+ * @note 在CAN发送邮箱完成中断中调用，仅在有周期报文等待重试时唤醒任务
+ */
+void CAN_TestBox_ProcessTxComplete(CAN_HandleTypeDef *hcan)
+{
+    CAN_TestBox_Channel_t channel = CAN_TestBox_FindChannelByHandle(hcan);
+    if (channel == NULL) {
+        return;
+    }
+
+    if (channel->tx_blocked) {
+        channel->tx_blocked = false;
+        CAN_Event_Notify(CAN_EVENT_TX_DONE);
+    }
+}
+
 /**
  * @brief CAN TestBox错误处理函数
  * @note 在CAN错误中断中调用此函数处理错误
  */
 void CAN_TestBox_ProcessError(CAN_HandleTypeDef *hcan)
 {
-    if (hcan != g_hcan || !g_initialized) {
+    CAN_TestBox_Channel_t channel = CAN_TestBox_FindChannelByHandle(hcan);
+    if (channel == NULL) {
         return;
     }
-    
-    g_statistics.bus_error_count++;
-    g_statistics.last_error_code = HAL_CAN_GetError(hcan);
-    
+
+    channel->statistics.bus_error_count++;
+    channel->statistics.last_error_code = HAL_CAN_GetError(hcan);
+
     // 不打印CAN错误信息 (Don't print CAN error information)
 }
 
@@ -826,4 +1875,4 @@ void HAL_CAN_ErrorCallback(CAN_HandleTypeDef *hcan)
 {
     // 已移至can_dual_node.c中统一处理
 }
-#endif
\ No newline at end of file
+#endif
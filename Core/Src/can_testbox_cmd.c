@@ -0,0 +1,305 @@
+/**
+ * @file can_testbox_cmd.c
+ * @brief CAN测试盒串口帧命令通道实现
+ * @version 1.0
+ * @date 2024
+ */
+
+#include "can_testbox_cmd.h"
+#include "can_testbox_event.h"
+#include "usart.h"
+#include <string.h>
+#include <stdio.h>
+
+/* ========================= 私有类型定义 ========================= */
+
+/**
+ * @brief 帧解析状态
+ */
+typedef enum {
+    CAN_CMD_STATE_IDLE = 0,     // 等待帧头
+    CAN_CMD_STATE_CMD,          // 等待命令字
+    CAN_CMD_STATE_LEN,          // 等待长度
+    CAN_CMD_STATE_PAYLOAD,      // 接收负载
+    CAN_CMD_STATE_SUM           // 等待校验和
+} CAN_Cmd_State_t;
+
+/**
+ * @brief 命令注册项
+ */
+typedef struct {
+    uint8_t cmd;
+    CAN_Cmd_Handler_t handler;
+} CAN_Cmd_Entry_t;
+
+/**
+ * @brief 已接收帧
+ */
+typedef struct {
+    uint8_t cmd;
+    uint8_t len;
+    uint8_t payload[CAN_CMD_MAX_PAYLOAD];
+} CAN_Cmd_Frame_t;
+
+/* ========================= 私有变量定义 ========================= */
+
+// 解析状态(仅在串口中断中访问)
+static CAN_Cmd_State_t g_cmd_state = CAN_CMD_STATE_IDLE;
+static CAN_Cmd_Frame_t g_cmd_rx_frame;
+static uint8_t g_cmd_rx_index = 0;
+static uint8_t g_cmd_rx_sum = 0;
+static uint32_t g_cmd_last_byte_tick = 0;
+
+// 待执行帧(中断写入，任务读取)
+static CAN_Cmd_Frame_t g_cmd_pending_frame;
+static volatile bool g_cmd_pending = false;
+
+// 命令注册表
+static CAN_Cmd_Entry_t g_cmd_table[CAN_CMD_MAX_HANDLERS];
+static uint8_t g_cmd_count = 0;
+
+// 分段应答校验和
+static uint8_t g_cmd_tx_sum = 0;
+
+// 统计信息
+static CAN_Cmd_Stats_t g_cmd_stats;
+
+/* ========================= 私有函数声明 ========================= */
+
+static void CAN_Cmd_Transmit(const uint8_t *data, uint16_t len);
+static void CAN_Cmd_HandlePing(uint8_t cmd, const uint8_t *payload, uint8_t len);
+
+/* ========================= 公共API实现 ========================= */
+
+/**
+ * @brief 初始化帧命令通道
+ */
+CAN_TestBox_Status_t CAN_Cmd_Init(void)
+{
+    g_cmd_state = CAN_CMD_STATE_IDLE;
+    g_cmd_pending = false;
+    g_cmd_count = 0;
+    memset(g_cmd_table, 0, sizeof(g_cmd_table));
+    memset(&g_cmd_stats, 0, sizeof(g_cmd_stats));
+
+    return CAN_Cmd_Register(CAN_CMD_ID_PING, CAN_Cmd_HandlePing);
+}
+
+/**
+ * @brief 注册命令处理函数
+ */
+CAN_TestBox_Status_t CAN_Cmd_Register(uint8_t cmd, CAN_Cmd_Handler_t handler)
+{
+    if (handler == NULL || (cmd & CAN_CMD_RESP_FLAG) != 0) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    for (uint8_t i = 0; i < g_cmd_count; i++) {
+        if (g_cmd_table[i].cmd == cmd) {
+            printf("[CMD-ERROR] Command 0x%02X already registered\r\n", (unsigned int)cmd);
+            return CAN_TESTBOX_ALREADY_EXISTS;
+        }
+    }
+
+    // 命令表满时该命令不可用，初始化阶段输出一次错误便于发现
+    if (g_cmd_count >= CAN_CMD_MAX_HANDLERS) {
+        printf("[CMD-ERROR] Command table full, 0x%02X not registered\r\n", (unsigned int)cmd);
+        return CAN_TESTBOX_QUEUE_FULL;
+    }
+
+    g_cmd_table[g_cmd_count].cmd = cmd;
+    g_cmd_table[g_cmd_count].handler = handler;
+    g_cmd_count++;
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 串口接收字节输入(在串口接收中断中调用)
+ */
+bool CAN_Cmd_InputByte(uint8_t byte)
+{
+    uint32_t now = HAL_GetTick();
+
+    // 帧内字节间隔超时，丢弃半帧
+    if (g_cmd_state != CAN_CMD_STATE_IDLE && (now - g_cmd_last_byte_tick) > CAN_CMD_BYTE_TIMEOUT_MS) {
+        g_cmd_stats.timeout_count++;
+        g_cmd_state = CAN_CMD_STATE_IDLE;
+    }
+    g_cmd_last_byte_tick = now;
+
+    switch (g_cmd_state) {
+        case CAN_CMD_STATE_IDLE:
+            if (byte != CAN_CMD_FRAME_HEADER) {
+                return false;
+            }
+            g_cmd_rx_sum = 0;
+            g_cmd_rx_index = 0;
+            g_cmd_state = CAN_CMD_STATE_CMD;
+            break;
+
+        case CAN_CMD_STATE_CMD:
+            g_cmd_rx_frame.cmd = byte;
+            g_cmd_rx_sum += byte;
+            g_cmd_state = CAN_CMD_STATE_LEN;
+            break;
+
+        case CAN_CMD_STATE_LEN:
+            if (byte > CAN_CMD_MAX_PAYLOAD) {
+                g_cmd_stats.length_error_count++;
+                g_cmd_state = CAN_CMD_STATE_IDLE;
+                break;
+            }
+            g_cmd_rx_frame.len = byte;
+            g_cmd_rx_sum += byte;
+            g_cmd_state = (byte == 0) ? CAN_CMD_STATE_SUM : CAN_CMD_STATE_PAYLOAD;
+            break;
+
+        case CAN_CMD_STATE_PAYLOAD:
+            g_cmd_rx_frame.payload[g_cmd_rx_index++] = byte;
+            g_cmd_rx_sum += byte;
+            if (g_cmd_rx_index >= g_cmd_rx_frame.len) {
+                g_cmd_state = CAN_CMD_STATE_SUM;
+            }
+            break;
+
+        case CAN_CMD_STATE_SUM:
+            g_cmd_state = CAN_CMD_STATE_IDLE;
+            if (byte != g_cmd_rx_sum) {
+                g_cmd_stats.checksum_error_count++;
+                break;
+            }
+
+            g_cmd_stats.frame_count++;
+            if (g_cmd_pending) {
+                // 上一帧尚未执行，丢弃本帧
+                g_cmd_stats.overrun_count++;
+                break;
+            }
+
+            g_cmd_pending_frame = g_cmd_rx_frame;
+            g_cmd_pending = true;
+            CAN_Event_Notify(CAN_EVENT_CMD);
+            break;
+
+        default:
+            g_cmd_state = CAN_CMD_STATE_IDLE;
+            break;
+    }
+
+    return true;
+}
+
+/**
+ * @brief 执行已接收的帧命令
+ */
+void CAN_Cmd_Process(void)
+{
+    if (!g_cmd_pending) {
+        return;
+    }
+
+    CAN_Cmd_Frame_t frame = g_cmd_pending_frame;
+    g_cmd_pending = false;
+
+    for (uint8_t i = 0; i < g_cmd_count; i++) {
+        if (g_cmd_table[i].cmd == frame.cmd) {
+            g_cmd_table[i].handler(frame.cmd, frame.payload, frame.len);
+            return;
+        }
+    }
+
+    g_cmd_stats.unknown_cmd_count++;
+    CAN_Cmd_SendResult(frame.cmd, CAN_CMD_RESULT_UNKNOWN_CMD);
+}
+
+/**
+ * @brief 发送完整应答帧
+ */
+void CAN_Cmd_SendResponse(uint8_t cmd, const uint8_t *payload, uint16_t len)
+{
+    CAN_Cmd_ResponseBegin(cmd, len);
+    if (len > 0) {
+        CAN_Cmd_ResponseWrite(payload, len);
+    }
+    CAN_Cmd_ResponseEnd();
+}
+
+/**
+ * @brief 发送单字节状态应答
+ */
+void CAN_Cmd_SendResult(uint8_t cmd, uint8_t result)
+{
+    CAN_Cmd_SendResponse(cmd, &result, 1);
+}
+
+/**
+ * @brief 分段发送应答帧: 开始
+ */
+void CAN_Cmd_ResponseBegin(uint8_t cmd, uint16_t total_len)
+{
+    uint8_t header[5] = {
+        CAN_CMD_RESP_HEADER0,
+        CAN_CMD_RESP_HEADER1,
+        (uint8_t)(cmd | CAN_CMD_RESP_FLAG),
+        (uint8_t)(total_len & 0xFFU),
+        (uint8_t)(total_len >> 8)
+    };
+
+    g_cmd_tx_sum = (uint8_t)(header[2] + header[3] + header[4]);
+    CAN_Cmd_Transmit(header, sizeof(header));
+}
+
+/**
+ * @brief 分段发送应答帧: 写出负载
+ */
+void CAN_Cmd_ResponseWrite(const void *data, uint16_t len)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+
+    for (uint16_t i = 0; i < len; i++) {
+        g_cmd_tx_sum += bytes[i];
+    }
+
+    CAN_Cmd_Transmit(bytes, len);
+}
+
+/**
+ * @brief 分段发送应答帧: 结束
+ */
+void CAN_Cmd_ResponseEnd(void)
+{
+    CAN_Cmd_Transmit(&g_cmd_tx_sum, 1);
+}
+
+/**
+ * @brief 获取帧解析统计
+ */
+CAN_TestBox_Status_t CAN_Cmd_GetStats(CAN_Cmd_Stats_t *stats)
+{
+    if (stats == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    *stats = g_cmd_stats;
+
+    return CAN_TESTBOX_OK;
+}
+
+/* ========================= 私有函数实现 ========================= */
+
+/**
+ * @brief 串口发送(与printf共用USART2)
+ */
+static void CAN_Cmd_Transmit(const uint8_t *data, uint16_t len)
+{
+    HAL_UART_Transmit(&huart2, (uint8_t *)data, len, HAL_MAX_DELAY);
+}
+
+/**
+ * @brief 链路测试命令
+ */
+static void CAN_Cmd_HandlePing(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    CAN_Cmd_SendResponse(cmd, payload, len);
+}
@@ -0,0 +1,714 @@
+/**
+ * @file can_testbox_cyclemon.c
+ * @brief CAN按ID周期监控实现
+ * @version 1.0
+ * @date 2024
+ */
+
+#include "can_testbox_cyclemon.h"
+#include "can_testbox_timestamp.h"
+#include "can_testbox_event.h"
+#include "can_testbox_cmd.h"
+#include <string.h>
+#include <stdio.h>
+
+/* ========================= 私有宏定义 ========================= */
+
+#define CAN_CYCLEMON_WHEEL_SIZE         (1U << CAN_CYCLEMON_WHEEL_BITS)
+#define CAN_CYCLEMON_WHEEL_MASK         (CAN_CYCLEMON_WHEEL_SIZE - 1U)
+#define CAN_CYCLEMON_KEY_EXT            0x80000000U   // 查找键中的扩展帧标志
+#define CAN_CYCLEMON_KEY_CAN2           0x40000000U   // 查找键中的CAN2标志(扩展ID只有29位)
+#define CAN_CYCLEMON_KEY_ID_MASK        0x1FFFFFFFU
+#define CAN_CYCLEMON_HASH_EMPTY         0x0000U       // 哈希项空闲
+#define CAN_CYCLEMON_HASH_DELETED       0xFFFFU       // 哈希项已删除(墓碑)
+#define CAN_CYCLEMON_NIL                0xFFFFU       // 时间轮链表结束
+
+/* ========================= 私有类型定义 ========================= */
+
+/**
+ * @brief 监控项
+ * @note  rx_count/last_rx_us/last_rx_tick/state及计数由接收中断写入，
+ *        时间轮字段(next/slot/rounds/armed_rx_count)只在任务中访问
+ */
+typedef struct {
+    bool     in_use;                // 是否已配置
+    uint32_t key;                   // 查找键(ID | CAN_CYCLEMON_KEY_EXT | CAN_CYCLEMON_KEY_CAN2)
+    uint32_t period_us;             // 期望周期(us)
+    uint32_t tolerance_us;          // 容差(us)
+    uint32_t timeout_ms;            // 丢失判定超时(ms)
+
+    volatile CAN_CycleMon_State_t state;
+    volatile uint32_t last_rx_us;   // 最近一帧硬件时间戳
+    volatile uint32_t last_rx_tick; // 最近一帧系统tick(ms)
+    CAN_CycleMon_Stats_t stats;     // 统计(state字段在读取时填充)
+
+    uint32_t armed_rx_count;        // 挂入时间轮时的接收帧数
+    uint16_t next;                  // 同槽位下一监控项
+    uint16_t slot;                  // 所在槽位
+    uint16_t rounds;                // 剩余轮数
+} CAN_CycleMon_Monitor_t;
+
+/* ========================= 私有变量定义 ========================= */
+
+// 监控项
+static CAN_CycleMon_Monitor_t g_monitors[CAN_CYCLEMON_MAX_MONITORS];
+
+// ID查找哈希表(存放监控项下标+1)
+static volatile uint16_t g_lookup[CAN_CYCLEMON_HASH_SIZE];
+
+// 时间轮
+static uint16_t g_wheel[CAN_CYCLEMON_WHEEL_SIZE];
+static uint32_t g_wheel_tick = 0;          // 已处理到的tick
+static bool g_initialized = false;
+
+// 事件缓冲区(中断与任务均可写入，关中断保护)
+static CAN_CycleMon_Event_t g_events[CAN_CYCLEMON_EVENT_QUEUE_SIZE];
+static volatile uint32_t g_event_head = 0;
+static volatile uint32_t g_event_tail = 0;
+static volatile uint32_t g_event_overflow = 0;
+
+// 事件钩子与串口输出
+static CAN_CycleMon_EventHook_t g_event_hook = NULL;
+static bool g_output_enabled = false;
+
+// 事件名称
+static const char * const g_event_names[] = {
+    "EARLY",
+    "LATE",
+    "MISSING",
+    "RECOVERED"
+};
+
+/* ========================= 私有函数声明 ========================= */
+
+static inline uint32_t CAN_CycleMon_MakeKey(uint8_t ch, uint32_t id, bool is_extended);
+static inline uint32_t CAN_CycleMon_Hash(uint32_t key);
+static int32_t CAN_CycleMon_Find(uint32_t key);
+static void CAN_CycleMon_WheelInsert(uint16_t index, uint32_t delay_ms);
+static void CAN_CycleMon_WheelUnlink(uint16_t index);
+static void CAN_CycleMon_Expire(uint16_t index, uint32_t tick);
+static void CAN_CycleMon_PushEvent(CAN_CycleMon_EventType_t type, uint16_t index, uint32_t interval_us, uint32_t timestamp_us);
+static uint32_t CAN_CycleMon_ReadU32(const uint8_t *p);
+static void CAN_CycleMon_HandleCtrl(uint8_t cmd, const uint8_t *payload, uint8_t len);
+
+/* ========================= 公共API实现 ========================= */
+
+/**
+ * @brief 初始化周期监控模块
+ */
+CAN_TestBox_Status_t CAN_CycleMon_Init(void)
+{
+    memset(g_monitors, 0, sizeof(g_monitors));
+    memset((void *)g_lookup, 0, sizeof(g_lookup));
+
+    for (uint32_t i = 0; i < CAN_CYCLEMON_WHEEL_SIZE; i++) {
+        g_wheel[i] = CAN_CYCLEMON_NIL;
+    }
+
+    g_wheel_tick = HAL_GetTick();
+    g_event_head = 0;
+    g_event_tail = 0;
+    g_event_overflow = 0;
+    g_initialized = true;
+
+    if (CAN_Cmd_Register(CAN_CMD_ID_CYCLEMON_CTRL, CAN_CycleMon_HandleCtrl) != CAN_TESTBOX_OK) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 添加监控项
+ */
+CAN_TestBox_Status_t CAN_CycleMon_Add(const CAN_CycleMon_Config_t *config, uint16_t *handle)
+{
+    if (!g_initialized) {
+        return CAN_TESTBOX_NOT_INITIALIZED;
+    }
+
+    if (config == NULL || handle == NULL || config->period_ms == 0 || config->channel > CAN_TESTBOX_CH_CAN2 ||
+        (config->is_extended ? (config->id > 0x1FFFFFFFU) : (config->id > 0x7FFU))) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    // 周期与容差换算为us后参与加减比较，默认超时按周期倍数计算，均不得回绕
+    if (config->period_ms > CAN_CYCLEMON_PERIOD_MAX_MS ||
+        config->tolerance_ms > CAN_CYCLEMON_PERIOD_MAX_MS - config->period_ms ||
+        (config->timeout_ms == 0 && config->period_ms > 0xFFFFFFFFU / CAN_CYCLEMON_DEFAULT_TIMEOUT_X)) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    uint32_t key = CAN_CycleMon_MakeKey(config->channel, config->id, config->is_extended);
+    if (CAN_CycleMon_Find(key) >= 0) {
+        return CAN_TESTBOX_ALREADY_EXISTS;
+    }
+
+    // 查找空闲监控项
+    uint16_t index;
+    for (index = 0; index < CAN_CYCLEMON_MAX_MONITORS; index++) {
+        if (!g_monitors[index].in_use) {
+            break;
+        }
+    }
+    if (index >= CAN_CYCLEMON_MAX_MONITORS) {
+        return CAN_TESTBOX_QUEUE_FULL;
+    }
+
+    CAN_CycleMon_Monitor_t *monitor = &g_monitors[index];
+    memset(monitor, 0, sizeof(*monitor));
+    monitor->key = key;
+    monitor->period_us = config->period_ms * 1000U;
+    monitor->tolerance_us = config->tolerance_ms * 1000U;
+    monitor->timeout_ms = (config->timeout_ms != 0) ? config->timeout_ms
+                                                    : config->period_ms * CAN_CYCLEMON_DEFAULT_TIMEOUT_X;
+    monitor->state = CAN_CYCLEMON_STATE_WAIT_FIRST;
+    monitor->last_rx_tick = HAL_GetTick();
+    monitor->stats.min_interval_us = 0xFFFFFFFFU;
+    monitor->next = CAN_CYCLEMON_NIL;
+
+    // 首帧超时从添加时刻开始计算
+    CAN_CycleMon_WheelInsert(index, monitor->timeout_ms);
+
+    // 写入查找表后中断中才可见
+    uint32_t slot = CAN_CycleMon_Hash(key);
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    while (g_lookup[slot] != CAN_CYCLEMON_HASH_EMPTY && g_lookup[slot] != CAN_CYCLEMON_HASH_DELETED) {
+        slot = (slot + 1U) & (CAN_CYCLEMON_HASH_SIZE - 1U);
+    }
+    g_lookup[slot] = (uint16_t)(index + 1U);
+    monitor->in_use = true;
+    __set_PRIMASK(primask);
+
+    *handle = index;
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 删除监控项
+ */
+CAN_TestBox_Status_t CAN_CycleMon_Remove(uint16_t handle)
+{
+    if (handle >= CAN_CYCLEMON_MAX_MONITORS) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    CAN_CycleMon_Monitor_t *monitor = &g_monitors[handle];
+    if (!monitor->in_use) {
+        return CAN_TESTBOX_NOT_FOUND;
+    }
+
+    int32_t slot = -1;
+    uint32_t hash = CAN_CycleMon_Hash(monitor->key);
+    for (uint32_t probe = 0; probe < CAN_CYCLEMON_HASH_SIZE; probe++) {
+        uint32_t i = (hash + probe) & (CAN_CYCLEMON_HASH_SIZE - 1U);
+        if (g_lookup[i] == handle + 1U) {
+            slot = (int32_t)i;
+            break;
+        }
+        if (g_lookup[i] == CAN_CYCLEMON_HASH_EMPTY) {
+            break;
+        }
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (slot >= 0) {
+        g_lookup[slot] = CAN_CYCLEMON_HASH_DELETED;
+    }
+    monitor->in_use = false;
+    __set_PRIMASK(primask);
+
+    CAN_CycleMon_WheelUnlink(handle);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 删除所有监控项
+ */
+CAN_TestBox_Status_t CAN_CycleMon_Clear(void)
+{
+    for (uint16_t i = 0; i < CAN_CYCLEMON_MAX_MONITORS; i++) {
+        if (g_monitors[i].in_use) {
+            CAN_CycleMon_Remove(i);
+        }
+    }
+
+    // 所有项已删除，可同时清除墓碑
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset((void *)g_lookup, 0, sizeof(g_lookup));
+    __set_PRIMASK(primask);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 获取监控项统计
+ */
+CAN_TestBox_Status_t CAN_CycleMon_GetStats(uint16_t handle, CAN_CycleMon_Stats_t *stats)
+{
+    if (handle >= CAN_CYCLEMON_MAX_MONITORS || stats == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    CAN_CycleMon_Monitor_t *monitor = &g_monitors[handle];
+    if (!monitor->in_use) {
+        return CAN_TESTBOX_NOT_FOUND;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *stats = monitor->stats;
+    stats->state = monitor->state;
+    __set_PRIMASK(primask);
+
+    if (stats->rx_count < 2) {
+        stats->min_interval_us = 0;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 重置所有监控项统计
+ */
+CAN_TestBox_Status_t CAN_CycleMon_ResetStats(void)
+{
+    for (uint16_t i = 0; i < CAN_CYCLEMON_MAX_MONITORS; i++) {
+        CAN_CycleMon_Monitor_t *monitor = &g_monitors[i];
+
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        // 保留rx_count，时间轮依赖其判断是否有新帧到达
+        uint32_t rx_count = monitor->stats.rx_count;
+        memset(&monitor->stats, 0, sizeof(monitor->stats));
+        monitor->stats.rx_count = rx_count;
+        monitor->stats.min_interval_us = 0xFFFFFFFFU;
+        __set_PRIMASK(primask);
+    }
+
+    g_event_overflow = 0;
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 设置事件钩子
+ */
+void CAN_CycleMon_SetEventHook(CAN_CycleMon_EventHook_t hook)
+{
+    g_event_hook = hook;
+}
+
+/**
+ * @brief 使能/禁用事件串口输出
+ */
+void CAN_CycleMon_SetOutput(bool enable)
+{
+    g_output_enabled = enable;
+}
+
+/**
+ * @brief 获取事件缓冲区溢出丢弃的事件数
+ */
+uint32_t CAN_CycleMon_GetEventOverflowCount(void)
+{
+    return g_event_overflow;
+}
+
+/**
+ * @brief 周期监控任务处理
+ */
+void CAN_CycleMon_Process(void)
+{
+    if (!g_initialized) {
+        return;
+    }
+
+    // 推进时间轮，逐格处理到当前tick
+    uint32_t now = HAL_GetTick();
+    while (g_wheel_tick != now) {
+        g_wheel_tick++;
+
+        uint32_t slot = g_wheel_tick & CAN_CYCLEMON_WHEEL_MASK;
+        uint16_t index = g_wheel[slot];
+        g_wheel[slot] = CAN_CYCLEMON_NIL;
+
+        while (index != CAN_CYCLEMON_NIL) {
+            CAN_CycleMon_Monitor_t *monitor = &g_monitors[index];
+            uint16_t next = monitor->next;
+
+            if (monitor->rounds > 0) {
+                // 未到期，留在本槽位等待下一圈
+                monitor->rounds--;
+                monitor->next = g_wheel[slot];
+                g_wheel[slot] = index;
+            } else {
+                monitor->next = CAN_CYCLEMON_NIL;
+                CAN_CycleMon_Expire(index, g_wheel_tick);
+            }
+
+            index = next;
+        }
+    }
+
+    // 分发事件
+    while (g_event_tail != g_event_head) {
+        CAN_CycleMon_Event_t event = g_events[g_event_tail & (CAN_CYCLEMON_EVENT_QUEUE_SIZE - 1U)];
+        g_event_tail++;
+
+        if (g_event_hook != NULL) {
+            g_event_hook(&event);
+        }
+
+        if (g_output_enabled) {
+            printf("[CYC] CAN%u ID:0x%03lX %s dt:%luus\r\n",
+                   (unsigned int)(event.channel + 1U),
+                   (unsigned long)event.id,
+                   g_event_names[event.type],
+                   (unsigned long)event.interval_us);
+        }
+    }
+}
+
+/**
+ * @brief 计算距下一个非空时间轮槽位的时间
+ * @note  时间轮只在任务中修改，无需关中断
+ */
+uint32_t CAN_CycleMon_GetIdleTime(uint32_t max_ms)
+{
+    if (!g_initialized) {
+        return max_ms;
+    }
+
+    // 有未分发事件时立即处理
+    if (g_event_head != g_event_tail) {
+        return 0;
+    }
+
+    uint32_t lag = HAL_GetTick() - g_wheel_tick;
+    if (max_ms > CAN_CYCLEMON_WHEEL_SIZE) {
+        max_ms = CAN_CYCLEMON_WHEEL_SIZE;
+    }
+
+    // 槽位中rounds>0的项也会提前唤醒一次，每圈至多一次，不影响正确性
+    for (uint32_t delay = 1; delay <= max_ms; delay++) {
+        if (g_wheel[(g_wheel_tick + delay) & CAN_CYCLEMON_WHEEL_MASK] != CAN_CYCLEMON_NIL) {
+            return (delay > lag) ? (delay - lag) : 0U;
+        }
+    }
+
+    return (max_ms > lag) ? (max_ms - lag) : 0U;
+}
+
+/* ========================= 中断处理函数 ========================= */
+
+/**
+ * @brief 接收报文周期检查(在CAN接收中断中调用)
+ */
+void CAN_CycleMon_ProcessRx(CAN_TestBox_ChannelId_t ch, const CAN_RxHeaderTypeDef *rx_header, uint32_t rx_timestamp_us)
+{
+    uint32_t key = (rx_header->IDE == CAN_ID_EXT) ? CAN_CycleMon_MakeKey((uint8_t)ch, rx_header->ExtId, true)
+                                                   : CAN_CycleMon_MakeKey((uint8_t)ch, rx_header->StdId, false);
+    int32_t index = CAN_CycleMon_Find(key);
+
+    if (index < 0) {
+        return;
+    }
+
+    CAN_CycleMon_Monitor_t *monitor = &g_monitors[index];
+    CAN_CycleMon_Stats_t *stats = &monitor->stats;
+
+    if (monitor->state == CAN_CYCLEMON_STATE_MISSING) {
+        // 丢失后恢复
+        uint32_t interval = rx_timestamp_us - monitor->last_rx_us;
+        stats->recovered_count++;
+        CAN_CycleMon_PushEvent(CAN_CYCLEMON_EVENT_RECOVERED, (uint16_t)index,
+                               (stats->rx_count > 0) ? interval : 0, rx_timestamp_us);
+    } else if (monitor->state == CAN_CYCLEMON_STATE_OK) {
+        uint32_t interval = rx_timestamp_us - monitor->last_rx_us;
+
+        stats->last_interval_us = interval;
+        if (interval < stats->min_interval_us) {
+            stats->min_interval_us = interval;
+        }
+        if (interval > stats->max_interval_us) {
+            stats->max_interval_us = interval;
+        }
+
+        if (interval > monitor->period_us + monitor->tolerance_us) {
+            stats->late_count++;
+            CAN_CycleMon_PushEvent(CAN_CYCLEMON_EVENT_LATE, (uint16_t)index, interval, rx_timestamp_us);
+        } else if (monitor->period_us > monitor->tolerance_us &&
+                   interval < monitor->period_us - monitor->tolerance_us) {
+            stats->early_count++;
+            CAN_CycleMon_PushEvent(CAN_CYCLEMON_EVENT_EARLY, (uint16_t)index, interval, rx_timestamp_us);
+        }
+    }
+
+    monitor->last_rx_us = rx_timestamp_us;
+    monitor->last_rx_tick = HAL_GetTick();
+    monitor->state = CAN_CYCLEMON_STATE_OK;
+    stats->rx_count++;
+}
+
+/* ========================= 私有函数实现 ========================= */
+
+/**
+ * @brief 生成查找键
+ */
+static inline uint32_t CAN_CycleMon_MakeKey(uint8_t ch, uint32_t id, bool is_extended)
+{
+    uint32_t key = is_extended ? (id | CAN_CYCLEMON_KEY_EXT) : id;
+
+    return (ch == CAN_TESTBOX_CH_CAN2) ? (key | CAN_CYCLEMON_KEY_CAN2) : key;
+}
+
+/**
+ * @brief 查找键哈希(乘法散列)
+ */
+static inline uint32_t CAN_CycleMon_Hash(uint32_t key)
+{
+    return (key * 2654435761U) & (CAN_CYCLEMON_HASH_SIZE - 1U);
+}
+
+/**
+ * @brief 按查找键查找监控项
+ * @return int32_t: 监控项下标，未找到返回-1
+ */
+static int32_t CAN_CycleMon_Find(uint32_t key)
+{
+    uint32_t hash = CAN_CycleMon_Hash(key);
+
+    for (uint32_t probe = 0; probe < CAN_CYCLEMON_HASH_SIZE; probe++) {
+        uint16_t entry = g_lookup[(hash + probe) & (CAN_CYCLEMON_HASH_SIZE - 1U)];
+
+        if (entry == CAN_CYCLEMON_HASH_EMPTY) {
+            return -1;
+        }
+
+        if (entry != CAN_CYCLEMON_HASH_DELETED) {
+            const CAN_CycleMon_Monitor_t *monitor = &g_monitors[entry - 1U];
+            if (monitor->in_use && monitor->key == key) {
+                return (int32_t)(entry - 1U);
+            }
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief 挂入时间轮
+ * @param index: 监控项下标
+ * @param delay_ms: 距当前tick的延时(ms)，至少为1
+ */
+static void CAN_CycleMon_WheelInsert(uint16_t index, uint32_t delay_ms)
+{
+    CAN_CycleMon_Monitor_t *monitor = &g_monitors[index];
+
+    if (delay_ms == 0) {
+        delay_ms = 1;
+    }
+
+    uint32_t slot = (g_wheel_tick + delay_ms) & CAN_CYCLEMON_WHEEL_MASK;
+    uint32_t rounds = (delay_ms - 1U) >> CAN_CYCLEMON_WHEEL_BITS;
+
+    monitor->slot = (uint16_t)slot;
+    monitor->rounds = (rounds > 0xFFFFU) ? 0xFFFFU : (uint16_t)rounds;
+    monitor->armed_rx_count = monitor->stats.rx_count;
+    monitor->next = g_wheel[slot];
+    g_wheel[slot] = index;
+}
+
+/**
+ * @brief 从时间轮摘除
+ */
+static void CAN_CycleMon_WheelUnlink(uint16_t index)
+{
+    uint16_t *link = &g_wheel[g_monitors[index].slot];
+
+    while (*link != CAN_CYCLEMON_NIL) {
+        if (*link == index) {
+            *link = g_monitors[index].next;
+            g_monitors[index].next = CAN_CYCLEMON_NIL;
+            return;
+        }
+        link = &g_monitors[*link].next;
+    }
+}
+
+/**
+ * @brief 监控项到期处理
+ * @note  到期时若期间收到过报文，则按最近接收时间重新挂入；否则判定丢失
+ */
+static void CAN_CycleMon_Expire(uint16_t index, uint32_t tick)
+{
+    CAN_CycleMon_Monitor_t *monitor = &g_monitors[index];
+
+    if (!monitor->in_use) {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (monitor->stats.rx_count != monitor->armed_rx_count) {
+        int32_t remaining = (int32_t)(monitor->last_rx_tick + monitor->timeout_ms - tick);
+        if (remaining > 0) {
+            __set_PRIMASK(primask);
+            CAN_CycleMon_WheelInsert(index, (uint32_t)remaining);
+            return;
+        }
+    }
+
+    monitor->state = CAN_CYCLEMON_STATE_MISSING;
+    monitor->stats.missing_count++;
+    __set_PRIMASK(primask);
+
+    CAN_CycleMon_PushEvent(CAN_CYCLEMON_EVENT_MISSING, index, 0, CAN_Timestamp_GetUs());
+
+    // 持续丢失时每个超时周期计一次
+    CAN_CycleMon_WheelInsert(index, monitor->timeout_ms);
+}
+
+/**
+ * @brief 写入事件缓冲区
+ */
+static void CAN_CycleMon_PushEvent(CAN_CycleMon_EventType_t type, uint16_t index, uint32_t interval_us, uint32_t timestamp_us)
+{
+    const CAN_CycleMon_Monitor_t *monitor = &g_monitors[index];
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (g_event_head - g_event_tail >= CAN_CYCLEMON_EVENT_QUEUE_SIZE) {
+        g_event_overflow++;
+        __set_PRIMASK(primask);
+        return;
+    }
+
+    CAN_CycleMon_Event_t *event = &g_events[g_event_head & (CAN_CYCLEMON_EVENT_QUEUE_SIZE - 1U)];
+    event->type = type;
+    event->handle = index;
+    event->channel = ((monitor->key & CAN_CYCLEMON_KEY_CAN2) != 0U) ? CAN_TESTBOX_CH_CAN2 : CAN_TESTBOX_CH_CAN1;
+    event->id = monitor->key & CAN_CYCLEMON_KEY_ID_MASK;
+    event->is_extended = (monitor->key & CAN_CYCLEMON_KEY_EXT) != 0;
+    event->interval_us = interval_us;
+    event->timestamp_us = timestamp_us;
+    g_event_head++;
+
+    __set_PRIMASK(primask);
+
+    CAN_Event_Notify(CAN_EVENT_RX);
+}
+
+/**
+ * @brief 读取小端u32
+ */
+static uint32_t CAN_CycleMon_ReadU32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief 串口命令: 周期监控项配置/统计/事件输出
+ */
+static void CAN_CycleMon_HandleCtrl(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    CAN_CycleMon_Config_t config;
+    CAN_CycleMon_Stats_t stats;
+    CAN_TestBox_Status_t status;
+    uint16_t handle;
+
+    if (len < 1U) {
+        CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+        return;
+    }
+
+    switch (payload[0]) {
+        case CAN_CYCLEMON_CTRL_STATUS:
+            // 句柄(u16)
+            if (len != 3U) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+                return;
+            }
+            if (CAN_CycleMon_GetStats((uint16_t)(payload[1] | (payload[2] << 8)), &stats) != CAN_TESTBOX_OK) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_PARAM);
+                return;
+            }
+            // 应答: 状态、接收、过早、迟到、丢失、恢复、最近/最小/最大帧间隔(us)、事件溢出数，均为u32
+            {
+                uint32_t reply[10] = {
+                    (uint32_t)stats.state,
+                    stats.rx_count,
+                    stats.early_count,
+                    stats.late_count,
+                    stats.missing_count,
+                    stats.recovered_count,
+                    stats.last_interval_us,
+                    stats.min_interval_us,
+                    stats.max_interval_us,
+                    g_event_overflow
+                };
+                CAN_Cmd_SendResponse(cmd, (const uint8_t *)reply, sizeof(reply));
+            }
+            return;
+
+        case CAN_CYCLEMON_CTRL_ADD:
+            // 扩展帧(u8)、ID(u32)、周期(u32)、容差(u32)、超时(u32)，可选通道(u8，省略为CAN1)
+            if (len != 18U && len != 19U) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+                return;
+            }
+            config.channel = (len == 19U) ? payload[18] : (uint8_t)CAN_TESTBOX_CH_CAN1;
+            config.is_extended = (payload[1] != 0U);
+            config.id = CAN_CycleMon_ReadU32(&payload[2]);
+            config.period_ms = CAN_CycleMon_ReadU32(&payload[6]);
+            config.tolerance_ms = CAN_CycleMon_ReadU32(&payload[10]);
+            config.timeout_ms = CAN_CycleMon_ReadU32(&payload[14]);
+            status = CAN_CycleMon_Add(&config, &handle);
+            if (status == CAN_TESTBOX_OK) {
+                uint8_t reply[2] = { (uint8_t)handle, (uint8_t)(handle >> 8) };
+                CAN_Cmd_SendResponse(cmd, reply, sizeof(reply));
+            } else {
+                CAN_Cmd_SendResult(cmd, (status == CAN_TESTBOX_INVALID_PARAM) ? CAN_CMD_RESULT_BAD_PARAM : CAN_CMD_RESULT_FAILED);
+            }
+            return;
+
+        case CAN_CYCLEMON_CTRL_REMOVE:
+            if (len != 3U) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+                return;
+            }
+            status = CAN_CycleMon_Remove((uint16_t)(payload[1] | (payload[2] << 8)));
+            break;
+
+        case CAN_CYCLEMON_CTRL_CLEAR:
+            status = CAN_CycleMon_Clear();
+            break;
+
+        case CAN_CYCLEMON_CTRL_OUTPUT:
+            if (len != 2U) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+                return;
+            }
+            CAN_CycleMon_SetOutput(payload[1] != 0U);
+            status = CAN_TESTBOX_OK;
+            break;
+
+        case CAN_CYCLEMON_CTRL_RESET_STATS:
+            status = CAN_CycleMon_ResetStats();
+            break;
+
+        default:
+            CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_PARAM);
+            return;
+    }
+
+    CAN_Cmd_SendResult(cmd, (status == CAN_TESTBOX_OK) ? CAN_CMD_RESULT_OK : CAN_CMD_RESULT_BAD_PARAM);
+}
@@ -0,0 +1,576 @@
+/**
+ * @file can_testbox_e2e.c
+ * @brief 周期报文E2E保护实现
+ * @version 1.0
+ * @date 2024
+ */
+
+#include "can_testbox_e2e.h"
+#include "can_testbox_frame.h"
+#include "can_testbox_cmd.h"
+#include <string.h>
+
+/* ========================= 私有宏定义 ========================= */
+
+#define CAN_E2E_NIL                 0xFFU   // 链表结束
+#define CAN_E2E_PROFILE_WIRE_LEN    9U      // 串口命令中保护参数的长度
+
+/* ========================= 私有类型定义 ========================= */
+
+/**
+ * @brief 发送保护槽位
+ */
+typedef struct {
+    CAN_E2E_Profile_t profile;
+    uint8_t counter;                        // 下一帧使用的计数器
+} CAN_E2E_TxSlot_t;
+
+/**
+ * @brief 接收校验登记
+ */
+typedef struct {
+    bool used;
+    uint8_t channel;
+    bool is_extended;
+    bool has_base;                          // 已收到首帧
+    uint8_t last_counter;                   // 上一帧计数器
+    uint8_t next;                           // 同桶下一项
+    uint32_t id;
+    CAN_E2E_Profile_t profile;
+    CAN_E2E_RxStats_t stats;
+} CAN_E2E_RxEntry_t;
+
+/* ========================= 私有变量定义 ========================= */
+
+// CRC8查表: [0] SAE J1850(0x1D)，[1] CRC8H2F(0x2F)
+static const uint8_t g_crc8_tables[2][256] = {
+    {
+    0x00, 0x1D, 0x3A, 0x27, 0x74, 0x69, 0x4E, 0x53, 0xE8, 0xF5, 0xD2, 0xCF, 0x9C, 0x81, 0xA6, 0xBB,
+    0xCD, 0xD0, 0xF7, 0xEA, 0xB9, 0xA4, 0x83, 0x9E, 0x25, 0x38, 0x1F, 0x02, 0x51, 0x4C, 0x6B, 0x76,
+    0x87, 0x9A, 0xBD, 0xA0, 0xF3, 0xEE, 0xC9, 0xD4, 0x6F, 0x72, 0x55, 0x48, 0x1B, 0x06, 0x21, 0x3C,
+    0x4A, 0x57, 0x70, 0x6D, 0x3E, 0x23, 0x04, 0x19, 0xA2, 0xBF, 0x98, 0x85, 0xD6, 0xCB, 0xEC, 0xF1,
+    0x13, 0x0E, 0x29, 0x34, 0x67, 0x7A, 0x5D, 0x40, 0xFB, 0xE6, 0xC1, 0xDC, 0x8F, 0x92, 0xB5, 0xA8,
+    0xDE, 0xC3, 0xE4, 0xF9, 0xAA, 0xB7, 0x90, 0x8D, 0x36, 0x2B, 0x0C, 0x11, 0x42, 0x5F, 0x78, 0x65,
+    0x94, 0x89, 0xAE, 0xB3, 0xE0, 0xFD, 0xDA, 0xC7, 0x7C, 0x61, 0x46, 0x5B, 0x08, 0x15, 0x32, 0x2F,
+    0x59, 0x44, 0x63, 0x7E, 0x2D, 0x30, 0x17, 0x0A, 0xB1, 0xAC, 0x8B, 0x96, 0xC5, 0xD8, 0xFF, 0xE2,
+    0x26, 0x3B, 0x1C, 0x01, 0x52, 0x4F, 0x68, 0x75, 0xCE, 0xD3, 0xF4, 0xE9, 0xBA, 0xA7, 0x80, 0x9D,
+    0xEB, 0xF6, 0xD1, 0xCC, 0x9F, 0x82, 0xA5, 0xB8, 0x03, 0x1E, 0x39, 0x24, 0x77, 0x6A, 0x4D, 0x50,
+    0xA1, 0xBC, 0x9B, 0x86, 0xD5, 0xC8, 0xEF, 0xF2, 0x49, 0x54, 0x73, 0x6E, 0x3D, 0x20, 0x07, 0x1A,
+    0x6C, 0x71, 0x56, 0x4B, 0x18, 0x05, 0x22, 0x3F, 0x84, 0x99, 0xBE, 0xA3, 0xF0, 0xED, 0xCA, 0xD7,
+    0x35, 0x28, 0x0F, 0x12, 0x41, 0x5C, 0x7B, 0x66, 0xDD, 0xC0, 0xE7, 0xFA, 0xA9, 0xB4, 0x93, 0x8E,
+    0xF8, 0xE5, 0xC2, 0xDF, 0x8C, 0x91, 0xB6, 0xAB, 0x10, 0x0D, 0x2A, 0x37, 0x64, 0x79, 0x5E, 0x43,
+    0xB2, 0xAF, 0x88, 0x95, 0xC6, 0xDB, 0xFC, 0xE1, 0x5A, 0x47, 0x60, 0x7D, 0x2E, 0x33, 0x14, 0x09,
+    0x7F, 0x62, 0x45, 0x58, 0x0B, 0x16, 0x31, 0x2C, 0x97, 0x8A, 0xAD, 0xB0, 0xE3, 0xFE, 0xD9, 0xC4
+    },
+    {
+    0x00, 0x2F, 0x5E, 0x71, 0xBC, 0x93, 0xE2, 0xCD, 0x57, 0x78, 0x09, 0x26, 0xEB, 0xC4, 0xB5, 0x9A,
+    0xAE, 0x81, 0xF0, 0xDF, 0x12, 0x3D, 0x4C, 0x63, 0xF9, 0xD6, 0xA7, 0x88, 0x45, 0x6A, 0x1B, 0x34,
+    0x73, 0x5C, 0x2D, 0x02, 0xCF, 0xE0, 0x91, 0xBE, 0x24, 0x0B, 0x7A, 0x55, 0x98, 0xB7, 0xC6, 0xE9,
+    0xDD, 0xF2, 0x83, 0xAC, 0x61, 0x4E, 0x3F, 0x10, 0x8A, 0xA5, 0xD4, 0xFB, 0x36, 0x19, 0x68, 0x47,
+    0xE6, 0xC9, 0xB8, 0x97, 0x5A, 0x75, 0x04, 0x2B, 0xB1, 0x9E, 0xEF, 0xC0, 0x0D, 0x22, 0x53, 0x7C,
+    0x48, 0x67, 0x16, 0x39, 0xF4, 0xDB, 0xAA, 0x85, 0x1F, 0x30, 0x41, 0x6E, 0xA3, 0x8C, 0xFD, 0xD2,
+    0x95, 0xBA, 0xCB, 0xE4, 0x29, 0x06, 0x77, 0x58, 0xC2, 0xED, 0x9C, 0xB3, 0x7E, 0x51, 0x20, 0x0F,
+    0x3B, 0x14, 0x65, 0x4A, 0x87, 0xA8, 0xD9, 0xF6, 0x6C, 0x43, 0x32, 0x1D, 0xD0, 0xFF, 0x8E, 0xA1,
+    0xE3, 0xCC, 0xBD, 0x92, 0x5F, 0x70, 0x01, 0x2E, 0xB4, 0x9B, 0xEA, 0xC5, 0x08, 0x27, 0x56, 0x79,
+    0x4D, 0x62, 0x13, 0x3C, 0xF1, 0xDE, 0xAF, 0x80, 0x1A, 0x35, 0x44, 0x6B, 0xA6, 0x89, 0xF8, 0xD7,
+    0x90, 0xBF, 0xCE, 0xE1, 0x2C, 0x03, 0x72, 0x5D, 0xC7, 0xE8, 0x99, 0xB6, 0x7B, 0x54, 0x25, 0x0A,
+    0x3E, 0x11, 0x60, 0x4F, 0x82, 0xAD, 0xDC, 0xF3, 0x69, 0x46, 0x37, 0x18, 0xD5, 0xFA, 0x8B, 0xA4,
+    0x05, 0x2A, 0x5B, 0x74, 0xB9, 0x96, 0xE7, 0xC8, 0x52, 0x7D, 0x0C, 0x23, 0xEE, 0xC1, 0xB0, 0x9F,
+    0xAB, 0x84, 0xF5, 0xDA, 0x17, 0x38, 0x49, 0x66, 0xFC, 0xD3, 0xA2, 0x8D, 0x40, 0x6F, 0x1E, 0x31,
+    0x76, 0x59, 0x28, 0x07, 0xCA, 0xE5, 0x94, 0xBB, 0x21, 0x0E, 0x7F, 0x50, 0x9D, 0xB2, 0xC3, 0xEC,
+    0xD8, 0xF7, 0x86, 0xA9, 0x64, 0x4B, 0x3A, 0x15, 0x8F, 0xA0, 0xD1, 0xFE, 0x33, 0x1C, 0x6D, 0x42
+    }
+};
+
+// 发送保护槽位与已绑定掩码(位i对应周期报文句柄i)
+static CAN_E2E_TxSlot_t g_tx_slots[CAN_TESTBOX_CH_COUNT][CAN_TESTBOX_MAX_PERIODIC_MSGS];
+static volatile uint32_t g_tx_mask[CAN_TESTBOX_CH_COUNT];
+static uint32_t g_tx_protected = 0;         // 已发送的受保护帧数
+static uint32_t g_tx_skipped = 0;           // 长度不足而未保护的帧数
+
+// 接收校验登记与散列桶
+static CAN_E2E_RxEntry_t g_rx_entries[CAN_E2E_RX_MAX];
+static uint8_t g_rx_buckets[CAN_E2E_RX_HASH_SIZE];
+static volatile uint8_t g_rx_count = 0;
+
+_Static_assert(CAN_TESTBOX_MAX_PERIODIC_MSGS <= 32, "tx mask too small");
+
+/* ========================= 私有函数声明 ========================= */
+
+static bool CAN_E2E_ValidateProfile(const CAN_E2E_Profile_t *profile);
+static uint8_t CAN_E2E_Compute(const CAN_E2E_Profile_t *profile, const uint8_t *data, uint8_t dlc);
+static uint8_t CAN_E2E_Hash(uint32_t id);
+static void CAN_E2E_Verify(CAN_E2E_RxEntry_t *entry, const uint8_t *data, uint8_t dlc);
+static void CAN_E2E_ParseProfile(const uint8_t *wire, CAN_E2E_Profile_t *profile);
+static void CAN_E2E_HandleCtrl(uint8_t cmd, const uint8_t *payload, uint8_t len);
+
+/* ========================= 公共API实现 ========================= */
+
+/**
+ * @brief 初始化E2E保护
+ */
+CAN_TestBox_Status_t CAN_E2E_Init(void)
+{
+    memset(g_tx_slots, 0, sizeof(g_tx_slots));
+    memset((void *)g_tx_mask, 0, sizeof(g_tx_mask));
+    memset(g_rx_entries, 0, sizeof(g_rx_entries));
+    memset(g_rx_buckets, CAN_E2E_NIL, sizeof(g_rx_buckets));
+    g_rx_count = 0;
+    g_tx_protected = 0;
+    g_tx_skipped = 0;
+
+    if (CAN_Cmd_Register(CAN_CMD_ID_E2E_CTRL, CAN_E2E_HandleCtrl) != CAN_TESTBOX_OK) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 计算CRC8
+ */
+uint8_t CAN_E2E_Crc8(uint8_t crc_type, uint8_t crc, const uint8_t *data, uint8_t len)
+{
+    const uint8_t *table = g_crc8_tables[(crc_type == CAN_E2E_CRC_8H2F) ? 1 : 0];
+
+    for (uint8_t i = 0; i < len; i++) {
+        crc = table[crc ^ data[i]];
+    }
+
+    return crc;
+}
+
+/**
+ * @brief 周期报文槽位绑定保护参数
+ */
+CAN_TestBox_Status_t CAN_E2E_AttachTx(CAN_TestBox_ChannelId_t ch, uint8_t handle, const CAN_E2E_Profile_t *profile)
+{
+    if (ch >= CAN_TESTBOX_CH_COUNT || handle >= CAN_TESTBOX_MAX_PERIODIC_MSGS ||
+        !CAN_E2E_ValidateProfile(profile)) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    // 先解除再写参数，发送路径不会看到写了一半的参数
+    g_tx_mask[ch] &= ~(1UL << handle);
+    g_tx_slots[ch][handle].profile = *profile;
+    g_tx_slots[ch][handle].counter = 0;
+    g_tx_mask[ch] |= (1UL << handle);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 周期报文槽位解除保护
+ */
+void CAN_E2E_DetachTx(CAN_TestBox_ChannelId_t ch, uint8_t handle)
+{
+    if (ch < CAN_TESTBOX_CH_COUNT && handle < CAN_TESTBOX_MAX_PERIODIC_MSGS) {
+        g_tx_mask[ch] &= ~(1UL << handle);
+    }
+}
+
+/**
+ * @brief 发送前生成受保护的帧副本
+ * @note  计数器在发送成功后才推进，邮箱满重试时不会跳号
+ */
+bool CAN_E2E_ProtectTx(CAN_TestBox_ChannelId_t ch, uint8_t handle,
+                       const CAN_TestBox_Frame_t *frame, CAN_TestBox_Frame_t *out)
+{
+    if ((g_tx_mask[ch] & (1UL << handle)) == 0U) {
+        return false;
+    }
+
+    const CAN_E2E_TxSlot_t *slot = &g_tx_slots[ch][handle];
+    const CAN_E2E_Profile_t *profile = &slot->profile;
+    uint8_t dlc = CAN_Frame_GetDlc(frame);
+
+    // 数据被修改为更短的长度时按原样发送
+    if (dlc <= profile->crc_byte || dlc <= profile->counter_byte) {
+        g_tx_skipped++;
+        return false;
+    }
+
+    *out = *frame;
+    uint8_t *data = CAN_Frame_Data(out);
+
+    if (profile->counter_nibble == CAN_E2E_NIBBLE_HIGH) {
+        data[profile->counter_byte] = (uint8_t)((data[profile->counter_byte] & 0x0FU) | (slot->counter << 4));
+    } else {
+        data[profile->counter_byte] = (uint8_t)((data[profile->counter_byte] & 0xF0U) | slot->counter);
+    }
+    data[profile->crc_byte] = CAN_E2E_Compute(profile, data, dlc);
+
+    return true;
+}
+
+/**
+ * @brief 受保护帧发送成功后推进计数器
+ */
+void CAN_E2E_ConfirmTx(CAN_TestBox_ChannelId_t ch, uint8_t handle)
+{
+    CAN_E2E_TxSlot_t *slot = &g_tx_slots[ch][handle];
+
+    slot->counter = (slot->counter >= slot->profile.counter_max) ? 0U : (uint8_t)(slot->counter + 1U);
+    g_tx_protected++;
+}
+
+/**
+ * @brief 登记接收校验
+ */
+CAN_TestBox_Status_t CAN_E2E_AddRx(CAN_TestBox_ChannelId_t ch, uint32_t id, bool is_extended,
+                                   const CAN_E2E_Profile_t *profile, uint8_t *index)
+{
+    if (ch >= CAN_TESTBOX_CH_COUNT || !CAN_E2E_ValidateProfile(profile) ||
+        id > (is_extended ? 0x1FFFFFFFU : 0x7FFU)) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    uint8_t slot = CAN_E2E_NIL;
+    for (uint8_t i = 0; i < CAN_E2E_RX_MAX; i++) {
+        const CAN_E2E_RxEntry_t *entry = &g_rx_entries[i];
+        if (entry->used) {
+            if (entry->channel == (uint8_t)ch && entry->id == id && entry->is_extended == is_extended) {
+                return CAN_TESTBOX_ALREADY_EXISTS;
+            }
+        } else if (slot == CAN_E2E_NIL) {
+            slot = i;
+        }
+    }
+
+    if (slot == CAN_E2E_NIL) {
+        return CAN_TESTBOX_QUEUE_FULL;
+    }
+
+    CAN_E2E_RxEntry_t *entry = &g_rx_entries[slot];
+    memset(entry, 0, sizeof(*entry));
+    entry->channel = (uint8_t)ch;
+    entry->is_extended = is_extended;
+    entry->id = id;
+    entry->profile = *profile;
+    entry->used = true;
+
+    // 插入桶头，接收中断只会看到完整的登记项
+    uint8_t bucket = CAN_E2E_Hash(id);
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    entry->next = g_rx_buckets[bucket];
+    g_rx_buckets[bucket] = slot;
+    g_rx_count++;
+    __set_PRIMASK(primask);
+
+    if (index != NULL) {
+        *index = slot;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 删除接收校验
+ */
+CAN_TestBox_Status_t CAN_E2E_RemoveRx(uint8_t index)
+{
+    if (index >= CAN_E2E_RX_MAX) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    if (!g_rx_entries[index].used) {
+        return CAN_TESTBOX_NOT_FOUND;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint8_t *link = &g_rx_buckets[CAN_E2E_Hash(g_rx_entries[index].id)];
+    while (*link != CAN_E2E_NIL && *link != index) {
+        link = &g_rx_entries[*link].next;
+    }
+    if (*link == index) {
+        *link = g_rx_entries[index].next;
+    }
+    g_rx_entries[index].used = false;
+    g_rx_count--;
+
+    __set_PRIMASK(primask);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 接收帧校验
+ */
+void CAN_E2E_CheckRx(const CAN_TestBox_Frame_t *frame)
+{
+    if (g_rx_count == 0U || CAN_Frame_IsRemote(frame)) {
+        return;
+    }
+
+    uint32_t id = CAN_Frame_GetId(frame);
+    bool is_extended = CAN_Frame_IsExtended(frame);
+    uint8_t channel = CAN_Frame_GetChannel(frame);
+
+    for (uint8_t i = g_rx_buckets[CAN_E2E_Hash(id)]; i != CAN_E2E_NIL; i = g_rx_entries[i].next) {
+        CAN_E2E_RxEntry_t *entry = &g_rx_entries[i];
+        if (entry->id == id && entry->is_extended == is_extended && entry->channel == channel) {
+            CAN_E2E_Verify(entry, CAN_Frame_ConstData(frame), CAN_Frame_GetDlc(frame));
+            return;
+        }
+    }
+}
+
+/**
+ * @brief 获取接收校验统计
+ */
+CAN_TestBox_Status_t CAN_E2E_GetRxStats(uint8_t index, CAN_E2E_RxStats_t *stats)
+{
+    if (index >= CAN_E2E_RX_MAX || stats == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    if (!g_rx_entries[index].used) {
+        return CAN_TESTBOX_NOT_FOUND;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *stats = g_rx_entries[index].stats;
+    __set_PRIMASK(primask);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 清空全部接收校验统计
+ */
+void CAN_E2E_ResetRxStats(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint8_t i = 0; i < CAN_E2E_RX_MAX; i++) {
+        memset(&g_rx_entries[i].stats, 0, sizeof(CAN_E2E_RxStats_t));
+        g_rx_entries[i].has_base = false;
+    }
+    g_tx_protected = 0;
+    g_tx_skipped = 0;
+    __set_PRIMASK(primask);
+}
+
+/* ========================= 私有函数实现 ========================= */
+
+/**
+ * @brief 检查保护参数
+ */
+static bool CAN_E2E_ValidateProfile(const CAN_E2E_Profile_t *profile)
+{
+    return (profile != NULL) &&
+           (profile->crc_type <= CAN_E2E_CRC_8H2F) &&
+           (profile->crc_byte < 8U) && (profile->counter_byte < 8U) &&
+           (profile->crc_byte != profile->counter_byte) &&
+           (profile->counter_nibble <= CAN_E2E_NIBBLE_HIGH) &&
+           (profile->counter_max >= 1U) && (profile->counter_max <= 15U) &&
+           (profile->max_delta >= 1U) && (profile->max_delta <= profile->counter_max) &&
+           (profile->data_id_mode <= CAN_E2E_DATAID_NONE);
+}
+
+/**
+ * @brief 按保护参数计算CRC(数据ID低字节、高字节，再跳过CRC字节的数据)
+ */
+static uint8_t CAN_E2E_Compute(const CAN_E2E_Profile_t *profile, const uint8_t *data, uint8_t dlc)
+{
+    const uint8_t *table = g_crc8_tables[profile->crc_type];
+    uint8_t crc = 0xFFU;
+
+    if (profile->data_id_mode != CAN_E2E_DATAID_NONE) {
+        crc = table[crc ^ (uint8_t)(profile->data_id)];
+        if (profile->data_id_mode == CAN_E2E_DATAID_BOTH) {
+            crc = table[crc ^ (uint8_t)(profile->data_id >> 8)];
+        }
+    }
+
+    for (uint8_t i = 0; i < dlc; i++) {
+        if (i != profile->crc_byte) {
+            crc = table[crc ^ data[i]];
+        }
+    }
+
+    return (uint8_t)(crc ^ 0xFFU);
+}
+
+/**
+ * @brief 接收散列
+ */
+static uint8_t CAN_E2E_Hash(uint32_t id)
+{
+    return (uint8_t)((id ^ (id >> 4) ^ (id >> 8)) & (CAN_E2E_RX_HASH_SIZE - 1U));
+}
+
+/**
+ * @brief 校验一帧并更新统计
+ * @note  计数器增量为0判为重复；增量超过max_delta判为跳变并以本帧重新同步；
+ *        增量在1~max_delta之间为通过，增量-1计入丢帧数
+ */
+static void CAN_E2E_Verify(CAN_E2E_RxEntry_t *entry, const uint8_t *data, uint8_t dlc)
+{
+    const CAN_E2E_Profile_t *profile = &entry->profile;
+    CAN_E2E_RxStats_t *stats = &entry->stats;
+
+    if (dlc <= profile->crc_byte || dlc <= profile->counter_byte) {
+        stats->length_errors++;
+        stats->last_result = CAN_E2E_RX_LENGTH_ERROR;
+        return;
+    }
+
+    if (CAN_E2E_Compute(profile, data, dlc) != data[profile->crc_byte]) {
+        stats->crc_errors++;
+        stats->last_result = CAN_E2E_RX_CRC_ERROR;
+        return;
+    }
+
+    uint8_t counter = (profile->counter_nibble == CAN_E2E_NIBBLE_HIGH) ?
+                      (uint8_t)(data[profile->counter_byte] >> 4) :
+                      (uint8_t)(data[profile->counter_byte] & 0x0FU);
+
+    if (!entry->has_base) {
+        entry->has_base = true;
+        entry->last_counter = counter;
+        stats->ok++;
+        stats->last_result = CAN_E2E_RX_INITIAL;
+        return;
+    }
+
+    uint8_t modulo = (uint8_t)(profile->counter_max + 1U);
+    uint8_t delta = (uint8_t)((counter + modulo - entry->last_counter) % modulo);
+
+    if (delta == 0U) {
+        stats->repeated++;
+        stats->last_result = CAN_E2E_RX_REPEATED;
+    } else if (delta > profile->max_delta) {
+        stats->wrong_sequence++;
+        stats->lost += (uint32_t)(delta - 1U);
+        stats->last_result = CAN_E2E_RX_WRONG_SEQUENCE;
+        entry->last_counter = counter;
+    } else {
+        stats->ok++;
+        stats->lost += (uint32_t)(delta - 1U);
+        stats->last_result = CAN_E2E_RX_OK;
+        entry->last_counter = counter;
+    }
+}
+
+/**
+ * @brief 解析串口命令中的保护参数(9字节，数据ID小端)
+ */
+static void CAN_E2E_ParseProfile(const uint8_t *wire, CAN_E2E_Profile_t *profile)
+{
+    profile->crc_type = wire[0];
+    profile->crc_byte = wire[1];
+    profile->counter_byte = wire[2];
+    profile->counter_nibble = wire[3];
+    profile->counter_max = wire[4];
+    profile->max_delta = wire[5];
+    profile->data_id_mode = wire[6];
+    profile->data_id = (uint16_t)(wire[7] | (wire[8] << 8));
+}
+
+/**
+ * @brief 串口命令: E2E保护绑定/登记/统计
+ */
+static void CAN_E2E_HandleCtrl(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    CAN_E2E_Profile_t profile;
+    CAN_TestBox_Status_t status;
+    uint8_t index;
+
+    if (len == 0U) {
+        CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+        return;
+    }
+
+    switch (payload[0]) {
+        case CAN_E2E_CTRL_ATTACH_TX:
+            if (len != 3U + CAN_E2E_PROFILE_WIRE_LEN) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+                break;
+            }
+            CAN_E2E_ParseProfile(&payload[3], &profile);
+            status = CAN_E2E_AttachTx((CAN_TestBox_ChannelId_t)payload[1], payload[2], &profile);
+            CAN_Cmd_SendResult(cmd, (status == CAN_TESTBOX_OK) ? CAN_CMD_RESULT_OK : CAN_CMD_RESULT_BAD_PARAM);
+            break;
+
+        case CAN_E2E_CTRL_DETACH_TX:
+            if (len != 3U) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+                break;
+            }
+            CAN_E2E_DetachTx((CAN_TestBox_ChannelId_t)payload[1], payload[2]);
+            CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_OK);
+            break;
+
+        case CAN_E2E_CTRL_ADD_RX:
+            if (len != 7U + CAN_E2E_PROFILE_WIRE_LEN) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+                break;
+            }
+            CAN_E2E_ParseProfile(&payload[7], &profile);
+            status = CAN_E2E_AddRx((CAN_TestBox_ChannelId_t)payload[1],
+                                   (uint32_t)payload[3] | ((uint32_t)payload[4] << 8) |
+                                   ((uint32_t)payload[5] << 16) | ((uint32_t)payload[6] << 24),
+                                   payload[2] != 0U, &profile, &index);
+            if (status == CAN_TESTBOX_OK) {
+                CAN_Cmd_SendResponse(cmd, &index, 1);
+            } else {
+                CAN_Cmd_SendResult(cmd, (status == CAN_TESTBOX_INVALID_PARAM) ? CAN_CMD_RESULT_BAD_PARAM : CAN_CMD_RESULT_FAILED);
+            }
+            break;
+
+        case CAN_E2E_CTRL_REMOVE_RX:
+            if (len != 2U) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+            } else if (CAN_E2E_RemoveRx(payload[1]) != CAN_TESTBOX_OK) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_PARAM);
+            } else {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_OK);
+            }
+            break;
+
+        case CAN_E2E_CTRL_GET_RX: {
+            // 应答: 发送受保护帧数(u32)、未保护帧数(u32)、登记数(u8)，
+            // 随后每项: 编号、通道、扩展帧、保留(各u8)、ID(u32)、统计(7个u32)
+            uint8_t count = 0;
+            for (uint8_t i = 0; i < CAN_E2E_RX_MAX; i++) {
+                if (g_rx_entries[i].used) {
+                    count++;
+                }
+            }
+
+            CAN_Cmd_ResponseBegin(cmd, (uint16_t)(9U + count * (8U + sizeof(CAN_E2E_RxStats_t))));
+            CAN_Cmd_ResponseWrite(&g_tx_protected, sizeof(g_tx_protected));
+            CAN_Cmd_ResponseWrite(&g_tx_skipped, sizeof(g_tx_skipped));
+            CAN_Cmd_ResponseWrite(&count, 1);
+            for (uint8_t i = 0; i < CAN_E2E_RX_MAX && count > 0U; i++) {
+                const CAN_E2E_RxEntry_t *entry = &g_rx_entries[i];
+                CAN_E2E_RxStats_t stats;
+                if (!entry->used) {
+                    continue;
+                }
+                uint8_t head[4] = { i, entry->channel, entry->is_extended ? 1U : 0U, 0U };
+                CAN_E2E_GetRxStats(i, &stats);
+                CAN_Cmd_ResponseWrite(head, sizeof(head));
+                CAN_Cmd_ResponseWrite(&entry->id, sizeof(entry->id));
+                CAN_Cmd_ResponseWrite(&stats, sizeof(stats));
+                count--;
+            }
+            CAN_Cmd_ResponseEnd();
+            break;
+        }
+
+        case CAN_E2E_CTRL_CLEAR:
+            CAN_E2E_ResetRxStats();
+            CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_OK);
+            break;
+
+        default:
+            CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_PARAM);
+            break;
+    }
+}
@@ -0,0 +1,503 @@
+/**
+ * @file can_testbox_errstats.c
+ * @brief CAN错误帧与错误计数器分析、总线关闭恢复策略实现
+ * @version 1.0
+ * @date 2024
+ */
+
+#include "can_testbox_errstats.h"
+#include "can_testbox_cmd.h"
+#include "can_testbox_timestamp.h"
+#include "can_testbox_event.h"
+#include <string.h>
+
+/* ========================= 外部变量声明 ========================= */
+
+extern CAN_HandleTypeDef hcan1;
+extern CAN_HandleTypeDef hcan2;
+
+/* ========================= 私有宏定义 ========================= */
+
+// 错误分析需要的中断
+#define CAN_ERRSTATS_IT_MASK    (CAN_IT_ERROR_WARNING | CAN_IT_ERROR_PASSIVE | CAN_IT_BUSOFF | \
+                                 CAN_IT_LAST_ERROR_CODE | CAN_IT_ERROR)
+
+/* ========================= 私有类型定义 ========================= */
+
+/**
+ * @brief 通道上下文
+ */
+typedef struct {
+    CAN_HandleTypeDef *hcan;
+    CAN_ErrStats_RecoveryPolicy_t policy;
+    CAN_ErrStats_Stats_t stats;
+    uint32_t bus_off_enter_tick;    // 进入总线关闭的系统tick
+    uint32_t recovery_attempts;     // 本次总线关闭的连续恢复次数
+
+    // 时间序列(中断与任务均可写入，关中断保护)
+    CAN_ErrStats_Sample_t samples[CAN_ERRSTATS_SAMPLE_COUNT];
+    uint32_t sample_head;
+    uint32_t sample_tail;
+} CAN_ErrStats_Channel_t;
+
+/* ========================= 私有变量定义 ========================= */
+
+static CAN_ErrStats_Channel_t g_err_channels[CAN_ERRSTATS_CHANNEL_COUNT];
+static bool g_errstats_initialized = false;
+
+// HAL错误码到错误类型的映射(按ESR.LEC编码顺序)
+static const uint32_t g_lec_hal_codes[CAN_ERRSTATS_LEC_COUNT] = {
+    HAL_CAN_ERROR_NONE,
+    HAL_CAN_ERROR_STF,
+    HAL_CAN_ERROR_FOR,
+    HAL_CAN_ERROR_ACK,
+    HAL_CAN_ERROR_BR,
+    HAL_CAN_ERROR_BD,
+    HAL_CAN_ERROR_CRC
+};
+
+/* ========================= 私有函数声明 ========================= */
+
+static CAN_ErrStats_Channel_t *CAN_ErrStats_GetChannel(CAN_HandleTypeDef *hcan);
+static CAN_ErrStats_State_t CAN_ErrStats_DecodeState(uint32_t esr);
+static void CAN_ErrStats_PushSample(CAN_ErrStats_Channel_t *channel, uint32_t timestamp_us, uint8_t lec, uint8_t flags);
+static bool CAN_ErrStats_UpdateState(CAN_ErrStats_Channel_t *channel, uint32_t esr, uint32_t timestamp_us, uint8_t lec);
+static CAN_TestBox_Status_t CAN_ErrStats_Restart(CAN_ErrStats_Channel_t *channel);
+static void CAN_ErrStats_HandleGet(uint8_t cmd, const uint8_t *payload, uint8_t len);
+
+/* ========================= 公共API实现 ========================= */
+
+/**
+ * @brief 初始化错误分析模块
+ */
+CAN_TestBox_Status_t CAN_ErrStats_Init(void)
+{
+    memset(g_err_channels, 0, sizeof(g_err_channels));
+    g_err_channels[0].hcan = &hcan1;
+    g_err_channels[1].hcan = &hcan2;
+
+    for (uint8_t i = 0; i < CAN_ERRSTATS_CHANNEL_COUNT; i++) {
+        CAN_ErrStats_Channel_t *channel = &g_err_channels[i];
+
+        channel->policy.mode = (channel->hcan->Init.AutoBusOff == ENABLE) ? CAN_ERRSTATS_RECOVERY_HW_AUTO
+                                                                          : CAN_ERRSTATS_RECOVERY_MANUAL;
+        channel->stats.state = CAN_ErrStats_DecodeState(channel->hcan->Instance->ESR);
+
+        // 错误警告/被动/总线关闭/LEC均产生中断
+        HAL_CAN_ActivateNotification(channel->hcan, CAN_ERRSTATS_IT_MASK);
+    }
+
+    g_errstats_initialized = true;
+
+    if (CAN_Cmd_Register(CAN_CMD_ID_ERRSTATS_GET, CAN_ErrStats_HandleGet) != CAN_TESTBOX_OK) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 设置总线关闭恢复策略
+ */
+CAN_TestBox_Status_t CAN_ErrStats_SetRecoveryPolicy(CAN_HandleTypeDef *hcan, const CAN_ErrStats_RecoveryPolicy_t *policy)
+{
+    CAN_ErrStats_Channel_t *channel = CAN_ErrStats_GetChannel(hcan);
+
+    if (channel == NULL || policy == NULL || policy->mode > CAN_ERRSTATS_RECOVERY_SW_DELAYED) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    channel->policy = *policy;
+    channel->recovery_attempts = 0;
+
+    // ABOM位不受初始化模式写保护，运行中可直接切换
+    if (policy->mode == CAN_ERRSTATS_RECOVERY_HW_AUTO) {
+        SET_BIT(hcan->Instance->MCR, CAN_MCR_ABOM);
+        hcan->Init.AutoBusOff = ENABLE;
+    } else {
+        CLEAR_BIT(hcan->Instance->MCR, CAN_MCR_ABOM);
+        hcan->Init.AutoBusOff = DISABLE;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 立即从总线关闭恢复
+ */
+CAN_TestBox_Status_t CAN_ErrStats_RecoverBusOff(CAN_HandleTypeDef *hcan)
+{
+    CAN_ErrStats_Channel_t *channel = CAN_ErrStats_GetChannel(hcan);
+
+    if (channel == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    if ((hcan->Instance->ESR & CAN_ESR_BOFF) == 0) {
+        return CAN_TESTBOX_OK;
+    }
+
+    return CAN_ErrStats_Restart(channel);
+}
+
+/**
+ * @brief 获取通道错误统计
+ */
+CAN_TestBox_Status_t CAN_ErrStats_GetStats(CAN_HandleTypeDef *hcan, CAN_ErrStats_Stats_t *stats)
+{
+    CAN_ErrStats_Channel_t *channel = CAN_ErrStats_GetChannel(hcan);
+
+    if (channel == NULL || stats == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *stats = channel->stats;
+    __set_PRIMASK(primask);
+
+    // 正处于总线关闭时计入当前持续时间
+    if (stats->state == CAN_ERRSTATS_STATE_BUS_OFF) {
+        stats->bus_off_total_ms += HAL_GetTick() - channel->bus_off_enter_tick;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 读取时间序列采样
+ */
+uint32_t CAN_ErrStats_ReadSamples(CAN_HandleTypeDef *hcan, CAN_ErrStats_Sample_t *samples, uint32_t max_count)
+{
+    CAN_ErrStats_Channel_t *channel = CAN_ErrStats_GetChannel(hcan);
+    uint32_t count = 0;
+
+    if (channel == NULL || samples == NULL) {
+        return 0;
+    }
+
+    while (count < max_count) {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+
+        if (channel->sample_tail == channel->sample_head) {
+            __set_PRIMASK(primask);
+            break;
+        }
+
+        samples[count++] = channel->samples[channel->sample_tail & (CAN_ERRSTATS_SAMPLE_COUNT - 1U)];
+        channel->sample_tail++;
+
+        __set_PRIMASK(primask);
+    }
+
+    return count;
+}
+
+/**
+ * @brief 重置通道统计与时间序列
+ */
+CAN_TestBox_Status_t CAN_ErrStats_Reset(CAN_HandleTypeDef *hcan)
+{
+    CAN_ErrStats_Channel_t *channel = CAN_ErrStats_GetChannel(hcan);
+
+    if (channel == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset(&channel->stats, 0, sizeof(channel->stats));
+    channel->stats.state = CAN_ErrStats_DecodeState(hcan->Instance->ESR);
+    channel->bus_off_enter_tick = HAL_GetTick();
+    channel->sample_head = 0;
+    channel->sample_tail = 0;
+    __set_PRIMASK(primask);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 错误分析任务处理
+ */
+void CAN_ErrStats_Process(void)
+{
+    if (!g_errstats_initialized) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < CAN_ERRSTATS_CHANNEL_COUNT; i++) {
+        CAN_ErrStats_Channel_t *channel = &g_err_channels[i];
+        CAN_HandleTypeDef *hcan = channel->hcan;
+
+        if (hcan->State != HAL_CAN_STATE_LISTENING) {
+            continue;
+        }
+
+        // 错误状态回落不产生中断，轮询ESR捕获
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        CAN_ErrStats_UpdateState(channel, hcan->Instance->ESR, CAN_Timestamp_GetUs(), CAN_ERRSTATS_LEC_NONE);
+        __set_PRIMASK(primask);
+
+        if (channel->stats.state == CAN_ERRSTATS_STATE_ACTIVE) {
+            channel->recovery_attempts = 0;
+        }
+
+        // 延时软件恢复
+        if (channel->policy.mode == CAN_ERRSTATS_RECOVERY_SW_DELAYED &&
+            channel->stats.state == CAN_ERRSTATS_STATE_BUS_OFF &&
+            (HAL_GetTick() - channel->bus_off_enter_tick) >= channel->policy.delay_ms &&
+            (channel->policy.max_attempts == 0 || channel->recovery_attempts < channel->policy.max_attempts)) {
+            channel->recovery_attempts++;
+            // 下一次尝试重新计时
+            channel->stats.bus_off_total_ms += HAL_GetTick() - channel->bus_off_enter_tick;
+            channel->bus_off_enter_tick = HAL_GetTick();
+            CAN_ErrStats_Restart(channel);
+        }
+    }
+}
+
+/**
+ * @brief 计算距下一次错误状态轮询的时间
+ * @note  错误状态升级均有中断，只有回落需要轮询；主动错误状态下无需唤醒
+ */
+uint32_t CAN_ErrStats_GetIdleTime(uint32_t max_ms)
+{
+    if (!g_errstats_initialized) {
+        return max_ms;
+    }
+
+    for (uint8_t i = 0; i < CAN_ERRSTATS_CHANNEL_COUNT; i++) {
+        const CAN_ErrStats_Channel_t *channel = &g_err_channels[i];
+
+        if (channel->hcan->State == HAL_CAN_STATE_LISTENING &&
+            channel->stats.state != CAN_ERRSTATS_STATE_ACTIVE) {
+            return (max_ms < CAN_ERRSTATS_POLL_MS) ? max_ms : CAN_ERRSTATS_POLL_MS;
+        }
+    }
+
+    return max_ms;
+}
+
+/* ========================= 中断处理函数 ========================= */
+
+/**
+ * @brief 错误中断采样
+ */
+void CAN_ErrStats_ProcessError(CAN_HandleTypeDef *hcan, uint32_t timestamp_us)
+{
+    CAN_ErrStats_Channel_t *channel = CAN_ErrStats_GetChannel(hcan);
+
+    if (channel == NULL) {
+        return;
+    }
+
+    uint32_t error = HAL_CAN_GetError(hcan);
+    uint8_t lec = CAN_ERRSTATS_LEC_NONE;
+
+    channel->stats.error_irq_count++;
+
+    // 同一次中断可能累积多个错误类型，全部计数，采样记录编码最小的一个
+    for (uint8_t i = CAN_ERRSTATS_LEC_STUFF; i < CAN_ERRSTATS_LEC_COUNT; i++) {
+        if (error & g_lec_hal_codes[i]) {
+            channel->stats.lec_count[i]++;
+            if (lec == CAN_ERRSTATS_LEC_NONE) {
+                lec = i;
+            }
+        }
+    }
+
+    if (!CAN_ErrStats_UpdateState(channel, hcan->Instance->ESR, timestamp_us, lec) && lec != CAN_ERRSTATS_LEC_NONE) {
+        CAN_ErrStats_PushSample(channel, timestamp_us, lec, 0);
+    }
+
+    HAL_CAN_ResetError(hcan);
+}
+
+/* ========================= 私有函数实现 ========================= */
+
+/**
+ * @brief CAN句柄映射到通道
+ */
+static CAN_ErrStats_Channel_t *CAN_ErrStats_GetChannel(CAN_HandleTypeDef *hcan)
+{
+    if (hcan == NULL) {
+        return NULL;
+    }
+
+    if (hcan->Instance == CAN1) {
+        return &g_err_channels[0];
+    }
+
+    if (hcan->Instance == CAN2) {
+        return &g_err_channels[1];
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief 由ESR解析错误状态
+ */
+static CAN_ErrStats_State_t CAN_ErrStats_DecodeState(uint32_t esr)
+{
+    if (esr & CAN_ESR_BOFF) {
+        return CAN_ERRSTATS_STATE_BUS_OFF;
+    }
+    if (esr & CAN_ESR_EPVF) {
+        return CAN_ERRSTATS_STATE_PASSIVE;
+    }
+    if (esr & CAN_ESR_EWGF) {
+        return CAN_ERRSTATS_STATE_WARNING;
+    }
+
+    return CAN_ERRSTATS_STATE_ACTIVE;
+}
+
+/**
+ * @brief 写入时间序列(满时覆盖最旧采样)
+ * @note  调用方需保证在中断中或已关中断
+ */
+static void CAN_ErrStats_PushSample(CAN_ErrStats_Channel_t *channel, uint32_t timestamp_us, uint8_t lec, uint8_t flags)
+{
+    if (channel->sample_head - channel->sample_tail >= CAN_ERRSTATS_SAMPLE_COUNT) {
+        channel->sample_tail++;
+        channel->stats.sample_overwrite_count++;
+    }
+
+    CAN_ErrStats_Sample_t *sample = &channel->samples[channel->sample_head & (CAN_ERRSTATS_SAMPLE_COUNT - 1U)];
+    sample->timestamp_us = timestamp_us;
+    sample->tec = channel->stats.tec;
+    sample->rec = channel->stats.rec;
+    sample->lec = lec;
+    sample->state = channel->stats.state;
+    sample->flags = flags;
+    channel->sample_head++;
+}
+
+/**
+ * @brief 更新错误计数与状态
+ * @return bool: true-发生状态转换(已写入转换采样)
+ * @note  调用方需保证在中断中或已关中断
+ */
+static bool CAN_ErrStats_UpdateState(CAN_ErrStats_Channel_t *channel, uint32_t esr, uint32_t timestamp_us, uint8_t lec)
+{
+    CAN_ErrStats_Stats_t *stats = &channel->stats;
+    CAN_ErrStats_State_t state = CAN_ErrStats_DecodeState(esr);
+
+    stats->tec = (uint8_t)((esr & CAN_ESR_TEC) >> CAN_ESR_TEC_Pos);
+    stats->rec = (uint8_t)((esr & CAN_ESR_REC) >> CAN_ESR_REC_Pos);
+    if (stats->tec > stats->max_tec) {
+        stats->max_tec = stats->tec;
+    }
+    if (stats->rec > stats->max_rec) {
+        stats->max_rec = stats->rec;
+    }
+
+    if (state == stats->state) {
+        return false;
+    }
+
+    uint32_t now = HAL_GetTick();
+
+    if (stats->state == CAN_ERRSTATS_STATE_BUS_OFF) {
+        stats->bus_off_total_ms += now - channel->bus_off_enter_tick;
+    }
+    if (state == CAN_ERRSTATS_STATE_BUS_OFF) {
+        channel->bus_off_enter_tick = now;
+    }
+
+    stats->state = state;
+    stats->state_enter_count[state]++;
+    stats->state_enter_us[state] = timestamp_us;
+
+    CAN_ErrStats_PushSample(channel, timestamp_us, lec, CAN_ERRSTATS_SAMPLE_FLAG_TRANSITION);
+
+    // 离开主动错误状态后任务需开始轮询回落
+    CAN_Event_Notify(CAN_EVENT_SCHEDULE);
+
+    return true;
+}
+
+/**
+ * @brief 重启控制器退出总线关闭
+ * @note  进入初始化模式再退出后，控制器检测到128次11个连续隐性位即恢复
+ */
+static CAN_TestBox_Status_t CAN_ErrStats_Restart(CAN_ErrStats_Channel_t *channel)
+{
+    CAN_HandleTypeDef *hcan = channel->hcan;
+    CAN_TestBox_Status_t status = CAN_TESTBOX_OK;
+
+    if (HAL_CAN_Stop(hcan) != HAL_OK || HAL_CAN_Start(hcan) != HAL_OK) {
+        status = CAN_TESTBOX_ERROR;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (status == CAN_TESTBOX_OK) {
+        channel->stats.recovery_count++;
+    } else {
+        channel->stats.recovery_fail_count++;
+    }
+    CAN_ErrStats_PushSample(channel, CAN_Timestamp_GetUs(), CAN_ERRSTATS_LEC_NONE, CAN_ERRSTATS_SAMPLE_FLAG_RECOVERY);
+    __set_PRIMASK(primask);
+
+    return status;
+}
+
+/**
+ * @brief 串口命令: 读取错误统计与时间序列
+ * @note  请求负载: 通道(u8, 0-CAN1, 1-CAN2)
+ *        应答(小端): 状态(u8) TEC(u8) REC(u8) TEC峰值(u8) REC峰值(u8)
+ *        错误中断数(u32) 错误类型计数[6](u32) 进入警告/被动/总线关闭次数[3](u32)
+ *        累计总线关闭时长ms(u32) 恢复次数(u32) 恢复失败次数(u32) 覆盖采样数(u32)
+ *        采样数(u8) 采样[n](时间戳u32 TEC u8 REC u8 LEC u8 状态|标志<<4 u8)
+ */
+static void CAN_ErrStats_HandleGet(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    if (len < 1 || payload[0] >= CAN_ERRSTATS_CHANNEL_COUNT) {
+        CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_PARAM);
+        return;
+    }
+
+    CAN_HandleTypeDef *hcan = g_err_channels[payload[0]].hcan;
+    CAN_ErrStats_Stats_t stats;
+    CAN_ErrStats_Sample_t samples[CAN_ERRSTATS_DUMP_MAX_SAMPLES];
+    uint8_t header[5 + 4 * 14 + 1];
+    uint8_t *p = header;
+
+    CAN_ErrStats_GetStats(hcan, &stats);
+    uint8_t count = (uint8_t)CAN_ErrStats_ReadSamples(hcan, samples, CAN_ERRSTATS_DUMP_MAX_SAMPLES);
+
+    *p++ = (uint8_t)stats.state;
+    *p++ = stats.tec;
+    *p++ = stats.rec;
+    *p++ = stats.max_tec;
+    *p++ = stats.max_rec;
+    memcpy(p, &stats.error_irq_count, 4); p += 4;
+    for (uint8_t i = CAN_ERRSTATS_LEC_STUFF; i < CAN_ERRSTATS_LEC_COUNT; i++) {
+        memcpy(p, &stats.lec_count[i], 4); p += 4;
+    }
+    for (uint8_t i = CAN_ERRSTATS_STATE_WARNING; i < CAN_ERRSTATS_STATE_COUNT; i++) {
+        memcpy(p, &stats.state_enter_count[i], 4); p += 4;
+    }
+    memcpy(p, &stats.bus_off_total_ms, 4); p += 4;
+    memcpy(p, &stats.recovery_count, 4); p += 4;
+    memcpy(p, &stats.recovery_fail_count, 4); p += 4;
+    memcpy(p, &stats.sample_overwrite_count, 4); p += 4;
+    *p++ = count;
+
+    CAN_Cmd_ResponseBegin(cmd, (uint16_t)(sizeof(header) + count * 8U));
+    CAN_Cmd_ResponseWrite(header, sizeof(header));
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t record[8];
+        memcpy(&record[0], &samples[i].timestamp_us, 4);
+        record[4] = samples[i].tec;
+        record[5] = samples[i].rec;
+        record[6] = samples[i].lec;
+        record[7] = (uint8_t)(samples[i].state | (samples[i].flags << 4));
+        CAN_Cmd_ResponseWrite(record, sizeof(record));
+    }
+    CAN_Cmd_ResponseEnd();
+}
@@ -0,0 +1,135 @@
+/**
+ * @file can_testbox_event.c
+ * @brief CAN测试盒任务事件通知实现
+ * @version 1.0
+ * @date 2024
+ */
+
+#include "can_testbox_event.h"
+#include "can_testbox_cmd.h"
+#include <string.h>
+
+/* ========================= 私有变量定义 ========================= */
+
+// 接收通知的任务(创建任务后设置，之前的通知直接丢弃)
+static osThreadId_t g_event_task = NULL;
+
+// 唤醒统计(仅在测试盒任务中访问)
+static CAN_Event_Stats_t g_event_stats;
+
+/* ========================= 私有函数声明 ========================= */
+
+static void CAN_Event_HandleStats(uint8_t cmd, const uint8_t *payload, uint8_t len);
+
+/* ========================= 公共API实现 ========================= */
+
+/**
+ * @brief 初始化事件通知
+ */
+CAN_TestBox_Status_t CAN_Event_Init(osThreadId_t task)
+{
+    if (task == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    memset(&g_event_stats, 0, sizeof(g_event_stats));
+    g_event_task = task;
+
+    if (CAN_Cmd_Register(CAN_CMD_ID_EVENT_STATS, CAN_Event_HandleStats) != CAN_TESTBOX_OK) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 通知测试盒任务
+ * @note  osThreadFlagsSet在中断中自动使用FromISR版本并请求切换，
+ *        事件位在任务处理前持续有效，多次通知合并为一次唤醒
+ */
+void CAN_Event_Notify(uint32_t events)
+{
+    osThreadId_t task = g_event_task;
+
+    if (task != NULL) {
+        osThreadFlagsSet(task, events & CAN_EVENT_ALL);
+    }
+}
+
+/**
+ * @brief 等待事件或超时
+ */
+uint32_t CAN_Event_Wait(uint32_t timeout_ms)
+{
+    uint32_t ticks = (timeout_ms * osKernelGetTickFreq() + 999U) / 1000U;
+    uint32_t events = osThreadFlagsWait(CAN_EVENT_ALL, osFlagsWaitAny, ticks);
+
+    g_event_stats.wakeups++;
+
+    // 超时或无事件时返回错误码(最高位置位)
+    if ((events & osFlagsError) != 0U) {
+        g_event_stats.timeouts++;
+        return 0;
+    }
+
+    if (events & CAN_EVENT_SCHEDULE) {
+        g_event_stats.schedule_count++;
+    }
+    if (events & CAN_EVENT_TX_DONE) {
+        g_event_stats.tx_done_count++;
+    }
+    if (events & CAN_EVENT_CMD) {
+        g_event_stats.cmd_count++;
+    }
+    if (events & CAN_EVENT_RX) {
+        g_event_stats.rx_count++;
+    }
+
+    return events;
+}
+
+/**
+ * @brief 获取任务唤醒统计
+ */
+CAN_TestBox_Status_t CAN_Event_GetStats(CAN_Event_Stats_t *stats)
+{
+    if (stats == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    *stats = g_event_stats;
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 清空任务唤醒统计
+ */
+void CAN_Event_ResetStats(void)
+{
+    memset(&g_event_stats, 0, sizeof(g_event_stats));
+}
+
+/* ========================= 私有函数实现 ========================= */
+
+/**
+ * @brief 命令0x15: 读取任务唤醒统计
+ * @note  请求: 选项(u8, bit0读取后清空)，可省略
+ *        应答: CAN_Event_Stats_t各字段依次为u32小端
+ */
+static void CAN_Event_HandleStats(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    CAN_Event_Stats_t stats;
+
+    if (len > 1U) {
+        CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+        return;
+    }
+
+    CAN_Event_GetStats(&stats);
+    CAN_Cmd_SendResponse(cmd, (const uint8_t *)&stats, sizeof(stats));
+
+    if (len == 1U && (payload[0] & 0x01U) != 0U) {
+        CAN_Event_ResetStats();
+    }
+}
@@ -0,0 +1,317 @@
+/**
+ * @file can_testbox_format.c
+ * @brief CAN报文日志快速格式化实现
+ * @version 1.0
+ * @date 2024
+ */
+
+#include "can_testbox_format.h"
+#include "can_testbox_timestamp.h"
+#include "can_testbox_cmd.h"
+#include "usart.h"
+#include <string.h>
+#include <stdio.h>
+
+/* ========================= 私有常量定义 ========================= */
+
+// 字节 -> 两位大写十六进制字符 (256 * 2字节)
+static const char g_hex_pairs[512] =
+    "000102030405060708090A0B0C0D0E0F"
+    "101112131415161718191A1B1C1D1E1F"
+    "202122232425262728292A2B2C2D2E2F"
+    "303132333435363738393A3B3C3D3E3F"
+    "404142434445464748494A4B4C4D4E4F"
+    "505152535455565758595A5B5C5D5E5F"
+    "606162636465666768696A6B6C6D6E6F"
+    "707172737475767778797A7B7C7D7E7F"
+    "808182838485868788898A8B8C8D8E8F"
+    "909192939495969798999A9B9C9D9E9F"
+    "A0A1A2A3A4A5A6A7A8A9AAABACADAEAF"
+    "B0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+    "C0C1C2C3C4C5C6C7C8C9CACBCCCDCECF"
+    "D0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+    "E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEF"
+    "F0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+
+// 0~99 -> 两位十进制字符 (100 * 2字节)
+static const char g_dec_pairs[200] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const char g_hex_digits[16] = {
+    '0', '1', '2', '3', '4', '5', '6', '7',
+    '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'
+};
+
+/* ========================= 私有函数声明 ========================= */
+
+static char *CAN_Format_Dec2(char *p, uint32_t value);
+static uint32_t CAN_Format_RenderPrintf(char *buffer, size_t size, const char *tag, uint32_t id,
+                                        const uint8_t *data, uint8_t dlc, bool is_remote);
+static void CAN_Format_HandleBench(uint8_t cmd, const uint8_t *payload, uint8_t len);
+
+/* ========================= 公共API实现 ========================= */
+
+/**
+ * @brief 初始化格式化模块
+ */
+CAN_TestBox_Status_t CAN_Format_Init(void)
+{
+    CAN_Timestamp_CycleCounterInit();
+
+    if (CAN_Cmd_Register(CAN_CMD_ID_FORMAT_BENCH, CAN_Format_HandleBench) != CAN_TESTBOX_OK) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 追加字符串
+ */
+char *CAN_Format_Str(char *p, const char *str, uint32_t max_len)
+{
+    while (max_len-- > 0U && *str != '\0') {
+        *p++ = *str++;
+    }
+    return p;
+}
+
+/**
+ * @brief 追加十进制无符号数
+ */
+char *CAN_Format_Dec(char *p, uint32_t value)
+{
+    char tmp[10];
+    uint32_t n = 0;
+
+    do {
+        tmp[n++] = (char)('0' + (value % 10U));
+        value /= 10U;
+    } while (value != 0U);
+
+    while (n > 0U) {
+        *p++ = tmp[--n];
+    }
+    return p;
+}
+
+/**
+ * @brief 追加大写十六进制数
+ */
+char *CAN_Format_Hex(char *p, uint32_t value, uint8_t min_digits)
+{
+    // 有效位数由前导零个数直接得到，无需逐位试除
+    uint32_t digits = (32U - __CLZ(value | 1U) + 3U) >> 2;
+    if (digits < min_digits) {
+        digits = (min_digits > 8U) ? 8U : min_digits;
+    }
+
+    for (uint32_t shift = digits * 4U; shift > 0U; shift -= 4U) {
+        *p++ = g_hex_digits[(value >> (shift - 4U)) & 0x0FU];
+    }
+    return p;
+}
+
+/**
+ * @brief 追加时间戳HH:MM:SS.mmm
+ */
+char *CAN_Format_Timestamp(char *p, uint32_t timestamp_ms)
+{
+    uint32_t seconds = timestamp_ms / 1000U;
+    uint32_t milliseconds = timestamp_ms % 1000U;
+    uint32_t minutes = seconds / 60U;
+    seconds = seconds % 60U;
+    uint32_t hours = minutes / 60U;
+    minutes = minutes % 60U;
+
+    p = CAN_Format_Dec2(p, hours);
+    *p++ = ':';
+    p = CAN_Format_Dec2(p, minutes);
+    *p++ = ':';
+    p = CAN_Format_Dec2(p, seconds);
+    *p++ = '.';
+    *p++ = (char)('0' + milliseconds / 100U);
+    memcpy(p, &g_dec_pairs[(milliseconds % 100U) * 2U], 2);
+    return p + 2;
+}
+
+/**
+ * @brief 追加报文主体
+ */
+char *CAN_Format_FrameBody(char *p, uint32_t id, uint8_t id_digits,
+                           const uint8_t *data, uint8_t dlc, bool is_remote)
+{
+    memcpy(p, " ID:0x", 6);
+    p = CAN_Format_Hex(p + 6, id, id_digits);
+    memcpy(p, ", Data:", 7);
+    p += 7;
+
+    if (is_remote) {
+        memcpy(p, "RTR", 3);
+        p += 3;
+    } else if (dlc > 0U) {
+        if (dlc > 8U) {
+            dlc = 8U;
+        }
+        // 每字节固定写出"XX "，最后回退一个空格
+        for (uint8_t i = 0; i < dlc; i++) {
+            memcpy(p, &g_hex_pairs[data[i] * 2U], 2);
+            p[2] = ' ';
+            p += 3;
+        }
+        p--;
+    }
+
+    memcpy(p, " [END]\r\n", 8);
+    return p + 8;
+}
+
+/**
+ * @brief 格式化完整报文日志行
+ */
+uint32_t CAN_Format_Frame(char *buffer, const char *tag, uint32_t id,
+                          const uint8_t *data, uint8_t dlc, bool is_remote)
+{
+    char *p = CAN_Format_Str(buffer, tag, CAN_FORMAT_TAG_MAX);
+    p = CAN_Format_FrameBody(p, id, CAN_FORMAT_STD_ID_DIGITS, data, dlc, is_remote);
+    *p = '\0';
+    return (uint32_t)(p - buffer);
+}
+
+/**
+ * @brief 格式化并输出一行报文日志
+ */
+void CAN_Format_PrintFrame(const char *tag, uint32_t id,
+                           const uint8_t *data, uint8_t dlc, bool is_remote)
+{
+    char line[CAN_FORMAT_LINE_MAX];
+    uint32_t len = CAN_Format_Frame(line, tag, id, data, dlc, is_remote);
+
+    CAN_Format_Output(line, len);
+}
+
+/**
+ * @brief 输出已格式化的日志行
+ */
+void CAN_Format_Output(const char *buffer, uint32_t len)
+{
+    HAL_UART_Transmit(&huart2, (uint8_t *)buffer, (uint16_t)len, HAL_MAX_DELAY);
+}
+
+/**
+ * @brief 运行格式化基准测试
+ */
+CAN_TestBox_Status_t CAN_Format_Benchmark(CAN_Format_Bench_t *result)
+{
+    static const uint8_t data[8] = {0x00, 0x5A, 0xA5, 0xFF, 0x12, 0x34, 0xC3, 0x7E};
+    static const uint16_t ids[4] = {0x05B, 0x401, 0x7FF, 0x036};
+    char line_printf[CAN_FORMAT_LINE_MAX];
+    char line_format[CAN_FORMAT_LINE_MAX];
+    uint32_t printf_total = 0;
+    uint32_t format_total = 0;
+
+    if (result == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    CAN_Timestamp_CycleCounterInit();
+    result->identical = true;
+    result->frames = 0;
+
+    // DLC 0~8为数据帧，第10种为远程帧
+    for (uint8_t c = 0; c <= 9U; c++) {
+        uint8_t dlc = (c <= 8U) ? c : 0U;
+        bool is_remote = (c == 9U);
+        uint32_t id = ids[c & 3U];
+        uint32_t len_printf = 0;
+        uint32_t len_format = 0;
+
+        for (uint32_t i = 0; i < CAN_FORMAT_BENCH_ITERATIONS; i++) {
+            uint32_t t0 = CAN_Timestamp_GetCycles();
+            len_printf = CAN_Format_RenderPrintf(line_printf, sizeof(line_printf), "[TX]",
+                                                 id, data, dlc, is_remote);
+            uint32_t t1 = CAN_Timestamp_GetCycles();
+            len_format = CAN_Format_Frame(line_format, "[TX]", id, data, dlc, is_remote);
+            uint32_t t2 = CAN_Timestamp_GetCycles();
+
+            printf_total += t1 - t0;
+            format_total += t2 - t1;
+        }
+
+        if (len_printf != len_format || memcmp(line_printf, line_format, len_format) != 0) {
+            result->identical = false;
+        }
+        result->frames += CAN_FORMAT_BENCH_ITERATIONS;
+    }
+
+    result->printf_cycles = printf_total / result->frames;
+    result->format_cycles = format_total / result->frames;
+
+    return CAN_TESTBOX_OK;
+}
+
+/* ========================= 私有函数实现 ========================= */
+
+/**
+ * @brief 追加至少两位的十进制数(等价于"%02lu")
+ */
+static char *CAN_Format_Dec2(char *p, uint32_t value)
+{
+    if (value < 100U) {
+        memcpy(p, &g_dec_pairs[value * 2U], 2);
+        return p + 2;
+    }
+    return CAN_Format_Dec(p, value);
+}
+
+/**
+ * @brief 按原日志代码的printf调用序列渲染到缓冲区(基准测试对照组)
+ */
+static uint32_t CAN_Format_RenderPrintf(char *buffer, size_t size, const char *tag, uint32_t id,
+                                        const uint8_t *data, uint8_t dlc, bool is_remote)
+{
+    int n = snprintf(buffer, size, "%s ID:0x%03X, Data:", tag, (unsigned int)id);
+
+    if (!is_remote) {
+        for (int i = 0; i < dlc; i++) {
+            n += snprintf(buffer + n, size - n, "%02X", data[i]);
+            if (i < dlc - 1) n += snprintf(buffer + n, size - n, " ");
+        }
+    } else {
+        n += snprintf(buffer + n, size - n, "RTR");
+    }
+
+    n += snprintf(buffer + n, size - n, " [END]\r\n");
+    return (uint32_t)n;
+}
+
+/**
+ * @brief 命令0x13: 运行格式化基准测试
+ * @note  应答: 原方式周期/帧(u32) 查表方式周期/帧(u32) 测量帧数(u32) 输出一致(u8)
+ */
+static void CAN_Format_HandleBench(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    (void)payload;
+    (void)len;
+
+    CAN_Format_Bench_t bench;
+    uint8_t resp[13];
+
+    CAN_Format_Benchmark(&bench);
+
+    memcpy(&resp[0], &bench.printf_cycles, 4);
+    memcpy(&resp[4], &bench.format_cycles, 4);
+    memcpy(&resp[8], &bench.frames, 4);
+    resp[12] = bench.identical ? 1U : 0U;
+
+    CAN_Cmd_SendResponse(cmd, resp, sizeof(resp));
+}
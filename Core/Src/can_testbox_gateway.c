@@ -0,0 +1,786 @@
+/**
+ * @file can_testbox_gateway.c
+ * @brief CAN1 <-> CAN2 网关转发模块实现
+ * @version 1.0
+ * @date 2024
+ *
+ * @note 转发路径说明：
+ * 1. 接收中断中匹配路由表(首个匹配生效)
+ * 2. 重映射ID并变换数据
+ * 3. 目标通道有空闲邮箱且软件队列为空时直接装入邮箱，否则进入软件队列
+ *    (不经发送仲裁，可用邮箱由CAN_TxArb_ExternalFreeLevel()给出)
+ * 4. 软件队列在目标通道发送完成/中止/错误回调中继续装入邮箱
+ * 转发时延 = 装入邮箱时刻 - 进入接收中断时刻，均取自TIM2硬件时间戳
+ */
+
+#include "can_testbox_gateway.h"
+#include "can_testbox_timestamp.h"
+#include "can_testbox_monitor.h"
+#include "can_testbox_txarb.h"
+#include "can_testbox_cmd.h"
+#include "can.h"
+#include <string.h>
+#include <stdio.h>
+
+/* ========================= 私有宏定义 ========================= */
+
+#define CAN_GATEWAY_CAN2_IT     (CAN_IT_RX_FIFO0_MSG_PENDING | CAN_IT_TX_MAILBOX_EMPTY | CAN_IT_ERROR)
+#define CAN_GATEWAY_ROUTE_LEN   22U     // 添加路由命令负载长度(不含掩码变换)
+#define CAN_GATEWAY_XFORM_LEN   16U     // 掩码变换附加长度(与掩码+异或掩码)
+
+/* ========================= 私有类型定义 ========================= */
+
+/**
+ * @brief 软件发送队列条目
+ */
+typedef struct {
+    CAN_TxHeaderTypeDef header;     // 发送头
+    uint8_t  data[8];               // 数据
+    uint8_t  route_index;           // 所属路由
+    uint32_t rx_timestamp_us;       // 接收时间戳(us)
+} CAN_Gateway_TxEntry_t;
+
+/**
+ * @brief 软件发送队列(环形缓冲区)
+ */
+typedef struct {
+    CAN_Gateway_TxEntry_t entries[CAN_GATEWAY_TX_QUEUE_SIZE];
+    uint16_t head;                  // 读位置
+    uint16_t tail;                  // 写位置
+    uint16_t count;                 // 当前条目数
+} CAN_Gateway_TxQueue_t;
+
+/* ========================= 私有变量定义 ========================= */
+
+// 运行标志
+static volatile bool g_gateway_active = false;
+
+// 网关启动前CAN2的运行状态与已开启的中断，停止时恢复
+static bool g_can2_was_started = false;
+static uint32_t g_can2_prev_it = 0;
+
+// 路由表
+static CAN_Gateway_Route_t g_routes[CAN_GATEWAY_MAX_ROUTES];
+static bool g_route_used[CAN_GATEWAY_MAX_ROUTES];
+
+// 路由统计
+static CAN_Gateway_RouteStats_t g_route_stats[CAN_GATEWAY_MAX_ROUTES];
+
+// 每个目标通道的软件发送队列
+static CAN_Gateway_TxQueue_t g_tx_queues[CAN_GATEWAY_PORT_COUNT];
+
+// 端口对应的CAN句柄
+static CAN_HandleTypeDef * const g_port_hcan[CAN_GATEWAY_PORT_COUNT] = {
+    &hcan1,
+    &hcan2
+};
+
+/* ========================= 私有函数声明 ========================= */
+
+static void CAN_Gateway_ResetRouteStats(uint8_t index);
+static void CAN_Gateway_ApplyFilters(bool enable);
+static void CAN_Gateway_ConfigFilterBank(CAN_HandleTypeDef *hcan, uint32_t bank,
+                                         const CAN_Gateway_Route_t *route, bool enable);
+static void CAN_Gateway_Forward(uint8_t route_index, const CAN_RxHeaderTypeDef *rx_header,
+                                const uint8_t *rx_data, uint32_t rx_timestamp_us);
+static void CAN_Gateway_Enqueue(CAN_Gateway_Port_t port, const CAN_Gateway_TxEntry_t *entry);
+static void CAN_Gateway_Drain(CAN_Gateway_Port_t port);
+static void CAN_Gateway_RecordLatency(uint8_t route_index, uint32_t rx_timestamp_us);
+static uint32_t CAN_Gateway_ReadU32(const uint8_t *p);
+static void CAN_Gateway_HandleCtrl(uint8_t cmd, const uint8_t *payload, uint8_t len);
+
+/* ========================= 公共API实现 ========================= */
+
+/**
+ * @brief 初始化网关模块
+ */
+CAN_TestBox_Status_t CAN_Gateway_Init(void)
+{
+    if (g_gateway_active) {
+        return CAN_TESTBOX_BUSY;
+    }
+
+    memset(g_routes, 0, sizeof(g_routes));
+    memset(g_route_used, 0, sizeof(g_route_used));
+    memset(g_tx_queues, 0, sizeof(g_tx_queues));
+
+    for (uint8_t i = 0; i < CAN_GATEWAY_MAX_ROUTES; i++) {
+        CAN_Gateway_ResetRouteStats(i);
+    }
+
+    if (CAN_Cmd_Register(CAN_CMD_ID_GATEWAY_CTRL, CAN_Gateway_HandleCtrl) != CAN_TESTBOX_OK) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 添加路由
+ */
+CAN_TestBox_Status_t CAN_Gateway_AddRoute(const CAN_Gateway_Route_t *route, uint8_t *route_index)
+{
+    if (route == NULL || route_index == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    if (route->src_port >= CAN_GATEWAY_PORT_COUNT || route->dst_port >= CAN_GATEWAY_PORT_COUNT ||
+        route->src_port == route->dst_port) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    if (route->transform == CAN_GATEWAY_XFORM_CALLBACK && route->transform_fn == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    // 每个源通道的硬件过滤器数量有限
+    uint8_t same_src = 0;
+    for (uint8_t i = 0; i < CAN_GATEWAY_MAX_ROUTES; i++) {
+        if (g_route_used[i] && g_routes[i].src_port == route->src_port) {
+            same_src++;
+        }
+    }
+    if (same_src >= CAN_GATEWAY_FILTERS_PER_PORT) {
+        return CAN_TESTBOX_QUEUE_FULL;
+    }
+
+    // 查找空闲槽位
+    uint8_t index;
+    for (index = 0; index < CAN_GATEWAY_MAX_ROUTES; index++) {
+        if (!g_route_used[index]) {
+            break;
+        }
+    }
+
+    if (index >= CAN_GATEWAY_MAX_ROUTES) {
+        return CAN_TESTBOX_QUEUE_FULL;
+    }
+
+    // 先写入路由内容，再置位使用标志，保证中断中看到的是完整条目
+    g_routes[index] = *route;
+    CAN_Gateway_ResetRouteStats(index);
+    g_route_used[index] = true;
+
+    if (g_gateway_active) {
+        CAN_Gateway_ApplyFilters(true);
+    }
+
+    *route_index = index;
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 移除路由
+ */
+CAN_TestBox_Status_t CAN_Gateway_RemoveRoute(uint8_t route_index)
+{
+    if (route_index >= CAN_GATEWAY_MAX_ROUTES) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    if (!g_route_used[route_index]) {
+        return CAN_TESTBOX_NOT_FOUND;
+    }
+
+    g_route_used[route_index] = false;
+
+    if (g_gateway_active) {
+        CAN_Gateway_ApplyFilters(true);
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 清空所有路由
+ */
+CAN_TestBox_Status_t CAN_Gateway_ClearRoutes(void)
+{
+    memset(g_route_used, 0, sizeof(g_route_used));
+
+    if (g_gateway_active) {
+        CAN_Gateway_ApplyFilters(true);
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 启动网关
+ */
+CAN_TestBox_Status_t CAN_Gateway_Start(void)
+{
+    if (g_gateway_active) {
+        return CAN_TESTBOX_OK;
+    }
+
+    // CAN2静默监听中不能切换为正常模式
+    if (CAN_Monitor_IsActive(CAN_MONITOR_CH_CAN2)) {
+        return CAN_TESTBOX_BUSY;
+    }
+
+    // CAN2默认为静默模式，网关需要切换到正常模式才能发送；
+    // 记录测试盒CAN2通道等已开启的状态，停止网关时恢复
+    g_can2_was_started = (hcan2.State == HAL_CAN_STATE_LISTENING);
+    g_can2_prev_it = hcan2.Instance->IER & CAN_GATEWAY_CAN2_IT;
+    if (g_can2_was_started) {
+        HAL_CAN_Stop(&hcan2);
+    }
+
+    hcan2.Init.Mode = CAN_MODE_NORMAL;
+    if (HAL_CAN_Init(&hcan2) != HAL_OK) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    memset(g_tx_queues, 0, sizeof(g_tx_queues));
+    CAN_Gateway_ApplyFilters(true);
+
+    if (HAL_CAN_Start(&hcan2) != HAL_OK) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    if (HAL_CAN_ActivateNotification(&hcan2, CAN_GATEWAY_CAN2_IT) != HAL_OK) {
+        HAL_CAN_Stop(&hcan2);
+        return CAN_TESTBOX_ERROR;
+    }
+
+    // CAN1发送完成中断用于继续发送CAN2->CAN1方向排队的报文
+    if (HAL_CAN_ActivateNotification(&hcan1, CAN_IT_TX_MAILBOX_EMPTY) != HAL_OK) {
+        HAL_CAN_Stop(&hcan2);
+        return CAN_TESTBOX_ERROR;
+    }
+
+    g_gateway_active = true;
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 停止网关
+ */
+CAN_TestBox_Status_t CAN_Gateway_Stop(void)
+{
+    if (!g_gateway_active) {
+        return CAN_TESTBOX_NOT_INITIALIZED;
+    }
+
+    g_gateway_active = false;
+
+    // 只关闭网关启动时新开启的中断，测试盒CAN2通道与错误统计仍需要其余中断
+    if ((CAN_GATEWAY_CAN2_IT & ~g_can2_prev_it) != 0U) {
+        HAL_CAN_DeactivateNotification(&hcan2, CAN_GATEWAY_CAN2_IT & ~g_can2_prev_it);
+    }
+    HAL_CAN_Stop(&hcan2);
+
+    // 停用网关占用的过滤器
+    CAN_Gateway_ApplyFilters(false);
+
+    // CAN2恢复静默模式，网关启动前已运行时重新启动
+    hcan2.Init.Mode = CAN_MODE_SILENT;
+    if (HAL_CAN_Init(&hcan2) != HAL_OK) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    if (g_can2_was_started && HAL_CAN_Start(&hcan2) != HAL_OK) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 网关是否运行中
+ */
+bool CAN_Gateway_IsActive(void)
+{
+    return g_gateway_active;
+}
+
+/**
+ * @brief 获取路由统计
+ */
+CAN_TestBox_Status_t CAN_Gateway_GetRouteStats(uint8_t route_index, CAN_Gateway_RouteStats_t *stats)
+{
+    if (route_index >= CAN_GATEWAY_MAX_ROUTES || stats == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    if (!g_route_used[route_index]) {
+        return CAN_TESTBOX_NOT_FOUND;
+    }
+
+    // 统计在中断中更新，关中断复制保证一致性
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *stats = g_route_stats[route_index];
+    __set_PRIMASK(primask);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 重置所有路由统计
+ */
+CAN_TestBox_Status_t CAN_Gateway_ResetStats(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint8_t i = 0; i < CAN_GATEWAY_MAX_ROUTES; i++) {
+        CAN_Gateway_ResetRouteStats(i);
+    }
+    __set_PRIMASK(primask);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 通过串口打印所有路由统计
+ */
+void CAN_Gateway_PrintStats(void)
+{
+    CAN_Gateway_RouteStats_t stats;
+
+    for (uint8_t i = 0; i < CAN_GATEWAY_MAX_ROUTES; i++) {
+        if (CAN_Gateway_GetRouteStats(i, &stats) != CAN_TESTBOX_OK) {
+            continue;
+        }
+
+        uint32_t avg_us = 0;
+        uint32_t min_us = 0;
+        if (stats.forwarded_count > 0) {
+            avg_us = (uint32_t)(stats.latency_sum_us / stats.forwarded_count);
+            min_us = stats.latency_min_us;
+        }
+
+        printf("[GW] Route %u: CAN%u->CAN%u, Match:%lu, Fwd:%lu, Queued:%lu, Drop:%lu, "
+               "Latency(us) min:%lu avg:%lu max:%lu, Over%uus:%lu\r\n",
+               i,
+               g_routes[i].src_port + 1U,
+               g_routes[i].dst_port + 1U,
+               (unsigned long)stats.matched_count,
+               (unsigned long)stats.forwarded_count,
+               (unsigned long)stats.queued_count,
+               (unsigned long)stats.dropped_count,
+               (unsigned long)min_us,
+               (unsigned long)avg_us,
+               (unsigned long)stats.latency_max_us,
+               CAN_GATEWAY_LATENCY_TARGET_US,
+               (unsigned long)stats.latency_over_target);
+    }
+}
+
+/* ========================= 中断处理函数 ========================= */
+
+/**
+ * @brief 网关接收处理
+ * @note  在CAN接收中断中调用，应在日志打印之前调用以保证转发时延
+ */
+bool CAN_Gateway_ProcessRx(CAN_HandleTypeDef *hcan, const CAN_RxHeaderTypeDef *rx_header,
+                           const uint8_t *rx_data, uint32_t rx_timestamp_us)
+{
+    if (!g_gateway_active) {
+        return false;
+    }
+
+    CAN_Gateway_Port_t port;
+    if (hcan->Instance == CAN1) {
+        port = CAN_GATEWAY_PORT_CAN1;
+    } else if (hcan->Instance == CAN2) {
+        port = CAN_GATEWAY_PORT_CAN2;
+    } else {
+        return false;
+    }
+
+    bool is_extended = (rx_header->IDE == CAN_ID_EXT);
+    uint32_t id = is_extended ? rx_header->ExtId : rx_header->StdId;
+
+    // 按表顺序查找首个匹配路由
+    for (uint8_t i = 0; i < CAN_GATEWAY_MAX_ROUTES; i++) {
+        if (!g_route_used[i]) {
+            continue;
+        }
+
+        const CAN_Gateway_Route_t *route = &g_routes[i];
+        if (route->src_port != port || route->is_extended != is_extended) {
+            continue;
+        }
+
+        if (((id ^ route->match_id) & route->match_mask) != 0) {
+            continue;
+        }
+
+        CAN_Gateway_Forward(i, rx_header, rx_data, rx_timestamp_us);
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief 网关发送邮箱空闲处理
+ */
+void CAN_Gateway_ProcessTxComplete(CAN_HandleTypeDef *hcan)
+{
+    if (!g_gateway_active) {
+        return;
+    }
+
+    if (hcan->Instance == CAN1) {
+        CAN_Gateway_Drain(CAN_GATEWAY_PORT_CAN1);
+    } else if (hcan->Instance == CAN2) {
+        CAN_Gateway_Drain(CAN_GATEWAY_PORT_CAN2);
+    }
+}
+
+/* ========================= 私有函数实现 ========================= */
+
+/**
+ * @brief 重置单条路由统计
+ */
+static void CAN_Gateway_ResetRouteStats(uint8_t index)
+{
+    memset(&g_route_stats[index], 0, sizeof(CAN_Gateway_RouteStats_t));
+    g_route_stats[index].latency_min_us = 0xFFFFFFFFU;
+}
+
+/**
+ * @brief 按路由表重新配置网关占用的硬件过滤器
+ * @param enable: false-仅停用网关占用的全部过滤器
+ */
+static void CAN_Gateway_ApplyFilters(bool enable)
+{
+    uint32_t next_bank[CAN_GATEWAY_PORT_COUNT] = {
+        CAN_GATEWAY_CAN1_FILTER_START,
+        CAN_GATEWAY_CAN2_FILTER_START
+    };
+
+    if (enable) {
+        for (uint8_t i = 0; i < CAN_GATEWAY_MAX_ROUTES; i++) {
+            if (!g_route_used[i]) {
+                continue;
+            }
+
+            CAN_Gateway_Port_t src = g_routes[i].src_port;
+            CAN_Gateway_ConfigFilterBank(g_port_hcan[src], next_bank[src], &g_routes[i], true);
+            next_bank[src]++;
+        }
+    }
+
+    // 停用剩余的网关过滤器
+    for (uint8_t port = 0; port < CAN_GATEWAY_PORT_COUNT; port++) {
+        uint32_t start = (port == CAN_GATEWAY_PORT_CAN1) ? CAN_GATEWAY_CAN1_FILTER_START : CAN_GATEWAY_CAN2_FILTER_START;
+        for (uint32_t bank = next_bank[port]; bank < start + CAN_GATEWAY_FILTERS_PER_PORT; bank++) {
+            CAN_Gateway_ConfigFilterBank(g_port_hcan[port], bank, NULL, false);
+        }
+    }
+}
+
+/**
+ * @brief 配置单个32位掩码模式过滤器
+ */
+static void CAN_Gateway_ConfigFilterBank(CAN_HandleTypeDef *hcan, uint32_t bank,
+                                         const CAN_Gateway_Route_t *route, bool enable)
+{
+    CAN_FilterTypeDef sFilterConfig;
+    uint32_t id_reg = 0;
+    uint32_t mask_reg = 0;
+
+    if (route != NULL) {
+        if (route->is_extended) {
+            id_reg = (route->match_id << 3) | CAN_ID_EXT;
+            mask_reg = ((route->match_mask & 0x1FFFFFFFU) << 3) | CAN_ID_EXT;
+        } else {
+            id_reg = (route->match_id << 21);
+            mask_reg = ((route->match_mask & 0x7FFU) << 21) | CAN_ID_EXT;
+        }
+    }
+
+    sFilterConfig.FilterBank = bank;
+    sFilterConfig.FilterMode = CAN_FILTERMODE_IDMASK;
+    sFilterConfig.FilterScale = CAN_FILTERSCALE_32BIT;
+    sFilterConfig.FilterIdHigh = (id_reg >> 16) & 0xFFFFU;
+    sFilterConfig.FilterIdLow = id_reg & 0xFFFFU;
+    sFilterConfig.FilterMaskIdHigh = (mask_reg >> 16) & 0xFFFFU;
+    sFilterConfig.FilterMaskIdLow = mask_reg & 0xFFFFU;
+    sFilterConfig.FilterFIFOAssignment = CAN_RX_FIFO0;
+    sFilterConfig.FilterActivation = enable ? CAN_FILTER_ENABLE : CAN_FILTER_DISABLE;
+    sFilterConfig.SlaveStartFilterBank = 14; // 与PEPS过滤器保持一致
+
+    HAL_CAN_ConfigFilter(hcan, &sFilterConfig);
+}
+
+/**
+ * @brief 按路由转发单帧
+ */
+static void CAN_Gateway_Forward(uint8_t route_index, const CAN_RxHeaderTypeDef *rx_header,
+                                const uint8_t *rx_data, uint32_t rx_timestamp_us)
+{
+    const CAN_Gateway_Route_t *route = &g_routes[route_index];
+    CAN_Gateway_TxEntry_t entry;
+
+    bool is_extended = (rx_header->IDE == CAN_ID_EXT);
+    uint32_t id = is_extended ? rx_header->ExtId : rx_header->StdId;
+    uint8_t dlc = (rx_header->DLC > 8U) ? 8U : (uint8_t)rx_header->DLC;
+
+    g_route_stats[route_index].matched_count++;
+
+    // ID重映射
+    if (route->remap_enable) {
+        id = (id & ~route->remap_mask) | (route->remap_id & route->remap_mask);
+    }
+
+    // 数据变换
+    memcpy(entry.data, rx_data, 8);
+    if (route->transform == CAN_GATEWAY_XFORM_MASK) {
+        for (uint8_t i = 0; i < dlc; i++) {
+            entry.data[i] = (entry.data[i] & route->and_mask[i]) ^ route->xor_mask[i];
+        }
+    } else if (route->transform == CAN_GATEWAY_XFORM_CALLBACK) {
+        route->transform_fn(&id, entry.data, &dlc);
+        if (dlc > 8U) {
+            dlc = 8U;
+        }
+    }
+
+    // 配置发送头
+    if (is_extended) {
+        entry.header.IDE = CAN_ID_EXT;
+        entry.header.ExtId = id & 0x1FFFFFFFU;
+        entry.header.StdId = 0;
+    } else {
+        entry.header.IDE = CAN_ID_STD;
+        entry.header.StdId = id & 0x7FFU;
+        entry.header.ExtId = 0;
+    }
+    entry.header.RTR = rx_header->RTR;
+    entry.header.DLC = dlc;
+    entry.header.TransmitGlobalTime = DISABLE;
+    entry.route_index = route_index;
+    entry.rx_timestamp_us = rx_timestamp_us;
+
+    CAN_Gateway_Enqueue(route->dst_port, &entry);
+}
+
+/**
+ * @brief 报文入目标通道发送队列并尝试装入邮箱
+ * @note  不同优先级的CAN中断都可能访问同一目标队列，整个过程在临界区内完成
+ */
+static void CAN_Gateway_Enqueue(CAN_Gateway_Port_t port, const CAN_Gateway_TxEntry_t *entry)
+{
+    CAN_Gateway_TxQueue_t *queue = &g_tx_queues[port];
+    CAN_HandleTypeDef *hcan = g_port_hcan[port];
+    uint32_t tx_mailbox;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    // 队列为空且有空闲邮箱时直接发送，保证最短时延且不打乱顺序
+    if (queue->count == 0 && CAN_TxArb_ExternalFreeLevel(hcan) > 0) {
+        if (HAL_CAN_AddTxMessage(hcan, &entry->header, entry->data, &tx_mailbox) == HAL_OK) {
+            CAN_Gateway_RecordLatency(entry->route_index, entry->rx_timestamp_us);
+            __set_PRIMASK(primask);
+            return;
+        }
+    }
+
+    if (queue->count < CAN_GATEWAY_TX_QUEUE_SIZE) {
+        queue->entries[queue->tail] = *entry;
+        queue->tail = (queue->tail + 1U) % CAN_GATEWAY_TX_QUEUE_SIZE;
+        queue->count++;
+        g_route_stats[entry->route_index].queued_count++;
+    } else {
+        g_route_stats[entry->route_index].dropped_count++;
+    }
+
+    CAN_Gateway_Drain(port);
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 将软件队列中的报文装入空闲邮箱
+ */
+static void CAN_Gateway_Drain(CAN_Gateway_Port_t port)
+{
+    CAN_Gateway_TxQueue_t *queue = &g_tx_queues[port];
+    CAN_HandleTypeDef *hcan = g_port_hcan[port];
+    uint32_t tx_mailbox;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    while (queue->count > 0 && CAN_TxArb_ExternalFreeLevel(hcan) > 0) {
+        CAN_Gateway_TxEntry_t *entry = &queue->entries[queue->head];
+
+        if (HAL_CAN_AddTxMessage(hcan, &entry->header, entry->data, &tx_mailbox) != HAL_OK) {
+            break;
+        }
+
+        CAN_Gateway_RecordLatency(entry->route_index, entry->rx_timestamp_us);
+
+        queue->head = (queue->head + 1U) % CAN_GATEWAY_TX_QUEUE_SIZE;
+        queue->count--;
+    }
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 记录转发时延(接收中断入口 -> 装入邮箱)
+ */
+static void CAN_Gateway_RecordLatency(uint8_t route_index, uint32_t rx_timestamp_us)
+{
+    CAN_Gateway_RouteStats_t *stats = &g_route_stats[route_index];
+    uint32_t latency = CAN_Timestamp_Elapsed(rx_timestamp_us, CAN_Timestamp_GetUs());
+
+    stats->forwarded_count++;
+    stats->latency_last_us = latency;
+    stats->latency_sum_us += latency;
+
+    if (latency < stats->latency_min_us) {
+        stats->latency_min_us = latency;
+    }
+    if (latency > stats->latency_max_us) {
+        stats->latency_max_us = latency;
+    }
+    if (latency > CAN_GATEWAY_LATENCY_TARGET_US) {
+        stats->latency_over_target++;
+    }
+}
+
+/**
+ * @brief 读取小端u32
+ */
+static uint32_t CAN_Gateway_ReadU32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief 串口命令: 网关路由配置/启停/统计
+ */
+static void CAN_Gateway_HandleCtrl(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    CAN_Gateway_Route_t route;
+    CAN_Gateway_RouteStats_t stats;
+    CAN_TestBox_Status_t status;
+    uint8_t index;
+
+    if (len < 1U) {
+        CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+        return;
+    }
+
+    switch (payload[0]) {
+        case CAN_GATEWAY_CTRL_STATUS:
+            // 应答: 运行中(u8)、路由位图(u16)
+            {
+                uint16_t route_mask = 0;
+                for (uint8_t i = 0; i < CAN_GATEWAY_MAX_ROUTES; i++) {
+                    if (g_route_used[i]) {
+                        route_mask |= (uint16_t)(1U << i);
+                    }
+                }
+                uint8_t reply[3] = {
+                    g_gateway_active ? 1U : 0U,
+                    (uint8_t)route_mask,
+                    (uint8_t)(route_mask >> 8)
+                };
+                CAN_Cmd_SendResponse(cmd, reply, sizeof(reply));
+            }
+            return;
+
+        case CAN_GATEWAY_CTRL_ROUTE_ADD:
+            // 源、目标、扩展帧、匹配ID、匹配掩码、重映射、重映射ID、重映射掩码、变换[、与掩码、异或掩码]
+            if (len != CAN_GATEWAY_ROUTE_LEN && len != CAN_GATEWAY_ROUTE_LEN + CAN_GATEWAY_XFORM_LEN) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+                return;
+            }
+            // 掩码变换须带与/异或掩码；回调变换只能由应用代码配置
+            if (payload[21] > CAN_GATEWAY_XFORM_MASK ||
+                (payload[21] == CAN_GATEWAY_XFORM_MASK) != (len != CAN_GATEWAY_ROUTE_LEN)) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_PARAM);
+                return;
+            }
+            memset(&route, 0, sizeof(route));
+            route.src_port = (CAN_Gateway_Port_t)payload[1];
+            route.dst_port = (CAN_Gateway_Port_t)payload[2];
+            route.is_extended = (payload[3] != 0U);
+            route.match_id = CAN_Gateway_ReadU32(&payload[4]);
+            route.match_mask = CAN_Gateway_ReadU32(&payload[8]);
+            route.remap_enable = (payload[12] != 0U);
+            route.remap_id = CAN_Gateway_ReadU32(&payload[13]);
+            route.remap_mask = CAN_Gateway_ReadU32(&payload[17]);
+            route.transform = (CAN_Gateway_Transform_t)payload[21];
+            if (route.transform == CAN_GATEWAY_XFORM_MASK) {
+                memcpy(route.and_mask, &payload[22], 8);
+                memcpy(route.xor_mask, &payload[30], 8);
+            }
+            status = CAN_Gateway_AddRoute(&route, &index);
+            if (status == CAN_TESTBOX_OK) {
+                CAN_Cmd_SendResponse(cmd, &index, 1);
+            } else {
+                CAN_Cmd_SendResult(cmd, (status == CAN_TESTBOX_INVALID_PARAM) ? CAN_CMD_RESULT_BAD_PARAM : CAN_CMD_RESULT_FAILED);
+            }
+            return;
+
+        case CAN_GATEWAY_CTRL_ROUTE_REMOVE:
+            if (len != 2U) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+                return;
+            }
+            status = CAN_Gateway_RemoveRoute(payload[1]);
+            break;
+
+        case CAN_GATEWAY_CTRL_ROUTE_CLEAR:
+            status = CAN_Gateway_ClearRoutes();
+            break;
+
+        case CAN_GATEWAY_CTRL_START:
+            // CAN2监听中返回执行失败，需先停止CAN2监听
+            status = CAN_Gateway_Start();
+            CAN_Cmd_SendResult(cmd, (status == CAN_TESTBOX_OK) ? CAN_CMD_RESULT_OK : CAN_CMD_RESULT_FAILED);
+            return;
+
+        case CAN_GATEWAY_CTRL_STOP:
+            status = CAN_Gateway_Stop();
+            CAN_Cmd_SendResult(cmd, (status == CAN_TESTBOX_OK) ? CAN_CMD_RESULT_OK : CAN_CMD_RESULT_FAILED);
+            return;
+
+        case CAN_GATEWAY_CTRL_ROUTE_STATS:
+            if (len != 2U) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+                return;
+            }
+            if (CAN_Gateway_GetRouteStats(payload[1], &stats) != CAN_TESTBOX_OK) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_PARAM);
+                return;
+            }
+            // 应答: 匹配、转发、排队、丢弃、最小/平均/最大/最近时延(us)、超过目标次数，均为u32
+            {
+                uint32_t reply[9] = {
+                    stats.matched_count,
+                    stats.forwarded_count,
+                    stats.queued_count,
+                    stats.dropped_count,
+                    (stats.forwarded_count > 0U) ? stats.latency_min_us : 0U,
+                    (stats.forwarded_count > 0U) ? (uint32_t)(stats.latency_sum_us / stats.forwarded_count) : 0U,
+                    stats.latency_max_us,
+                    stats.latency_last_us,
+                    stats.latency_over_target
+                };
+                CAN_Cmd_SendResponse(cmd, (const uint8_t *)reply, sizeof(reply));
+            }
+            return;
+
+        case CAN_GATEWAY_CTRL_RESET_STATS:
+            status = CAN_Gateway_ResetStats();
+            break;
+
+        default:
+            CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_PARAM);
+            return;
+    }
+
+    CAN_Cmd_SendResult(cmd, (status == CAN_TESTBOX_OK) ? CAN_CMD_RESULT_OK : CAN_CMD_RESULT_BAD_PARAM);
+}
@@ -0,0 +1,572 @@
+/**
+ * @file can_testbox_gen.c
+ * @brief 周期/连续帧负载生成器实现
+ * @version 1.0
+ * @date 2024
+ */
+
+#include "can_testbox_gen.h"
+#include "can_testbox_timestamp.h"
+#include "can_testbox_cmd.h"
+#include <string.h>
+
+/* ========================= 私有宏定义 ========================= */
+
+#define CAN_GEN_LFSR_POLY           0xD0000001U // x^32 + x^31 + x^29 + x + 1
+#define CAN_GEN_LFSR_SEED           0xACE1ACE1U // 种子为0时使用
+
+/* ========================= 私有类型定义 ========================= */
+
+/**
+ * @brief 信号生成器运行状态
+ */
+typedef struct {
+    uint32_t value;                         // 当前输出值
+    uint32_t aux;                           // 方向/相位/LFSR寄存器/保持计数/回放位置
+} CAN_Gen_SignalState_t;
+
+/**
+ * @brief 生成器组
+ */
+typedef struct {
+    uint8_t signal_mask;                    // 已配置的信号(位i对应序号i)
+    uint8_t lane_mask;                      // 参与的字节通道
+    CAN_Gen_Signal_t signals[CAN_GEN_SIGNALS_PER_SET];
+    CAN_Gen_SignalState_t state[CAN_GEN_SIGNALS_PER_SET];
+    uint32_t lane_word_mask[2];             // 字节通道掩码(按字)
+    uint32_t lane_init[2];                  // 字节通道初值
+    uint32_t lane_value[2];                 // 字节通道当前值
+    uint32_t lane_step[2];                  // 字节通道步长
+} CAN_Gen_Set_t;
+
+/* ========================= 私有变量定义 ========================= */
+
+// 正弦表(Q15，一周256点)
+static const int16_t g_sine_q15[256] = {
+    0, 804, 1608, 2410, 3212, 4011, 4808, 5602, 6393, 7179, 7962, 8739, 9512, 10278, 11039, 11793,
+    12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530, 18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+    23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790, 27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+    30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971, 32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+    32767, 32757, 32728, 32678, 32609, 32521, 32412, 32285, 32137, 31971, 31785, 31580, 31356, 31113, 30852, 30571,
+    30273, 29956, 29621, 29268, 28898, 28510, 28105, 27683, 27245, 26790, 26319, 25832, 25329, 24811, 24279, 23731,
+    23170, 22594, 22005, 21403, 20787, 20159, 19519, 18868, 18204, 17530, 16846, 16151, 15446, 14732, 14010, 13279,
+    12539, 11793, 11039, 10278, 9512, 8739, 7962, 7179, 6393, 5602, 4808, 4011, 3212, 2410, 1608, 804,
+    0, -804, -1608, -2410, -3212, -4011, -4808, -5602, -6393, -7179, -7962, -8739, -9512, -10278, -11039, -11793,
+    -12539, -13279, -14010, -14732, -15446, -16151, -16846, -17530, -18204, -18868, -19519, -20159, -20787, -21403, -22005, -22594,
+    -23170, -23731, -24279, -24811, -25329, -25832, -26319, -26790, -27245, -27683, -28105, -28510, -28898, -29268, -29621, -29956,
+    -30273, -30571, -30852, -31113, -31356, -31580, -31785, -31971, -32137, -32285, -32412, -32521, -32609, -32678, -32728, -32757,
+    -32767, -32757, -32728, -32678, -32609, -32521, -32412, -32285, -32137, -31971, -31785, -31580, -31356, -31113, -30852, -30571,
+    -30273, -29956, -29621, -29268, -28898, -28510, -28105, -27683, -27245, -26790, -26319, -25832, -25329, -24811, -24279, -23731,
+    -23170, -22594, -22005, -21403, -20787, -20159, -19519, -18868, -18204, -17530, -16846, -16151, -15446, -14732, -14010, -13279,
+    -12539, -11793, -11039, -10278, -9512, -8739, -7962, -7179, -6393, -5602, -4808, -4011, -3212, -2410, -1608, -804
+};
+
+static CAN_Gen_Set_t g_sets[CAN_GEN_SET_MAX];
+static uint32_t g_replay[CAN_GEN_REPLAY_MAX];
+
+// 周期报文槽位绑定的生成器组(0为未绑定)
+static uint8_t g_bindings[CAN_TESTBOX_CH_COUNT][CAN_TESTBOX_MAX_PERIODIC_MSGS];
+
+// 执行统计
+static uint32_t g_evaluations = 0;
+static uint32_t g_advances = 0;
+static uint64_t g_cycles_sum = 0;
+static uint32_t g_cycles_max = 0;
+
+/* ========================= 私有函数声明 ========================= */
+
+static bool CAN_Gen_ValidateSignal(const CAN_Gen_Signal_t *signal);
+static void CAN_Gen_InitState(const CAN_Gen_Signal_t *signal, CAN_Gen_SignalState_t *state);
+static void CAN_Gen_Step(const CAN_Gen_Signal_t *signal, CAN_Gen_SignalState_t *state);
+static uint32_t CAN_Gen_Sine(const CAN_Gen_Signal_t *signal, uint32_t phase);
+static uint32_t CAN_Gen_ReadU32(const uint8_t *p);
+static void CAN_Gen_HandleCtrl(uint8_t cmd, const uint8_t *payload, uint8_t len);
+
+/* ========================= 公共API实现 ========================= */
+
+/**
+ * @brief 初始化负载生成器
+ */
+CAN_TestBox_Status_t CAN_Gen_Init(void)
+{
+    memset(g_sets, 0, sizeof(g_sets));
+    memset(g_replay, 0, sizeof(g_replay));
+    memset(g_bindings, 0, sizeof(g_bindings));
+    g_evaluations = 0;
+    g_advances = 0;
+    g_cycles_sum = 0;
+    g_cycles_max = 0;
+
+    CAN_Timestamp_CycleCounterInit();
+    if (CAN_Cmd_Register(CAN_CMD_ID_GEN_CTRL, CAN_Gen_HandleCtrl) != CAN_TESTBOX_OK) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 配置组内信号生成器
+ */
+CAN_TestBox_Status_t CAN_Gen_SetSignal(uint8_t set, uint8_t index, const CAN_Gen_Signal_t *signal)
+{
+    if (set == 0U || set > CAN_GEN_SET_MAX || index >= CAN_GEN_SIGNALS_PER_SET || signal == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    CAN_Gen_Set_t *gen = &g_sets[set - 1U];
+
+    if (signal->type == CAN_GEN_TYPE_NONE) {
+        gen->signal_mask &= (uint8_t)~(1U << index);
+        return CAN_TESTBOX_OK;
+    }
+
+    if (!CAN_Gen_ValidateSignal(signal)) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    gen->signal_mask &= (uint8_t)~(1U << index);
+    gen->signals[index] = *signal;
+    CAN_Gen_InitState(signal, &gen->state[index]);
+    gen->signal_mask |= (uint8_t)(1U << index);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 配置组内字节通道
+ */
+CAN_TestBox_Status_t CAN_Gen_SetLanes(uint8_t set, uint8_t mask, const uint8_t *init, const uint8_t *step)
+{
+    if (set == 0U || set > CAN_GEN_SET_MAX || init == NULL || step == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    CAN_Gen_Set_t *gen = &g_sets[set - 1U];
+    uint8_t mask_bytes[8];
+
+    for (uint8_t i = 0; i < 8U; i++) {
+        mask_bytes[i] = ((mask & (1U << i)) != 0U) ? 0xFFU : 0x00U;
+    }
+
+    gen->lane_mask = 0;
+    memcpy(gen->lane_word_mask, mask_bytes, sizeof(gen->lane_word_mask));
+    memcpy(gen->lane_init, init, sizeof(gen->lane_init));
+    memcpy(gen->lane_step, step, sizeof(gen->lane_step));
+    memcpy(gen->lane_value, gen->lane_init, sizeof(gen->lane_value));
+    gen->lane_mask = mask;
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 清空生成器组
+ */
+CAN_TestBox_Status_t CAN_Gen_ClearSet(uint8_t set)
+{
+    if (set == 0U || set > CAN_GEN_SET_MAX) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    memset(&g_sets[set - 1U], 0, sizeof(CAN_Gen_Set_t));
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 生成器组状态回到初值
+ */
+CAN_TestBox_Status_t CAN_Gen_ResetState(uint8_t set)
+{
+    if (set == 0U || set > CAN_GEN_SET_MAX) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    CAN_Gen_Set_t *gen = &g_sets[set - 1U];
+
+    for (uint8_t i = 0; i < CAN_GEN_SIGNALS_PER_SET; i++) {
+        if ((gen->signal_mask & (1U << i)) != 0U) {
+            CAN_Gen_InitState(&gen->signals[i], &gen->state[i]);
+        }
+    }
+    memcpy(gen->lane_value, gen->lane_init, sizeof(gen->lane_value));
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 写入回放值池
+ */
+CAN_TestBox_Status_t CAN_Gen_WriteReplay(uint8_t offset, const uint32_t *values, uint8_t count)
+{
+    if (values == NULL || (uint32_t)offset + count > CAN_GEN_REPLAY_MAX) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    memcpy(&g_replay[offset], values, count * sizeof(uint32_t));
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 周期报文槽位绑定生成器组
+ */
+CAN_TestBox_Status_t CAN_Gen_BindPeriodic(CAN_TestBox_ChannelId_t ch, uint8_t handle, uint8_t set)
+{
+    if (ch >= CAN_TESTBOX_CH_COUNT || handle >= CAN_TESTBOX_MAX_PERIODIC_MSGS || set > CAN_GEN_SET_MAX) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    g_bindings[ch][handle] = set;
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 获取周期报文槽位绑定的生成器组
+ */
+uint8_t CAN_Gen_GetBinding(CAN_TestBox_ChannelId_t ch, uint8_t handle)
+{
+    return g_bindings[ch][handle];
+}
+
+/**
+ * @brief 按当前状态写入负载
+ * @note  字节通道按字合并，信号按64位小端负载插入位段
+ */
+void CAN_Gen_Apply(uint8_t set, uint8_t *data)
+{
+    if (set == 0U || set > CAN_GEN_SET_MAX) {
+        return;
+    }
+
+    const CAN_Gen_Set_t *gen = &g_sets[set - 1U];
+    if (gen->signal_mask == 0U && gen->lane_mask == 0U) {
+        return;
+    }
+
+    uint32_t t0 = CAN_Timestamp_GetCycles();
+
+    uint32_t words[2];
+    memcpy(words, data, sizeof(words));
+
+    if (gen->lane_mask != 0U) {
+        words[0] = (words[0] & ~gen->lane_word_mask[0]) | (gen->lane_value[0] & gen->lane_word_mask[0]);
+        words[1] = (words[1] & ~gen->lane_word_mask[1]) | (gen->lane_value[1] & gen->lane_word_mask[1]);
+    }
+
+    if (gen->signal_mask != 0U) {
+        uint64_t payload = (uint64_t)words[0] | ((uint64_t)words[1] << 32);
+
+        for (uint8_t i = 0; i < CAN_GEN_SIGNALS_PER_SET; i++) {
+            if ((gen->signal_mask & (1U << i)) == 0U) {
+                continue;
+            }
+            const CAN_Gen_Signal_t *signal = &gen->signals[i];
+            uint64_t field = ((signal->length == 32U) ? 0xFFFFFFFFULL : ((1ULL << signal->length) - 1U)) << signal->start_bit;
+            payload = (payload & ~field) | (((uint64_t)gen->state[i].value << signal->start_bit) & field);
+        }
+
+        words[0] = (uint32_t)payload;
+        words[1] = (uint32_t)(payload >> 32);
+    }
+
+    memcpy(data, words, sizeof(words));
+
+    uint32_t cycles = CAN_Timestamp_GetCycles() - t0;
+    g_evaluations++;
+    g_cycles_sum += cycles;
+    if (cycles > g_cycles_max) {
+        g_cycles_max = cycles;
+    }
+}
+
+/**
+ * @brief 发送成功后推进生成器组状态
+ */
+void CAN_Gen_Advance(uint8_t set)
+{
+    if (set == 0U || set > CAN_GEN_SET_MAX) {
+        return;
+    }
+
+    CAN_Gen_Set_t *gen = &g_sets[set - 1U];
+
+    if (gen->lane_mask != 0U) {
+        CAN_Gen_AddBytes(gen->lane_value, gen->lane_step);
+    }
+
+    if (gen->signal_mask != 0U) {
+        for (uint8_t i = 0; i < CAN_GEN_SIGNALS_PER_SET; i++) {
+            if ((gen->signal_mask & (1U << i)) != 0U) {
+                CAN_Gen_Step(&gen->signals[i], &gen->state[i]);
+            }
+        }
+    }
+
+    if ((gen->signal_mask | gen->lane_mask) != 0U) {
+        g_advances++;
+    }
+}
+
+/**
+ * @brief 字节通道逐字节相加(模256)
+ * @note  DSP扩展下__UADD8一条指令完成4个字节；否则低7位相加后
+ *        用异或补回最高位，字节间不产生进位
+ */
+void CAN_Gen_AddBytes(uint32_t *data, const uint32_t *step)
+{
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+    data[0] = __UADD8(data[0], step[0]);
+    data[1] = __UADD8(data[1], step[1]);
+#else
+    for (uint8_t i = 0; i < 2U; i++) {
+        uint32_t a = data[i];
+        uint32_t b = step[i];
+        data[i] = ((a & 0x7F7F7F7FU) + (b & 0x7F7F7F7FU)) ^ ((a ^ b) & 0x80808080U);
+    }
+#endif
+}
+
+/**
+ * @brief 获取执行统计
+ */
+CAN_TestBox_Status_t CAN_Gen_GetStats(CAN_Gen_Stats_t *stats)
+{
+    if (stats == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    stats->evaluations = g_evaluations;
+    stats->advances = g_advances;
+    stats->cycles_max = g_cycles_max;
+    stats->cycles_avg = (g_evaluations > 0U) ? (uint32_t)(g_cycles_sum / g_evaluations) : 0U;
+
+    return CAN_TESTBOX_OK;
+}
+
+/* ========================= 私有函数实现 ========================= */
+
+/**
+ * @brief 检查信号生成器配置
+ */
+static bool CAN_Gen_ValidateSignal(const CAN_Gen_Signal_t *signal)
+{
+    if (signal->type > CAN_GEN_TYPE_REPLAY || signal->length == 0U || signal->length > 32U ||
+        signal->start_bit >= 64U || (uint32_t)signal->start_bit + signal->length > 64U) {
+        return false;
+    }
+
+    switch (signal->type) {
+        case CAN_GEN_TYPE_COUNTER:
+        case CAN_GEN_TYPE_RAMP:
+            return signal->min <= signal->max;
+
+        case CAN_GEN_TYPE_REPLAY:
+            return signal->max >= 1U && signal->min < CAN_GEN_REPLAY_MAX &&
+                   signal->max <= CAN_GEN_REPLAY_MAX - signal->min;
+
+        default:
+            return true;
+    }
+}
+
+/**
+ * @brief 状态回到初值
+ */
+static void CAN_Gen_InitState(const CAN_Gen_Signal_t *signal, CAN_Gen_SignalState_t *state)
+{
+    state->aux = 0;
+
+    switch (signal->type) {
+        case CAN_GEN_TYPE_SINE:
+            state->value = CAN_Gen_Sine(signal, 0);
+            break;
+
+        case CAN_GEN_TYPE_LFSR:
+            state->aux = (signal->step != 0U) ? signal->step : CAN_GEN_LFSR_SEED;
+            state->value = state->aux;
+            break;
+
+        case CAN_GEN_TYPE_REPLAY:
+            state->value = g_replay[signal->min];
+            break;
+
+        default:
+            state->value = signal->min;
+            break;
+    }
+}
+
+/**
+ * @brief 推进一个信号生成器
+ */
+static void CAN_Gen_Step(const CAN_Gen_Signal_t *signal, CAN_Gen_SignalState_t *state)
+{
+    switch (signal->type) {
+        case CAN_GEN_TYPE_COUNTER: {
+            uint64_t span = (uint64_t)signal->max - signal->min + 1U;
+            uint64_t offset = (uint64_t)(state->value - signal->min) + signal->step;
+            state->value = signal->min + (uint32_t)(offset % span);
+            break;
+        }
+
+        case CAN_GEN_TYPE_RAMP:
+            // aux: 0-上升 1-下降
+            if (state->aux == 0U) {
+                if (signal->max - state->value <= signal->step) {
+                    state->value = signal->max;
+                    state->aux = 1;
+                } else {
+                    state->value += signal->step;
+                }
+            } else {
+                if (state->value - signal->min <= signal->step) {
+                    state->value = signal->min;
+                    state->aux = 0;
+                } else {
+                    state->value -= signal->step;
+                }
+            }
+            break;
+
+        case CAN_GEN_TYPE_SINE:
+            // aux: 16位相位累加器
+            state->aux = (state->aux + signal->step) & 0xFFFFU;
+            state->value = CAN_Gen_Sine(signal, state->aux);
+            break;
+
+        case CAN_GEN_TYPE_LFSR:
+            // 每帧移出位长个新位，相邻两帧的值不相关
+            for (uint8_t i = 0; i < signal->length; i++) {
+                state->aux = (state->aux >> 1) ^ ((0U - (state->aux & 1U)) & CAN_GEN_LFSR_POLY);
+            }
+            state->value = state->aux;
+            break;
+
+        case CAN_GEN_TYPE_TOGGLE:
+            // aux: 当前值已保持的帧数
+            if (++state->aux >= ((signal->step > 0U) ? signal->step : 1U)) {
+                state->aux = 0;
+                state->value = (state->value == signal->min) ? signal->max : signal->min;
+            }
+            break;
+
+        case CAN_GEN_TYPE_REPLAY:
+            // aux: 回放位置
+            state->aux = (state->aux + 1U >= signal->max) ? 0U : state->aux + 1U;
+            state->value = g_replay[signal->min + state->aux];
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief 正弦值: 偏置 + 幅值*sin(相位)，限幅到信号位宽
+ */
+static uint32_t CAN_Gen_Sine(const CAN_Gen_Signal_t *signal, uint32_t phase)
+{
+    int64_t value = (int64_t)signal->min + (((int64_t)signal->max * g_sine_q15[(phase >> 8) & 0xFFU]) >> 15);
+    int64_t limit = (signal->length == 32U) ? 0xFFFFFFFFLL : ((1LL << signal->length) - 1);
+
+    if (value < 0) {
+        value = 0;
+    } else if (value > limit) {
+        value = limit;
+    }
+
+    return (uint32_t)value;
+}
+
+/**
+ * @brief 读取小端u32
+ */
+static uint32_t CAN_Gen_ReadU32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief 串口命令: 负载生成器配置/绑定/统计
+ */
+static void CAN_Gen_HandleCtrl(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    CAN_Gen_Signal_t signal;
+    CAN_Gen_Stats_t stats;
+    uint32_t values[(CAN_CMD_MAX_PAYLOAD - 2U) / 4U];
+    CAN_TestBox_Status_t status;
+
+    if (len == 0U) {
+        CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+        return;
+    }
+
+    switch (payload[0]) {
+        case CAN_GEN_CTRL_SET_SIGNAL:
+            // 组、序号、类型、起始位、位长、min、max、step
+            if (len != 18U) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+                return;
+            }
+            signal.type = payload[3];
+            signal.start_bit = payload[4];
+            signal.length = payload[5];
+            signal.min = CAN_Gen_ReadU32(&payload[6]);
+            signal.max = CAN_Gen_ReadU32(&payload[10]);
+            signal.step = CAN_Gen_ReadU32(&payload[14]);
+            status = CAN_Gen_SetSignal(payload[1], payload[2], &signal);
+            break;
+
+        case CAN_GEN_CTRL_SET_LANES:
+            // 组、字节掩码、8字节初值、8字节步长
+            if (len != 19U) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+                return;
+            }
+            status = CAN_Gen_SetLanes(payload[1], payload[2], &payload[3], &payload[11]);
+            break;
+
+        case CAN_GEN_CTRL_CLEAR_SET:
+        case CAN_GEN_CTRL_RESET_STATE:
+            if (len != 2U) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+                return;
+            }
+            status = (payload[0] == CAN_GEN_CTRL_CLEAR_SET) ? CAN_Gen_ClearSet(payload[1]) : CAN_Gen_ResetState(payload[1]);
+            break;
+
+        case CAN_GEN_CTRL_BIND:
+            // 通道、周期报文句柄、组
+            if (len != 4U) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+                return;
+            }
+            status = CAN_Gen_BindPeriodic((CAN_TestBox_ChannelId_t)payload[1], payload[2], payload[3]);
+            break;
+
+        case CAN_GEN_CTRL_REPLAY_WRITE:
+            // 起始下标、若干u32
+            if (len < 6U || ((len - 2U) % 4U) != 0U) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+                return;
+            }
+            for (uint8_t i = 0; i < (len - 2U) / 4U; i++) {
+                values[i] = CAN_Gen_ReadU32(&payload[2U + i * 4U]);
+            }
+            status = CAN_Gen_WriteReplay(payload[1], values, (uint8_t)((len - 2U) / 4U));
+            break;
+
+        case CAN_GEN_CTRL_STATUS:
+            CAN_Gen_GetStats(&stats);
+            CAN_Cmd_SendResponse(cmd, (const uint8_t *)&stats, sizeof(stats));
+            return;
+
+        default:
+            CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_PARAM);
+            return;
+    }
+
+    CAN_Cmd_SendResult(cmd, (status == CAN_TESTBOX_OK) ? CAN_CMD_RESULT_OK : CAN_CMD_RESULT_BAD_PARAM);
+}
@@ -0,0 +1,525 @@
+/**
+ * @file can_testbox_idstats.c
+ * @brief CAN按ID实时统计表实现
+ * @version 1.0
+ * @date 2024
+ */
+
+#include "can_testbox_idstats.h"
+#include "can_testbox_cmd.h"
+#include "can_testbox_mem.h"
+#include <string.h>
+
+/* ========================= 私有宏定义 ========================= */
+
+#define CAN_IDSTATS_EXT_VALID           0x80000000U   // 哈希项已占用标志
+#define CAN_IDSTATS_KEY_EXT             0x40000000U   // CAN2哈希键中的扩展帧标志(扩展ID只有29位)
+#define CAN_IDSTATS_FLAG_RTR            0x01U         // 最近一帧为远程帧
+#define CAN_IDSTATS_EXT_HASH_SHIFT      25U           // 乘法散列取高7位，与哈希表容量一致
+
+_Static_assert((1UL << (32U - CAN_IDSTATS_EXT_HASH_SHIFT)) == CAN_IDSTATS_EXT_SIZE, "hash shift does not match table size");
+_Static_assert(CAN_IDSTATS_CAN2_SIZE == CAN_IDSTATS_EXT_SIZE, "CAN2 table shares the extended-ID hash");
+
+// 导出记录中ID字段的标志位
+#define CAN_IDSTATS_DUMP_ID_EXT         0x80000000U
+#define CAN_IDSTATS_DUMP_ID_RTR         0x40000000U
+#define CAN_IDSTATS_DUMP_ID_CAN2        0x20000000U
+#define CAN_IDSTATS_DUMP_RECORD_SIZE    31            // 单条导出记录长度
+#define CAN_IDSTATS_DUMP_HEADER_SIZE    10            // 导出应答头长度
+#define CAN_IDSTATS_DUMP_MAX_RECORDS    2048          // 单帧最多导出记录数(受应答长度u16限制)
+#define CAN_IDSTATS_DUMP_OPT_RESET      0x01U         // 导出后清空
+
+/* ========================= 私有类型定义 ========================= */
+
+/**
+ * @brief 统计项(32字节)
+ * @note  中断中最后写入count，读取方以count作为版本号检测拷贝是否被打断
+ */
+typedef struct {
+    uint32_t count;                 // 帧计数
+    uint32_t first_us;              // 首帧时间戳
+    uint32_t last_us;               // 最近一帧时间戳
+    uint32_t min_dt_us;             // 最小帧间隔
+    uint32_t max_dt_us;             // 最大帧间隔
+    uint16_t jitter_us;             // 平滑偏差(饱和至65535)
+    uint8_t  dlc;                   // 最近一帧DLC
+    uint8_t  flags;                 // CAN_IDSTATS_FLAG_xxx
+    uint8_t  data[8];               // 最近一帧数据
+} CAN_IdStats_Entry_t;
+
+/**
+ * @brief 哈希项
+ */
+typedef struct {
+    uint32_t key;                   // ID | CAN_IDSTATS_EXT_VALID [| CAN_IDSTATS_KEY_EXT]，0表示空闲
+    CAN_IdStats_Entry_t entry;
+} CAN_IdStats_ExtEntry_t;
+
+/**
+ * @brief 导出游标
+ */
+typedef struct {
+    uint32_t index;                 // 当前遍历序号
+    uint32_t start;                 // 起始序号
+    uint32_t remaining;             // 剩余输出条数
+} CAN_IdStats_DumpCursor_t;
+
+/* ========================= 私有变量定义 ========================= */
+
+// 标准帧直接索引表(64KB，放在CCM RAM，不占用主SRAM)
+static CAN_IdStats_Entry_t g_std_table[CAN_IDSTATS_STD_COUNT] CAN_TESTBOX_CCM_BSS;
+
+// CAN1扩展帧哈希表
+static CAN_IdStats_ExtEntry_t g_ext_table[CAN_IDSTATS_EXT_SIZE];
+
+// CAN2哈希表(标准帧与扩展帧)
+static CAN_IdStats_ExtEntry_t g_can2_table[CAN_IDSTATS_CAN2_SIZE];
+
+// 哈希表溢出计数(CAN1、CAN2接收中断优先级不同，分开计数)
+static volatile uint32_t g_overflow_count[2];
+
+/* ========================= 私有函数声明 ========================= */
+
+static inline uint32_t CAN_IdStats_Hash(uint32_t id);
+static CAN_IdStats_Entry_t *CAN_IdStats_Lookup(CAN_IdStats_ExtEntry_t *table, uint32_t key, bool insert);
+static uint32_t CAN_IdStats_Overflow(void);
+static bool CAN_IdStats_ReadEntry(const CAN_IdStats_Entry_t *entry, uint8_t ch, uint32_t id, bool is_extended, CAN_IdStats_Snapshot_t *snapshot);
+static void CAN_IdStats_CountVisitor(const CAN_IdStats_Snapshot_t *snapshot, void *context);
+static void CAN_IdStats_DumpVisitor(const CAN_IdStats_Snapshot_t *snapshot, void *context);
+static void CAN_IdStats_HandleDump(uint8_t cmd, const uint8_t *payload, uint8_t len);
+static void CAN_IdStats_HandleReset(uint8_t cmd, const uint8_t *payload, uint8_t len);
+
+/* ========================= 公共API实现 ========================= */
+
+/**
+ * @brief 初始化统计表并注册串口导出命令
+ */
+CAN_TestBox_Status_t CAN_IdStats_Init(void)
+{
+    // CCM RAM段不由启动代码清零
+    memset(g_std_table, 0, sizeof(g_std_table));
+    memset(g_ext_table, 0, sizeof(g_ext_table));
+    memset(g_can2_table, 0, sizeof(g_can2_table));
+    g_overflow_count[0] = 0;
+    g_overflow_count[1] = 0;
+
+    if (CAN_Cmd_Register(CAN_CMD_ID_IDSTATS_DUMP, CAN_IdStats_HandleDump) != CAN_TESTBOX_OK ||
+        CAN_Cmd_Register(CAN_CMD_ID_IDSTATS_RESET, CAN_IdStats_HandleReset) != CAN_TESTBOX_OK) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 获取单个ID统计快照
+ */
+CAN_TestBox_Status_t CAN_IdStats_Get(CAN_TestBox_ChannelId_t ch, uint32_t id, bool is_extended, CAN_IdStats_Snapshot_t *snapshot)
+{
+    if (snapshot == NULL || ch > CAN_TESTBOX_CH_CAN2 ||
+        (is_extended ? (id > 0x1FFFFFFFU) : (id >= CAN_IDSTATS_STD_COUNT))) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    const CAN_IdStats_Entry_t *entry;
+
+    if (ch == CAN_TESTBOX_CH_CAN2) {
+        entry = CAN_IdStats_Lookup(g_can2_table, is_extended ? (id | CAN_IDSTATS_KEY_EXT) : id, false);
+    } else if (is_extended) {
+        entry = CAN_IdStats_Lookup(g_ext_table, id, false);
+    } else {
+        entry = &g_std_table[id];
+    }
+
+    if (entry == NULL || !CAN_IdStats_ReadEntry(entry, (uint8_t)ch, id, is_extended, snapshot)) {
+        return CAN_TESTBOX_NOT_FOUND;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 遍历所有有记录的ID
+ */
+uint32_t CAN_IdStats_ForEach(CAN_IdStats_Visitor_t visitor, void *context)
+{
+    CAN_IdStats_Snapshot_t snapshot;
+    uint32_t visited = 0;
+
+    if (visitor == NULL) {
+        return 0;
+    }
+
+    for (uint32_t id = 0; id < CAN_IDSTATS_STD_COUNT; id++) {
+        if (CAN_IdStats_ReadEntry(&g_std_table[id], CAN_TESTBOX_CH_CAN1, id, false, &snapshot)) {
+            visitor(&snapshot, context);
+            visited++;
+        }
+    }
+
+    for (uint32_t i = 0; i < CAN_IDSTATS_EXT_SIZE; i++) {
+        uint32_t key = g_ext_table[i].key;
+        if (key == 0) {
+            continue;
+        }
+        if (CAN_IdStats_ReadEntry(&g_ext_table[i].entry, CAN_TESTBOX_CH_CAN1, key & ~CAN_IDSTATS_EXT_VALID, true, &snapshot)) {
+            visitor(&snapshot, context);
+            visited++;
+        }
+    }
+
+    for (uint32_t i = 0; i < CAN_IDSTATS_CAN2_SIZE; i++) {
+        uint32_t key = g_can2_table[i].key;
+        if (key == 0) {
+            continue;
+        }
+        if (CAN_IdStats_ReadEntry(&g_can2_table[i].entry, CAN_TESTBOX_CH_CAN2,
+                                  key & ~(CAN_IDSTATS_EXT_VALID | CAN_IDSTATS_KEY_EXT),
+                                  (key & CAN_IDSTATS_KEY_EXT) != 0U, &snapshot)) {
+            visitor(&snapshot, context);
+            visited++;
+        }
+    }
+
+    return visited;
+}
+
+/**
+ * @brief 获取统计表概要
+ */
+CAN_TestBox_Status_t CAN_IdStats_GetSummary(CAN_IdStats_Summary_t *summary)
+{
+    if (summary == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    memset(summary, 0, sizeof(*summary));
+
+    for (uint32_t id = 0; id < CAN_IDSTATS_STD_COUNT; id++) {
+        uint32_t count = g_std_table[id].count;
+        if (count != 0) {
+            summary->std_active_count++;
+            summary->total_frame_count += count;
+        }
+    }
+
+    for (uint32_t i = 0; i < CAN_IDSTATS_EXT_SIZE; i++) {
+        uint32_t count = g_ext_table[i].entry.count;
+        if (g_ext_table[i].key != 0 && count != 0) {
+            summary->ext_active_count++;
+            summary->total_frame_count += count;
+        }
+    }
+
+    for (uint32_t i = 0; i < CAN_IDSTATS_CAN2_SIZE; i++) {
+        uint32_t count = g_can2_table[i].entry.count;
+        if (g_can2_table[i].key != 0 && count != 0) {
+            summary->can2_active_count++;
+            summary->total_frame_count += count;
+        }
+    }
+
+    summary->ext_overflow_count = CAN_IdStats_Overflow();
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 清空统计表
+ * @note  逐项关中断清除，不长时间阻塞接收中断
+ */
+CAN_TestBox_Status_t CAN_IdStats_Reset(void)
+{
+    for (uint32_t id = 0; id < CAN_IDSTATS_STD_COUNT; id++) {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        memset(&g_std_table[id], 0, sizeof(g_std_table[id]));
+        __set_PRIMASK(primask);
+    }
+
+    for (uint32_t i = 0; i < CAN_IDSTATS_EXT_SIZE; i++) {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        memset(&g_ext_table[i], 0, sizeof(g_ext_table[i]));
+        memset(&g_can2_table[i], 0, sizeof(g_can2_table[i]));
+        __set_PRIMASK(primask);
+    }
+
+    g_overflow_count[0] = 0;
+    g_overflow_count[1] = 0;
+
+    return CAN_TESTBOX_OK;
+}
+
+/* ========================= 中断处理函数 ========================= */
+
+/**
+ * @brief 更新ID统计(在CAN接收中断中调用)
+ */
+void CAN_IdStats_Update(CAN_TestBox_ChannelId_t ch, const CAN_RxHeaderTypeDef *rx_header, const uint8_t *rx_data, uint32_t rx_timestamp_us)
+{
+    CAN_IdStats_Entry_t *entry;
+
+    if (ch == CAN_TESTBOX_CH_CAN2) {
+        uint32_t key = (rx_header->IDE == CAN_ID_EXT) ? (rx_header->ExtId | CAN_IDSTATS_KEY_EXT)
+                                                       : (rx_header->StdId & (CAN_IDSTATS_STD_COUNT - 1U));
+        entry = CAN_IdStats_Lookup(g_can2_table, key, true);
+        if (entry == NULL) {
+            g_overflow_count[1]++;
+            return;
+        }
+    } else if (rx_header->IDE == CAN_ID_EXT) {
+        entry = CAN_IdStats_Lookup(g_ext_table, rx_header->ExtId, true);
+        if (entry == NULL) {
+            g_overflow_count[0]++;
+            return;
+        }
+    } else {
+        entry = &g_std_table[rx_header->StdId & (CAN_IDSTATS_STD_COUNT - 1U)];
+    }
+
+    uint32_t count = entry->count;
+
+    if (count == 0) {
+        entry->first_us = rx_timestamp_us;
+        entry->min_dt_us = 0xFFFFFFFFU;
+        entry->max_dt_us = 0;
+        entry->jitter_us = 0;
+    } else {
+        uint32_t dt = rx_timestamp_us - entry->last_us;
+        // 包含本帧在内共count个间隔
+        uint32_t avg = (rx_timestamp_us - entry->first_us) / count;
+        uint32_t dev = (dt > avg) ? (dt - avg) : (avg - dt);
+
+        if (dt < entry->min_dt_us) {
+            entry->min_dt_us = dt;
+        }
+        if (dt > entry->max_dt_us) {
+            entry->max_dt_us = dt;
+        }
+
+        if (dev > 0xFFFFU) {
+            dev = 0xFFFFU;
+        }
+        entry->jitter_us = (uint16_t)(((uint32_t)entry->jitter_us * ((1U << CAN_IDSTATS_JITTER_SHIFT) - 1U) +
+                                       dev + (1U << (CAN_IDSTATS_JITTER_SHIFT - 1U))) >> CAN_IDSTATS_JITTER_SHIFT);
+    }
+
+    entry->last_us = rx_timestamp_us;
+    entry->dlc = (uint8_t)rx_header->DLC;
+    entry->flags = (rx_header->RTR == CAN_RTR_REMOTE) ? CAN_IDSTATS_FLAG_RTR : 0U;
+    memcpy(entry->data, rx_data, 8);
+
+    // 最后更新计数，作为读取方的版本号
+    __COMPILER_BARRIER();
+    entry->count = count + 1U;
+}
+
+/* ========================= 私有函数实现 ========================= */
+
+/**
+ * @brief 扩展ID哈希(乘法散列)
+ */
+static inline uint32_t CAN_IdStats_Hash(uint32_t id)
+{
+    return (id * 2654435761U) >> CAN_IDSTATS_EXT_HASH_SHIFT;
+}
+
+/**
+ * @brief 在哈希表中查找统计项
+ * @param table: CAN1扩展帧表或CAN2表(容量均为CAN_IDSTATS_EXT_SIZE)
+ * @param key: 查找键(不含CAN_IDSTATS_EXT_VALID)
+ * @param insert: 未找到时是否占用空闲项
+ * @return CAN_IdStats_Entry_t*: 统计项，未找到或探测次数耗尽返回NULL
+ */
+static CAN_IdStats_Entry_t *CAN_IdStats_Lookup(CAN_IdStats_ExtEntry_t *table, uint32_t key, bool insert)
+{
+    uint32_t index = CAN_IdStats_Hash(key);
+
+    key |= CAN_IDSTATS_EXT_VALID;
+
+    for (uint32_t probe = 0; probe < CAN_IDSTATS_EXT_MAX_PROBE; probe++) {
+        CAN_IdStats_ExtEntry_t *slot = &table[(index + probe) & (CAN_IDSTATS_EXT_SIZE - 1U)];
+
+        if (slot->key == key) {
+            return &slot->entry;
+        }
+
+        if (slot->key == 0) {
+            if (!insert) {
+                return NULL;
+            }
+            slot->key = key;
+            return &slot->entry;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief 哈希表溢出总数
+ */
+static uint32_t CAN_IdStats_Overflow(void)
+{
+    return g_overflow_count[0] + g_overflow_count[1];
+}
+
+/**
+ * @brief 读取统计项快照(检测中断打断并重试)
+ * @return bool: true-该项有记录
+ */
+static bool CAN_IdStats_ReadEntry(const CAN_IdStats_Entry_t *entry, uint8_t ch, uint32_t id, bool is_extended, CAN_IdStats_Snapshot_t *snapshot)
+{
+    CAN_IdStats_Entry_t copy;
+    uint32_t count;
+
+    do {
+        count = entry->count;
+        __COMPILER_BARRIER();
+        copy = *entry;
+        __COMPILER_BARRIER();
+    } while (count != entry->count);
+
+    if (count == 0) {
+        return false;
+    }
+
+    snapshot->channel = ch;
+    snapshot->id = id;
+    snapshot->is_extended = is_extended;
+    snapshot->is_remote = (copy.flags & CAN_IDSTATS_FLAG_RTR) != 0;
+    snapshot->dlc = copy.dlc;
+    memcpy(snapshot->data, copy.data, sizeof(snapshot->data));
+    snapshot->count = count;
+    snapshot->last_timestamp_us = copy.last_us;
+    snapshot->jitter_us = copy.jitter_us;
+
+    if (count > 1) {
+        snapshot->min_interval_us = copy.min_dt_us;
+        snapshot->max_interval_us = copy.max_dt_us;
+        snapshot->avg_interval_us = (copy.last_us - copy.first_us) / (count - 1U);
+    } else {
+        snapshot->min_interval_us = 0;
+        snapshot->max_interval_us = 0;
+        snapshot->avg_interval_us = 0;
+    }
+
+    return true;
+}
+
+/**
+ * @brief 统计有记录的ID数量
+ */
+static void CAN_IdStats_CountVisitor(const CAN_IdStats_Snapshot_t *snapshot, void *context)
+{
+    (void)snapshot;
+    (*(uint32_t *)context)++;
+}
+
+/**
+ * @brief 导出单条记录(小端，31字节)
+ * @note  记录: ID(u32, bit31扩展帧, bit30远程帧, bit29 CAN2) 计数(u32) 最小/平均/最大间隔(u32)
+ *        抖动(u16) DLC(u8) 数据[8]
+ */
+static void CAN_IdStats_DumpVisitor(const CAN_IdStats_Snapshot_t *snapshot, void *context)
+{
+    CAN_IdStats_DumpCursor_t *cursor = (CAN_IdStats_DumpCursor_t *)context;
+    uint8_t record[CAN_IDSTATS_DUMP_RECORD_SIZE];
+    uint32_t id = snapshot->id;
+    uint16_t jitter = (snapshot->jitter_us > 0xFFFFU) ? 0xFFFFU : (uint16_t)snapshot->jitter_us;
+
+    // 跳过起始序号之前的记录，且输出条数不超过应答头声明的条数
+    if (cursor->index++ < cursor->start || cursor->remaining == 0) {
+        return;
+    }
+    cursor->remaining--;
+
+    if (snapshot->is_extended) {
+        id |= CAN_IDSTATS_DUMP_ID_EXT;
+    }
+    if (snapshot->is_remote) {
+        id |= CAN_IDSTATS_DUMP_ID_RTR;
+    }
+    if (snapshot->channel == CAN_TESTBOX_CH_CAN2) {
+        id |= CAN_IDSTATS_DUMP_ID_CAN2;
+    }
+
+    memcpy(&record[0], &id, 4);
+    memcpy(&record[4], &snapshot->count, 4);
+    memcpy(&record[8], &snapshot->min_interval_us, 4);
+    memcpy(&record[12], &snapshot->avg_interval_us, 4);
+    memcpy(&record[16], &snapshot->max_interval_us, 4);
+    memcpy(&record[20], &jitter, 2);
+    record[22] = snapshot->dlc;
+    memcpy(&record[23], snapshot->data, 8);
+
+    CAN_Cmd_ResponseWrite(record, sizeof(record));
+}
+
+/**
+ * @brief 串口命令: 导出统计表
+ * @note  请求负载(可选): 起始序号(u16) + 选项(u8, bit0导出后清空)
+ *        应答: 总记录数(u16) + 起始序号(u16) + 本帧记录数(u16) + 哈希表溢出数(u32) + 记录[n]
+ *        单帧最多CAN_IDSTATS_DUMP_MAX_RECORDS条，上位机按起始序号分页读取
+ */
+static void CAN_IdStats_HandleDump(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    uint16_t start = 0;
+    uint8_t options = 0;
+    uint32_t total = 0;
+
+    if (len >= 2) {
+        start = (uint16_t)(payload[0] | ((uint16_t)payload[1] << 8));
+    }
+    if (len >= 3) {
+        options = payload[2];
+    }
+
+    // 导出期间只会新增记录，先计数再按计数导出
+    CAN_IdStats_ForEach(CAN_IdStats_CountVisitor, &total);
+
+    uint32_t count = (total > start) ? (total - start) : 0;
+    if (count > CAN_IDSTATS_DUMP_MAX_RECORDS) {
+        count = CAN_IDSTATS_DUMP_MAX_RECORDS;
+    }
+
+    uint8_t header[CAN_IDSTATS_DUMP_HEADER_SIZE];
+    uint16_t total16 = (uint16_t)total;
+    uint16_t count16 = (uint16_t)count;
+    uint32_t overflow = CAN_IdStats_Overflow();
+
+    memcpy(&header[0], &total16, 2);
+    memcpy(&header[2], &start, 2);
+    memcpy(&header[4], &count16, 2);
+    memcpy(&header[6], &overflow, 4);
+
+    CAN_IdStats_DumpCursor_t cursor = {
+        .index = 0,
+        .start = start,
+        .remaining = count
+    };
+
+    CAN_Cmd_ResponseBegin(cmd, (uint16_t)(CAN_IDSTATS_DUMP_HEADER_SIZE + count * CAN_IDSTATS_DUMP_RECORD_SIZE));
+    CAN_Cmd_ResponseWrite(header, sizeof(header));
+    if (count > 0) {
+        CAN_IdStats_ForEach(CAN_IdStats_DumpVisitor, &cursor);
+    }
+    CAN_Cmd_ResponseEnd();
+
+    if (options & CAN_IDSTATS_DUMP_OPT_RESET) {
+        CAN_IdStats_Reset();
+    }
+}
+
+/**
+ * @brief 串口命令: 清空统计表
+ */
+static void CAN_IdStats_HandleReset(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    (void)payload;
+    (void)len;
+
+    CAN_IdStats_Reset();
+    CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_OK);
+}
@@ -0,0 +1,303 @@
+/**
+ * @file can_testbox_latency.c
+ * @brief CAN测试盒接收链路时延直方图实现
+ * @version 1.0
+ * @date 2024
+ */
+
+#include "can_testbox_latency.h"
+#include "can_testbox_timestamp.h"
+#include "can_testbox_cmd.h"
+#include <string.h>
+
+/* ========================= 私有宏定义 ========================= */
+
+#define CAN_LATENCY_OPT_CLEAR       0x01U   // 读取后清空
+#define CAN_LATENCY_OPT_BUCKETS     0x02U   // 附带各桶计数
+
+/* ========================= 私有变量定义 ========================= */
+
+// 各片内CAN通道当前接收中断的入口周期数，0表示不在中断中
+static volatile uint32_t g_irq_entry[CAN_TESTBOX_CH_EXT];
+
+// 各阶段直方图
+static CAN_Latency_Hist_t g_hist[CAN_LATENCY_STAGE_COUNT];
+
+/* ========================= 私有函数声明 ========================= */
+
+static uint32_t CAN_Latency_BucketIndex(uint32_t cycles);
+static uint32_t CAN_Latency_BucketUpper(uint32_t index);
+static uint32_t CAN_Latency_Percentile(const CAN_Latency_Hist_t *hist, uint32_t percent);
+static uint32_t CAN_Latency_CyclesToNs(uint32_t cycles);
+static void CAN_Latency_Summarize(const CAN_Latency_Hist_t *hist, CAN_Latency_Summary_t *summary);
+static void CAN_Latency_HandleGet(uint8_t cmd, const uint8_t *payload, uint8_t len);
+
+/* ========================= 公共API实现 ========================= */
+
+/**
+ * @brief 初始化时延统计
+ */
+CAN_TestBox_Status_t CAN_Latency_Init(void)
+{
+    CAN_Timestamp_CycleCounterInit();
+    CAN_Latency_Reset();
+
+    if (CAN_Cmd_Register(CAN_CMD_ID_LATENCY_GET, CAN_Latency_HandleGet) != CAN_TESTBOX_OK) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 接收中断入口
+ */
+void CAN_Latency_IrqEntry(CAN_TestBox_ChannelId_t ch)
+{
+    uint32_t cycles = CAN_Timestamp_GetCycles();
+
+    if (ch < CAN_TESTBOX_CH_EXT) {
+        // 0保留为无效值
+        g_irq_entry[ch] = (cycles != 0U) ? cycles : 1U;
+    }
+}
+
+/**
+ * @brief 接收中断出口
+ */
+void CAN_Latency_IrqExit(CAN_TestBox_ChannelId_t ch)
+{
+    if (ch < CAN_TESTBOX_CH_EXT) {
+        g_irq_entry[ch] = 0;
+    }
+}
+
+/**
+ * @brief 获取当前接收中断的入口周期数
+ */
+uint32_t CAN_Latency_GetEntry(CAN_TestBox_ChannelId_t ch)
+{
+    return (ch < CAN_TESTBOX_CH_EXT) ? g_irq_entry[ch] : 0U;
+}
+
+/**
+ * @brief 按入口周期数记录一个样本
+ */
+void CAN_Latency_Record(CAN_Latency_Stage_t stage, uint32_t entry_cycles)
+{
+    if (entry_cycles == 0U || stage >= CAN_LATENCY_STAGE_COUNT) {
+        return;
+    }
+
+    uint32_t cycles = CAN_Timestamp_GetCycles() - entry_cycles;
+    uint32_t index = CAN_Latency_BucketIndex(cycles);
+    CAN_Latency_Hist_t *hist = &g_hist[stage];
+
+    // 消费阶段可能由多个任务记录，更新期间关中断
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    hist->count++;
+    hist->buckets[index]++;
+    if (cycles > hist->max_cycles) {
+        hist->max_cycles = cycles;
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 在接收中断中记录当前阶段
+ */
+void CAN_Latency_Mark(CAN_TestBox_ChannelId_t ch, CAN_Latency_Stage_t stage)
+{
+    CAN_Latency_Record(stage, CAN_Latency_GetEntry(ch));
+}
+
+/**
+ * @brief 获取阶段直方图
+ */
+CAN_TestBox_Status_t CAN_Latency_GetHistogram(CAN_Latency_Stage_t stage, CAN_Latency_Hist_t *hist)
+{
+    if (hist == NULL || stage >= CAN_LATENCY_STAGE_COUNT) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *hist = g_hist[stage];
+    __set_PRIMASK(primask);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 获取全部阶段直方图，可在同一临界区内清空
+ */
+CAN_TestBox_Status_t CAN_Latency_Snapshot(CAN_Latency_Hist_t *hist, bool clear)
+{
+    if (hist == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memcpy(hist, g_hist, sizeof(g_hist));
+    if (clear) {
+        memset(g_hist, 0, sizeof(g_hist));
+    }
+    __set_PRIMASK(primask);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 获取阶段摘要
+ */
+CAN_TestBox_Status_t CAN_Latency_GetSummary(CAN_Latency_Stage_t stage, CAN_Latency_Summary_t *summary)
+{
+    CAN_Latency_Hist_t hist;
+
+    if (summary == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    CAN_TestBox_Status_t status = CAN_Latency_GetHistogram(stage, &hist);
+    if (status != CAN_TESTBOX_OK) {
+        return status;
+    }
+
+    CAN_Latency_Summarize(&hist, summary);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 清空全部阶段直方图
+ */
+void CAN_Latency_Reset(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset(g_hist, 0, sizeof(g_hist));
+    __set_PRIMASK(primask);
+}
+
+/* ========================= 私有函数实现 ========================= */
+
+/**
+ * @brief 计算样本所在桶
+ * @note  0、1各占一桶；其余按最高位msb与次高位分桶: 2*msb + 次高位
+ */
+static uint32_t CAN_Latency_BucketIndex(uint32_t cycles)
+{
+    if (cycles < 2U) {
+        return cycles;
+    }
+
+    uint32_t msb = 31U - __CLZ(cycles);
+    return (msb * 2U) + ((cycles >> (msb - 1U)) & 1U);
+}
+
+/**
+ * @brief 计算桶上界(含)
+ */
+static uint32_t CAN_Latency_BucketUpper(uint32_t index)
+{
+    if (index < 2U) {
+        return index;
+    }
+
+    uint32_t msb = index / 2U;
+    uint32_t lower = (2U | (index & 1U)) << (msb - 1U);
+    return lower + ((1UL << (msb - 1U)) - 1U);
+}
+
+/**
+ * @brief 计算百分位(CPU周期)
+ * @return uint32_t: 百分位所在桶上界，不超过最大值
+ */
+static uint32_t CAN_Latency_Percentile(const CAN_Latency_Hist_t *hist, uint32_t percent)
+{
+    if (hist->count == 0U) {
+        return 0;
+    }
+
+    uint32_t target = (uint32_t)(((uint64_t)hist->count * percent + 99U) / 100U);
+    uint32_t cumulative = 0;
+
+    for (uint32_t i = 0; i < CAN_LATENCY_BUCKETS; i++) {
+        cumulative += hist->buckets[i];
+        if (cumulative >= target) {
+            uint32_t upper = CAN_Latency_BucketUpper(i);
+            return (upper < hist->max_cycles) ? upper : hist->max_cycles;
+        }
+    }
+
+    return hist->max_cycles;
+}
+
+/**
+ * @brief CPU周期换算为ns(超过u32范围时饱和)
+ */
+static uint32_t CAN_Latency_CyclesToNs(uint32_t cycles)
+{
+    uint64_t ns = ((uint64_t)cycles * 1000U) / (SystemCoreClock / 1000000U);
+    return (ns > 0xFFFFFFFFULL) ? 0xFFFFFFFFU : (uint32_t)ns;
+}
+
+/**
+ * @brief 由直方图计算摘要
+ */
+static void CAN_Latency_Summarize(const CAN_Latency_Hist_t *hist, CAN_Latency_Summary_t *summary)
+{
+    summary->count = hist->count;
+    summary->p50_ns = CAN_Latency_CyclesToNs(CAN_Latency_Percentile(hist, 50U));
+    summary->p99_ns = CAN_Latency_CyclesToNs(CAN_Latency_Percentile(hist, 99U));
+    summary->max_ns = CAN_Latency_CyclesToNs(hist->max_cycles);
+}
+
+/**
+ * @brief 命令0x18: 读取接收链路时延
+ * @note  请求: 空或选项(u8, bit0-读取后清空 bit1-附带各桶计数)
+ *        应答: 内核频率MHz(u16) + 每阶段样本数/p50/p99/max(u32, ns)
+ *              [+ 每阶段CAN_LATENCY_BUCKETS个桶计数(u32)]
+ *        摘要与桶计数取自同一快照，清空与快照在同一临界区内完成
+ */
+static void CAN_Latency_HandleGet(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    CAN_Latency_Hist_t hist[CAN_LATENCY_STAGE_COUNT];   // 约800字节，占用任务栈
+    CAN_Latency_Summary_t summary;
+    uint8_t option = 0;
+
+    if (len > 1U) {
+        CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+        return;
+    }
+    if (len == 1U) {
+        option = payload[0];
+    }
+
+    uint16_t core_mhz = (uint16_t)(SystemCoreClock / 1000000U);
+    uint16_t total = (uint16_t)(sizeof(core_mhz) + CAN_LATENCY_STAGE_COUNT * sizeof(summary));
+    if (option & CAN_LATENCY_OPT_BUCKETS) {
+        total += (uint16_t)(CAN_LATENCY_STAGE_COUNT * sizeof(hist[0].buckets));
+    }
+
+    CAN_Latency_Snapshot(hist, (option & CAN_LATENCY_OPT_CLEAR) != 0U);
+
+    CAN_Cmd_ResponseBegin(cmd, total);
+    CAN_Cmd_ResponseWrite(&core_mhz, sizeof(core_mhz));
+
+    for (uint32_t stage = 0; stage < CAN_LATENCY_STAGE_COUNT; stage++) {
+        // 结构体全部为u32字段，无填充，直接按小端输出
+        CAN_Latency_Summarize(&hist[stage], &summary);
+        CAN_Cmd_ResponseWrite(&summary, sizeof(summary));
+    }
+
+    if (option & CAN_LATENCY_OPT_BUCKETS) {
+        for (uint32_t stage = 0; stage < CAN_LATENCY_STAGE_COUNT; stage++) {
+            CAN_Cmd_ResponseWrite(hist[stage].buckets, sizeof(hist[stage].buckets));
+        }
+    }
+
+    CAN_Cmd_ResponseEnd();
+}
@@ -0,0 +1,801 @@
+/**
+ * @file can_testbox_mcp2515.c
+ * @brief MCP2515外部CAN控制器驱动实现(中断 + SPI DMA)
+ * @version 1.0
+ * @date 2024
+ *
+ * @note 运行时状态机说明：
+ * SPI总线同一时刻只进行一个DMA事务，每个事务完成后在DMA中断中选择下一个事务：
+ * 1. 读取接收缓冲区(READ RX BUFFER，读完CS拉高后硬件自动清除RXnIF)
+ * 2. 清除已处理的中断标志(BIT MODIFY CANINTF/EFLG)
+ * 3. 发送队列非空且有空闲发送缓冲区时装载报文(LOAD TX BUFFER + RTS)
+ * 4. INT引脚仍为低电平时读取CANINTF/EFLG(READ 0x2C，2字节)
+ * 全部空闲时状态机停止，等待INT下降沿或新的发送请求重新启动
+ */
+
+#include "can_testbox_mcp2515.h"
+#include "can_testbox_mem.h"
+#include "can_testbox_frame.h"
+#include "cmsis_os.h"
+#include <string.h>
+
+/* ========================= MCP2515寄存器与指令 ========================= */
+
+// SPI指令
+#define MCP2515_CMD_RESET           0xC0
+#define MCP2515_CMD_READ            0x03
+#define MCP2515_CMD_WRITE           0x02
+#define MCP2515_CMD_BIT_MODIFY      0x05
+#define MCP2515_CMD_READ_RX0        0x90    // READ RX BUFFER, 从RXB0SIDH开始
+#define MCP2515_CMD_READ_RX1        0x94    // READ RX BUFFER, 从RXB1SIDH开始
+#define MCP2515_CMD_LOAD_TX(n)      (0x40 + ((n) * 2U))  // LOAD TX BUFFER, 从TXBnSIDH开始
+#define MCP2515_CMD_RTS(n)          (0x80 | (1U << (n))) // REQUEST TO SEND
+
+// 寄存器地址
+#define MCP2515_REG_CANSTAT         0x0E
+#define MCP2515_REG_CANCTRL         0x0F
+#define MCP2515_REG_CNF3            0x28
+#define MCP2515_REG_CANINTE         0x2B
+#define MCP2515_REG_CANINTF         0x2C
+#define MCP2515_REG_EFLG            0x2D
+#define MCP2515_REG_RXB0CTRL        0x60
+#define MCP2515_REG_RXB1CTRL        0x70
+
+// CANINTF/CANINTE位
+#define MCP2515_INT_RX0             0x01
+#define MCP2515_INT_RX1             0x02
+#define MCP2515_INT_TX0             0x04
+#define MCP2515_INT_TX1             0x08
+#define MCP2515_INT_TX2             0x10
+#define MCP2515_INT_ERR             0x20
+#define MCP2515_INT_WAK             0x40
+#define MCP2515_INT_MERR            0x80
+
+// EFLG位
+#define MCP2515_EFLG_RX0OVR         0x40
+#define MCP2515_EFLG_RX1OVR         0x80
+#define MCP2515_EFLG_TXBO           0x20
+
+// 模式
+#define MCP2515_MODE_MASK           0xE0
+#define MCP2515_MODE_NORMAL         0x00
+#define MCP2515_MODE_CONFIG         0x80
+
+// RXBnCTRL: 接收所有报文，RXB0满时滚动到RXB1
+#define MCP2515_RXB0CTRL_VALUE      0x64
+#define MCP2515_RXB1CTRL_VALUE      0x60
+
+// 帧缓冲区格式(SIDH, SIDL, EID8, EID0, DLC, D0~D7)
+#define MCP2515_FRAME_LEN           13
+#define MCP2515_SIDL_EXIDE          0x08
+#define MCP2515_SIDL_SRR            0x10
+#define MCP2515_DLC_RTR             0x40
+
+#define MCP2515_TX_BUFFER_COUNT     3
+#define MCP2515_TX_ALL_BUSY         0x07
+
+/* ========================= 私有类型定义 ========================= */
+
+/**
+ * @brief SPI事务状态
+ */
+typedef enum {
+    MCP2515_STATE_IDLE = 0,
+    MCP2515_STATE_READ_FLAGS,       // 读取CANINTF/EFLG
+    MCP2515_STATE_READ_RX0,         // 读取RXB0
+    MCP2515_STATE_READ_RX1,         // 读取RXB1
+    MCP2515_STATE_LOAD_TX,          // 装载发送缓冲区
+    MCP2515_STATE_RTS,              // 请求发送
+    MCP2515_STATE_CLEAR_INTF,       // 清除CANINTF标志
+    MCP2515_STATE_CLEAR_EFLG        // 清除EFLG溢出标志
+} CAN_MCP2515_State_t;
+
+/* ========================= 私有变量定义 ========================= */
+
+// DMA句柄
+DMA_HandleTypeDef hdma_spi1_rx;
+DMA_HandleTypeDef hdma_spi1_tx;
+
+extern SPI_HandleTypeDef hspi1;
+
+// 驱动状态
+static volatile bool g_mcp_ready = false;
+static volatile CAN_MCP2515_State_t g_mcp_state = MCP2515_STATE_IDLE;
+
+// DMA缓冲区(指令字节 + 最多13字节数据)
+static uint8_t g_spi_tx_buf[MCP2515_FRAME_LEN + 1];
+static uint8_t g_spi_rx_buf[MCP2515_FRAME_LEN + 1];
+
+// 待处理事件
+static uint8_t g_pending_rx = 0;            // 待读取的接收缓冲区(bit0: RXB0, bit1: RXB1)
+static uint8_t g_pending_clear_intf = 0;    // 待清除的CANINTF位
+static uint8_t g_pending_clear_eflg = 0;    // 待清除的EFLG位
+static uint8_t g_tx_busy = 0;               // 已装载未完成的发送缓冲区
+static uint8_t g_loading_buffer = 0;        // 正在装载的发送缓冲区
+
+// 发送队列(任务/中断写入，DMA中断读取，均在关中断下访问)
+static CAN_TestBox_Frame_t g_tx_ring[CAN_MCP2515_TX_QUEUE_SIZE];
+static uint16_t g_tx_head = 0;
+static uint16_t g_tx_tail = 0;
+static uint16_t g_tx_count = 0;
+
+// 接收队列与回调
+CAN_TESTBOX_STATIC_QUEUE(g_mcp_rx_queue_mem, CAN_MCP2515_RX_QUEUE_SIZE, sizeof(CAN_TestBox_Frame_t));
+static const osMessageQueueAttr_t g_mcp_rx_queue_attr = {
+    .name = "MCP2515RxQueue", CAN_TESTBOX_STATIC_QUEUE_MEM(g_mcp_rx_queue_mem)
+};
+static osMessageQueueId_t g_mcp_rx_queue = NULL;
+static CAN_TestBox_RxCallback_t g_mcp_rx_callback = NULL;
+
+// 统计信息
+static CAN_MCP2515_Stats_t g_mcp_stats;
+
+// 测试盒通道
+static CAN_TestBox_Channel_t g_mcp_channel = NULL;
+
+/* ========================= 私有函数声明 ========================= */
+
+static HAL_StatusTypeDef CAN_MCP2515_LowLevelInit(void);
+static HAL_StatusTypeDef CAN_MCP2515_Transfer(const uint8_t *tx, uint8_t *rx, uint16_t len);
+static HAL_StatusTypeDef CAN_MCP2515_WriteRegister(uint8_t address, uint8_t value);
+static uint8_t CAN_MCP2515_ReadRegister(uint8_t address);
+static void CAN_MCP2515_Kick(void);
+static bool CAN_MCP2515_StartTransfer(CAN_MCP2515_State_t state, uint16_t len);
+static CAN_TestBox_Status_t CAN_MCP2515_SendFrame(const CAN_TestBox_Frame_t *frame);
+static void CAN_MCP2515_EncodeFrame(const CAN_TestBox_Frame_t *frame, uint8_t *buffer);
+static void CAN_MCP2515_DecodeFrame(const uint8_t *buffer, CAN_TestBox_Frame_t *frame);
+static void CAN_MCP2515_HandleFlags(uint8_t canintf, uint8_t eflg);
+static void CAN_MCP2515_DeliverRx(const uint8_t *frame);
+static uint32_t CAN_MCP2515_GetBusStatus(void);
+
+// 测试盒外部通道操作接口
+static const CAN_TestBox_ChannelOps_t g_mcp_channel_ops = {
+    .send = CAN_MCP2515_SendFrame,
+    .get_bus_status = CAN_MCP2515_GetBusStatus
+};
+
+static inline void CAN_MCP2515_Select(void)
+{
+    CAN_MCP2515_CS_PORT->BSRR = (uint32_t)CAN_MCP2515_CS_PIN << 16U;
+}
+
+static inline void CAN_MCP2515_Deselect(void)
+{
+    CAN_MCP2515_CS_PORT->BSRR = CAN_MCP2515_CS_PIN;
+}
+
+/* ========================= 公共API实现 ========================= */
+
+/**
+ * @brief 初始化MCP2515通道
+ */
+CAN_TestBox_Status_t CAN_MCP2515_Init(void)
+{
+    if (g_mcp_ready) {
+        return CAN_TESTBOX_OK;
+    }
+
+    if (CAN_MCP2515_LowLevelInit() != HAL_OK) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    // 复位后芯片进入配置模式
+    uint8_t cmd = MCP2515_CMD_RESET;
+    uint8_t dummy;
+    CAN_MCP2515_Transfer(&cmd, &dummy, 1);
+    HAL_Delay(2);
+
+    if ((CAN_MCP2515_ReadRegister(MCP2515_REG_CANSTAT) & MCP2515_MODE_MASK) != MCP2515_MODE_CONFIG) {
+        return CAN_TESTBOX_ERROR;  // 芯片无响应
+    }
+
+    // 位时序(CNF3/CNF2/CNF1地址连续，一次写入)
+    uint8_t cnf[5] = {
+        MCP2515_CMD_WRITE, MCP2515_REG_CNF3,
+        CAN_MCP2515_CNF3_500K, CAN_MCP2515_CNF2_500K, CAN_MCP2515_CNF1_500K
+    };
+    uint8_t cnf_rx[5];
+    CAN_MCP2515_Transfer(cnf, cnf_rx, sizeof(cnf));
+
+    // 接收缓冲区: 接收所有报文，RXB0满时滚动到RXB1
+    CAN_MCP2515_WriteRegister(MCP2515_REG_RXB0CTRL, MCP2515_RXB0CTRL_VALUE);
+    CAN_MCP2515_WriteRegister(MCP2515_REG_RXB1CTRL, MCP2515_RXB1CTRL_VALUE);
+
+    // 使能接收/发送完成/错误中断
+    CAN_MCP2515_WriteRegister(MCP2515_REG_CANINTF, 0x00);
+    CAN_MCP2515_WriteRegister(MCP2515_REG_CANINTE,
+                              MCP2515_INT_RX0 | MCP2515_INT_RX1 |
+                              MCP2515_INT_TX0 | MCP2515_INT_TX1 | MCP2515_INT_TX2 |
+                              MCP2515_INT_ERR | MCP2515_INT_MERR);
+
+    // 切换到正常模式
+    CAN_MCP2515_WriteRegister(MCP2515_REG_CANCTRL, MCP2515_MODE_NORMAL);
+    if ((CAN_MCP2515_ReadRegister(MCP2515_REG_CANSTAT) & MCP2515_MODE_MASK) != MCP2515_MODE_NORMAL) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    // 创建接收队列
+    if (g_mcp_rx_queue == NULL) {
+        g_mcp_rx_queue = osMessageQueueNew(CAN_MCP2515_RX_QUEUE_SIZE, sizeof(CAN_TestBox_Frame_t), &g_mcp_rx_queue_attr);
+        if (g_mcp_rx_queue == NULL) {
+            return CAN_TESTBOX_ERROR;
+        }
+    }
+
+    memset(&g_mcp_stats, 0, sizeof(g_mcp_stats));
+    g_pending_rx = 0;
+    g_pending_clear_intf = 0;
+    g_pending_clear_eflg = 0;
+    g_tx_busy = 0;
+    g_tx_head = 0;
+    g_tx_tail = 0;
+    g_tx_count = 0;
+    g_mcp_state = MCP2515_STATE_IDLE;
+    g_mcp_ready = true;
+
+    // 此后SPI访问全部由中断+DMA完成
+    __HAL_GPIO_EXTI_CLEAR_IT(CAN_MCP2515_INT_PIN);
+    HAL_NVIC_EnableIRQ(CAN_MCP2515_INT_IRQn);
+    CAN_MCP2515_Kick();
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief MCP2515通道是否已初始化
+ */
+bool CAN_MCP2515_IsReady(void)
+{
+    return g_mcp_ready;
+}
+
+/**
+ * @brief 发送报文
+ */
+CAN_TestBox_Status_t CAN_MCP2515_SendMessage(const CAN_TestBox_Message_t *message)
+{
+    if (!g_mcp_ready) {
+        return CAN_TESTBOX_NOT_INITIALIZED;
+    }
+
+    if (message == NULL || message->dlc > 8 ||
+        (message->is_extended ? (message->id > 0x1FFFFFFFU) : (message->id > 0x7FFU))) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    CAN_TestBox_Frame_t frame;
+    CAN_Frame_FromMessage(&frame, message);
+
+    return CAN_MCP2515_SendFrame(&frame);
+}
+
+/**
+ * @brief 紧凑帧入发送队列(测试盒通道发送接口，帧已由上层校验)
+ */
+static CAN_TestBox_Status_t CAN_MCP2515_SendFrame(const CAN_TestBox_Frame_t *frame)
+{
+    if (!g_mcp_ready) {
+        return CAN_TESTBOX_NOT_INITIALIZED;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (g_tx_count >= CAN_MCP2515_TX_QUEUE_SIZE) {
+        g_mcp_stats.tx_queue_full_count++;
+        __set_PRIMASK(primask);
+        return CAN_TESTBOX_QUEUE_FULL;
+    }
+
+    g_tx_ring[g_tx_tail] = *frame;
+    g_tx_tail = (g_tx_tail + 1U) % CAN_MCP2515_TX_QUEUE_SIZE;
+    g_tx_count++;
+
+    __set_PRIMASK(primask);
+
+    CAN_MCP2515_Kick();
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 从接收队列读取报文
+ */
+CAN_TestBox_Status_t CAN_MCP2515_ReceiveMessage(CAN_TestBox_Message_t *message, uint32_t timeout_ms)
+{
+    if (!g_mcp_ready) {
+        return CAN_TESTBOX_NOT_INITIALIZED;
+    }
+
+    if (message == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    CAN_TestBox_Frame_t frame;
+    osStatus_t status = osMessageQueueGet(g_mcp_rx_queue, &frame, NULL, timeout_ms);
+    if (status == osOK) {
+        CAN_Frame_ToMessage(message, &frame, HAL_GetTick());
+        return CAN_TESTBOX_OK;
+    } else if (status == osErrorTimeout) {
+        return CAN_TESTBOX_TIMEOUT;
+    }
+
+    return CAN_TESTBOX_QUEUE_EMPTY;
+}
+
+/**
+ * @brief 设置接收回调函数
+ */
+CAN_TestBox_Status_t CAN_MCP2515_SetRxCallback(CAN_TestBox_RxCallback_t callback)
+{
+    g_mcp_rx_callback = callback;
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 获取通道统计
+ */
+CAN_TestBox_Status_t CAN_MCP2515_GetStatistics(CAN_MCP2515_Stats_t *stats)
+{
+    if (stats == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *stats = g_mcp_stats;
+    __set_PRIMASK(primask);
+
+    stats->common.uptime_ms = HAL_GetTick();
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 重置通道统计
+ */
+CAN_TestBox_Status_t CAN_MCP2515_ResetStatistics(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset(&g_mcp_stats, 0, sizeof(g_mcp_stats));
+    __set_PRIMASK(primask);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 将MCP2515注册为测试盒外部通道
+ */
+CAN_TestBox_Status_t CAN_MCP2515_AttachChannel(CAN_TestBox_Channel_t *channel)
+{
+    if (!g_mcp_ready) {
+        return CAN_TESTBOX_NOT_INITIALIZED;
+    }
+
+    if (g_mcp_channel == NULL) {
+        CAN_TestBox_Status_t status = CAN_TestBox_ChannelOpenExternal(CAN_TESTBOX_CH_EXT, &g_mcp_channel_ops, &g_mcp_channel);
+        if (status != CAN_TESTBOX_OK) {
+            return status;
+        }
+        // 此后接收报文由DeliverRx直接送入通道
+    }
+
+    if (channel != NULL) {
+        *channel = g_mcp_channel;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/* ========================= 私有函数实现 ========================= */
+
+/**
+ * @brief 片选/INT引脚、SPI时钟与DMA配置
+ */
+static HAL_StatusTypeDef CAN_MCP2515_LowLevelInit(void)
+{
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+    __HAL_RCC_DMA2_CLK_ENABLE();
+
+    // CS: 推挽输出，默认高电平
+    CAN_MCP2515_Deselect();
+    GPIO_InitStruct.Pin = CAN_MCP2515_CS_PIN;
+    GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+    HAL_GPIO_Init(CAN_MCP2515_CS_PORT, &GPIO_InitStruct);
+
+    // INT: 低电平有效，下降沿触发
+    GPIO_InitStruct.Pin = CAN_MCP2515_INT_PIN;
+    GPIO_InitStruct.Mode = GPIO_MODE_IT_FALLING;
+    GPIO_InitStruct.Pull = GPIO_PULLUP;
+    HAL_GPIO_Init(CAN_MCP2515_INT_PORT, &GPIO_InitStruct);
+    HAL_NVIC_SetPriority(CAN_MCP2515_INT_IRQn, 5, 0);
+
+    // 提高SPI时钟(原配置分频32仅2.6MHz)
+    hspi1.Init.BaudRatePrescaler = CAN_MCP2515_SPI_PRESCALER;
+    if (HAL_SPI_Init(&hspi1) != HAL_OK) {
+        return HAL_ERROR;
+    }
+
+    // SPI1_RX: DMA2 Stream0 通道3
+    hdma_spi1_rx.Instance = DMA2_Stream0;
+    hdma_spi1_rx.Init.Channel = DMA_CHANNEL_3;
+    hdma_spi1_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma_spi1_rx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_spi1_rx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_spi1_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_spi1_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_spi1_rx.Init.Mode = DMA_NORMAL;
+    hdma_spi1_rx.Init.Priority = DMA_PRIORITY_HIGH;
+    hdma_spi1_rx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    if (HAL_DMA_Init(&hdma_spi1_rx) != HAL_OK) {
+        return HAL_ERROR;
+    }
+    __HAL_LINKDMA(&hspi1, hdmarx, hdma_spi1_rx);
+
+    // SPI1_TX: DMA2 Stream3 通道3
+    hdma_spi1_tx.Instance = DMA2_Stream3;
+    hdma_spi1_tx.Init.Channel = DMA_CHANNEL_3;
+    hdma_spi1_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_spi1_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_spi1_tx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_spi1_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_spi1_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_spi1_tx.Init.Mode = DMA_NORMAL;
+    hdma_spi1_tx.Init.Priority = DMA_PRIORITY_MEDIUM;
+    hdma_spi1_tx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    if (HAL_DMA_Init(&hdma_spi1_tx) != HAL_OK) {
+        return HAL_ERROR;
+    }
+    __HAL_LINKDMA(&hspi1, hdmatx, hdma_spi1_tx);
+
+    // DMA中断优先级与CAN中断一致(可调用FreeRTOS FromISR接口)
+    HAL_NVIC_SetPriority(DMA2_Stream0_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(DMA2_Stream0_IRQn);
+    HAL_NVIC_SetPriority(DMA2_Stream3_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(DMA2_Stream3_IRQn);
+
+    return HAL_OK;
+}
+
+/**
+ * @brief 阻塞SPI事务(仅初始化阶段使用)
+ */
+static HAL_StatusTypeDef CAN_MCP2515_Transfer(const uint8_t *tx, uint8_t *rx, uint16_t len)
+{
+    HAL_StatusTypeDef status;
+
+    CAN_MCP2515_Select();
+    status = HAL_SPI_TransmitReceive(&hspi1, (uint8_t *)tx, rx, len, 10);
+    CAN_MCP2515_Deselect();
+
+    return status;
+}
+
+/**
+ * @brief 写寄存器(仅初始化阶段使用)
+ */
+static HAL_StatusTypeDef CAN_MCP2515_WriteRegister(uint8_t address, uint8_t value)
+{
+    uint8_t tx[3] = {MCP2515_CMD_WRITE, address, value};
+    uint8_t rx[3];
+
+    return CAN_MCP2515_Transfer(tx, rx, sizeof(tx));
+}
+
+/**
+ * @brief 读寄存器(仅初始化阶段使用)
+ */
+static uint8_t CAN_MCP2515_ReadRegister(uint8_t address)
+{
+    uint8_t tx[3] = {MCP2515_CMD_READ, address, 0xFF};
+    uint8_t rx[3] = {0xFF, 0xFF, 0xFF};
+
+    CAN_MCP2515_Transfer(tx, rx, sizeof(tx));
+
+    return rx[2];
+}
+
+/**
+ * @brief 总线空闲时启动下一个SPI事务
+ * @note  可在任务、EXTI中断和DMA中断中调用
+ */
+static void CAN_MCP2515_Kick(void)
+{
+    if (!g_mcp_ready) {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (g_mcp_state != MCP2515_STATE_IDLE) {
+        __set_PRIMASK(primask);
+        return;
+    }
+
+    if (g_pending_rx & MCP2515_INT_RX0) {
+        // 优先读取接收缓冲区，避免溢出
+        g_spi_tx_buf[0] = MCP2515_CMD_READ_RX0;
+        CAN_MCP2515_StartTransfer(MCP2515_STATE_READ_RX0, MCP2515_FRAME_LEN + 1);
+    } else if (g_pending_rx & MCP2515_INT_RX1) {
+        g_spi_tx_buf[0] = MCP2515_CMD_READ_RX1;
+        CAN_MCP2515_StartTransfer(MCP2515_STATE_READ_RX1, MCP2515_FRAME_LEN + 1);
+    } else if (g_pending_clear_intf != 0) {
+        g_spi_tx_buf[0] = MCP2515_CMD_BIT_MODIFY;
+        g_spi_tx_buf[1] = MCP2515_REG_CANINTF;
+        g_spi_tx_buf[2] = g_pending_clear_intf;
+        g_spi_tx_buf[3] = 0x00;
+        g_pending_clear_intf = 0;
+        CAN_MCP2515_StartTransfer(MCP2515_STATE_CLEAR_INTF, 4);
+    } else if (g_pending_clear_eflg != 0) {
+        g_spi_tx_buf[0] = MCP2515_CMD_BIT_MODIFY;
+        g_spi_tx_buf[1] = MCP2515_REG_EFLG;
+        g_spi_tx_buf[2] = g_pending_clear_eflg;
+        g_spi_tx_buf[3] = 0x00;
+        g_pending_clear_eflg = 0;
+        CAN_MCP2515_StartTransfer(MCP2515_STATE_CLEAR_EFLG, 4);
+    } else if (g_tx_count > 0 && g_tx_busy != MCP2515_TX_ALL_BUSY) {
+        // 选择空闲发送缓冲区
+        uint8_t n = 0;
+        while (g_tx_busy & (1U << n)) {
+            n++;
+        }
+
+        g_loading_buffer = n;
+        g_spi_tx_buf[0] = MCP2515_CMD_LOAD_TX(n);
+        CAN_MCP2515_EncodeFrame(&g_tx_ring[g_tx_head], &g_spi_tx_buf[1]);
+        g_tx_head = (g_tx_head + 1U) % CAN_MCP2515_TX_QUEUE_SIZE;
+        g_tx_count--;
+        CAN_MCP2515_StartTransfer(MCP2515_STATE_LOAD_TX, MCP2515_FRAME_LEN + 1);
+    } else if (HAL_GPIO_ReadPin(CAN_MCP2515_INT_PORT, CAN_MCP2515_INT_PIN) == GPIO_PIN_RESET) {
+        // INT为电平信号，仍为低说明还有未处理的中断标志
+        g_spi_tx_buf[0] = MCP2515_CMD_READ;
+        g_spi_tx_buf[1] = MCP2515_REG_CANINTF;
+        g_spi_tx_buf[2] = 0xFF;
+        g_spi_tx_buf[3] = 0xFF;
+        CAN_MCP2515_StartTransfer(MCP2515_STATE_READ_FLAGS, 4);
+    }
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 启动一次SPI DMA事务(调用者已关中断)
+ */
+static bool CAN_MCP2515_StartTransfer(CAN_MCP2515_State_t state, uint16_t len)
+{
+    g_mcp_state = state;
+    CAN_MCP2515_Select();
+
+    if (HAL_SPI_TransmitReceive_DMA(&hspi1, g_spi_tx_buf, g_spi_rx_buf, len) != HAL_OK) {
+        CAN_MCP2515_Deselect();
+        g_mcp_state = MCP2515_STATE_IDLE;
+        g_mcp_stats.spi_error_count++;
+        return false;
+    }
+
+    g_mcp_stats.spi_transfer_count++;
+    return true;
+}
+
+/**
+ * @brief 将紧凑帧编码为MCP2515帧缓冲区格式
+ */
+static void CAN_MCP2515_EncodeFrame(const CAN_TestBox_Frame_t *frame, uint8_t *buffer)
+{
+    uint32_t id = CAN_Frame_GetId(frame);
+
+    if (CAN_Frame_IsExtended(frame)) {
+        buffer[0] = (uint8_t)(id >> 21);
+        buffer[1] = (uint8_t)((((id >> 18) & 0x07U) << 5) | MCP2515_SIDL_EXIDE | ((id >> 16) & 0x03U));
+        buffer[2] = (uint8_t)(id >> 8);
+        buffer[3] = (uint8_t)id;
+    } else {
+        buffer[0] = (uint8_t)(id >> 3);
+        buffer[1] = (uint8_t)((id & 0x07U) << 5);
+        buffer[2] = 0;
+        buffer[3] = 0;
+    }
+
+    buffer[4] = CAN_Frame_GetDlc(frame) | (CAN_Frame_IsRemote(frame) ? MCP2515_DLC_RTR : 0U);
+    memcpy(&buffer[5], frame->data, 8);
+}
+
+/**
+ * @brief 将MCP2515帧缓冲区解码为紧凑帧
+ */
+static void CAN_MCP2515_DecodeFrame(const uint8_t *buffer, CAN_TestBox_Frame_t *frame)
+{
+    uint32_t sid = ((uint32_t)buffer[0] << 3) | (buffer[1] >> 5);
+    uint32_t id;
+    bool is_extended;
+    bool is_remote;
+
+    if (buffer[1] & MCP2515_SIDL_EXIDE) {
+        is_extended = true;
+        id = (sid << 18) | ((uint32_t)(buffer[1] & 0x03U) << 16) |
+             ((uint32_t)buffer[2] << 8) | buffer[3];
+        is_remote = (buffer[4] & MCP2515_DLC_RTR) != 0;
+    } else {
+        is_extended = false;
+        id = sid;
+        is_remote = (buffer[1] & MCP2515_SIDL_SRR) != 0;
+    }
+
+    uint8_t dlc = buffer[4] & 0x0FU;
+    if (dlc > 8) {
+        dlc = 8;
+    }
+
+    CAN_Frame_Pack(frame, id, is_extended, is_remote, dlc, &buffer[5],
+                   CAN_TESTBOX_CH_EXT, HAL_GetTick());
+}
+
+/**
+ * @brief 处理CANINTF/EFLG
+ */
+static void CAN_MCP2515_HandleFlags(uint8_t canintf, uint8_t eflg)
+{
+    // 接收缓冲区满，等待READ RX BUFFER读取(读取后自动清除)
+    g_pending_rx |= canintf & (MCP2515_INT_RX0 | MCP2515_INT_RX1);
+
+    // 发送完成，释放发送缓冲区
+    for (uint8_t n = 0; n < MCP2515_TX_BUFFER_COUNT; n++) {
+        uint8_t flag = (uint8_t)(MCP2515_INT_TX0 << n);
+        if (canintf & flag) {
+            g_tx_busy &= (uint8_t)~(1U << n);
+            g_mcp_stats.common.tx_success_count++;
+            g_pending_clear_intf |= flag;
+        }
+    }
+
+    if (canintf & MCP2515_INT_ERR) {
+        g_mcp_stats.common.bus_error_count++;
+        g_mcp_stats.common.last_error_code = eflg;
+        g_mcp_stats.last_eflg = eflg;
+
+        if (eflg & (MCP2515_EFLG_RX0OVR | MCP2515_EFLG_RX1OVR)) {
+            g_mcp_stats.rx_overflow_count++;
+            g_mcp_stats.common.rx_error_count++;
+            g_pending_clear_eflg |= eflg & (MCP2515_EFLG_RX0OVR | MCP2515_EFLG_RX1OVR);
+        }
+        g_pending_clear_intf |= MCP2515_INT_ERR;
+    }
+
+    if (canintf & MCP2515_INT_MERR) {
+        g_mcp_stats.common.tx_error_count++;
+        g_pending_clear_intf |= MCP2515_INT_MERR;
+    }
+
+    if (canintf & MCP2515_INT_WAK) {
+        g_pending_clear_intf |= MCP2515_INT_WAK;
+    }
+}
+
+/**
+ * @brief 分发接收报文
+ */
+static void CAN_MCP2515_DeliverRx(const uint8_t *frame)
+{
+    CAN_TestBox_Frame_t rx_frame;
+
+    CAN_MCP2515_DecodeFrame(frame, &rx_frame);
+
+    g_mcp_stats.common.rx_total_count++;
+    g_mcp_stats.common.rx_valid_count++;
+
+    if (g_mcp_channel != NULL) {
+        // 已接入测试盒通道，紧凑帧直接送入通道
+        CAN_TestBox_ChannelInputFrame(g_mcp_channel, &rx_frame);
+    } else if (g_mcp_rx_callback != NULL) {
+        CAN_TestBox_Message_t message;
+        CAN_Frame_ToMessage(&message, &rx_frame, HAL_GetTick());
+        g_mcp_rx_callback(&message);
+    } else if (osMessageQueuePut(g_mcp_rx_queue, &rx_frame, 0, 0) != osOK) {
+        g_mcp_stats.rx_queue_full_count++;
+    }
+}
+
+/**
+ * @brief 通道总线状态(最近一次EFLG)
+ */
+static uint32_t CAN_MCP2515_GetBusStatus(void)
+{
+    return g_mcp_stats.last_eflg;
+}
+
+/* ========================= HAL回调函数 ========================= */
+
+/**
+ * @brief EXTI中断回调(INT引脚下降沿)
+ */
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+    if (GPIO_Pin == CAN_MCP2515_INT_PIN) {
+        g_mcp_stats.int_count++;
+        CAN_MCP2515_Kick();
+    }
+}
+
+/**
+ * @brief SPI DMA收发完成回调
+ */
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    if (hspi->Instance != SPI1) {
+        return;
+    }
+
+    // CS拉高结束本次指令(READ RX BUFFER在此时自动清除RXnIF)
+    CAN_MCP2515_Deselect();
+
+    CAN_MCP2515_State_t state = g_mcp_state;
+    g_mcp_state = MCP2515_STATE_IDLE;
+
+    switch (state) {
+        case MCP2515_STATE_READ_FLAGS:
+            CAN_MCP2515_HandleFlags(g_spi_rx_buf[2], g_spi_rx_buf[3]);
+            break;
+
+        case MCP2515_STATE_READ_RX0:
+            g_pending_rx &= (uint8_t)~MCP2515_INT_RX0;
+            CAN_MCP2515_DeliverRx(&g_spi_rx_buf[1]);
+            break;
+
+        case MCP2515_STATE_READ_RX1:
+            g_pending_rx &= (uint8_t)~MCP2515_INT_RX1;
+            CAN_MCP2515_DeliverRx(&g_spi_rx_buf[1]);
+            break;
+
+        case MCP2515_STATE_LOAD_TX:
+            // 装载完成后立即请求发送
+            g_tx_busy |= (uint8_t)(1U << g_loading_buffer);
+            g_mcp_stats.common.tx_total_count++;
+            g_spi_tx_buf[0] = MCP2515_CMD_RTS(g_loading_buffer);
+            if (CAN_MCP2515_StartTransfer(MCP2515_STATE_RTS, 1)) {
+                return;
+            }
+            g_tx_busy &= (uint8_t)~(1U << g_loading_buffer);
+            g_mcp_stats.common.tx_error_count++;
+            break;
+
+        default:
+            break;
+    }
+
+    CAN_MCP2515_Kick();
+}
+
+/**
+ * @brief SPI错误回调
+ */
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
+{
+    if (hspi->Instance != SPI1) {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    CAN_MCP2515_Deselect();
+
+    // 装载失败的发送缓冲区不标记为占用，该帧计为发送错误
+    if (g_mcp_state == MCP2515_STATE_LOAD_TX || g_mcp_state == MCP2515_STATE_RTS) {
+        g_tx_busy &= (uint8_t)~(1U << g_loading_buffer);
+        g_mcp_stats.common.tx_error_count++;
+    }
+
+    g_mcp_state = MCP2515_STATE_IDLE;
+    g_mcp_stats.spi_error_count++;
+
+    __set_PRIMASK(primask);
+
+    CAN_MCP2515_Kick();
+}
@@ -0,0 +1,77 @@
+/**
+ * @file can_testbox_mem.c
+ * @brief CAN测试盒静态内存规划与内存报告实现
+ * @version 1.0
+ * @date 2024
+ */
+
+#include "can_testbox_mem.h"
+#include "can_testbox_cmd.h"
+
+/* ========================= 链接脚本符号 ========================= */
+
+extern uint32_t _sdata, _edata;         // .data
+extern uint32_t _sbss, _ebss;           // .bss
+extern uint32_t _estack;                // 主SRAM末尾
+extern uint32_t _sccmram;               // CCM起始(.ccmram)
+extern uint32_t _eccmbss;               // CCM已用末尾(.ccmbss)
+extern uint32_t _srtos_pool, _ertos_pool; // RTOS对象池
+
+/* ========================= 私有函数声明 ========================= */
+
+static void CAN_Mem_HandleReport(uint8_t cmd, const uint8_t *payload, uint8_t len);
+
+/* ========================= 公共API实现 ========================= */
+
+/**
+ * @brief 初始化内存报告模块
+ */
+CAN_TestBox_Status_t CAN_Mem_Init(void)
+{
+    if (CAN_Cmd_Register(CAN_CMD_ID_MEM_REPORT, CAN_Mem_HandleReport) != CAN_TESTBOX_OK) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 获取内存使用报告
+ */
+CAN_TestBox_Status_t CAN_Mem_GetReport(CAN_Mem_Report_t *report)
+{
+    if (report == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    report->ram_total = (uint32_t)(uintptr_t)&_estack - SRAM1_BASE;
+    report->ram_data = (uint32_t)(uintptr_t)&_edata - (uint32_t)(uintptr_t)&_sdata;
+    report->ram_bss = (uint32_t)(uintptr_t)&_ebss - (uint32_t)(uintptr_t)&_sbss;
+    report->rtos_pool = (uint32_t)(uintptr_t)&_ertos_pool - (uint32_t)(uintptr_t)&_srtos_pool;
+    report->ccm_total = CCMDATARAM_END - CCMDATARAM_BASE + 1U;
+    report->ccm_used = (uint32_t)(uintptr_t)&_eccmbss - (uint32_t)(uintptr_t)&_sccmram;
+    report->heap_total = configTOTAL_HEAP_SIZE;
+    report->heap_free = xPortGetFreeHeapSize();
+    report->heap_min_free = xPortGetMinimumEverFreeHeapSize();
+
+    return CAN_TESTBOX_OK;
+}
+
+/* ========================= 私有函数实现 ========================= */
+
+/**
+ * @brief 命令0x14: 读取内存报告
+ * @note  应答: CAN_Mem_Report_t各字段依次为u32小端
+ */
+static void CAN_Mem_HandleReport(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    (void)payload;
+    (void)len;
+
+    CAN_Mem_Report_t report;
+
+    CAN_Mem_GetReport(&report);
+
+    // 结构体全部为u32字段，无填充，直接按小端输出
+    CAN_Cmd_SendResponse(cmd, (const uint8_t *)&report, sizeof(report));
+}
@@ -0,0 +1,578 @@
+/**
+ * @file can_testbox_monitor.c
+ * @brief CAN多通道监听与时间排序合并模块实现
+ * @version 1.0
+ * @date 2024
+ *
+ * @note 环形缓冲区为单生产者(接收中断)/单消费者(测试盒任务)结构，
+ *       写位置只由中断修改，读位置只由任务修改，无需关中断
+ */
+
+#include "can_testbox_monitor.h"
+#include "can_testbox_timestamp.h"
+#include "can_testbox_gateway.h"
+#include "can_testbox_format.h"
+#include "can_testbox_event.h"
+#include "can_testbox_cmd.h"
+#include "can.h"
+#include <string.h>
+
+/* ========================= 私有类型定义 ========================= */
+
+#define CAN_MONITOR_RING_MASK   (CAN_MONITOR_RING_SIZE - 1U)
+
+#if (CAN_MONITOR_RING_SIZE & CAN_MONITOR_RING_MASK) != 0
+#error "CAN_MONITOR_RING_SIZE must be a power of two"
+#endif
+
+/**
+ * @brief 通道上下文
+ */
+typedef struct {
+    volatile bool     active;                               // 监听中
+    volatile uint16_t head;                                 // 写位置(中断)
+    volatile uint16_t tail;                                 // 读位置(任务)
+    CAN_Monitor_Record_t ring[CAN_MONITOR_RING_SIZE];       // 环形缓冲区
+    CAN_Monitor_Filter_t filters[CAN_MONITOR_MAX_FILTERS];  // 软件过滤器
+    volatile uint8_t  filter_count;                         // 过滤器数量
+    CAN_Monitor_Stats_t stats;                              // 统计信息
+} CAN_Monitor_Context_t;
+
+/* ========================= 私有变量定义 ========================= */
+
+static CAN_Monitor_Context_t g_monitor_ctx[CAN_MONITOR_CH_COUNT];
+
+// 串口输出使能
+static volatile bool g_monitor_output = false;
+
+// 启动CAN2监听前CAN2的运行状态与接收中断(测试盒CAN2通道打开时已开启)，停止时恢复
+static bool g_can2_was_started = false;
+static bool g_can2_rx_it_was_on = false;
+
+/* ========================= 私有函数声明 ========================= */
+
+static bool CAN_Monitor_FilterAccept(const CAN_Monitor_Context_t *ctx, uint32_t id, bool is_extended);
+static void CAN_Monitor_ConfigCan2Filter(bool enable);
+static void CAN_Monitor_PrintRecord(const CAN_Monitor_Record_t *record);
+static void CAN_Monitor_HandleCtrl(uint8_t cmd, const uint8_t *payload, uint8_t len);
+
+/* ========================= 公共API实现 ========================= */
+
+/**
+ * @brief 初始化监听模块
+ */
+CAN_TestBox_Status_t CAN_Monitor_Init(void)
+{
+    for (uint8_t ch = 0; ch < CAN_MONITOR_CH_COUNT; ch++) {
+        if (g_monitor_ctx[ch].active) {
+            return CAN_TESTBOX_BUSY;
+        }
+    }
+
+    memset(g_monitor_ctx, 0, sizeof(g_monitor_ctx));
+    g_monitor_output = false;
+
+    if (CAN_Cmd_Register(CAN_CMD_ID_MONITOR_CTRL, CAN_Monitor_HandleCtrl) != CAN_TESTBOX_OK) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 启动通道监听
+ */
+CAN_TestBox_Status_t CAN_Monitor_Start(CAN_Monitor_Channel_t channel)
+{
+    if (channel >= CAN_MONITOR_CH_COUNT) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    CAN_Monitor_Context_t *ctx = &g_monitor_ctx[channel];
+    if (ctx->active) {
+        return CAN_TESTBOX_OK;
+    }
+
+    // 清空缓冲区
+    ctx->head = 0;
+    ctx->tail = 0;
+
+    if (channel == CAN_MONITOR_CH_CAN1) {
+        // CAN1由测试盒启动，只需打开抓包开关
+        ctx->active = true;
+        return CAN_TESTBOX_OK;
+    }
+
+    // CAN2: 网关运行时CAN2处于正常模式，不能同时静默监听
+    if (CAN_Gateway_IsActive()) {
+        return CAN_TESTBOX_BUSY;
+    }
+
+    g_can2_was_started = (hcan2.State == HAL_CAN_STATE_LISTENING);
+    g_can2_rx_it_was_on = (hcan2.Instance->IER & CAN_IT_RX_FIFO0_MSG_PENDING) != 0U;
+    if (g_can2_was_started) {
+        HAL_CAN_Stop(&hcan2);
+    }
+
+    if (hcan2.Init.Mode != CAN_MODE_SILENT) {
+        hcan2.Init.Mode = CAN_MODE_SILENT;
+        if (HAL_CAN_Init(&hcan2) != HAL_OK) {
+            return CAN_TESTBOX_ERROR;
+        }
+    }
+
+    CAN_Monitor_ConfigCan2Filter(true);
+
+    ctx->active = true;
+
+    if (HAL_CAN_Start(&hcan2) != HAL_OK) {
+        ctx->active = false;
+        return CAN_TESTBOX_ERROR;
+    }
+
+    if (!g_can2_rx_it_was_on && HAL_CAN_ActivateNotification(&hcan2, CAN_IT_RX_FIFO0_MSG_PENDING) != HAL_OK) {
+        ctx->active = false;
+        HAL_CAN_Stop(&hcan2);
+        return CAN_TESTBOX_ERROR;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 停止通道监听
+ */
+CAN_TestBox_Status_t CAN_Monitor_Stop(CAN_Monitor_Channel_t channel)
+{
+    if (channel >= CAN_MONITOR_CH_COUNT) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    CAN_Monitor_Context_t *ctx = &g_monitor_ctx[channel];
+    if (!ctx->active) {
+        return CAN_TESTBOX_NOT_INITIALIZED;
+    }
+
+    ctx->active = false;
+
+    // CAN2只撤销本模块开启的部分，测试盒CAN2通道仍使用接收中断与控制器
+    if (channel == CAN_MONITOR_CH_CAN2) {
+        CAN_Monitor_ConfigCan2Filter(false);
+        if (!g_can2_rx_it_was_on) {
+            HAL_CAN_DeactivateNotification(&hcan2, CAN_IT_RX_FIFO0_MSG_PENDING);
+        }
+        if (!g_can2_was_started) {
+            HAL_CAN_Stop(&hcan2);
+        }
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 通道是否正在监听
+ */
+bool CAN_Monitor_IsActive(CAN_Monitor_Channel_t channel)
+{
+    if (channel >= CAN_MONITOR_CH_COUNT) {
+        return false;
+    }
+
+    return g_monitor_ctx[channel].active;
+}
+
+/**
+ * @brief 添加通道软件过滤器
+ */
+CAN_TestBox_Status_t CAN_Monitor_AddFilter(CAN_Monitor_Channel_t channel, const CAN_Monitor_Filter_t *filter)
+{
+    if (channel >= CAN_MONITOR_CH_COUNT || filter == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    CAN_Monitor_Context_t *ctx = &g_monitor_ctx[channel];
+    if (ctx->filter_count >= CAN_MONITOR_MAX_FILTERS) {
+        return CAN_TESTBOX_QUEUE_FULL;
+    }
+
+    // 先写入过滤器，再增加数量，保证中断中看到的是完整条目
+    ctx->filters[ctx->filter_count] = *filter;
+    ctx->filter_count++;
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 清除通道所有软件过滤器
+ */
+CAN_TestBox_Status_t CAN_Monitor_ClearFilters(CAN_Monitor_Channel_t channel)
+{
+    if (channel >= CAN_MONITOR_CH_COUNT) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    g_monitor_ctx[channel].filter_count = 0;
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 读取单个通道的下一条记录
+ */
+CAN_TestBox_Status_t CAN_Monitor_ReadChannel(CAN_Monitor_Channel_t channel, CAN_Monitor_Record_t *record)
+{
+    if (channel >= CAN_MONITOR_CH_COUNT || record == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    CAN_Monitor_Context_t *ctx = &g_monitor_ctx[channel];
+    uint16_t tail = ctx->tail;
+
+    if (tail == ctx->head) {
+        return CAN_TESTBOX_QUEUE_EMPTY;
+    }
+
+    *record = ctx->ring[tail & CAN_MONITOR_RING_MASK];
+    ctx->tail = tail + 1U;
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 按时间顺序读取合并报文流
+ */
+uint32_t CAN_Monitor_ReadMerged(CAN_Monitor_Record_t *records, uint32_t max_count)
+{
+    uint32_t count = 0;
+
+    if (records == NULL) {
+        return 0;
+    }
+
+    while (count < max_count) {
+        int8_t best = -1;
+        uint32_t best_ts = 0;
+
+        // 选出各通道队首中时间最早的记录
+        for (uint8_t ch = 0; ch < CAN_MONITOR_CH_COUNT; ch++) {
+            CAN_Monitor_Context_t *ctx = &g_monitor_ctx[ch];
+            if (ctx->tail == ctx->head) {
+                continue;
+            }
+
+            uint32_t ts = ctx->ring[ctx->tail & CAN_MONITOR_RING_MASK].timestamp_us;
+            if (best < 0 || (int32_t)(ts - best_ts) < 0) {
+                best = (int8_t)ch;
+                best_ts = ts;
+            }
+        }
+
+        if (best < 0) {
+            break;
+        }
+
+        // 其他监听中的通道缓冲区为空时，等待其可能迟到的更早报文
+        bool wait = false;
+        for (uint8_t ch = 0; ch < CAN_MONITOR_CH_COUNT; ch++) {
+            CAN_Monitor_Context_t *ctx = &g_monitor_ctx[ch];
+            if (ch != (uint8_t)best && ctx->active && ctx->tail == ctx->head) {
+                if (CAN_Timestamp_Elapsed(best_ts, CAN_Timestamp_GetUs()) < CAN_MONITOR_MERGE_HOLDOFF_US) {
+                    wait = true;
+                    break;
+                }
+            }
+        }
+
+        if (wait) {
+            break;
+        }
+
+        CAN_Monitor_ReadChannel((CAN_Monitor_Channel_t)best, &records[count]);
+        count++;
+    }
+
+    return count;
+}
+
+/**
+ * @brief 获取通道统计
+ */
+CAN_TestBox_Status_t CAN_Monitor_GetStats(CAN_Monitor_Channel_t channel, CAN_Monitor_Stats_t *stats)
+{
+    if (channel >= CAN_MONITOR_CH_COUNT || stats == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *stats = g_monitor_ctx[channel].stats;
+    __set_PRIMASK(primask);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 重置所有通道统计
+ */
+CAN_TestBox_Status_t CAN_Monitor_ResetStats(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint8_t ch = 0; ch < CAN_MONITOR_CH_COUNT; ch++) {
+        memset(&g_monitor_ctx[ch].stats, 0, sizeof(CAN_Monitor_Stats_t));
+    }
+    __set_PRIMASK(primask);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 使能/禁用合并报文流的串口输出
+ */
+void CAN_Monitor_SetOutput(bool enable)
+{
+    g_monitor_output = enable;
+}
+
+/**
+ * @brief 监听模块任务处理
+ */
+void CAN_Monitor_Process(void)
+{
+    CAN_Monitor_Record_t records[CAN_MONITOR_PRINT_BATCH];
+
+    if (!g_monitor_output) {
+        return;
+    }
+
+    uint32_t count = CAN_Monitor_ReadMerged(records, CAN_MONITOR_PRINT_BATCH);
+    for (uint32_t i = 0; i < count; i++) {
+        CAN_Monitor_PrintRecord(&records[i]);
+    }
+
+    // 本批已满，可能还有积压，立即再次调度
+    if (count == CAN_MONITOR_PRINT_BATCH) {
+        CAN_Event_Notify(CAN_EVENT_RX);
+    }
+}
+
+/* ========================= 中断处理函数 ========================= */
+
+/**
+ * @brief 抓包接收处理
+ */
+void CAN_Monitor_CaptureRx(CAN_HandleTypeDef *hcan, const CAN_RxHeaderTypeDef *rx_header,
+                           const uint8_t *rx_data, uint32_t rx_timestamp_us)
+{
+    CAN_Monitor_Channel_t channel;
+    if (hcan->Instance == CAN1) {
+        channel = CAN_MONITOR_CH_CAN1;
+    } else if (hcan->Instance == CAN2) {
+        channel = CAN_MONITOR_CH_CAN2;
+    } else {
+        return;
+    }
+
+    CAN_Monitor_Context_t *ctx = &g_monitor_ctx[channel];
+    if (!ctx->active) {
+        return;
+    }
+
+    bool is_extended = (rx_header->IDE == CAN_ID_EXT);
+    uint32_t id = is_extended ? rx_header->ExtId : rx_header->StdId;
+
+    ctx->stats.rx_count++;
+    ctx->stats.last_timestamp_us = rx_timestamp_us;
+
+    if (!CAN_Monitor_FilterAccept(ctx, id, is_extended)) {
+        ctx->stats.filtered_count++;
+        return;
+    }
+
+    ctx->stats.accepted_count++;
+    if (is_extended) {
+        ctx->stats.ext_count++;
+    } else {
+        ctx->stats.std_count++;
+    }
+
+    uint16_t head = ctx->head;
+    uint16_t depth = (uint16_t)(head - ctx->tail);
+    if (depth >= CAN_MONITOR_RING_SIZE) {
+        ctx->stats.overflow_count++;
+        return;
+    }
+
+    CAN_Monitor_Record_t *record = &ctx->ring[head & CAN_MONITOR_RING_MASK];
+    record->timestamp_us = rx_timestamp_us;
+    record->id = id;
+    record->channel = (uint8_t)channel;
+    record->dlc = (rx_header->DLC > 8U) ? 8U : (uint8_t)rx_header->DLC;
+    record->flags = is_extended ? CAN_MONITOR_FLAG_EXT : 0U;
+    if (rx_header->RTR == CAN_RTR_REMOTE) {
+        record->flags |= CAN_MONITOR_FLAG_RTR;
+        ctx->stats.rtr_count++;
+    }
+    record->reserved = 0;
+    memcpy(record->data, rx_data, 8);
+
+    // 记录写完后再发布写位置
+    ctx->head = head + 1U;
+
+    if (g_monitor_output) {
+        CAN_Event_Notify(CAN_EVENT_RX);
+    }
+
+    if ((uint32_t)depth + 1U > ctx->stats.max_depth) {
+        ctx->stats.max_depth = depth + 1U;
+    }
+}
+
+/* ========================= 私有函数实现 ========================= */
+
+/**
+ * @brief 软件过滤器匹配
+ */
+static bool CAN_Monitor_FilterAccept(const CAN_Monitor_Context_t *ctx, uint32_t id, bool is_extended)
+{
+    uint8_t count = ctx->filter_count;
+
+    // 无过滤器时全部接收
+    if (count == 0) {
+        return true;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        const CAN_Monitor_Filter_t *filter = &ctx->filters[i];
+        if (filter->is_extended == is_extended && ((id ^ filter->id) & filter->mask) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief 配置CAN2监听用的全接收过滤器
+ */
+static void CAN_Monitor_ConfigCan2Filter(bool enable)
+{
+    CAN_FilterTypeDef sFilterConfig;
+
+    sFilterConfig.FilterBank = CAN_MONITOR_CAN2_FILTER_BANK;
+    sFilterConfig.FilterMode = CAN_FILTERMODE_IDMASK;
+    sFilterConfig.FilterScale = CAN_FILTERSCALE_32BIT;
+    sFilterConfig.FilterIdHigh = 0x0000;
+    sFilterConfig.FilterIdLow = 0x0000;
+    sFilterConfig.FilterMaskIdHigh = 0x0000;     // 掩码全0，接收所有报文
+    sFilterConfig.FilterMaskIdLow = 0x0000;
+    sFilterConfig.FilterFIFOAssignment = CAN_RX_FIFO0;
+    sFilterConfig.FilterActivation = enable ? CAN_FILTER_ENABLE : CAN_FILTER_DISABLE;
+    sFilterConfig.SlaveStartFilterBank = 14;     // 与PEPS过滤器保持一致
+
+    HAL_CAN_ConfigFilter(&hcan2, &sFilterConfig);
+}
+
+/**
+ * @brief 打印单条合并记录
+ */
+static void CAN_Monitor_PrintRecord(const CAN_Monitor_Record_t *record)
+{
+    char line[CAN_FORMAT_LINE_MAX];
+    char *p = line;
+    bool is_ext = (record->flags & CAN_MONITOR_FLAG_EXT) != 0U;
+
+    memcpy(p, "[MON] CAN", 9);
+    p = CAN_Format_Dec(p + 9, record->channel + 1U);
+    memcpy(p, " T:", 3);
+    p = CAN_Format_Dec(p + 3, record->timestamp_us);
+    p = CAN_Format_FrameBody(p, record->id,
+                             is_ext ? CAN_FORMAT_EXT_ID_DIGITS : CAN_FORMAT_STD_ID_DIGITS,
+                             record->data, record->dlc,
+                             (record->flags & CAN_MONITOR_FLAG_RTR) != 0U);
+    CAN_Format_Output(line, (uint32_t)(p - line));
+}
+
+/**
+ * @brief 串口命令: 抓包启停/过滤器/串口输出/统计
+ */
+static void CAN_Monitor_HandleCtrl(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    CAN_Monitor_Filter_t filter;
+    CAN_Monitor_Stats_t stats;
+    CAN_TestBox_Status_t status;
+
+    // 除清空统计外第2字节为通道或使能
+    if (len == 0U || (len < 2U && payload[0] != CAN_MONITOR_CTRL_RESET_STATS)) {
+        CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+        return;
+    }
+
+    CAN_Monitor_Channel_t channel = (CAN_Monitor_Channel_t)((len > 1U) ? payload[1] : 0U);
+
+    switch (payload[0]) {
+        case CAN_MONITOR_CTRL_STATUS:
+            if (CAN_Monitor_GetStats(channel, &stats) != CAN_TESTBOX_OK) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_PARAM);
+                return;
+            }
+            // 应答: 监听中(u8)、过滤器数(u8)、通道统计
+            {
+                uint8_t head[2] = {
+                    g_monitor_ctx[channel].active ? 1U : 0U,
+                    g_monitor_ctx[channel].filter_count
+                };
+                CAN_Cmd_ResponseBegin(cmd, (uint16_t)(sizeof(head) + sizeof(stats)));
+                CAN_Cmd_ResponseWrite(head, sizeof(head));
+                CAN_Cmd_ResponseWrite(&stats, sizeof(stats));
+                CAN_Cmd_ResponseEnd();
+            }
+            return;
+
+        case CAN_MONITOR_CTRL_START:
+            // CAN2在网关运行时返回执行失败
+            status = CAN_Monitor_Start(channel);
+            break;
+
+        case CAN_MONITOR_CTRL_STOP:
+            status = CAN_Monitor_Stop(channel);
+            if (status == CAN_TESTBOX_NOT_INITIALIZED) {
+                status = CAN_TESTBOX_OK;
+            }
+            break;
+
+        case CAN_MONITOR_CTRL_OUTPUT:
+            CAN_Monitor_SetOutput(payload[1] != 0U);
+            status = CAN_TESTBOX_OK;
+            break;
+
+        case CAN_MONITOR_CTRL_FILTER_ADD:
+            // 通道、扩展帧、ID(u32)、掩码(u32)
+            if (len != 11U) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+                return;
+            }
+            filter.is_extended = (payload[2] != 0U);
+            filter.id = (uint32_t)payload[3] | ((uint32_t)payload[4] << 8) |
+                        ((uint32_t)payload[5] << 16) | ((uint32_t)payload[6] << 24);
+            filter.mask = (uint32_t)payload[7] | ((uint32_t)payload[8] << 8) |
+                          ((uint32_t)payload[9] << 16) | ((uint32_t)payload[10] << 24);
+            status = CAN_Monitor_AddFilter(channel, &filter);
+            break;
+
+        case CAN_MONITOR_CTRL_FILTER_CLEAR:
+            status = CAN_Monitor_ClearFilters(channel);
+            break;
+
+        case CAN_MONITOR_CTRL_RESET_STATS:
+            status = CAN_Monitor_ResetStats();
+            break;
+
+        default:
+            CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_PARAM);
+            return;
+    }
+
+    CAN_Cmd_SendResult(cmd, (status == CAN_TESTBOX_OK) ? CAN_CMD_RESULT_OK :
+                            (status == CAN_TESTBOX_INVALID_PARAM) ? CAN_CMD_RESULT_BAD_PARAM : CAN_CMD_RESULT_FAILED);
+}
@@ -6,6 +6,7 @@
  */
 
 #include "can.h"
+#include "can_testbox_rlink.h"
 #include <stdio.h>
 
 /* ========================= 私有宏定义 ========================= */
@@ -86,6 +87,19 @@ static HAL_StatusTypeDef ConfigureCAN1PepsFilters(void)
         return status;
     }
     
+    // 过滤器4: 双节点可靠链路确认帧与数据帧 (0x190, 0x191)
+    sFilterConfig.FilterBank = 3;
+    sFilterConfig.FilterIdHigh = CAN_RLINK_RX_ACK_ID << 5;
+    sFilterConfig.FilterIdLow = CAN_RLINK_RX_DATA_ID << 5;
+    sFilterConfig.FilterMaskIdHigh = CAN_RLINK_RX_ACK_ID << 5; // 列表模式下重复填入
+    sFilterConfig.FilterMaskIdLow = CAN_RLINK_RX_DATA_ID << 5;
+    
+    status = HAL_CAN_ConfigFilter(&hcan1, &sFilterConfig);
+    if (status != HAL_OK) {
+        // 不打印错误信息，避免乱码
+        return status;
+    }
+    
     // 不打印成功信息，避免乱码
     return HAL_OK;
 }
@@ -18,6 +18,8 @@
  */
 
 #include "can_testbox_api.h"
+#include "can_testbox_cmd.h"
+#include "can_testbox_peps_scenario.h"
 #include "usart.h"
 #include <stdio.h>
 #include <string.h>
@@ -408,8 +410,20 @@ static void PEPS_Helper_ProcessChar(uint8_t received_char)
             // 不打印测试序列状态 (Don't print test sequence status)
             break;
             
+        // 场景指令 (0xF5-0xF6)，按场景表定时切换报文
+        case 0xF5:  // 钥匙插拔场景
+            PEPS_Scenario_Start(PEPS_SCN_KEY_CYCLE);
+            break;
+            
+        case 0xF6:  // 唤醒场景
+            PEPS_Scenario_Start(PEPS_SCN_WAKEUP);
+            break;
+            
         // 系统控制指令 (0xFF-0x00)
         case 0xFF:  // 停止所有周期报文
+            // 先中止场景，避免场景继续启动报文
+            PEPS_Scenario_Stop();
+            
             // 使用封装函数停止所有周期性消息
             PEPS_Helper_StopAllPeriodicMessagesEx();
             
@@ -476,8 +490,10 @@ __weak void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
 {
     if (huart->Instance == USART2)
     {
-        // 处理接收到的字符
-        PEPS_Helper_ProcessChar(g_uart_rx_char);
+        // 帧命令优先解析，非帧数据按单字节指令处理
+        if (!CAN_Cmd_InputByte(g_uart_rx_char)) {
+            PEPS_Helper_ProcessChar(g_uart_rx_char);
+        }
         
         // 重新启动单字符接收
         HAL_UART_Receive_IT(&huart2, &g_uart_rx_char, 1);
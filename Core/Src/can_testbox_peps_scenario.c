@@ -0,0 +1,479 @@
+/**
+ * @file can_testbox_peps_scenario.c
+ * @brief PEPS场景状态机实现
+ * @version 1.0
+ * @date 2024
+ */
+
+#include "can_testbox_peps_scenario.h"
+#include "can_testbox_frame.h"
+#include "can_testbox_timestamp.h"
+#include "can_testbox_event.h"
+#include "can_testbox_cmd.h"
+#include <stdio.h>
+#include <string.h>
+
+/* ========================= 私有宏定义 ========================= */
+
+#define PEPS_SCN_REQ_NONE           0xFFU     // 无待处理请求
+#define PEPS_SCN_REQ_STOP           0xFEU     // 中止请求
+
+// 进入/退出报文集合中的一项(只设置data[0]，其余字节为0)
+#define PEPS_SCN_SEND(slot, b0)     { (slot), PEPS_SCN_ACT_SEND, { (b0), 0, 0, 0, 0, 0, 0, 0 } }
+#define PEPS_SCN_STOP(slot)         { (slot), PEPS_SCN_ACT_STOP, { 0 } }
+#define PEPS_SCN_FRAMES(set)        (set), (uint8_t)(sizeof(set) / sizeof((set)[0]))
+#define PEPS_SCN_NO_FRAMES          NULL, 0
+
+// 0x442钥匙位置
+#define PEPS_KEY_ABSENT             0x00
+#define PEPS_KEY_PRESENT            0x01
+#define PEPS_KEY_INSERTING          0x02
+#define PEPS_KEY_REMOVING           0x03
+
+// 0x036 BSI状态
+#define PEPS_BSI_NORMAL             0x01
+#define PEPS_BSI_STANDBY            0x02
+#define PEPS_BSI_INIT               0x03
+
+// SCW1 PEPS唤醒帧接收ID
+#define PEPS_WAKEUP_RX_ID_SCW1      0x05A
+
+/* ========================= 私有类型定义 ========================= */
+
+/**
+ * @brief 槽位对应的报文ID与周期
+ */
+typedef struct {
+    uint16_t id;
+    uint16_t period_ms;
+} PEPS_Scenario_SlotDef_t;
+
+/**
+ * @brief 槽位运行状态(句柄0有效，用active区分)
+ */
+typedef struct {
+    bool active;
+    uint8_t handle;
+} PEPS_Scenario_SlotState_t;
+
+/* ========================= 场景表 ========================= */
+
+static const PEPS_Scenario_SlotDef_t g_slot_defs[PEPS_SCN_SLOT_COUNT] = {
+    [PEPS_SCN_SLOT_SCW1]    = { 0x05B, 200 },
+    [PEPS_SCN_SLOT_SCW2]    = { 0x401, 500 },
+    [PEPS_SCN_SLOT_KEY_POS] = { 0x442, 100 },
+    [PEPS_SCN_SLOT_BSI]     = { 0x036, 100 },
+};
+
+// 钥匙插拔: BSI初始化 -> 插入中 -> 在位 -> 拔出中 -> 不在位(BSI待机)
+static const PEPS_Scenario_Frame_t g_key_boot[] = {
+    PEPS_SCN_SEND(PEPS_SCN_SLOT_BSI, PEPS_BSI_INIT),
+    PEPS_SCN_SEND(PEPS_SCN_SLOT_KEY_POS, PEPS_KEY_ABSENT),
+};
+static const PEPS_Scenario_Frame_t g_key_inserting[] = {
+    PEPS_SCN_SEND(PEPS_SCN_SLOT_BSI, PEPS_BSI_NORMAL),
+    PEPS_SCN_SEND(PEPS_SCN_SLOT_KEY_POS, PEPS_KEY_INSERTING),
+};
+static const PEPS_Scenario_Frame_t g_key_present[] = {
+    PEPS_SCN_SEND(PEPS_SCN_SLOT_KEY_POS, PEPS_KEY_PRESENT),
+};
+static const PEPS_Scenario_Frame_t g_key_removing[] = {
+    PEPS_SCN_SEND(PEPS_SCN_SLOT_KEY_POS, PEPS_KEY_REMOVING),
+};
+static const PEPS_Scenario_Frame_t g_key_absent[] = {
+    PEPS_SCN_SEND(PEPS_SCN_SLOT_KEY_POS, PEPS_KEY_ABSENT),
+    PEPS_SCN_SEND(PEPS_SCN_SLOT_BSI, PEPS_BSI_STANDBY),
+};
+static const PEPS_Scenario_Frame_t g_key_release[] = {
+    PEPS_SCN_STOP(PEPS_SCN_SLOT_KEY_POS),
+    PEPS_SCN_STOP(PEPS_SCN_SLOT_BSI),
+};
+
+static const PEPS_Scenario_State_t g_key_cycle_states[] = {
+    { "BSI_INIT",      PEPS_SCN_FRAMES(g_key_boot),      PEPS_SCN_NO_FRAMES,
+      200,  1, PEPS_SCN_RX_NONE, 0 },
+    { "KEY_INSERTING", PEPS_SCN_FRAMES(g_key_inserting), PEPS_SCN_NO_FRAMES,
+      300,  2, PEPS_SCN_RX_NONE, 0 },
+    { "KEY_PRESENT",   PEPS_SCN_FRAMES(g_key_present),   PEPS_SCN_NO_FRAMES,
+      2000, 3, PEPS_SCN_RX_NONE, 0 },
+    { "KEY_REMOVING",  PEPS_SCN_FRAMES(g_key_removing),  PEPS_SCN_NO_FRAMES,
+      300,  4, PEPS_SCN_RX_NONE, 0 },
+    { "KEY_ABSENT",    PEPS_SCN_FRAMES(g_key_absent),    PEPS_SCN_FRAMES(g_key_release),
+      1000, PEPS_SCN_STATE_END, PEPS_SCN_RX_NONE, 0 },
+};
+
+// 唤醒流程: 等待0x05A -> SCW1/SCW2唤醒 -> 钥匙在位(BSI正常) -> BSI待机后停止
+static const PEPS_Scenario_Frame_t g_wake_scw[] = {
+    PEPS_SCN_SEND(PEPS_SCN_SLOT_SCW1, 0x01),
+    PEPS_SCN_SEND(PEPS_SCN_SLOT_SCW2, 0x01),
+};
+static const PEPS_Scenario_Frame_t g_wake_scw_done[] = {
+    PEPS_SCN_STOP(PEPS_SCN_SLOT_SCW1),
+};
+static const PEPS_Scenario_Frame_t g_wake_active[] = {
+    PEPS_SCN_SEND(PEPS_SCN_SLOT_KEY_POS, PEPS_KEY_PRESENT),
+    PEPS_SCN_SEND(PEPS_SCN_SLOT_BSI, PEPS_BSI_NORMAL),
+};
+static const PEPS_Scenario_Frame_t g_wake_sleep[] = {
+    PEPS_SCN_SEND(PEPS_SCN_SLOT_KEY_POS, PEPS_KEY_ABSENT),
+    PEPS_SCN_SEND(PEPS_SCN_SLOT_BSI, PEPS_BSI_STANDBY),
+};
+static const PEPS_Scenario_Frame_t g_wake_release[] = {
+    PEPS_SCN_STOP(PEPS_SCN_SLOT_SCW2),
+    PEPS_SCN_STOP(PEPS_SCN_SLOT_KEY_POS),
+    PEPS_SCN_STOP(PEPS_SCN_SLOT_BSI),
+};
+
+static const PEPS_Scenario_State_t g_wakeup_states[] = {
+    { "WAIT_WAKE",     PEPS_SCN_NO_FRAMES,               PEPS_SCN_NO_FRAMES,
+      10000, PEPS_SCN_STATE_END, PEPS_WAKEUP_RX_ID_SCW1, 1 },
+    { "SCW_WAKE",      PEPS_SCN_FRAMES(g_wake_scw),      PEPS_SCN_FRAMES(g_wake_scw_done),
+      1000, 2, PEPS_SCN_RX_NONE, 0 },
+    { "ACTIVE",        PEPS_SCN_FRAMES(g_wake_active),   PEPS_SCN_NO_FRAMES,
+      2000, 3, PEPS_SCN_RX_NONE, 0 },
+    { "SLEEP",         PEPS_SCN_FRAMES(g_wake_sleep),    PEPS_SCN_FRAMES(g_wake_release),
+      500,  PEPS_SCN_STATE_END, PEPS_SCN_RX_NONE, 0 },
+};
+
+static const PEPS_Scenario_Def_t g_scenarios[PEPS_SCN_COUNT] = {
+    [PEPS_SCN_KEY_CYCLE] = { "KEY_CYCLE", g_key_cycle_states,
+                             (uint8_t)(sizeof(g_key_cycle_states) / sizeof(g_key_cycle_states[0])) },
+    [PEPS_SCN_WAKEUP]    = { "WAKEUP", g_wakeup_states,
+                             (uint8_t)(sizeof(g_wakeup_states) / sizeof(g_wakeup_states[0])) },
+};
+
+/* ========================= 私有变量定义 ========================= */
+
+// 启动/中止请求(中断或命令写入，任务中处理)
+static volatile uint8_t g_request = PEPS_SCN_REQ_NONE;
+
+// 定时转移到期(TIM2闹钟中断置位)
+static volatile bool g_timer_due = false;
+
+// 等待的接收ID与命中信息(接收中断写入)
+static volatile uint16_t g_rx_wait_id = PEPS_SCN_RX_NONE;
+static volatile bool g_rx_due = false;
+static volatile uint32_t g_rx_hit_us = 0;
+
+// 运行上下文(仅在CAN测试盒任务中访问)
+static const PEPS_Scenario_Def_t *g_scn = NULL;
+static const PEPS_Scenario_State_t *g_state = NULL;
+static uint32_t g_start_us = 0;
+static uint32_t g_deadline_us = 0;
+static PEPS_Scenario_Status_t g_status;
+static PEPS_Scenario_SlotState_t g_slots[PEPS_SCN_SLOT_COUNT];
+
+/* ========================= 私有函数声明 ========================= */
+
+static void PEPS_Scenario_AlarmCallback(void);
+static void PEPS_Scenario_Begin(uint8_t scenario);
+static void PEPS_Scenario_Enter(uint8_t index, uint32_t at_us);
+static void PEPS_Scenario_Transition(uint8_t next, uint32_t at_us);
+static void PEPS_Scenario_Finish(const char *reason);
+static void PEPS_Scenario_ApplyFrames(const PEPS_Scenario_Frame_t *frames, uint8_t count);
+static void PEPS_Scenario_HandleCtrl(uint8_t cmd, const uint8_t *payload, uint8_t len);
+
+/* ========================= 公共API实现 ========================= */
+
+/**
+ * @brief 初始化PEPS场景状态机
+ */
+CAN_TestBox_Status_t PEPS_Scenario_Init(void)
+{
+    memset(&g_status, 0, sizeof(g_status));
+    memset(g_slots, 0, sizeof(g_slots));
+    g_status.state = PEPS_SCN_STATE_END;
+
+    if (CAN_Cmd_Register(CAN_CMD_ID_PEPS_SCENARIO, PEPS_Scenario_HandleCtrl) != CAN_TESTBOX_OK) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 请求启动场景
+ */
+CAN_TestBox_Status_t PEPS_Scenario_Start(uint8_t scenario)
+{
+    if (scenario >= PEPS_SCN_COUNT) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    g_request = scenario;
+    CAN_Event_Notify(CAN_EVENT_SCHEDULE);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 请求中止场景
+ */
+void PEPS_Scenario_Stop(void)
+{
+    g_request = PEPS_SCN_REQ_STOP;
+    CAN_Event_Notify(CAN_EVENT_SCHEDULE);
+}
+
+/**
+ * @brief 获取运行状态
+ */
+CAN_TestBox_Status_t PEPS_Scenario_GetStatus(PEPS_Scenario_Status_t *status)
+{
+    if (status == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    *status = g_status;
+    if (g_scn != NULL) {
+        status->elapsed_us = CAN_Timestamp_Elapsed(g_start_us, CAN_Timestamp_GetUs());
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 报文输入
+ * @note  只在等待接收的状态中做一次ID比较，命中后解除等待并唤醒测试盒任务
+ */
+void PEPS_Scenario_InputFrame(const CAN_TestBox_Frame_t *frame)
+{
+    if (g_rx_wait_id == PEPS_SCN_RX_NONE || frame == NULL || CAN_Frame_IsExtended(frame)) {
+        return;
+    }
+
+    bool hit = false;
+
+    // CAN1/CAN2接收中断优先级不同，判断与解除等待需原子完成
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (g_rx_wait_id != PEPS_SCN_RX_NONE && CAN_Frame_GetId(frame) == g_rx_wait_id) {
+        g_rx_wait_id = PEPS_SCN_RX_NONE;
+        g_rx_hit_us = CAN_Timestamp_GetUs();
+        g_rx_due = true;
+        hit = true;
+    }
+    __set_PRIMASK(primask);
+
+    if (hit) {
+        CAN_Event_Notify(CAN_EVENT_SCHEDULE);
+    }
+}
+
+/**
+ * @brief 执行到期的状态转移
+ * @note  在CAN_TestBox_Task()之前调用，进入报文集合在同一轮调度中生效
+ */
+void PEPS_Scenario_Process(void)
+{
+    uint8_t request = g_request;
+
+    if (request != PEPS_SCN_REQ_NONE) {
+        g_request = PEPS_SCN_REQ_NONE;
+
+        if (g_scn != NULL) {
+            PEPS_Scenario_Finish("aborted");
+        }
+        if (request < PEPS_SCN_COUNT) {
+            PEPS_Scenario_Begin(request);
+        }
+    }
+
+    if (g_scn == NULL) {
+        return;
+    }
+
+    // 每次只执行一次转移；新状态若已到期，闹钟立即触发并再次唤醒任务
+    if (g_rx_due) {
+        g_rx_due = false;
+        PEPS_Scenario_Transition(g_state->rx_next, g_rx_hit_us);
+    } else if (g_timer_due) {
+        g_timer_due = false;
+        PEPS_Scenario_Transition(g_state->timeout_next, g_deadline_us);
+    }
+}
+
+/* ========================= 私有函数实现 ========================= */
+
+/**
+ * @brief TIM2闹钟回调(中断上下文)
+ */
+static void PEPS_Scenario_AlarmCallback(void)
+{
+    g_timer_due = true;
+    CAN_Event_Notify(CAN_EVENT_SCHEDULE);
+}
+
+/**
+ * @brief 开始场景
+ */
+static void PEPS_Scenario_Begin(uint8_t scenario)
+{
+    g_scn = &g_scenarios[scenario];
+    g_start_us = CAN_Timestamp_GetUs();
+
+    memset(&g_status, 0, sizeof(g_status));
+    g_status.running = 1;
+    g_status.scenario = scenario;
+
+    printf("[PEPS-SCN] %s start\r\n", g_scn->name);
+    PEPS_Scenario_Enter(0, g_start_us);
+}
+
+/**
+ * @brief 进入状态
+ * @param index: 状态编号
+ * @param at_us: 进入的计划时刻，停留时间从此起算
+ */
+static void PEPS_Scenario_Enter(uint8_t index, uint32_t at_us)
+{
+    g_state = &g_scn->states[index];
+    g_status.state = index;
+
+    PEPS_Scenario_ApplyFrames(g_state->entry, g_state->entry_count);
+
+    g_rx_due = false;
+    g_rx_wait_id = g_state->rx_id;
+
+    g_timer_due = false;
+    if (g_state->dwell_ms != 0U) {
+        g_deadline_us = at_us + (uint32_t)g_state->dwell_ms * 1000U;
+        CAN_Timestamp_SetAlarm(g_deadline_us, PEPS_Scenario_AlarmCallback);
+    } else {
+        CAN_Timestamp_CancelAlarm();
+    }
+
+    printf("[PEPS-SCN] %s -> %s\r\n", g_scn->name, g_state->name);
+}
+
+/**
+ * @brief 执行状态转移
+ * @param next: 下一状态，PEPS_SCN_STATE_END表示结束
+ * @param at_us: 转移的计划时刻(闹钟到期时刻或报文到达时刻)
+ */
+static void PEPS_Scenario_Transition(uint8_t next, uint32_t at_us)
+{
+    uint32_t late_us = CAN_Timestamp_Elapsed(at_us, CAN_Timestamp_GetUs());
+    if (late_us > g_status.late_max_us) {
+        g_status.late_max_us = late_us;
+    }
+    g_status.transitions++;
+
+    g_rx_wait_id = PEPS_SCN_RX_NONE;
+    PEPS_Scenario_ApplyFrames(g_state->exit, g_state->exit_count);
+
+    if (next >= g_scn->state_count) {
+        PEPS_Scenario_Finish("done");
+        return;
+    }
+
+    PEPS_Scenario_Enter(next, at_us);
+}
+
+/**
+ * @brief 结束场景，停止场景启动的全部周期报文
+ */
+static void PEPS_Scenario_Finish(const char *reason)
+{
+    CAN_Timestamp_CancelAlarm();
+    g_timer_due = false;
+    g_rx_wait_id = PEPS_SCN_RX_NONE;
+    g_rx_due = false;
+
+    for (uint8_t i = 0; i < PEPS_SCN_SLOT_COUNT; i++) {
+        if (g_slots[i].active) {
+            CAN_TestBox_StopPeriodicMessage(g_slots[i].handle);
+            g_slots[i].active = false;
+        }
+    }
+
+    g_status.running = 0;
+    g_status.state = PEPS_SCN_STATE_END;
+    g_status.elapsed_us = CAN_Timestamp_Elapsed(g_start_us, CAN_Timestamp_GetUs());
+
+    printf("[PEPS-SCN] %s %s, %lu ms\r\n", g_scn->name, reason,
+           (unsigned long)(g_status.elapsed_us / 1000U));
+
+    g_scn = NULL;
+    g_state = NULL;
+}
+
+/**
+ * @brief 执行报文集合
+ */
+static void PEPS_Scenario_ApplyFrames(const PEPS_Scenario_Frame_t *frames, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; i++) {
+        const PEPS_Scenario_Frame_t *frame = &frames[i];
+        if (frame->slot >= PEPS_SCN_SLOT_COUNT) {
+            continue;
+        }
+
+        PEPS_Scenario_SlotState_t *slot = &g_slots[frame->slot];
+
+        if (frame->action == PEPS_SCN_ACT_STOP) {
+            if (slot->active) {
+                CAN_TestBox_StopPeriodicMessage(slot->handle);
+                slot->active = false;
+            }
+            continue;
+        }
+
+        // 已在发送时只替换数据，不打乱发送相位
+        if (slot->active &&
+            CAN_TestBox_ModifyPeriodicData(slot->handle, frame->data, 8) == CAN_TESTBOX_OK) {
+            continue;
+        }
+
+        CAN_TestBox_Message_t message;
+        message.id = g_slot_defs[frame->slot].id;
+        message.dlc = 8;
+        message.is_extended = false;
+        message.is_remote = false;
+        memcpy(message.data, frame->data, 8);
+
+        slot->active = (CAN_TestBox_StartPeriodicMessage(&message, g_slot_defs[frame->slot].period_ms,
+                                                         &slot->handle) == CAN_TESTBOX_OK);
+    }
+}
+
+/**
+ * @brief 命令0x1B: PEPS场景控制
+ * @note  请求: 操作(u8)[+ 场景编号(u8)]，见PEPS_SCN_CTRL_xxx
+ *        应答: 读取状态时为PEPS_Scenario_Status_t(u32小端)，其余为状态码
+ */
+static void PEPS_Scenario_HandleCtrl(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    PEPS_Scenario_Status_t status;
+
+    if (len == 0U) {
+        CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+        return;
+    }
+
+    switch (payload[0]) {
+        case PEPS_SCN_CTRL_START:
+            if (len != 2U) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+            } else if (PEPS_Scenario_Start(payload[1]) != CAN_TESTBOX_OK) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_PARAM);
+            } else {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_OK);
+            }
+            break;
+
+        case PEPS_SCN_CTRL_STOP:
+            PEPS_Scenario_Stop();
+            CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_OK);
+            break;
+
+        case PEPS_SCN_CTRL_STATUS:
+            PEPS_Scenario_GetStatus(&status);
+            CAN_Cmd_SendResponse(cmd, (const uint8_t *)&status, sizeof(status));
+            break;
+
+        default:
+            CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_PARAM);
+            break;
+    }
+}
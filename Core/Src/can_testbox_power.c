@@ -0,0 +1,212 @@
+/**
+ * @file can_testbox_power.c
+ * @brief CAN测试盒低功耗空闲实现
+ * @version 1.0
+ * @date 2024
+ */
+
+#include "can_testbox_power.h"
+#include "can_testbox_timestamp.h"
+#include "can_testbox_cmd.h"
+#include "FreeRTOS.h"
+#include <string.h>
+
+/* ========================= 外部函数声明 ========================= */
+
+// FreeRTOS移植层的默认实现(停止SysTick并WFI)
+extern void vPortSuppressTicksAndSleep(TickType_t xExpectedIdleTime);
+
+/* ========================= 私有变量定义 ========================= */
+
+static volatile bool g_tickless_enabled = true;
+
+// 本次睡眠状态(仅在关中断的睡眠前后处理中访问)
+static bool g_sleep_active = false;
+static uint32_t g_sleep_start_us = 0;       // 睡眠前TIM2时间戳
+static uint32_t g_sleep_start_cnt = 0;      // 睡眠前TIM1计数相位
+
+// 睡眠统计
+static uint32_t g_sleep_count = 0;
+static uint32_t g_sleep_total_us = 0;
+static uint32_t g_sleep_max_us = 0;
+static uint32_t g_tick_compensated = 0;
+static uint32_t g_stats_start_tick = 0;
+
+/* ========================= 私有函数声明 ========================= */
+
+static void CAN_Power_HandleCmd(uint8_t cmd, const uint8_t *payload, uint8_t len);
+
+/* ========================= 公共API实现 ========================= */
+
+/**
+ * @brief 初始化低功耗模块
+ */
+CAN_TestBox_Status_t CAN_Power_Init(void)
+{
+    CAN_Power_ResetStats();
+
+    if (CAN_Cmd_Register(CAN_CMD_ID_POWER_CTRL, CAN_Power_HandleCmd) != CAN_TESTBOX_OK) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 使能/禁用tickless空闲
+ */
+void CAN_Power_SetTickless(bool enable)
+{
+    g_tickless_enabled = enable;
+}
+
+/**
+ * @brief 获取低功耗与周期抖动报告
+ */
+CAN_TestBox_Status_t CAN_Power_GetReport(CAN_Power_Report_t *report)
+{
+    CAN_TestBox_Jitter_t jitter;
+
+    if (report == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    report->tickless_enabled = g_tickless_enabled ? 1U : 0U;
+    report->sleep_count = g_sleep_count;
+    report->sleep_total_us = g_sleep_total_us;
+    report->sleep_max_us = g_sleep_max_us;
+    report->tick_compensated = g_tick_compensated;
+    report->measure_ms = HAL_GetTick() - g_stats_start_tick;
+    __set_PRIMASK(primask);
+
+    CAN_TestBox_GetPeriodicJitter(&jitter);
+    report->jitter_samples = jitter.samples;
+    report->jitter_avg_us = (jitter.samples > 0U) ? (jitter.sum_us / jitter.samples) : 0U;
+    report->jitter_max_us = jitter.max_us;
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 清空睡眠统计与周期抖动统计
+ */
+void CAN_Power_ResetStats(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    g_sleep_count = 0;
+    g_sleep_total_us = 0;
+    g_sleep_max_us = 0;
+    g_tick_compensated = 0;
+    g_stats_start_tick = HAL_GetTick();
+    __set_PRIMASK(primask);
+
+    CAN_TestBox_ResetPeriodicJitter();
+}
+
+/* ========================= FreeRTOS钩子 ========================= */
+
+/**
+ * @brief 空闲任务停止tick睡眠
+ * @note  禁用时直接返回，空闲任务继续循环，SysTick与TIM1照常1kHz运行
+ */
+void CAN_Power_SuppressTicksAndSleep(uint32_t expected_idle_ticks)
+{
+    if (g_tickless_enabled) {
+        vPortSuppressTicksAndSleep(expected_idle_ticks);
+    }
+}
+
+/**
+ * @brief 睡眠前处理
+ */
+void CAN_Power_PreSleep(uint32_t *idle_ticks)
+{
+    // 关闭TIM1更新中断，计数器继续运行以保持HAL时基相位
+    HAL_SuspendTick();
+
+    g_sleep_start_cnt = TIM1->CNT;
+    g_sleep_start_us = CAN_Timestamp_GetUs();
+
+    // 已有未处理的HAL tick时放弃本次睡眠，交给TIM1中断正常计数
+    if (TIM1->SR & TIM_SR_UIF) {
+        HAL_ResumeTick();
+        *idle_ticks = 0;
+        g_sleep_active = false;
+        return;
+    }
+
+    g_sleep_active = true;
+}
+
+/**
+ * @brief 唤醒后处理
+ * @note  补偿值按TIM1实际计数推算：经过的计数 = 睡眠时长 + 起始相位 - 当前相位，
+ *        必为TIM1周期的整数倍，四舍五入消除TIM1/TIM2读取间的1us误差
+ */
+void CAN_Power_PostSleep(uint32_t *idle_ticks)
+{
+    (void)idle_ticks;
+
+    if (!g_sleep_active) {
+        return;
+    }
+    g_sleep_active = false;
+
+    uint32_t period = TIM1->ARR + 1U;
+
+    // 先清更新标志，之后的回绕由读取的相位计入
+    TIM1->SR = ~(uint32_t)TIM_SR_UIF;
+    uint32_t cnt = TIM1->CNT;
+    uint32_t elapsed_us = CAN_Timestamp_GetUs() - g_sleep_start_us;
+
+    int32_t counts = (int32_t)(elapsed_us + g_sleep_start_cnt - cnt);
+    uint32_t ticks = (counts > 0) ? (((uint32_t)counts + period / 2U) / period) : 0U;
+
+    // 清标志后、读相位前发生的回绕已计入ticks，标志需再次清除；
+    // 读相位后才发生的回绕留给TIM1中断计数
+    if ((TIM1->SR & TIM_SR_UIF) && TIM1->CNT >= cnt) {
+        TIM1->SR = ~(uint32_t)TIM_SR_UIF;
+    }
+
+    uwTick += ticks * (uint32_t)uwTickFreq;
+    HAL_ResumeTick();
+
+    g_sleep_count++;
+    g_sleep_total_us += elapsed_us;
+    if (elapsed_us > g_sleep_max_us) {
+        g_sleep_max_us = elapsed_us;
+    }
+    g_tick_compensated += ticks;
+}
+
+/* ========================= 私有函数实现 ========================= */
+
+/**
+ * @brief 命令0x16: 低功耗控制与周期抖动报告
+ * @note  请求: 空-仅读取; tickless(u8, 0-关闭 1-开启)-切换模式并清空统计
+ *        应答: CAN_Power_Report_t各字段依次为u32小端
+ */
+static void CAN_Power_HandleCmd(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    CAN_Power_Report_t report;
+
+    if (len > 1U) {
+        CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+        return;
+    }
+
+    if (len == 1U) {
+        if (payload[0] > 1U) {
+            CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_PARAM);
+            return;
+        }
+        CAN_Power_SetTickless(payload[0] != 0U);
+        CAN_Power_ResetStats();
+    }
+
+    CAN_Power_GetReport(&report);
+    CAN_Cmd_SendResponse(cmd, (const uint8_t *)&report, sizeof(report));
+}
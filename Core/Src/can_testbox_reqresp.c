@@ -0,0 +1,610 @@
+/**
+ * @file can_testbox_reqresp.c
+ * @brief CAN测试盒请求/应答匹配与往返时延统计实现
+ * @version 1.0
+ * @date 2024
+ */
+
+#include "can_testbox_reqresp.h"
+#include "can_testbox_txarb.h"
+#include "can_testbox_frame.h"
+#include "can_testbox_timestamp.h"
+#include "can_testbox_event.h"
+#include "can_testbox_cmd.h"
+#include <string.h>
+
+/* ========================= 私有宏定义 ========================= */
+
+#define CAN_REQRESP_NIL             0xFFU                       // 链表结束
+#define CAN_REQRESP_WILDCARD        CAN_REQRESP_HASH_SIZE       // 通配链表编号
+#define CAN_REQRESP_STD_ID_MASK     0x000007FFU
+#define CAN_REQRESP_EXT_ID_MASK     0x1FFFFFFFU
+
+#define CAN_REQRESP_OPT_CLEAR       0x01U   // 读取后清空
+#define CAN_REQRESP_OPT_BUCKETS     0x02U   // 附带各桶计数
+
+/* ========================= 私有类型定义 ========================= */
+
+/**
+ * @brief 待决项状态
+ */
+typedef enum {
+    CAN_REQRESP_SLOT_FREE = 0,
+    CAN_REQRESP_SLOT_PENDING,               // 等待应答(在散列链中)
+    CAN_REQRESP_SLOT_MATCHED                // 已匹配，等待任务回调(已出链)
+} CAN_ReqResp_SlotState_t;
+
+/**
+ * @brief 待决项
+ */
+typedef struct {
+    volatile uint8_t state;                 // CAN_ReqResp_SlotState_t
+    uint8_t next;                           // 同链下一项
+    uint8_t chain;                          // 所在链(散列桶或通配链表)
+    uint8_t dlc;                            // 应答长度
+    volatile bool tx_done;                  // 请求已发送完成，tx_us有效
+    CAN_ReqResp_Expect_t expect;
+    uint32_t start_us;                      // 登记时刻(超时起点)
+    uint32_t tx_us;                         // 请求发送完成时刻(RTT起点)
+    uint32_t timeout_us;                    // 超时(us)
+    uint32_t rtt_us;                        // 往返时延
+    uint8_t data[8];                        // 应答数据
+} CAN_ReqResp_Slot_t;
+
+/* ========================= 私有变量定义 ========================= */
+
+static CAN_ReqResp_Slot_t g_slots[CAN_REQRESP_PENDING_MAX];
+
+// 散列桶与通配链表头
+static uint8_t g_chains[CAN_REQRESP_HASH_SIZE + 1];
+
+// 各请求类型统计
+static CAN_ReqResp_TypeStats_t g_stats[CAN_REQRESP_TYPE_MAX];
+
+/* ========================= 私有函数声明 ========================= */
+
+static uint8_t CAN_ReqResp_Hash(uint32_t id);
+static uint8_t CAN_ReqResp_ChainOf(const CAN_ReqResp_Expect_t *expect);
+static void CAN_ReqResp_Unlink(uint8_t index);
+static void CAN_ReqResp_RecordRtt(uint8_t type, uint32_t rtt_us);
+static uint32_t CAN_ReqResp_BucketIndex(uint32_t rtt_us);
+static uint32_t CAN_ReqResp_Percentile(const CAN_ReqResp_TypeStats_t *stats, uint32_t percent);
+static void CAN_ReqResp_HandleGet(uint8_t cmd, const uint8_t *payload, uint8_t len);
+
+/* ========================= 公共API实现 ========================= */
+
+/**
+ * @brief 初始化请求/应答匹配
+ */
+CAN_TestBox_Status_t CAN_ReqResp_Init(void)
+{
+    memset(g_slots, 0, sizeof(g_slots));
+    memset(g_chains, CAN_REQRESP_NIL, sizeof(g_chains));
+    CAN_ReqResp_ResetStats();
+
+    if (CAN_TxArb_AddConfirmCallback(CAN_ReqResp_ProcessTxConfirm) != CAN_TESTBOX_OK) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    if (CAN_Cmd_Register(CAN_CMD_ID_REQRESP_GET, CAN_ReqResp_HandleGet) != CAN_TESTBOX_OK) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 登记期望的应答
+ * @note  插入链尾，同一ID的多个期望按登记顺序匹配
+ */
+CAN_TestBox_Status_t CAN_ReqResp_Arm(const CAN_ReqResp_Expect_t *expect, uint8_t *handle)
+{
+    if (expect == NULL || expect->type >= CAN_REQRESP_TYPE_MAX ||
+        expect->timeout_ms == 0U || expect->timeout_ms > 0x7FFFFFFFU / 1000U) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    uint8_t chain = CAN_ReqResp_ChainOf(expect);
+    uint8_t index = CAN_REQRESP_NIL;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    for (uint8_t i = 0; i < CAN_REQRESP_PENDING_MAX; i++) {
+        if (g_slots[i].state == CAN_REQRESP_SLOT_FREE) {
+            index = i;
+            break;
+        }
+    }
+
+    if (index == CAN_REQRESP_NIL) {
+        __set_PRIMASK(primask);
+        return CAN_TESTBOX_QUEUE_FULL;
+    }
+
+    CAN_ReqResp_Slot_t *slot = &g_slots[index];
+    slot->expect = *expect;
+    slot->chain = chain;
+    slot->next = CAN_REQRESP_NIL;
+    slot->timeout_us = expect->timeout_ms * 1000U;
+    slot->tx_done = false;
+
+    uint8_t *link = &g_chains[chain];
+    while (*link != CAN_REQRESP_NIL) {
+        link = &g_slots[*link].next;
+    }
+    *link = index;
+
+    g_stats[expect->type].requests++;
+    slot->start_us = CAN_Timestamp_GetUs();
+    slot->state = CAN_REQRESP_SLOT_PENDING;
+
+    __set_PRIMASK(primask);
+
+    if (handle != NULL) {
+        *handle = index;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 登记期望的应答并发送请求
+ */
+CAN_TestBox_Status_t CAN_ReqResp_SendAndAwait(CAN_TestBox_Channel_t channel, const CAN_TestBox_Message_t *request,
+                                              const CAN_ReqResp_Expect_t *expect, uint8_t *handle)
+{
+    CAN_ReqResp_Expect_t armed;
+    uint8_t index;
+
+    if (request == NULL || expect == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    // 片内CAN按请求的发送完成时刻计时
+    armed = *expect;
+    if (CAN_TestBox_ChannelGetId(channel) < CAN_TESTBOX_CH_EXT) {
+        armed.has_request = true;
+        armed.request_channel = (uint8_t)CAN_TestBox_ChannelGetId(channel);
+        armed.request_extended = request->is_extended;
+        armed.request_id = request->id;
+    }
+
+    // 先登记再发送，避免应答先于登记到达
+    CAN_TestBox_Status_t status = CAN_ReqResp_Arm(&armed, &index);
+    if (status != CAN_TESTBOX_OK) {
+        return status;
+    }
+
+    status = CAN_TestBox_ChannelSendSingleFrame(channel, request);
+    if (status != CAN_TESTBOX_OK) {
+        CAN_ReqResp_Cancel(index);
+        return status;
+    }
+
+    if (handle != NULL) {
+        *handle = index;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 取消待决请求
+ * @note  仍在等待的请求从请求数中扣除，保持请求数=应答数+超时数+待决数
+ */
+CAN_TestBox_Status_t CAN_ReqResp_Cancel(uint8_t handle)
+{
+    if (handle >= CAN_REQRESP_PENDING_MAX) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    CAN_TestBox_Status_t status = CAN_TESTBOX_OK;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (g_slots[handle].state == CAN_REQRESP_SLOT_PENDING) {
+        CAN_ReqResp_Unlink(handle);
+        g_stats[g_slots[handle].expect.type].requests--;
+        g_slots[handle].state = CAN_REQRESP_SLOT_FREE;
+    } else if (g_slots[handle].state == CAN_REQRESP_SLOT_MATCHED) {
+        g_slots[handle].state = CAN_REQRESP_SLOT_FREE;
+    } else {
+        status = CAN_TESTBOX_NOT_FOUND;
+    }
+    __set_PRIMASK(primask);
+
+    return status;
+}
+
+/**
+ * @brief 接收报文匹配
+ * @note  只比较同散列桶与通配链表中的项，无待决请求时只做两次读
+ */
+bool CAN_ReqResp_ProcessRx(CAN_TestBox_ChannelId_t ch, const CAN_RxHeaderTypeDef *header,
+                           const uint8_t *data, uint32_t rx_timestamp_us)
+{
+    if (header == NULL || data == NULL) {
+        return false;
+    }
+
+    bool is_extended = (header->IDE == CAN_ID_EXT);
+    uint32_t id = is_extended ? header->ExtId : header->StdId;
+    uint8_t dlc = (header->DLC > 8U) ? 8U : (uint8_t)header->DLC;
+    uint8_t chains[2] = { CAN_ReqResp_Hash(id), CAN_REQRESP_WILDCARD };
+    uint8_t hit = CAN_REQRESP_NIL;
+
+    if (g_chains[chains[0]] == CAN_REQRESP_NIL && g_chains[CAN_REQRESP_WILDCARD] == CAN_REQRESP_NIL) {
+        return false;
+    }
+
+    // CAN1/CAN2接收中断优先级不同，查找与出链需原子完成
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    for (uint8_t c = 0; c < 2U && hit == CAN_REQRESP_NIL; c++) {
+        for (uint8_t i = g_chains[chains[c]]; i != CAN_REQRESP_NIL; i = g_slots[i].next) {
+            const CAN_ReqResp_Expect_t *expect = &g_slots[i].expect;
+
+            if (expect->is_extended != is_extended ||
+                ((id ^ expect->id) & expect->mask) != 0U ||
+                (expect->channel != CAN_REQRESP_CH_ANY && expect->channel != (uint8_t)ch)) {
+                continue;
+            }
+            if (expect->predicate != NULL && !expect->predicate(data, dlc, expect->context)) {
+                continue;
+            }
+
+            hit = i;
+            break;
+        }
+    }
+
+    if (hit != CAN_REQRESP_NIL) {
+        CAN_ReqResp_Slot_t *slot = &g_slots[hit];
+
+        CAN_ReqResp_Unlink(hit);
+        slot->rtt_us = rx_timestamp_us - (slot->tx_done ? slot->tx_us : slot->start_us);
+        slot->dlc = dlc;
+        memcpy(slot->data, data, dlc);
+        slot->state = CAN_REQRESP_SLOT_MATCHED;
+        CAN_ReqResp_RecordRtt(slot->expect.type, slot->rtt_us);
+    }
+
+    __set_PRIMASK(primask);
+
+    if (hit == CAN_REQRESP_NIL) {
+        return false;
+    }
+
+    CAN_Event_Notify(CAN_EVENT_RX);
+    return true;
+}
+
+/**
+ * @brief 请求发送完成
+ * @note  已在发送仲裁临界区内；同ID请求在同一分类内先进先出，取登记最早的未发出项
+ */
+void CAN_ReqResp_ProcessTxConfirm(CAN_TestBox_ChannelId_t ch, uint8_t tx_class, uint8_t tag,
+                                  const CAN_TestBox_Frame_t *frame, uint32_t enqueue_us,
+                                  uint32_t done_us, bool sent)
+{
+    (void)tx_class;
+    (void)tag;
+    (void)enqueue_us;
+
+    if (!sent) {
+        return;
+    }
+
+    uint32_t id = CAN_Frame_GetId(frame);
+    bool is_extended = CAN_Frame_IsExtended(frame);
+    uint8_t oldest = CAN_REQRESP_NIL;
+    uint32_t oldest_age = 0;
+
+    for (uint8_t i = 0; i < CAN_REQRESP_PENDING_MAX; i++) {
+        const CAN_ReqResp_Slot_t *slot = &g_slots[i];
+        const CAN_ReqResp_Expect_t *expect = &slot->expect;
+
+        if (slot->state != CAN_REQRESP_SLOT_PENDING || slot->tx_done || !expect->has_request ||
+            expect->request_channel != (uint8_t)ch || expect->request_extended != is_extended ||
+            expect->request_id != id) {
+            continue;
+        }
+
+        uint32_t age = done_us - slot->start_us;
+        if (oldest == CAN_REQRESP_NIL || age > oldest_age) {
+            oldest = i;
+            oldest_age = age;
+        }
+    }
+
+    if (oldest != CAN_REQRESP_NIL) {
+        g_slots[oldest].tx_us = done_us;
+        g_slots[oldest].tx_done = true;
+    }
+}
+
+/**
+ * @brief 分发匹配结果并处理超时
+ */
+void CAN_ReqResp_Process(void)
+{
+    uint32_t now_us = CAN_Timestamp_GetUs();
+
+    for (uint8_t i = 0; i < CAN_REQRESP_PENDING_MAX; i++) {
+        CAN_ReqResp_Slot_t *slot = &g_slots[i];
+        CAN_ReqResp_Result_t result;
+        uint32_t rtt_us;
+        uint8_t data[8];
+        uint8_t dlc = 0;
+
+        if (slot->state == CAN_REQRESP_SLOT_FREE) {
+            continue;
+        }
+
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+
+        if (slot->state == CAN_REQRESP_SLOT_MATCHED) {
+            result = CAN_REQRESP_RESULT_MATCHED;
+            rtt_us = slot->rtt_us;
+            dlc = slot->dlc;
+            memcpy(data, slot->data, dlc);
+        } else if (slot->state == CAN_REQRESP_SLOT_PENDING &&
+                   (now_us - slot->start_us) >= slot->timeout_us) {
+            result = CAN_REQRESP_RESULT_TIMEOUT;
+            rtt_us = now_us - slot->start_us;
+            CAN_ReqResp_Unlink(i);
+            g_stats[slot->expect.type].timeouts++;
+        } else {
+            __set_PRIMASK(primask);
+            continue;
+        }
+
+        CAN_ReqResp_Callback_t callback = slot->expect.callback;
+        void *context = slot->expect.context;
+        slot->state = CAN_REQRESP_SLOT_FREE;
+
+        __set_PRIMASK(primask);
+
+        if (callback != NULL) {
+            callback(i, result, rtt_us, (result == CAN_REQRESP_RESULT_MATCHED) ? data : NULL, dlc, context);
+        }
+    }
+}
+
+/**
+ * @brief 计算距最近一个超时的等待时间
+ */
+uint32_t CAN_ReqResp_GetIdleTime(uint32_t max_ms)
+{
+    uint32_t now_us = CAN_Timestamp_GetUs();
+
+    for (uint8_t i = 0; i < CAN_REQRESP_PENDING_MAX; i++) {
+        const CAN_ReqResp_Slot_t *slot = &g_slots[i];
+
+        if (slot->state == CAN_REQRESP_SLOT_MATCHED) {
+            return 0;
+        }
+        if (slot->state != CAN_REQRESP_SLOT_PENDING) {
+            continue;
+        }
+
+        uint32_t elapsed_us = now_us - slot->start_us;
+        if (elapsed_us >= slot->timeout_us) {
+            return 0;
+        }
+
+        // 向上取整到ms，避免提前醒来后空转
+        uint32_t remain_ms = (slot->timeout_us - elapsed_us + 999U) / 1000U;
+        if (remain_ms < max_ms) {
+            max_ms = remain_ms;
+        }
+    }
+
+    return max_ms;
+}
+
+/**
+ * @brief 获取请求类型统计
+ */
+CAN_TestBox_Status_t CAN_ReqResp_GetStats(uint8_t type, CAN_ReqResp_TypeStats_t *stats)
+{
+    if (stats == NULL || type >= CAN_REQRESP_TYPE_MAX) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *stats = g_stats[type];
+    __set_PRIMASK(primask);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 获取请求类型摘要
+ */
+CAN_TestBox_Status_t CAN_ReqResp_GetSummary(uint8_t type, CAN_ReqResp_Summary_t *summary)
+{
+    static CAN_ReqResp_TypeStats_t stats;
+
+    if (summary == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    CAN_TestBox_Status_t status = CAN_ReqResp_GetStats(type, &stats);
+    if (status != CAN_TESTBOX_OK) {
+        return status;
+    }
+
+    summary->requests = stats.requests;
+    summary->matched = stats.matched;
+    summary->timeouts = stats.timeouts;
+    summary->rtt_min_us = (stats.matched != 0U) ? stats.rtt_min_us : 0U;
+    summary->rtt_avg_us = (stats.matched != 0U) ? (uint32_t)(stats.rtt_sum_us / stats.matched) : 0U;
+    summary->rtt_p50_us = CAN_ReqResp_Percentile(&stats, 50U);
+    summary->rtt_p99_us = CAN_ReqResp_Percentile(&stats, 99U);
+    summary->rtt_max_us = stats.rtt_max_us;
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 清空全部类型统计
+ */
+void CAN_ReqResp_ResetStats(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset(g_stats, 0, sizeof(g_stats));
+    for (uint8_t i = 0; i < CAN_REQRESP_TYPE_MAX; i++) {
+        g_stats[i].rtt_min_us = 0xFFFFFFFFU;
+    }
+    __set_PRIMASK(primask);
+}
+
+/* ========================= 私有函数实现 ========================= */
+
+/**
+ * @brief 应答ID散列(各4位折叠异或)
+ */
+static uint8_t CAN_ReqResp_Hash(uint32_t id)
+{
+    id ^= id >> 16;
+    id ^= id >> 8;
+    id ^= id >> 4;
+    return (uint8_t)(id & (CAN_REQRESP_HASH_SIZE - 1U));
+}
+
+/**
+ * @brief 计算期望所在链: 掩码覆盖全部ID位时按ID散列，否则放入通配链表
+ */
+static uint8_t CAN_ReqResp_ChainOf(const CAN_ReqResp_Expect_t *expect)
+{
+    uint32_t full = expect->is_extended ? CAN_REQRESP_EXT_ID_MASK : CAN_REQRESP_STD_ID_MASK;
+
+    if ((expect->mask & full) == full) {
+        return CAN_ReqResp_Hash(expect->id & full);
+    }
+
+    return CAN_REQRESP_WILDCARD;
+}
+
+/**
+ * @brief 从所在链中摘除(调用者已关中断)
+ */
+static void CAN_ReqResp_Unlink(uint8_t index)
+{
+    uint8_t *link = &g_chains[g_slots[index].chain];
+
+    while (*link != CAN_REQRESP_NIL) {
+        if (*link == index) {
+            *link = g_slots[index].next;
+            break;
+        }
+        link = &g_slots[*link].next;
+    }
+
+    g_slots[index].next = CAN_REQRESP_NIL;
+}
+
+/**
+ * @brief 记录一次RTT(调用者已关中断)
+ */
+static void CAN_ReqResp_RecordRtt(uint8_t type, uint32_t rtt_us)
+{
+    CAN_ReqResp_TypeStats_t *stats = &g_stats[type];
+
+    stats->matched++;
+    stats->rtt_sum_us += rtt_us;
+    stats->buckets[CAN_ReqResp_BucketIndex(rtt_us)]++;
+    if (rtt_us < stats->rtt_min_us) {
+        stats->rtt_min_us = rtt_us;
+    }
+    if (rtt_us > stats->rtt_max_us) {
+        stats->rtt_max_us = rtt_us;
+    }
+}
+
+/**
+ * @brief 计算RTT所在桶: 0us为桶0，其余为最高位序号+1，超出部分并入最后一桶
+ */
+static uint32_t CAN_ReqResp_BucketIndex(uint32_t rtt_us)
+{
+    uint32_t index = 32U - __CLZ(rtt_us);
+    return (index < CAN_REQRESP_BUCKETS) ? index : (CAN_REQRESP_BUCKETS - 1U);
+}
+
+/**
+ * @brief 计算百分位(us)
+ * @return uint32_t: 百分位所在桶上界，不超过最大值
+ */
+static uint32_t CAN_ReqResp_Percentile(const CAN_ReqResp_TypeStats_t *stats, uint32_t percent)
+{
+    if (stats->matched == 0U) {
+        return 0;
+    }
+
+    uint32_t target = (uint32_t)(((uint64_t)stats->matched * percent + 99U) / 100U);
+    uint32_t cumulative = 0;
+
+    for (uint32_t i = 0; i < CAN_REQRESP_BUCKETS; i++) {
+        cumulative += stats->buckets[i];
+        if (cumulative >= target) {
+            uint32_t upper = (i == 0U) ? 0U : (uint32_t)((1ULL << i) - 1U);
+            return (upper < stats->rtt_max_us) ? upper : stats->rtt_max_us;
+        }
+    }
+
+    return stats->rtt_max_us;
+}
+
+/**
+ * @brief 命令0x1C: 读取请求/应答往返时延
+ * @note  请求: 空或选项(u8, bit0-读取后清空 bit1-附带各桶计数)
+ *        应答: 类型数(u8) + 每类型CAN_ReqResp_Summary_t(u32小端)
+ *              [+ 每类型CAN_REQRESP_BUCKETS个桶计数(u32)]
+ */
+static void CAN_ReqResp_HandleGet(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    static CAN_ReqResp_TypeStats_t stats;
+    CAN_ReqResp_Summary_t summary;
+    uint8_t option = 0;
+    uint8_t count = CAN_REQRESP_TYPE_MAX;
+
+    if (len > 1U) {
+        CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+        return;
+    }
+    if (len == 1U) {
+        option = payload[0];
+    }
+
+    uint16_t total = (uint16_t)(sizeof(count) + CAN_REQRESP_TYPE_MAX * sizeof(summary));
+    if (option & CAN_REQRESP_OPT_BUCKETS) {
+        total += (uint16_t)(CAN_REQRESP_TYPE_MAX * sizeof(stats.buckets));
+    }
+
+    CAN_Cmd_ResponseBegin(cmd, total);
+    CAN_Cmd_ResponseWrite(&count, sizeof(count));
+
+    for (uint8_t type = 0; type < CAN_REQRESP_TYPE_MAX; type++) {
+        CAN_ReqResp_GetSummary(type, &summary);
+        CAN_Cmd_ResponseWrite(&summary, sizeof(summary));
+    }
+
+    if (option & CAN_REQRESP_OPT_BUCKETS) {
+        for (uint8_t type = 0; type < CAN_REQRESP_TYPE_MAX; type++) {
+            CAN_ReqResp_GetStats(type, &stats);
+            CAN_Cmd_ResponseWrite(stats.buckets, sizeof(stats.buckets));
+        }
+    }
+
+    CAN_Cmd_ResponseEnd();
+
+    if (option & CAN_REQRESP_OPT_CLEAR) {
+        CAN_ReqResp_ResetStats();
+    }
+}
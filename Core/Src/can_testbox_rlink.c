@@ -0,0 +1,921 @@
+/**
+ * @file can_testbox_rlink.c
+ * @brief 双节点可靠链路实现
+ * @version 1.0
+ * @date 2024
+ */
+
+#include "can_testbox_rlink.h"
+#include "can_testbox_timestamp.h"
+#include "can_testbox_event.h"
+#include "can_testbox_cmd.h"
+#include "can_testbox_txarb.h"
+#include "can.h"
+#include <string.h>
+
+/* ========================= 私有宏定义 ========================= */
+
+#define CAN_RLINK_RING_MASK         (CAN_RLINK_TX_RING - 1U)
+#define CAN_RLINK_OOO_MASK          (CAN_RLINK_WINDOW_MAX - 1U)
+#define CAN_RLINK_ACK_LEN           6U
+#define CAN_RLINK_SACK_BITS         32U
+#define CAN_RLINK_SEQ_BEHIND        0x80U   // 序号差不小于此值视为已经过去的序号
+#define CAN_RLINK_SEQ_STALE         (0x100U - CAN_RLINK_WINDOW_MAX) // 重传的已交付序号不早于rcv_nxt-窗口
+
+#define CAN_RLINK_FLAG_SACKED       0x01U   // 已被选择确认
+#define CAN_RLINK_FLAG_RETX         0x02U   // 等待重传
+
+#define CAN_RLINK_BULK_FILL         0xA5U   // 测试数据填充字节
+
+/* ========================= 私有类型定义 ========================= */
+
+/**
+ * @brief 发送环中的一帧
+ */
+typedef struct {
+    uint8_t len;                            // 负载长度
+    uint8_t flags;                          // CAN_RLINK_FLAG_xxx
+    uint8_t tx_count;                       // 已发送次数(0表示尚未发送)
+    uint8_t data[CAN_RLINK_PAYLOAD_MAX];
+    uint32_t sent_us;                       // 最近一次装入邮箱的时刻
+} CAN_RLink_TxEntry_t;
+
+/**
+ * @brief 接收缓存中的一帧
+ */
+typedef struct {
+    uint8_t len;
+    uint8_t data[CAN_RLINK_PAYLOAD_MAX];
+} CAN_RLink_RxEntry_t;
+
+/* ========================= 私有变量定义 ========================= */
+
+// 发送端: [snd_una, snd_nxt)在途，[snd_nxt, snd_end)排队
+static CAN_RLink_TxEntry_t g_tx_ring[CAN_RLINK_TX_RING];
+static uint8_t g_snd_una = 0;
+static uint8_t g_snd_nxt = 0;
+static uint8_t g_snd_end = 0;
+static uint8_t g_window = CAN_RLINK_WINDOW_DEFAULT;
+static uint8_t g_peer_window = CAN_RLINK_WINDOW_MAX;
+static uint8_t g_retx_count = 0;            // 标记为等待重传的帧数
+static bool g_probe = false;                // 对端窗口为0时允许发送一帧探测
+static uint32_t g_srtt_us = 0;
+static uint32_t g_rttvar_us = 0;
+static uint32_t g_rto_us = CAN_RLINK_RTO_INIT_US;
+static uint32_t g_last_ack_us = 0;
+static uint8_t g_tx_insane = 0;             // 连续越界确认数(对端重启检测)
+
+// 接收端: 乱序缓存按序号低5位存放
+static CAN_RLink_RxEntry_t g_ooo[CAN_RLINK_WINDOW_MAX];
+static uint32_t g_ooo_valid = 0;
+static uint8_t g_ooo_count = 0;
+static CAN_RLink_RxEntry_t g_rx_queue[CAN_RLINK_RX_QUEUE];
+static uint8_t g_rx_head = 0;
+static uint8_t g_rx_count = 0;
+static uint8_t g_rcv_nxt = 0;               // 期望的下一个序号
+static uint8_t g_rcv_high = 0;              // 已见到的最大序号+1
+static uint8_t g_unacked = 0;               // 按序到达但尚未确认的帧数
+static uint8_t g_last_adv = CAN_RLINK_WINDOW_MAX;
+static bool g_ack_now = false;              // 有空闲邮箱即发送确认
+static volatile bool g_ack_delayed = false; // 由任务补发合并确认
+static bool g_sink = false;                 // 任务中直接丢弃按序交付的数据
+static uint8_t g_rx_insane = 0;             // 连续不可能出现的数据序号数(对端重启检测)
+
+// 测试数据
+static uint32_t g_bulk_remaining = 0;
+static uint32_t g_bulk_counter = 0;
+
+// 统计
+static CAN_RLink_Stats_t g_stats;
+static uint64_t g_occupancy_sum = 0;
+static uint32_t g_occupancy_samples = 0;
+static uint32_t g_stats_start_ms = 0;
+
+/* ========================= 私有函数声明 ========================= */
+
+static void CAN_RLink_Pump(void);
+static uint8_t CAN_RLink_EffectiveWindow(void);
+static uint8_t CAN_RLink_RxWindow(void);
+static void CAN_RLink_BuildAck(uint8_t *frame);
+static void CAN_RLink_HandleAck(const uint8_t *data);
+static void CAN_RLink_HandleData(const uint8_t *data, uint8_t dlc);
+static void CAN_RLink_Deliver(const uint8_t *data, uint8_t len);
+static void CAN_RLink_ResyncTx(uint8_t cum);
+static void CAN_RLink_Reverse(uint8_t first, uint8_t last);
+static void CAN_RLink_UpdateRto(uint32_t rtt_us);
+static void CAN_RLink_HandleCtrl(uint8_t cmd, const uint8_t *payload, uint8_t len);
+
+/* ========================= 公共API实现 ========================= */
+
+/**
+ * @brief 初始化可靠链路
+ */
+CAN_TestBox_Status_t CAN_RLink_Init(void)
+{
+    g_window = CAN_RLINK_WINDOW_DEFAULT;
+    g_sink = false;
+    CAN_RLink_Reset();
+    CAN_RLink_ResetStats();
+
+    if (CAN_Cmd_Register(CAN_CMD_ID_RLINK_CTRL, CAN_RLink_HandleCtrl) != CAN_TESTBOX_OK) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 复位双向序号
+ */
+void CAN_RLink_Reset(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    memset(g_tx_ring, 0, sizeof(g_tx_ring));
+    g_snd_una = 0;
+    g_snd_nxt = 0;
+    g_snd_end = 0;
+    g_peer_window = CAN_RLINK_WINDOW_MAX;
+    g_retx_count = 0;
+    g_probe = false;
+    g_srtt_us = 0;
+    g_rttvar_us = 0;
+    g_rto_us = CAN_RLINK_RTO_INIT_US;
+    g_last_ack_us = CAN_Timestamp_GetUs();
+    g_tx_insane = 0;
+
+    g_ooo_valid = 0;
+    g_ooo_count = 0;
+    g_rx_head = 0;
+    g_rx_count = 0;
+    g_rcv_nxt = 0;
+    g_rcv_high = 0;
+    g_unacked = 0;
+    g_last_adv = CAN_RLINK_WINDOW_MAX;
+    g_ack_now = false;
+    g_ack_delayed = false;
+    g_rx_insane = 0;
+
+    g_bulk_remaining = 0;
+    g_bulk_counter = 0;
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 设置发送窗口
+ * @note  缩小窗口不撤回已在途的帧，在途帧确认到新窗口以内后再继续发送
+ */
+CAN_TestBox_Status_t CAN_RLink_SetWindow(uint8_t window)
+{
+    if (window == 0U || window > CAN_RLINK_WINDOW_MAX) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    g_window = window;
+    CAN_RLink_Pump();
+    __set_PRIMASK(primask);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 提交一帧数据
+ */
+CAN_TestBox_Status_t CAN_RLink_Send(const uint8_t *data, uint8_t len)
+{
+    if (len > CAN_RLINK_PAYLOAD_MAX || (data == NULL && len > 0U)) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if ((uint8_t)(g_snd_end - g_snd_una) >= CAN_RLINK_TX_RING) {
+        __set_PRIMASK(primask);
+        return CAN_TESTBOX_QUEUE_FULL;
+    }
+
+    CAN_RLink_TxEntry_t *entry = &g_tx_ring[g_snd_end & CAN_RLINK_RING_MASK];
+    entry->len = len;
+    entry->flags = 0;
+    entry->tx_count = 0;
+    if (len > 0U) {
+        memcpy(entry->data, data, len);
+    }
+    g_snd_end++;
+
+    CAN_RLink_Pump();
+
+    __set_PRIMASK(primask);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 读取一帧按序交付的数据
+ * @note  通告窗口曾为0时立即发送窗口更新
+ */
+CAN_TestBox_Status_t CAN_RLink_Receive(uint8_t *data, uint8_t *len)
+{
+    if (data == NULL || len == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (g_rx_count == 0U) {
+        __set_PRIMASK(primask);
+        return CAN_TESTBOX_QUEUE_EMPTY;
+    }
+
+    CAN_RLink_RxEntry_t *entry = &g_rx_queue[g_rx_head];
+    memcpy(data, entry->data, entry->len);
+    *len = entry->len;
+    g_rx_head = (uint8_t)((g_rx_head + 1U) % CAN_RLINK_RX_QUEUE);
+    g_rx_count--;
+
+    if (g_last_adv == 0U) {
+        g_ack_now = true;
+        CAN_RLink_Pump();
+    }
+
+    __set_PRIMASK(primask);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 可靠链路报文接收
+ */
+bool CAN_RLink_ProcessRx(const CAN_RxHeaderTypeDef *header, const uint8_t *data)
+{
+    if (header->IDE != CAN_ID_STD || header->RTR != CAN_RTR_DATA) {
+        return false;
+    }
+
+    if (header->StdId == CAN_RLINK_RX_ACK_ID) {
+        if (header->DLC >= CAN_RLINK_ACK_LEN) {
+            CAN_RLink_HandleAck(data);
+        }
+        return true;
+    }
+
+    if (header->StdId == CAN_RLINK_RX_DATA_ID) {
+        if (header->DLC >= 1U) {
+            CAN_RLink_HandleData(data, (uint8_t)header->DLC);
+        }
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief 发送邮箱空闲时继续发送
+ */
+void CAN_RLink_ProcessTxComplete(CAN_HandleTypeDef *hcan)
+{
+    if (hcan->Instance == CAN1) {
+        CAN_RLink_Pump();
+    }
+}
+
+/**
+ * @brief 超时重传、延迟确认与测试数据补充
+ */
+void CAN_RLink_Process(void)
+{
+    uint8_t frame[CAN_RLINK_PAYLOAD_MAX];
+    uint8_t len;
+
+    if (g_sink) {
+        while (CAN_RLink_Receive(frame, &len) == CAN_TESTBOX_OK) {
+        }
+    }
+
+    // 测试数据: 4字节小端计数+3字节填充，发送环满时等待确认腾出空间
+    while (g_bulk_remaining > 0U) {
+        frame[0] = (uint8_t)(g_bulk_counter);
+        frame[1] = (uint8_t)(g_bulk_counter >> 8);
+        frame[2] = (uint8_t)(g_bulk_counter >> 16);
+        frame[3] = (uint8_t)(g_bulk_counter >> 24);
+        memset(&frame[4], CAN_RLINK_BULK_FILL, CAN_RLINK_PAYLOAD_MAX - 4U);
+        if (CAN_RLink_Send(frame, CAN_RLINK_PAYLOAD_MAX) != CAN_TESTBOX_OK) {
+            break;
+        }
+        g_bulk_counter++;
+        g_bulk_remaining--;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint32_t now = CAN_Timestamp_GetUs();
+
+    if (g_ack_delayed) {
+        g_ack_now = true;
+    }
+
+    // 超时未确认的帧全部标记重传，本轮有到期时RTO加倍退避
+    bool expired = false;
+    uint8_t in_flight = (uint8_t)(g_snd_nxt - g_snd_una);
+    for (uint8_t k = 0; k < in_flight; k++) {
+        CAN_RLink_TxEntry_t *entry = &g_tx_ring[(uint8_t)(g_snd_una + k) & CAN_RLINK_RING_MASK];
+        if ((entry->flags & (CAN_RLINK_FLAG_SACKED | CAN_RLINK_FLAG_RETX)) != 0U) {
+            continue;
+        }
+        if (now - entry->sent_us >= g_rto_us) {
+            entry->flags |= CAN_RLINK_FLAG_RETX;
+            g_retx_count++;
+            g_stats.rto_expiries++;
+            expired = true;
+        }
+    }
+    if (expired) {
+        g_rto_us = (g_rto_us * 2U > CAN_RLINK_RTO_MAX_US) ? CAN_RLINK_RTO_MAX_US : g_rto_us * 2U;
+    }
+
+    // 对端窗口为0且无在途帧时，超过RTO未收到窗口更新则发送一帧探测
+    if (g_peer_window == 0U && in_flight == 0U && g_snd_nxt != g_snd_end &&
+        now - g_last_ack_us >= g_rto_us) {
+        g_probe = true;
+    }
+
+    CAN_RLink_Pump();
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 计算距最近一个重传超时的等待时间
+ */
+uint32_t CAN_RLink_GetIdleTime(uint32_t max_ms)
+{
+    uint32_t wait_us = max_ms * 1000U;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint32_t now = CAN_Timestamp_GetUs();
+    uint8_t in_flight = (uint8_t)(g_snd_nxt - g_snd_una);
+
+    if (g_ack_delayed || (g_sink && g_rx_count > 0U) ||
+        (g_bulk_remaining > 0U && (uint8_t)(g_snd_end - g_snd_una) < CAN_RLINK_TX_RING)) {
+        wait_us = 0;
+    }
+
+    for (uint8_t k = 0; k < in_flight && wait_us > 0U; k++) {
+        const CAN_RLink_TxEntry_t *entry = &g_tx_ring[(uint8_t)(g_snd_una + k) & CAN_RLINK_RING_MASK];
+        if ((entry->flags & (CAN_RLINK_FLAG_SACKED | CAN_RLINK_FLAG_RETX)) != 0U) {
+            continue;
+        }
+        uint32_t elapsed = now - entry->sent_us;
+        uint32_t remain = (elapsed >= g_rto_us) ? 0U : g_rto_us - elapsed;
+        if (remain < wait_us) {
+            wait_us = remain;
+        }
+    }
+
+    if (g_peer_window == 0U && in_flight == 0U && g_snd_nxt != g_snd_end) {
+        uint32_t elapsed = now - g_last_ack_us;
+        uint32_t remain = (elapsed >= g_rto_us) ? 0U : g_rto_us - elapsed;
+        if (remain < wait_us) {
+            wait_us = remain;
+        }
+    }
+
+    __set_PRIMASK(primask);
+
+    return (wait_us + 999U) / 1000U;
+}
+
+/**
+ * @brief 获取统计
+ */
+CAN_TestBox_Status_t CAN_RLink_GetStats(CAN_RLink_Stats_t *stats)
+{
+    if (stats == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    *stats = g_stats;
+    stats->window = g_window;
+    stats->peer_window = g_peer_window;
+    stats->in_flight = (uint8_t)(g_snd_nxt - g_snd_una);
+    stats->queued = (uint8_t)(g_snd_end - g_snd_nxt);
+    stats->in_flight_avg_x100 = (g_occupancy_samples > 0U) ?
+        (uint32_t)(g_occupancy_sum * 100U / g_occupancy_samples) : 0U;
+    stats->srtt_us = g_srtt_us;
+    stats->rto_us = g_rto_us;
+    stats->rx_queue_depth = g_rx_count;
+    stats->bulk_remaining = g_bulk_remaining;
+
+    __set_PRIMASK(primask);
+
+    stats->elapsed_ms = HAL_GetTick() - g_stats_start_ms;
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 清空统计
+ */
+void CAN_RLink_ResetStats(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset(&g_stats, 0, sizeof(g_stats));
+    g_occupancy_sum = 0;
+    g_occupancy_samples = 0;
+    g_stats_start_ms = HAL_GetTick();
+    __set_PRIMASK(primask);
+}
+
+/* ========================= 私有函数实现 ========================= */
+
+/**
+ * @brief 将确认、重传与新数据装入空闲邮箱
+ * @note  任务、接收中断与发送完成中断都会调用，整个过程在临界区内完成；
+ *        不经发送仲裁，可用邮箱由CAN_TxArb_ExternalFreeLevel()给出；
+ *        确认帧可使用最后一个可用邮箱，数据帧至少保留
+ *        CAN_RLINK_TX_MAILBOX_RESERVE个邮箱给其他报文
+ */
+static void CAN_RLink_Pump(void)
+{
+    CAN_TxHeaderTypeDef header;
+    uint8_t frame[8];
+    uint32_t tx_mailbox;
+
+    header.IDE = CAN_ID_STD;
+    header.RTR = CAN_RTR_DATA;
+    header.TransmitGlobalTime = DISABLE;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    while (1) {
+        uint32_t free_level = CAN_TxArb_ExternalFreeLevel(&hcan1);
+        if (free_level == 0U) {
+            break;
+        }
+
+        if (g_ack_now) {
+            CAN_RLink_BuildAck(frame);
+            header.StdId = CAN_RLINK_TX_ACK_ID;
+            header.DLC = CAN_RLINK_ACK_LEN;
+            if (HAL_CAN_AddTxMessage(&hcan1, &header, frame, &tx_mailbox) != HAL_OK) {
+                break;
+            }
+            g_last_adv = frame[5];
+            g_ack_now = false;
+            g_ack_delayed = false;
+            g_unacked = 0;
+            g_stats.acks_sent++;
+            continue;
+        }
+
+        if (free_level <= CAN_RLINK_TX_MAILBOX_RESERVE) {
+            break;
+        }
+
+        // 重传优先于新数据
+        CAN_RLink_TxEntry_t *entry = NULL;
+        uint8_t seq = 0;
+        if (g_retx_count > 0U) {
+            uint8_t in_flight = (uint8_t)(g_snd_nxt - g_snd_una);
+            for (uint8_t k = 0; k < in_flight; k++) {
+                seq = (uint8_t)(g_snd_una + k);
+                if ((g_tx_ring[seq & CAN_RLINK_RING_MASK].flags & CAN_RLINK_FLAG_RETX) != 0U) {
+                    entry = &g_tx_ring[seq & CAN_RLINK_RING_MASK];
+                    break;
+                }
+            }
+            if (entry == NULL) {
+                g_retx_count = 0;
+            }
+        }
+
+        bool is_retx = (entry != NULL);
+        if (!is_retx) {
+            if (g_snd_nxt == g_snd_end ||
+                (uint8_t)(g_snd_nxt - g_snd_una) >= CAN_RLink_EffectiveWindow()) {
+                break;
+            }
+            seq = g_snd_nxt;
+            entry = &g_tx_ring[seq & CAN_RLINK_RING_MASK];
+        }
+
+        frame[0] = seq;
+        memcpy(&frame[1], entry->data, entry->len);
+        header.StdId = CAN_RLINK_TX_DATA_ID;
+        header.DLC = 1U + entry->len;
+        if (HAL_CAN_AddTxMessage(&hcan1, &header, frame, &tx_mailbox) != HAL_OK) {
+            break;
+        }
+
+        entry->sent_us = CAN_Timestamp_GetUs();
+        if (entry->tx_count < 0xFFU) {
+            entry->tx_count++;
+        }
+
+        if (is_retx) {
+            entry->flags &= (uint8_t)~CAN_RLINK_FLAG_RETX;
+            g_retx_count--;
+            g_stats.retransmits++;
+        } else {
+            g_snd_nxt++;
+            g_probe = false;
+            g_stats.tx_frames++;
+
+            uint8_t in_flight = (uint8_t)(g_snd_nxt - g_snd_una);
+            if (in_flight > g_stats.in_flight_max) {
+                g_stats.in_flight_max = in_flight;
+            }
+            g_occupancy_sum += in_flight;
+            g_occupancy_samples++;
+        }
+    }
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 实际发送窗口
+ */
+static uint8_t CAN_RLink_EffectiveWindow(void)
+{
+    uint8_t window = (g_window < g_peer_window) ? g_window : g_peer_window;
+
+    if (window == 0U && g_probe) {
+        window = 1;
+    }
+
+    return window;
+}
+
+/**
+ * @brief 接收窗口: 保证窗口内的帧按序交付时接收队列一定有空间
+ */
+static uint8_t CAN_RLink_RxWindow(void)
+{
+    uint8_t free_slots = (uint8_t)(CAN_RLINK_RX_QUEUE - g_rx_count);
+
+    return (free_slots < CAN_RLINK_WINDOW_MAX) ? free_slots : CAN_RLINK_WINDOW_MAX;
+}
+
+/**
+ * @brief 构造确认帧(按发送时刻的接收状态，自动合并之前未发出的确认)
+ */
+static void CAN_RLink_BuildAck(uint8_t *frame)
+{
+    uint32_t sack = 0;
+
+    if (g_ooo_count > 0U) {
+        for (uint32_t i = 0; i < CAN_RLINK_SACK_BITS - 1U; i++) {
+            uint8_t slot = (uint8_t)(g_rcv_nxt + 1U + i) & CAN_RLINK_OOO_MASK;
+            if ((g_ooo_valid & (1UL << slot)) != 0U) {
+                sack |= (1UL << i);
+            }
+        }
+    }
+
+    frame[0] = g_rcv_nxt;
+    frame[1] = (uint8_t)(sack);
+    frame[2] = (uint8_t)(sack >> 8);
+    frame[3] = (uint8_t)(sack >> 16);
+    frame[4] = (uint8_t)(sack >> 24);
+    frame[5] = CAN_RLink_RxWindow();
+}
+
+/**
+ * @brief 处理对端确认帧
+ * @note  RTT只取首次发送即被确认的帧(Karn算法)；空洞之后已有
+ *        CAN_RLINK_DUP_THRESH帧被选择确认时，空洞中只发送过一次的帧快速重传
+ */
+static void CAN_RLink_HandleAck(const uint8_t *data)
+{
+    uint32_t now = CAN_Timestamp_GetUs();
+    uint8_t cum = data[0];
+    uint32_t sack = (uint32_t)data[1] | ((uint32_t)data[2] << 8) |
+                    ((uint32_t)data[3] << 16) | ((uint32_t)data[4] << 24);
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    g_stats.acks_received++;
+    g_last_ack_us = now;
+    g_peer_window = (data[5] < CAN_RLINK_WINDOW_MAX) ? data[5] : CAN_RLINK_WINDOW_MAX;
+
+    uint8_t in_flight = (uint8_t)(g_snd_nxt - g_snd_una);
+    uint8_t advance = (uint8_t)(cum - g_snd_una);
+    if (advance > in_flight) {
+        // 越界的确认只采用其窗口；连续出现说明对端已重启，按其期望序号重新编号
+        if (++g_tx_insane >= CAN_RLINK_RESYNC_THRESH) {
+            CAN_RLink_ResyncTx(cum);
+        }
+        CAN_RLink_Pump();
+        __set_PRIMASK(primask);
+        return;
+    }
+    g_tx_insane = 0;
+
+    // 累计确认
+    bool sampled = false;
+    uint32_t rtt_us = 0;
+    while (g_snd_una != cum) {
+        CAN_RLink_TxEntry_t *entry = &g_tx_ring[g_snd_una & CAN_RLINK_RING_MASK];
+        if ((entry->flags & CAN_RLINK_FLAG_RETX) != 0U) {
+            g_retx_count--;
+        }
+        if (entry->tx_count == 1U && (entry->flags & CAN_RLINK_FLAG_SACKED) == 0U) {
+            rtt_us = now - entry->sent_us;
+            sampled = true;
+        }
+        entry->flags = 0;
+        g_stats.acked_frames++;
+        g_stats.acked_bytes += entry->len;
+        g_snd_una++;
+    }
+
+    // 选择确认与快速重传: 从最新的在途帧向前扫描，统计其后已到达的帧数
+    in_flight = (uint8_t)(g_snd_nxt - g_snd_una);
+    uint8_t above = 0;
+    for (int16_t k = (int16_t)in_flight - 1; k >= 0; k--) {
+        CAN_RLink_TxEntry_t *entry = &g_tx_ring[(uint8_t)(g_snd_una + k) & CAN_RLINK_RING_MASK];
+        if (k >= 1 && (uint32_t)(k - 1) < CAN_RLINK_SACK_BITS && (sack & (1UL << (k - 1))) != 0U) {
+            if ((entry->flags & CAN_RLINK_FLAG_SACKED) == 0U) {
+                if ((entry->flags & CAN_RLINK_FLAG_RETX) != 0U) {
+                    g_retx_count--;
+                }
+                if (entry->tx_count == 1U) {
+                    rtt_us = now - entry->sent_us;
+                    sampled = true;
+                }
+                entry->flags = CAN_RLINK_FLAG_SACKED;
+            }
+            above++;
+        } else if (above >= CAN_RLINK_DUP_THRESH && entry->tx_count == 1U &&
+                   (entry->flags & (CAN_RLINK_FLAG_SACKED | CAN_RLINK_FLAG_RETX)) == 0U) {
+            entry->flags |= CAN_RLINK_FLAG_RETX;
+            g_retx_count++;
+            g_stats.fast_retransmits++;
+        }
+    }
+
+    if (sampled) {
+        CAN_RLink_UpdateRto(rtt_us);
+    }
+
+    CAN_RLink_Pump();
+
+    __set_PRIMASK(primask);
+
+    // 发送环腾出空间，由任务继续补充测试数据
+    if (advance > 0U && g_bulk_remaining > 0U) {
+        CAN_Event_Notify(CAN_EVENT_TX_DONE);
+    }
+}
+
+/**
+ * @brief 处理对端数据帧
+ * @note  按序到达每CAN_RLINK_ACK_EVERY帧确认一次，不足时由任务补发；
+ *        乱序、重复、越界或填补空洞时立即确认，使发送端尽快得知丢失
+ */
+static void CAN_RLink_HandleData(const uint8_t *data, uint8_t dlc)
+{
+    uint8_t seq = data[0];
+    uint8_t len = (uint8_t)(((dlc > 8U) ? 8U : dlc) - 1U);
+    bool notify = false;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint8_t off = (uint8_t)(seq - g_rcv_nxt);
+
+    // 既不在窗口内也不是近期已交付的序号，连续出现说明对端已重启，以本帧为新起点
+    if (off >= CAN_RLINK_WINDOW_MAX && off < CAN_RLINK_SEQ_STALE) {
+        if (++g_rx_insane >= CAN_RLINK_RESYNC_THRESH) {
+            g_ooo_valid = 0;
+            g_ooo_count = 0;
+            g_unacked = 0;
+            g_rcv_nxt = seq;
+            g_rcv_high = seq;
+            g_rx_insane = 0;
+            g_stats.rx_resyncs++;
+            off = 0;
+        }
+    } else {
+        g_rx_insane = 0;
+    }
+
+    if (off >= CAN_RLINK_SEQ_BEHIND) {
+        // 已交付过的序号: 对端未收到确认而重传
+        g_stats.rx_duplicates++;
+        g_ack_now = true;
+    } else if (off >= CAN_RLink_RxWindow()) {
+        g_stats.rx_dropped++;
+        g_ack_now = true;
+    } else {
+        uint8_t ahead = (uint8_t)(seq - g_rcv_high);
+        if (ahead < CAN_RLINK_SEQ_BEHIND) {
+            g_stats.rx_missing += ahead;
+            g_rcv_high = (uint8_t)(seq + 1U);
+        }
+
+        uint8_t slot = seq & CAN_RLINK_OOO_MASK;
+        if (off == 0U) {
+            bool filled = false;
+
+            CAN_RLink_Deliver(&data[1], len);
+            g_rcv_nxt++;
+
+            while (g_ooo_count > 0U && (g_ooo_valid & (1UL << (g_rcv_nxt & CAN_RLINK_OOO_MASK))) != 0U) {
+                slot = g_rcv_nxt & CAN_RLINK_OOO_MASK;
+                CAN_RLink_Deliver(g_ooo[slot].data, g_ooo[slot].len);
+                g_ooo_valid &= ~(1UL << slot);
+                g_ooo_count--;
+                g_rcv_nxt++;
+                filled = true;
+            }
+
+            g_unacked++;
+            if (filled || g_ooo_count > 0U || g_unacked >= CAN_RLINK_ACK_EVERY) {
+                g_ack_now = true;
+            } else if (!g_ack_delayed) {
+                g_ack_delayed = true;
+                notify = true;
+            }
+        } else if ((g_ooo_valid & (1UL << slot)) != 0U) {
+            g_stats.rx_duplicates++;
+            g_ack_now = true;
+        } else {
+            memcpy(g_ooo[slot].data, &data[1], len);
+            g_ooo[slot].len = len;
+            g_ooo_valid |= (1UL << slot);
+            g_ooo_count++;
+            g_stats.rx_out_of_order++;
+            g_ack_now = true;
+        }
+    }
+
+    if (g_ack_now) {
+        CAN_RLink_Pump();
+    }
+
+    __set_PRIMASK(primask);
+
+    if (notify || g_sink) {
+        CAN_Event_Notify(CAN_EVENT_RX);
+    }
+}
+
+/**
+ * @brief 按序交付一帧到接收队列(接收窗口保证有空间)
+ */
+static void CAN_RLink_Deliver(const uint8_t *data, uint8_t len)
+{
+    if (g_rx_count >= CAN_RLINK_RX_QUEUE) {
+        g_stats.rx_dropped++;
+        return;
+    }
+
+    CAN_RLink_RxEntry_t *entry = &g_rx_queue[(g_rx_head + g_rx_count) % CAN_RLINK_RX_QUEUE];
+    memcpy(entry->data, data, len);
+    entry->len = len;
+    g_rx_count++;
+    g_stats.rx_delivered++;
+}
+
+/**
+ * @brief 发送端重同步: 未确认与排队的数据按对端期望的序号cum重新编号(调用者已关中断)
+ * @note  发送环按序号低位存放，整体循环右移(cum-snd_una)个位置即完成重新编号；
+ *        原在途帧视为未发送，按新序号全部重发
+ */
+static void CAN_RLink_ResyncTx(uint8_t cum)
+{
+    uint8_t pending = (uint8_t)(g_snd_end - g_snd_una);
+    uint8_t shift = (uint8_t)(cum - g_snd_una) & CAN_RLINK_RING_MASK;
+
+    if (shift != 0U) {
+        CAN_RLink_Reverse(0, CAN_RLINK_RING_MASK);
+        CAN_RLink_Reverse(0, (uint8_t)(shift - 1U));
+        CAN_RLink_Reverse(shift, CAN_RLINK_RING_MASK);
+    }
+
+    for (uint8_t k = 0; k < pending; k++) {
+        CAN_RLink_TxEntry_t *entry = &g_tx_ring[(uint8_t)(cum + k) & CAN_RLINK_RING_MASK];
+        entry->flags = 0;
+        entry->tx_count = 0;
+    }
+
+    g_snd_una = cum;
+    g_snd_nxt = cum;
+    g_snd_end = (uint8_t)(cum + pending);
+    g_retx_count = 0;
+    g_probe = false;
+    g_srtt_us = 0;
+    g_rttvar_us = 0;
+    g_rto_us = CAN_RLINK_RTO_INIT_US;
+    g_tx_insane = 0;
+    g_stats.tx_resyncs++;
+}
+
+/**
+ * @brief 反转发送环[first, last]区间
+ */
+static void CAN_RLink_Reverse(uint8_t first, uint8_t last)
+{
+    while (first < last) {
+        CAN_RLink_TxEntry_t tmp = g_tx_ring[first];
+        g_tx_ring[first] = g_tx_ring[last];
+        g_tx_ring[last] = tmp;
+        first++;
+        last--;
+    }
+}
+
+/**
+ * @brief 按RTT样本更新重传超时(RTO = SRTT + 4*RTTVAR)
+ */
+static void CAN_RLink_UpdateRto(uint32_t rtt_us)
+{
+    if (g_srtt_us == 0U) {
+        g_srtt_us = rtt_us;
+        g_rttvar_us = rtt_us / 2U;
+    } else {
+        uint32_t diff = (g_srtt_us > rtt_us) ? g_srtt_us - rtt_us : rtt_us - g_srtt_us;
+        g_rttvar_us = (3U * g_rttvar_us + diff) / 4U;
+        g_srtt_us = (7U * g_srtt_us + rtt_us) / 8U;
+    }
+
+    uint32_t rto = g_srtt_us + 4U * g_rttvar_us;
+    if (rto < CAN_RLINK_RTO_MIN_US) {
+        rto = CAN_RLINK_RTO_MIN_US;
+    } else if (rto > CAN_RLINK_RTO_MAX_US) {
+        rto = CAN_RLINK_RTO_MAX_US;
+    }
+    g_rto_us = rto;
+}
+
+/**
+ * @brief 串口命令: 可靠链路状态/配置/测试
+ */
+static void CAN_RLink_HandleCtrl(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    CAN_RLink_Stats_t stats;
+
+    if (len == 0U) {
+        CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+        return;
+    }
+
+    switch (payload[0]) {
+        case CAN_RLINK_CTRL_STATUS:
+            CAN_RLink_GetStats(&stats);
+            CAN_Cmd_SendResponse(cmd, (const uint8_t *)&stats, sizeof(stats));
+            break;
+
+        case CAN_RLINK_CTRL_CONFIG:
+            if (len != 3U) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+            } else if (CAN_RLink_SetWindow(payload[1]) != CAN_TESTBOX_OK) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_PARAM);
+            } else {
+                g_sink = (payload[2] != 0U);
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_OK);
+            }
+            break;
+
+        case CAN_RLINK_CTRL_CLEAR:
+            CAN_RLink_ResetStats();
+            CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_OK);
+            break;
+
+        case CAN_RLINK_CTRL_BULK:
+            if (len != 5U) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+            } else {
+                g_bulk_remaining = (uint32_t)payload[1] | ((uint32_t)payload[2] << 8) |
+                                   ((uint32_t)payload[3] << 16) | ((uint32_t)payload[4] << 24);
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_OK);
+            }
+            break;
+
+        case CAN_RLINK_CTRL_RESET:
+            CAN_RLink_Reset();
+            CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_OK);
+            break;
+
+        default:
+            CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_PARAM);
+            break;
+    }
+}
@@ -0,0 +1,219 @@
+/**
+ * @file can_testbox_rtstats.c
+ * @brief CAN测试盒任务运行时统计实现
+ * @version 1.0
+ * @date 2024
+ */
+
+#include "can_testbox_rtstats.h"
+#include "can_testbox_timestamp.h"
+#include "can_testbox_cmd.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <string.h>
+
+/* ========================= 私有类型定义 ========================= */
+
+/**
+ * @brief 上次采样的任务运行时间
+ */
+typedef struct {
+    UBaseType_t task_number;
+    uint32_t run_time;
+} CAN_RtStats_Prev_t;
+
+/* ========================= 私有变量定义 ========================= */
+
+// 中断嵌套深度与累计周期数(只由最外层中断写入)
+static volatile uint32_t g_isr_nesting = 0;
+static volatile uint64_t g_isr_cycles = 0;
+
+// 统计窗口起点(仅在任务中访问)
+static uint32_t g_window_start_us = 0;
+static uint64_t g_window_isr_cycles = 0;
+static CAN_RtStats_Prev_t g_prev[CAN_RTSTATS_MAX_TASKS];
+static uint8_t g_prev_count = 0;
+
+// uxTaskGetSystemState缓冲区
+static TaskStatus_t g_task_status[CAN_RTSTATS_MAX_TASKS];
+
+/* ========================= 私有函数声明 ========================= */
+
+static uint32_t CAN_RtStats_FindPrev(UBaseType_t task_number);
+static void CAN_RtStats_HandleGet(uint8_t cmd, const uint8_t *payload, uint8_t len);
+
+/* ========================= 公共API实现 ========================= */
+
+/**
+ * @brief 初始化运行时统计
+ */
+CAN_TestBox_Status_t CAN_RtStats_Init(void)
+{
+    CAN_Timestamp_CycleCounterInit();
+
+    g_window_start_us = CAN_RtStats_GetCounter();
+    g_window_isr_cycles = 0;
+    g_prev_count = 0;
+
+    if (CAN_Cmd_Register(CAN_CMD_ID_RTSTATS_GET, CAN_RtStats_HandleGet) != CAN_TESTBOX_OK) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 采集统计并开始新的统计窗口
+ */
+CAN_TestBox_Status_t CAN_RtStats_Sample(CAN_RtStats_Report_t *report)
+{
+    uint32_t total_run_time;
+
+    if (report == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    memset(report, 0, sizeof(*report));
+
+    UBaseType_t count = uxTaskGetSystemState(g_task_status, CAN_RTSTATS_MAX_TASKS, &total_run_time);
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint64_t isr_cycles = g_isr_cycles;
+    __set_PRIMASK(primask);
+
+    uint32_t window_us = total_run_time - g_window_start_us;
+    report->window_us = window_us;
+    report->heap_free = xPortGetFreeHeapSize();
+    report->heap_min_free = xPortGetMinimumEverFreeHeapSize();
+    report->task_count = (uint8_t)count;
+
+    if (window_us > 0U) {
+        uint64_t window_cycles = (uint64_t)window_us * (SystemCoreClock / 1000000U);
+        uint64_t bp = ((isr_cycles - g_window_isr_cycles) * 10000U) / window_cycles;
+        report->isr_bp = (uint16_t)((bp > 10000U) ? 10000U : bp);
+    }
+
+    for (UBaseType_t i = 0; i < count; i++) {
+        const TaskStatus_t *status = &g_task_status[i];
+        CAN_RtStats_Task_t *task = &report->tasks[i];
+
+        strncpy(task->name, status->pcTaskName, CAN_RTSTATS_NAME_LEN);
+        task->state = (uint8_t)status->eCurrentState;
+        task->priority = (uint8_t)status->uxCurrentPriority;
+        task->stack_free_min = (uint32_t)status->usStackHighWaterMark * sizeof(StackType_t);
+
+        // 窗口内新建的任务从0开始计
+        uint32_t delta = status->ulRunTimeCounter - CAN_RtStats_FindPrev(status->xTaskNumber);
+        if (window_us > 0U) {
+            uint64_t bp = ((uint64_t)delta * 10000U) / window_us;
+            task->cpu_bp = (uint16_t)((bp > 10000U) ? 10000U : bp);
+        }
+    }
+
+    // 记录本次采样作为下一窗口起点
+    for (UBaseType_t i = 0; i < count; i++) {
+        g_prev[i].task_number = g_task_status[i].xTaskNumber;
+        g_prev[i].run_time = g_task_status[i].ulRunTimeCounter;
+    }
+    g_prev_count = (uint8_t)count;
+    g_window_start_us = total_run_time;
+    g_window_isr_cycles = isr_cycles;
+
+    return CAN_TESTBOX_OK;
+}
+
+/* ========================= FreeRTOS/中断钩子 ========================= */
+
+/**
+ * @brief 配置运行时计数器
+ * @note  TIM2已在main()中调度器启动前初始化，这里只使能中断统计用的DWT
+ */
+void CAN_RtStats_ConfigureTimer(void)
+{
+    CAN_Timestamp_CycleCounterInit();
+}
+
+/**
+ * @brief 读取运行时计数器
+ */
+uint32_t CAN_RtStats_GetCounter(void)
+{
+    return CAN_Timestamp_GetUs();
+}
+
+/**
+ * @brief 外设中断入口
+ * @note  嵌套中断在返回前恢复深度，无需关中断
+ */
+uint32_t CAN_RtStats_IsrEnter(void)
+{
+    return (g_isr_nesting++ == 0U) ? CAN_Timestamp_GetCycles() : 0U;
+}
+
+/**
+ * @brief 外设中断出口
+ */
+void CAN_RtStats_IsrExit(uint32_t start)
+{
+    if (--g_isr_nesting == 0U) {
+        g_isr_cycles += CAN_Timestamp_GetCycles() - start;
+    }
+}
+
+/* ========================= 私有函数实现 ========================= */
+
+/**
+ * @brief 查找任务上次采样的运行时间
+ * @return uint32_t: 运行时间，未找到返回0
+ */
+static uint32_t CAN_RtStats_FindPrev(UBaseType_t task_number)
+{
+    for (uint8_t i = 0; i < g_prev_count; i++) {
+        if (g_prev[i].task_number == task_number) {
+            return g_prev[i].run_time;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief 命令0x17: 读取任务运行时统计
+ * @note  应答: 窗口us(u32) 中断占用0.01%(u16) 堆剩余(u32) 堆最小剩余(u32) 任务数(u8)
+ *        + 每任务: 名称(16) 状态(u8) 优先级(u8) CPU占用0.01%(u16) 栈最小剩余字节(u32)
+ *        读取后开始新的统计窗口
+ */
+static void CAN_RtStats_HandleGet(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    (void)payload;
+    (void)len;
+
+    static CAN_RtStats_Report_t report;
+    uint8_t header[15];
+    uint8_t record[CAN_RTSTATS_NAME_LEN + 8];
+
+    CAN_RtStats_Sample(&report);
+
+    memcpy(&header[0], &report.window_us, 4);
+    memcpy(&header[4], &report.isr_bp, 2);
+    memcpy(&header[6], &report.heap_free, 4);
+    memcpy(&header[10], &report.heap_min_free, 4);
+    header[14] = report.task_count;
+
+    CAN_Cmd_ResponseBegin(cmd, (uint16_t)(sizeof(header) + report.task_count * sizeof(record)));
+    CAN_Cmd_ResponseWrite(header, sizeof(header));
+
+    for (uint8_t i = 0; i < report.task_count; i++) {
+        const CAN_RtStats_Task_t *task = &report.tasks[i];
+
+        memcpy(&record[0], task->name, CAN_RTSTATS_NAME_LEN);
+        record[16] = task->state;
+        record[17] = task->priority;
+        memcpy(&record[18], &task->cpu_bp, 2);
+        memcpy(&record[20], &task->stack_free_min, 4);
+        CAN_Cmd_ResponseWrite(record, sizeof(record));
+    }
+
+    CAN_Cmd_ResponseEnd();
+}
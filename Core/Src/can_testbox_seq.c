@@ -0,0 +1,791 @@
+/**
+ * @file can_testbox_seq.c
+ * @brief CAN测试盒测试序列虚拟机实现
+ * @version 1.0
+ * @date 2024
+ */
+
+#include "can_testbox_seq.h"
+#include "can_testbox_frame.h"
+#include "can_testbox_timestamp.h"
+#include "can_testbox_event.h"
+#include "can_testbox_mem.h"
+#include "can_testbox_cmd.h"
+#include "can_testbox_gateway.h"
+#include "can_testbox_peps_scenario.h"
+#include "cmsis_os.h"
+#include <string.h>
+
+/* ========================= 私有宏定义 ========================= */
+
+// 执行任务线程标志
+#define CAN_SEQ_FLAG_RUN            (1UL << 0)  // 开始运行
+#define CAN_SEQ_FLAG_RX             (1UL << 1)  // 等待的报文已到达
+#define CAN_SEQ_FLAG_ABORT          (1UL << 2)  // 中止
+
+#define CAN_SEQ_CH_ANY              0xFFU       // WAIT匹配任意通道
+#define CAN_SEQ_ID_EXT_FLAG         0x80000000U // ID中的扩展帧标志
+#define CAN_SEQ_TIMING_TIMEOUT      0xFFFFFFFFU // WAIT超时的计时结果
+
+/* ========================= 私有类型定义 ========================= */
+
+/**
+ * @brief Flash中的脚本头
+ */
+typedef struct {
+    uint32_t magic;                         // CAN_SEQ_FLASH_MAGIC
+    uint32_t length;                        // 脚本长度
+    uint32_t checksum;                      // 脚本FNV-1a校验
+} CAN_Seq_FlashHeader_t;
+
+/**
+ * @brief 脚本启动的周期报文槽位
+ */
+typedef struct {
+    bool active;
+    CAN_TestBox_Channel_t channel;
+    uint8_t handle;
+    uint8_t dlc;
+    uint8_t data[8];
+} CAN_Seq_Slot_t;
+
+/**
+ * @brief 虚拟机执行上下文
+ */
+typedef struct {
+    uint32_t pc;                            // 下一条指令偏移
+    uint32_t start_us;                      // 开始时间
+    bool flag;                              // 条件标志
+    bool done;                              // 执行到END
+    uint16_t regs[CAN_SEQ_REG_MAX];         // 计数寄存器
+} CAN_Seq_Vm_t;
+
+/* ========================= 私有变量定义 ========================= */
+
+// 执行任务(栈大小见can_testbox_mem.h)
+CAN_TESTBOX_STATIC_TASK(CANSeqTask, CAN_TESTBOX_SEQ_TASK_STACK_WORDS);
+static const osThreadAttr_t g_seq_task_attr = {
+    .name = "CANSeqTask",
+    CAN_TESTBOX_STATIC_TASK_MEM(CANSeqTask),
+    .priority = (osPriority_t) osPriorityAboveNormal,
+};
+static osThreadId_t g_seq_task = NULL;
+
+// 脚本(运行期间只读)
+static uint8_t g_script[CAN_SEQ_SCRIPT_MAX];
+static uint16_t g_script_len = 0;
+
+// 运行控制
+static volatile bool g_running = false;
+static volatile bool g_abort = false;
+static volatile bool g_report_pending = false;
+static CAN_Seq_Result_t g_result;
+static CAN_Seq_Slot_t g_slots[CAN_SEQ_SLOT_MAX];
+
+// 等待匹配(执行任务布置，接收路径命中)
+static volatile bool g_wait_armed = false;
+static volatile bool g_wait_hit = false;
+static uint8_t g_wait_ch = CAN_SEQ_CH_ANY;
+static uint32_t g_wait_id = 0;
+static uint32_t g_wait_mask = 0;
+static uint32_t g_wait_hit_us = 0;
+static CAN_TestBox_Frame_t g_last_rx;
+static bool g_last_rx_valid = false;
+
+/* ========================= 私有函数声明 ========================= */
+
+static void CAN_Seq_TaskEntry(void *argument);
+static void CAN_Seq_Execute(void);
+static CAN_Seq_Error_t CAN_Seq_Step(CAN_Seq_Vm_t *vm);
+static bool CAN_Seq_Fetch(CAN_Seq_Vm_t *vm, void *out, uint32_t len);
+static bool CAN_Seq_Delay(uint32_t us);
+static bool CAN_Seq_Wait(uint8_t ch, uint32_t id, uint32_t mask, uint16_t timeout_ms, uint32_t *elapsed_us);
+static void CAN_Seq_AddTiming(uint32_t us);
+static void CAN_Seq_StopSlots(void);
+static uint32_t CAN_Seq_Checksum(const uint8_t *data, uint32_t len);
+static uint8_t CAN_Seq_StatusToResult(CAN_TestBox_Status_t status);
+static void CAN_Seq_HandleWrite(uint8_t cmd, const uint8_t *payload, uint8_t len);
+static void CAN_Seq_HandleCtrl(uint8_t cmd, const uint8_t *payload, uint8_t len);
+
+/* ========================= 公共API实现 ========================= */
+
+/**
+ * @brief 初始化测试序列虚拟机
+ */
+CAN_TestBox_Status_t CAN_Seq_Init(void)
+{
+    memset(&g_result, 0, sizeof(g_result));
+    memset(g_slots, 0, sizeof(g_slots));
+
+    g_seq_task = osThreadNew(CAN_Seq_TaskEntry, NULL, &g_seq_task_attr);
+    if (g_seq_task == NULL) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    // Flash中无有效脚本时保持空脚本
+    (void)CAN_Seq_Load();
+
+    if (CAN_Cmd_Register(CAN_CMD_ID_SEQ_WRITE, CAN_Seq_HandleWrite) != CAN_TESTBOX_OK ||
+        CAN_Cmd_Register(CAN_CMD_ID_SEQ_CTRL, CAN_Seq_HandleCtrl) != CAN_TESTBOX_OK) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 写入脚本片段
+ */
+CAN_TestBox_Status_t CAN_Seq_Write(uint16_t offset, const uint8_t *data, uint16_t len)
+{
+    if (g_running) {
+        return CAN_TESTBOX_BUSY;
+    }
+
+    if ((data == NULL && len > 0U) || (uint32_t)offset + len > CAN_SEQ_SCRIPT_MAX) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    if (offset == 0U) {
+        g_script_len = 0;
+    } else if (offset > g_script_len) {
+        // 片段必须连续
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    memcpy(&g_script[offset], data, len);
+    if ((uint16_t)(offset + len) > g_script_len) {
+        g_script_len = (uint16_t)(offset + len);
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 开始运行RAM中的脚本
+ */
+CAN_TestBox_Status_t CAN_Seq_Run(void)
+{
+    if (g_seq_task == NULL) {
+        return CAN_TESTBOX_NOT_INITIALIZED;
+    }
+
+    if (g_running) {
+        return CAN_TESTBOX_BUSY;
+    }
+
+    if (g_script_len == 0U) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset(&g_result, 0, sizeof(g_result));
+    g_result.state = CAN_SEQ_STATE_RUNNING;
+    __set_PRIMASK(primask);
+
+    g_abort = false;
+    g_running = true;
+    osThreadFlagsSet(g_seq_task, CAN_SEQ_FLAG_RUN);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 中止运行
+ */
+void CAN_Seq_Stop(void)
+{
+    if (g_running) {
+        g_abort = true;
+        osThreadFlagsSet(g_seq_task, CAN_SEQ_FLAG_ABORT);
+    }
+}
+
+/**
+ * @brief 将RAM中的脚本保存到Flash
+ */
+CAN_TestBox_Status_t CAN_Seq_Save(void)
+{
+    FLASH_EraseInitTypeDef erase = {
+        .TypeErase = FLASH_TYPEERASE_SECTORS,
+        .Sector = CAN_SEQ_FLASH_SECTOR,
+        .NbSectors = 1,
+        .VoltageRange = FLASH_VOLTAGE_RANGE_3
+    };
+    CAN_Seq_FlashHeader_t header = {
+        .magic = CAN_SEQ_FLASH_MAGIC,
+        .length = g_script_len,
+        .checksum = CAN_Seq_Checksum(g_script, g_script_len)
+    };
+    PEPS_Scenario_Status_t scenario;
+    uint32_t sector_error = 0;
+    uint32_t address = CAN_SEQ_FLASH_ADDR;
+    uint32_t word;
+
+    // 擦除期间从Flash取指暂停，所有任务与中断都停顿，正在调度的发送会整体错过时刻
+    if (g_running || CAN_TestBox_HasActivePeriodic() || CAN_Gateway_IsActive() ||
+        (PEPS_Scenario_GetStatus(&scenario) == CAN_TESTBOX_OK && scenario.running != 0U)) {
+        return CAN_TESTBOX_BUSY;
+    }
+
+    HAL_FLASH_Unlock();
+    // 清除之前操作残留的错误标志，否则擦除会被直接判为失败
+    __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR |
+                           FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
+
+    HAL_StatusTypeDef status = HAL_FLASHEx_Erase(&erase, &sector_error);
+
+    // 按字编程，脚本末尾不足一字的部分补0xFF
+    for (uint32_t i = 0; status == HAL_OK && i < sizeof(header); i += 4U, address += 4U) {
+        memcpy(&word, (const uint8_t *)&header + i, 4);
+        status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, address, word);
+    }
+    for (uint32_t i = 0; status == HAL_OK && i < g_script_len; i += 4U, address += 4U) {
+        uint32_t chunk = ((uint32_t)g_script_len - i < 4U) ? ((uint32_t)g_script_len - i) : 4U;
+        word = 0xFFFFFFFFU;
+        memcpy(&word, &g_script[i], chunk);
+        status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, address, word);
+    }
+
+    HAL_FLASH_Lock();
+
+    return (status == HAL_OK) ? CAN_TESTBOX_OK : CAN_TESTBOX_ERROR;
+}
+
+/**
+ * @brief 从Flash载入脚本到RAM
+ */
+CAN_TestBox_Status_t CAN_Seq_Load(void)
+{
+    const CAN_Seq_FlashHeader_t *header = (const CAN_Seq_FlashHeader_t *)CAN_SEQ_FLASH_ADDR;
+    const uint8_t *script = (const uint8_t *)(CAN_SEQ_FLASH_ADDR + sizeof(CAN_Seq_FlashHeader_t));
+
+    if (g_running) {
+        return CAN_TESTBOX_BUSY;
+    }
+
+    if (header->magic != CAN_SEQ_FLASH_MAGIC || header->length == 0U || header->length > CAN_SEQ_SCRIPT_MAX ||
+        header->checksum != CAN_Seq_Checksum(script, header->length)) {
+        return CAN_TESTBOX_NOT_FOUND;
+    }
+
+    memcpy(g_script, script, header->length);
+    g_script_len = (uint16_t)header->length;
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 获取运行结果
+ */
+CAN_TestBox_Status_t CAN_Seq_GetResult(CAN_Seq_Result_t *result)
+{
+    if (result == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *result = g_result;
+    __set_PRIMASK(primask);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 报文输入
+ * @note  只在WAIT布置期间做一次ID比较，命中后立即解除布置并唤醒执行任务
+ */
+void CAN_Seq_InputFrame(const CAN_TestBox_Frame_t *frame)
+{
+    if (!g_wait_armed || frame == NULL) {
+        return;
+    }
+
+    uint32_t key = CAN_Frame_GetId(frame) | (CAN_Frame_IsExtended(frame) ? CAN_SEQ_ID_EXT_FLAG : 0U);
+    bool hit = false;
+
+    // CAN1/CAN2接收中断优先级不同，判断与解除布置需原子完成
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (g_wait_armed &&
+        (g_wait_ch == CAN_SEQ_CH_ANY || g_wait_ch == CAN_Frame_GetChannel(frame)) &&
+        ((key ^ g_wait_id) & g_wait_mask) == 0U) {
+        g_wait_armed = false;
+        g_last_rx = *frame;
+        g_wait_hit_us = CAN_Timestamp_GetUs();
+        g_wait_hit = true;
+        hit = true;
+    }
+    __set_PRIMASK(primask);
+
+    if (hit) {
+        osThreadFlagsSet(g_seq_task, CAN_SEQ_FLAG_RX);
+    }
+}
+
+/**
+ * @brief 上报运行结果
+ */
+void CAN_Seq_Process(void)
+{
+    CAN_Seq_Result_t result;
+
+    if (!g_report_pending) {
+        return;
+    }
+    g_report_pending = false;
+
+    CAN_Seq_GetResult(&result);
+    CAN_Cmd_SendResponse(CAN_CMD_ID_SEQ_CTRL, (const uint8_t *)&result, sizeof(result));
+}
+
+/* ========================= 私有函数实现 ========================= */
+
+/**
+ * @brief 执行任务入口
+ */
+static void CAN_Seq_TaskEntry(void *argument)
+{
+    (void)argument;
+
+    for (;;) {
+        osThreadFlagsWait(CAN_SEQ_FLAG_RUN, osFlagsWaitAny, osWaitForever);
+        CAN_Seq_Execute();
+    }
+}
+
+/**
+ * @brief 执行一次脚本并记录结果
+ */
+static void CAN_Seq_Execute(void)
+{
+    CAN_Seq_Vm_t vm;
+    CAN_Seq_Error_t error = CAN_SEQ_ERR_NONE;
+    uint32_t steps = 0;
+    uint32_t op_pc = 0;
+
+    memset(&vm, 0, sizeof(vm));
+    g_last_rx_valid = false;
+    osThreadFlagsClear(CAN_SEQ_FLAG_RX | CAN_SEQ_FLAG_ABORT);
+    vm.start_us = CAN_Timestamp_GetUs();
+
+    while (!vm.done && error == CAN_SEQ_ERR_NONE && !g_abort) {
+        op_pc = vm.pc;
+        error = CAN_Seq_Step(&vm);
+        steps++;
+    }
+
+    CAN_Seq_StopSlots();
+
+    CAN_Seq_State_t state;
+    if (error != CAN_SEQ_ERR_NONE) {
+        state = CAN_SEQ_STATE_FAIL;
+    } else if (vm.done) {
+        state = CAN_SEQ_STATE_PASS;
+    } else {
+        state = CAN_SEQ_STATE_ABORTED;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    g_result.state = state;
+    g_result.error = error;
+    g_result.pc = op_pc;
+    g_result.steps = steps;
+    g_result.duration_us = CAN_Timestamp_Elapsed(vm.start_us, CAN_Timestamp_GetUs());
+    __set_PRIMASK(primask);
+
+    g_running = false;
+
+    // 由测试盒任务发送结果，避免两个任务同时写串口
+    g_report_pending = true;
+    CAN_Event_Notify(CAN_EVENT_CMD);
+}
+
+/**
+ * @brief 执行一条指令
+ * @return CAN_Seq_Error_t: 失败原因，中止时返回CAN_SEQ_ERR_NONE由调用方判断
+ */
+static CAN_Seq_Error_t CAN_Seq_Step(CAN_Seq_Vm_t *vm)
+{
+    uint8_t op;
+    uint8_t ch, slot, reg, code;
+    uint8_t dlc = 0;
+    uint8_t start_bit, bit_len;
+    uint16_t value16, target, period_ms, timeout_ms;
+    uint32_t id, mask, us, value32, elapsed_us;
+    uint8_t data[8] = {0};
+    uint8_t data_mask[8];
+    CAN_TestBox_Message_t message;
+    CAN_TestBox_Channel_t channel;
+
+    if (!CAN_Seq_Fetch(vm, &op, 1)) {
+        return CAN_SEQ_ERR_TRUNCATED;
+    }
+
+    switch (op) {
+        case CAN_SEQ_OP_END:
+            vm->done = true;
+            return CAN_SEQ_ERR_NONE;
+
+        case CAN_SEQ_OP_SEND:
+            if (!CAN_Seq_Fetch(vm, &ch, 1) || !CAN_Seq_Fetch(vm, &id, 4) || !CAN_Seq_Fetch(vm, &dlc, 1) ||
+                dlc > 8U || !CAN_Seq_Fetch(vm, data, dlc)) {
+                return (dlc > 8U) ? CAN_SEQ_ERR_BAD_OPERAND : CAN_SEQ_ERR_TRUNCATED;
+            }
+            channel = CAN_TestBox_GetChannel((CAN_TestBox_ChannelId_t)ch);
+            if (channel == NULL) {
+                return CAN_SEQ_ERR_BAD_OPERAND;
+            }
+            message.id = id & ~CAN_SEQ_ID_EXT_FLAG;
+            message.is_extended = (id & CAN_SEQ_ID_EXT_FLAG) != 0U;
+            message.is_remote = false;
+            message.dlc = dlc;
+            memcpy(message.data, data, 8);
+            if (CAN_TestBox_ChannelSendSingleFrame(channel, &message) != CAN_TESTBOX_OK) {
+                return CAN_SEQ_ERR_SEND;
+            }
+            return CAN_SEQ_ERR_NONE;
+
+        case CAN_SEQ_OP_PSTART:
+            if (!CAN_Seq_Fetch(vm, &slot, 1) || !CAN_Seq_Fetch(vm, &ch, 1) || !CAN_Seq_Fetch(vm, &id, 4) ||
+                !CAN_Seq_Fetch(vm, &dlc, 1) || !CAN_Seq_Fetch(vm, &period_ms, 2) ||
+                dlc > 8U || !CAN_Seq_Fetch(vm, data, dlc)) {
+                return (dlc > 8U) ? CAN_SEQ_ERR_BAD_OPERAND : CAN_SEQ_ERR_TRUNCATED;
+            }
+            channel = CAN_TestBox_GetChannel((CAN_TestBox_ChannelId_t)ch);
+            if (slot >= CAN_SEQ_SLOT_MAX || channel == NULL) {
+                return CAN_SEQ_ERR_BAD_OPERAND;
+            }
+            if (g_slots[slot].active) {
+                CAN_TestBox_ChannelStopPeriodicMessage(g_slots[slot].channel, g_slots[slot].handle);
+                g_slots[slot].active = false;
+            }
+            message.id = id & ~CAN_SEQ_ID_EXT_FLAG;
+            message.is_extended = (id & CAN_SEQ_ID_EXT_FLAG) != 0U;
+            message.is_remote = false;
+            message.dlc = dlc;
+            memcpy(message.data, data, 8);
+            if (CAN_TestBox_ChannelStartPeriodicMessage(channel, &message, period_ms, &g_slots[slot].handle) != CAN_TESTBOX_OK) {
+                return CAN_SEQ_ERR_PERIODIC;
+            }
+            g_slots[slot].active = true;
+            g_slots[slot].channel = channel;
+            g_slots[slot].dlc = dlc;
+            memcpy(g_slots[slot].data, data, 8);
+            return CAN_SEQ_ERR_NONE;
+
+        case CAN_SEQ_OP_PSTOP:
+            if (!CAN_Seq_Fetch(vm, &slot, 1)) {
+                return CAN_SEQ_ERR_TRUNCATED;
+            }
+            if (slot >= CAN_SEQ_SLOT_MAX) {
+                return CAN_SEQ_ERR_BAD_OPERAND;
+            }
+            if (g_slots[slot].active) {
+                CAN_TestBox_ChannelStopPeriodicMessage(g_slots[slot].channel, g_slots[slot].handle);
+                g_slots[slot].active = false;
+            }
+            return CAN_SEQ_ERR_NONE;
+
+        case CAN_SEQ_OP_WAIT:
+            if (!CAN_Seq_Fetch(vm, &ch, 1) || !CAN_Seq_Fetch(vm, &id, 4) || !CAN_Seq_Fetch(vm, &mask, 4) ||
+                !CAN_Seq_Fetch(vm, &timeout_ms, 2)) {
+                return CAN_SEQ_ERR_TRUNCATED;
+            }
+            vm->flag = CAN_Seq_Wait(ch, id, mask, timeout_ms, &elapsed_us);
+            if (!g_abort) {
+                CAN_Seq_AddTiming(vm->flag ? elapsed_us : CAN_SEQ_TIMING_TIMEOUT);
+            }
+            return CAN_SEQ_ERR_NONE;
+
+        case CAN_SEQ_OP_CHECK:
+            if (!CAN_Seq_Fetch(vm, data, 8) || !CAN_Seq_Fetch(vm, data_mask, 8)) {
+                return CAN_SEQ_ERR_TRUNCATED;
+            }
+            vm->flag = g_last_rx_valid;
+            for (uint32_t i = 0; i < 8U && vm->flag; i++) {
+                if (((CAN_Frame_ConstData(&g_last_rx)[i] ^ data[i]) & data_mask[i]) != 0U) {
+                    vm->flag = false;
+                }
+            }
+            return CAN_SEQ_ERR_NONE;
+
+        case CAN_SEQ_OP_ASSERT:
+            return vm->flag ? CAN_SEQ_ERR_NONE : CAN_SEQ_ERR_ASSERT;
+
+        case CAN_SEQ_OP_DELAY:
+            if (!CAN_Seq_Fetch(vm, &us, 4)) {
+                return CAN_SEQ_ERR_TRUNCATED;
+            }
+            (void)CAN_Seq_Delay(us);
+            return CAN_SEQ_ERR_NONE;
+
+        case CAN_SEQ_OP_SETR:
+            if (!CAN_Seq_Fetch(vm, &reg, 1) || !CAN_Seq_Fetch(vm, &value16, 2)) {
+                return CAN_SEQ_ERR_TRUNCATED;
+            }
+            if (reg >= CAN_SEQ_REG_MAX) {
+                return CAN_SEQ_ERR_BAD_OPERAND;
+            }
+            vm->regs[reg] = value16;
+            return CAN_SEQ_ERR_NONE;
+
+        case CAN_SEQ_OP_DJNZ:
+            if (!CAN_Seq_Fetch(vm, &reg, 1) || !CAN_Seq_Fetch(vm, &target, 2)) {
+                return CAN_SEQ_ERR_TRUNCATED;
+            }
+            if (reg >= CAN_SEQ_REG_MAX || target >= g_script_len) {
+                return CAN_SEQ_ERR_BAD_OPERAND;
+            }
+            if (vm->regs[reg] > 0U && --vm->regs[reg] > 0U) {
+                vm->pc = target;
+            }
+            return CAN_SEQ_ERR_NONE;
+
+        case CAN_SEQ_OP_JMP:
+        case CAN_SEQ_OP_JZ:
+        case CAN_SEQ_OP_JNZ:
+            if (!CAN_Seq_Fetch(vm, &target, 2)) {
+                return CAN_SEQ_ERR_TRUNCATED;
+            }
+            if (target >= g_script_len) {
+                return CAN_SEQ_ERR_BAD_OPERAND;
+            }
+            if (op == CAN_SEQ_OP_JMP || (op == CAN_SEQ_OP_JZ && !vm->flag) || (op == CAN_SEQ_OP_JNZ && vm->flag)) {
+                vm->pc = target;
+            }
+            return CAN_SEQ_ERR_NONE;
+
+        case CAN_SEQ_OP_SIGNAL:
+            if (!CAN_Seq_Fetch(vm, &slot, 1) || !CAN_Seq_Fetch(vm, &start_bit, 1) ||
+                !CAN_Seq_Fetch(vm, &bit_len, 1) || !CAN_Seq_Fetch(vm, &value32, 4)) {
+                return CAN_SEQ_ERR_TRUNCATED;
+            }
+            if (slot >= CAN_SEQ_SLOT_MAX || !g_slots[slot].active || bit_len == 0U || bit_len > 32U ||
+                (uint32_t)start_bit + bit_len > 64U) {
+                return CAN_SEQ_ERR_BAD_OPERAND;
+            }
+            // Intel字节序: 起始位为最低有效位，按位号递增写入
+            for (uint32_t i = 0; i < bit_len; i++) {
+                uint32_t bit = (uint32_t)start_bit + i;
+                uint8_t bit_mask = (uint8_t)(1U << (bit & 7U));
+                if ((value32 >> i) & 1U) {
+                    g_slots[slot].data[bit >> 3] |= bit_mask;
+                } else {
+                    g_slots[slot].data[bit >> 3] &= (uint8_t)~bit_mask;
+                }
+            }
+            if (CAN_TestBox_ChannelModifyPeriodicData(g_slots[slot].channel, g_slots[slot].handle,
+                                                      g_slots[slot].data, g_slots[slot].dlc) != CAN_TESTBOX_OK) {
+                return CAN_SEQ_ERR_PERIODIC;
+            }
+            return CAN_SEQ_ERR_NONE;
+
+        case CAN_SEQ_OP_FAIL:
+            if (!CAN_Seq_Fetch(vm, &code, 1)) {
+                return CAN_SEQ_ERR_TRUNCATED;
+            }
+            return (CAN_Seq_Error_t)(CAN_SEQ_ERR_USER | (code & 0x7FU));
+
+        case CAN_SEQ_OP_MARK:
+            CAN_Seq_AddTiming(CAN_Timestamp_Elapsed(vm->start_us, CAN_Timestamp_GetUs()));
+            return CAN_SEQ_ERR_NONE;
+
+        default:
+            return CAN_SEQ_ERR_BAD_OPCODE;
+    }
+}
+
+/**
+ * @brief 读取操作数
+ * @return bool: 脚本剩余长度不足返回false
+ */
+static bool CAN_Seq_Fetch(CAN_Seq_Vm_t *vm, void *out, uint32_t len)
+{
+    if (vm->pc + len > g_script_len) {
+        return false;
+    }
+
+    memcpy(out, &g_script[vm->pc], len);
+    vm->pc += len;
+
+    return true;
+}
+
+/**
+ * @brief 微秒延时
+ * @note  整毫秒部分阻塞等待(少等1个tick以免超过目标时刻)，剩余部分按TIM2忙等
+ * @return bool: 被中止返回false
+ */
+static bool CAN_Seq_Delay(uint32_t us)
+{
+    uint32_t start_us = CAN_Timestamp_GetUs();
+
+    if (us >= 2000U) {
+        uint32_t flags = osThreadFlagsWait(CAN_SEQ_FLAG_ABORT, osFlagsWaitAny, (us / 1000U) - 1U);
+        if ((flags & osFlagsError) == 0U) {
+            return false;
+        }
+    }
+
+    while (CAN_Timestamp_Elapsed(start_us, CAN_Timestamp_GetUs()) < us) {
+        if (g_abort) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief 等待匹配报文
+ * @param elapsed_us: 命中时输出等待时长
+ * @return bool: true-命中, false-超时或中止
+ */
+static bool CAN_Seq_Wait(uint8_t ch, uint32_t id, uint32_t mask, uint16_t timeout_ms, uint32_t *elapsed_us)
+{
+    osThreadFlagsClear(CAN_SEQ_FLAG_RX);
+
+    uint32_t start_us = CAN_Timestamp_GetUs();
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    g_wait_ch = ch;
+    g_wait_id = id;
+    g_wait_mask = mask;
+    g_wait_hit = false;
+    g_wait_armed = true;
+    __set_PRIMASK(primask);
+
+    osThreadFlagsWait(CAN_SEQ_FLAG_RX | CAN_SEQ_FLAG_ABORT, osFlagsWaitAny, timeout_ms);
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    g_wait_armed = false;
+    bool hit = g_wait_hit;
+    __set_PRIMASK(primask);
+
+    if (hit) {
+        g_last_rx_valid = true;
+        *elapsed_us = CAN_Timestamp_Elapsed(start_us, g_wait_hit_us);
+    }
+
+    return hit;
+}
+
+/**
+ * @brief 追加计时结果(超出容量后丢弃)
+ */
+static void CAN_Seq_AddTiming(uint32_t us)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (g_result.timing_count < CAN_SEQ_TIMING_MAX) {
+        g_result.timings[g_result.timing_count++] = us;
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 停止脚本启动的全部周期报文
+ */
+static void CAN_Seq_StopSlots(void)
+{
+    for (uint32_t i = 0; i < CAN_SEQ_SLOT_MAX; i++) {
+        if (g_slots[i].active) {
+            CAN_TestBox_ChannelStopPeriodicMessage(g_slots[i].channel, g_slots[i].handle);
+            g_slots[i].active = false;
+        }
+    }
+}
+
+/**
+ * @brief 脚本校验(FNV-1a)
+ */
+static uint32_t CAN_Seq_Checksum(const uint8_t *data, uint32_t len)
+{
+    uint32_t hash = 2166136261U;
+
+    for (uint32_t i = 0; i < len; i++) {
+        hash = (hash ^ data[i]) * 16777619U;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief 返回状态转换为应答状态码
+ */
+static uint8_t CAN_Seq_StatusToResult(CAN_TestBox_Status_t status)
+{
+    switch (status) {
+        case CAN_TESTBOX_OK:
+            return CAN_CMD_RESULT_OK;
+        case CAN_TESTBOX_INVALID_PARAM:
+            return CAN_CMD_RESULT_BAD_PARAM;
+        default:
+            return CAN_CMD_RESULT_FAILED;
+    }
+}
+
+/**
+ * @brief 命令0x19: 写入脚本片段
+ * @note  请求: 偏移(u16) + 脚本数据，偏移0开始新脚本，后续片段须紧接已写入部分
+ */
+static void CAN_Seq_HandleWrite(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    uint16_t offset;
+
+    if (len < 2U) {
+        CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+        return;
+    }
+
+    memcpy(&offset, payload, 2);
+    CAN_Cmd_SendResult(cmd, CAN_Seq_StatusToResult(CAN_Seq_Write(offset, &payload[2], (uint16_t)(len - 2U))));
+}
+
+/**
+ * @brief 命令0x1A: 序列控制
+ * @note  请求: 操作(u8)，见CAN_SEQ_CTRL_xxx
+ *        应答: 读取状态时为CAN_Seq_Result_t(u32小端)，其余为状态码；
+ *        序列结束时另外主动发送一次与读取状态相同格式的应答
+ */
+static void CAN_Seq_HandleCtrl(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    CAN_Seq_Result_t result;
+    CAN_TestBox_Status_t status;
+
+    if (len != 1U) {
+        CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+        return;
+    }
+
+    switch (payload[0]) {
+        case CAN_SEQ_CTRL_RUN:
+            status = CAN_Seq_Run();
+            break;
+        case CAN_SEQ_CTRL_STOP:
+            CAN_Seq_Stop();
+            status = CAN_TESTBOX_OK;
+            break;
+        case CAN_SEQ_CTRL_SAVE:
+            status = CAN_Seq_Save();
+            break;
+        case CAN_SEQ_CTRL_LOAD:
+            status = CAN_Seq_Load();
+            break;
+        case CAN_SEQ_CTRL_STATUS:
+            CAN_Seq_GetResult(&result);
+            CAN_Cmd_SendResponse(cmd, (const uint8_t *)&result, sizeof(result));
+            return;
+        default:
+            status = CAN_TESTBOX_INVALID_PARAM;
+            break;
+    }
+
+    CAN_Cmd_SendResult(cmd, CAN_Seq_StatusToResult(status));
+}
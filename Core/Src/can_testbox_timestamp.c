@@ -0,0 +1,113 @@
+/**
+ * @file can_testbox_timestamp.c
+ * @brief CAN测试盒硬件微秒时间戳实现
+ * @version 1.0
+ * @date 2024
+ */
+
+#include "can_testbox_timestamp.h"
+
+/* ========================= 私有变量定义 ========================= */
+
+// TIM2句柄 (APB1定时器, 32位计数器)
+static TIM_HandleTypeDef g_htim_timestamp;
+
+// 定时闹钟回调
+static volatile CAN_Timestamp_AlarmCallback_t g_alarm_callback = NULL;
+
+/* ========================= 公共API实现 ========================= */
+
+/**
+ * @brief 初始化硬件时间戳定时器
+ * @note  TIM2挂在APB1上，APB1分频不为1时定时器时钟为PCLK1的2倍
+ */
+HAL_StatusTypeDef CAN_Timestamp_Init(void)
+{
+    RCC_ClkInitTypeDef clkconfig;
+    uint32_t flash_latency;
+    uint32_t tim_clock;
+
+    __HAL_RCC_TIM2_CLK_ENABLE();
+
+    // 计算TIM2输入时钟
+    HAL_RCC_GetClockConfig(&clkconfig, &flash_latency);
+    tim_clock = HAL_RCC_GetPCLK1Freq();
+    if (clkconfig.APB1CLKDivider != RCC_HCLK_DIV1) {
+        tim_clock *= 2U;
+    }
+
+    g_htim_timestamp.Instance = TIM2;
+    g_htim_timestamp.Init.Prescaler = (tim_clock / CAN_TIMESTAMP_FREQ_HZ) - 1U;
+    g_htim_timestamp.Init.CounterMode = TIM_COUNTERMODE_UP;
+    g_htim_timestamp.Init.Period = 0xFFFFFFFFU;
+    g_htim_timestamp.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    g_htim_timestamp.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+
+    if (HAL_TIM_Base_Init(&g_htim_timestamp) != HAL_OK) {
+        return HAL_ERROR;
+    }
+
+    // 调试暂停时同步冻结计数器，保证单步调试时时间戳连续
+    __HAL_DBGMCU_FREEZE_TIM2();
+
+    // 比较通道1仅用于闹钟中断，不输出到引脚；NVIC提前使能，由CC1IE控制
+    HAL_NVIC_SetPriority(TIM2_IRQn, CAN_TIMESTAMP_ALARM_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(TIM2_IRQn);
+
+    // 仅启动计数，不开启更新中断
+    return HAL_TIM_Base_Start(&g_htim_timestamp);
+}
+
+/**
+ * @brief 设置单次定时闹钟
+ * @note  比较匹配只在CNT等于CCR1时产生，写入时已经错过的时刻用软件产生事件
+ */
+void CAN_Timestamp_SetAlarm(uint32_t at_us, CAN_Timestamp_AlarmCallback_t callback)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    g_alarm_callback = callback;
+    TIM2->CCR1 = at_us;
+    TIM2->SR = ~(uint32_t)TIM_SR_CC1IF;
+    TIM2->DIER |= TIM_DIER_CC1IE;
+
+    if ((int32_t)(at_us - TIM2->CNT) <= 0 && (TIM2->SR & TIM_SR_CC1IF) == 0U) {
+        TIM2->EGR = TIM_EGR_CC1G;
+    }
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 取消定时闹钟
+ */
+void CAN_Timestamp_CancelAlarm(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    TIM2->DIER &= ~(uint32_t)TIM_DIER_CC1IE;
+    TIM2->SR = ~(uint32_t)TIM_SR_CC1IF;
+    g_alarm_callback = NULL;
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief TIM2中断处理
+ */
+void CAN_Timestamp_IRQHandler(void)
+{
+    if ((TIM2->SR & TIM_SR_CC1IF) != 0U && (TIM2->DIER & TIM_DIER_CC1IE) != 0U) {
+        // 单次闹钟: 先关闭再回调，回调中可重新设置
+        TIM2->DIER &= ~(uint32_t)TIM_DIER_CC1IE;
+        TIM2->SR = ~(uint32_t)TIM_SR_CC1IF;
+
+        CAN_Timestamp_AlarmCallback_t callback = g_alarm_callback;
+        g_alarm_callback = NULL;
+        if (callback != NULL) {
+            callback();
+        }
+    }
+}
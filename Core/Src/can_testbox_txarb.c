@@ -0,0 +1,698 @@
+/**
+ * @file can_testbox_txarb.c
+ * @brief 片内CAN发送仲裁实现
+ * @version 1.0
+ * @date 2024
+ */
+
+#include "can_testbox_txarb.h"
+#include "can_testbox_frame.h"
+#include "can_testbox_timestamp.h"
+#include "can_testbox_cmd.h"
+#include "can.h"
+#include <string.h>
+
+/* ========================= 私有宏定义 ========================= */
+
+#define CAN_TXARB_MAILBOXES         3U
+#define CAN_TXARB_RQCP_ALL          (CAN_TSR_RQCP0 | CAN_TSR_RQCP1 | CAN_TSR_RQCP2)
+
+/* ========================= 私有类型定义 ========================= */
+
+/**
+ * @brief 排队项
+ */
+typedef struct {
+    CAN_TestBox_Frame_t frame;
+    uint32_t key;                           // 总线仲裁顺序键(越小越优先)
+    uint32_t enqueue_us;                    // 入队时间
+    uint8_t tag;                            // 替换标签(0为不替换)
+} CAN_TxArb_Entry_t;
+
+/**
+ * @brief 分类队列(按键降序存放，末尾为下一帧)
+ */
+typedef struct {
+    CAN_TxArb_Entry_t entries[CAN_TXARB_QUEUE_DEPTH];
+    uint8_t count;                          // 排队数
+    uint8_t in_mailbox;                     // 已装入邮箱数
+} CAN_TxArb_Queue_t;
+
+/**
+ * @brief 仲裁器装入的邮箱
+ */
+typedef struct {
+    CAN_TxArb_Entry_t entry;
+    CAN_TxArb_Entry_t replacement;          // 中止成功后顶替的同标签新实例
+    uint8_t tx_class;
+    bool owned;                             // 由仲裁器装入且尚未结束
+    bool has_replacement;
+} CAN_TxArb_Mailbox_t;
+
+/**
+ * @brief 分类统计(内部)
+ */
+typedef struct {
+    uint32_t submitted;
+    uint32_t sent;
+    uint32_t preempted;
+    uint32_t replaced;
+    uint32_t failed;
+    uint32_t dropped;
+    uint32_t queue_peak;
+    uint32_t latency_max_us;
+    uint64_t latency_sum_us;
+} CAN_TxArb_Counters_t;
+
+/**
+ * @brief 单通道仲裁上下文
+ */
+typedef struct {
+    CAN_HandleTypeDef *hcan;
+    bool preempt;                           // 允许抢占
+    uint32_t aborting;                      // 已请求中止的邮箱(CAN_TX_MAILBOXn位)
+    CAN_TxArb_Queue_t queues[CAN_TXARB_CLASS_COUNT];
+    CAN_TxArb_Mailbox_t mailboxes[CAN_TXARB_MAILBOXES];
+    CAN_TxArb_Counters_t counters[CAN_TXARB_CLASS_COUNT];
+    uint32_t depth_peak;                    // 全部分类待发送帧数(排队+邮箱)峰值
+} CAN_TxArb_Context_t;
+
+/* ========================= 私有变量定义 ========================= */
+
+// 静态初始化句柄，初始化之前的发送(如双节点ACK)也可排队
+static CAN_TxArb_Context_t g_contexts[CAN_TXARB_CH_COUNT] = {
+    { .hcan = &hcan1, .preempt = true },
+    { .hcan = &hcan2, .preempt = true }
+};
+
+// 发送确认回调
+static CAN_TxArb_ConfirmCallback_t g_confirm_callbacks[CAN_TXARB_CONFIRM_MAX];
+
+/* ========================= 私有函数声明 ========================= */
+
+static CAN_TxArb_Context_t* CAN_TxArb_FindContext(CAN_HandleTypeDef *hcan);
+static uint32_t CAN_TxArb_Key(const CAN_TestBox_Frame_t *frame);
+static bool CAN_TxArb_Outranks(uint8_t class_a, uint32_t key_a, uint8_t class_b, uint32_t key_b);
+static void CAN_TxArb_Insert(CAN_TxArb_Queue_t *queue, const CAN_TxArb_Entry_t *entry, bool requeue);
+static bool CAN_TxArb_Replace(CAN_TxArb_Context_t *ctx, uint8_t tx_class, const CAN_TxArb_Entry_t *entry);
+static void CAN_TxArb_Release(CAN_TxArb_Context_t *ctx, uint32_t index, bool requeue);
+static void CAN_TxArb_Confirm(const CAN_TxArb_Context_t *ctx, const CAN_TxArb_Mailbox_t *slot, uint32_t done_us, bool sent);
+static void CAN_TxArb_Kick(CAN_TxArb_Context_t *ctx);
+static void CAN_TxArb_HandleCtrl(uint8_t cmd, const uint8_t *payload, uint8_t len);
+
+/* ========================= 公共API实现 ========================= */
+
+/**
+ * @brief 初始化发送仲裁
+ */
+CAN_TestBox_Status_t CAN_TxArb_Init(void)
+{
+    for (uint8_t ch = 0; ch < CAN_TXARB_CH_COUNT; ch++) {
+        g_contexts[ch].preempt = true;
+        CAN_TxArb_ResetStats((CAN_TestBox_ChannelId_t)ch);
+    }
+
+    if (CAN_Cmd_Register(CAN_CMD_ID_TXARB_CTRL, CAN_TxArb_HandleCtrl) != CAN_TESTBOX_OK) {
+        return CAN_TESTBOX_ERROR;
+    }
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 提交一帧
+ */
+CAN_TestBox_Status_t CAN_TxArb_Submit(CAN_TestBox_ChannelId_t ch, uint8_t tx_class, uint8_t tag,
+                                      const CAN_TestBox_Frame_t *frame)
+{
+    if (ch >= CAN_TXARB_CH_COUNT || tx_class >= CAN_TXARB_CLASS_COUNT || frame == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    CAN_TxArb_Context_t *ctx = &g_contexts[ch];
+    CAN_TxArb_Queue_t *queue = &ctx->queues[tx_class];
+    CAN_TxArb_Counters_t *counters = &ctx->counters[tx_class];
+    CAN_TxArb_Entry_t entry;
+
+    entry.frame = *frame;
+    entry.key = CAN_TxArb_Key(frame);
+    entry.enqueue_us = CAN_Timestamp_GetUs();
+    entry.tag = tag;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    // 同标签的上一实例尚未发出时由本帧替换，不占用新容量
+    if (tag != 0U && CAN_TxArb_Replace(ctx, tx_class, &entry)) {
+        counters->submitted++;
+        __set_PRIMASK(primask);
+        return CAN_TESTBOX_OK;
+    }
+
+    if ((uint32_t)queue->count + queue->in_mailbox >= CAN_TXARB_QUEUE_DEPTH) {
+        counters->dropped++;
+        __set_PRIMASK(primask);
+        return CAN_TESTBOX_QUEUE_FULL;
+    }
+
+    CAN_TxArb_Insert(queue, &entry, false);
+    counters->submitted++;
+    if (queue->count > counters->queue_peak) {
+        counters->queue_peak = queue->count;
+    }
+
+    uint32_t depth = 0;
+    for (uint8_t c = 0; c < CAN_TXARB_CLASS_COUNT; c++) {
+        depth += (uint32_t)ctx->queues[c].count + ctx->queues[c].in_mailbox;
+    }
+    if (depth > ctx->depth_peak) {
+        ctx->depth_peak = depth;
+    }
+
+    CAN_TxArb_Kick(ctx);
+
+    __set_PRIMASK(primask);
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 注册发送确认回调
+ */
+CAN_TestBox_Status_t CAN_TxArb_AddConfirmCallback(CAN_TxArb_ConfirmCallback_t callback)
+{
+    if (callback == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    CAN_TestBox_Status_t status = CAN_TESTBOX_QUEUE_FULL;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint8_t i = 0; i < CAN_TXARB_CONFIRM_MAX; i++) {
+        if (g_confirm_callbacks[i] == callback) {
+            status = CAN_TESTBOX_OK;
+            break;
+        }
+        if (g_confirm_callbacks[i] == NULL) {
+            g_confirm_callbacks[i] = callback;
+            status = CAN_TESTBOX_OK;
+            break;
+        }
+    }
+    __set_PRIMASK(primask);
+
+    return status;
+}
+
+/**
+ * @brief 邮箱发送完成
+ */
+void CAN_TxArb_ProcessTxComplete(CAN_HandleTypeDef *hcan, uint32_t mailbox, uint32_t done_us)
+{
+    CAN_TxArb_Context_t *ctx = CAN_TxArb_FindContext(hcan);
+    if (ctx == NULL) {
+        return;
+    }
+
+    uint32_t index = mailbox >> 1;          // CAN_TX_MAILBOX0/1/2 = 1/2/4
+    CAN_TxArb_Mailbox_t *slot = &ctx->mailboxes[index];
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    // 中止请求晚于发送完成时按正常完成处理
+    ctx->aborting &= ~mailbox;
+
+    if (slot->owned) {
+        CAN_TxArb_Counters_t *counters = &ctx->counters[slot->tx_class];
+        uint32_t latency_us = done_us - slot->entry.enqueue_us;
+
+        counters->sent++;
+        counters->latency_sum_us += latency_us;
+        if (latency_us > counters->latency_max_us) {
+            counters->latency_max_us = latency_us;
+        }
+        CAN_TxArb_Confirm(ctx, slot, done_us, true);
+        CAN_TxArb_Release(ctx, index, false);
+    }
+
+    CAN_TxArb_Kick(ctx);
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 邮箱中止完成: 被抢占的报文回到队列，待替换的由新实例顶替
+ */
+void CAN_TxArb_ProcessAbort(CAN_HandleTypeDef *hcan, uint32_t mailbox)
+{
+    CAN_TxArb_Context_t *ctx = CAN_TxArb_FindContext(hcan);
+    if (ctx == NULL) {
+        return;
+    }
+
+    uint32_t index = mailbox >> 1;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    ctx->aborting &= ~mailbox;
+    if (ctx->mailboxes[index].owned) {
+        CAN_TxArb_Release(ctx, index, true);
+    }
+
+    CAN_TxArb_Kick(ctx);
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 回收因仲裁丢失/发送错误而结束的邮箱
+ * @note  HAL在发送中断中清除RQCP后，按TXOK/ALST/TERR分别回调完成、累积错误码或
+ *        回调中止，全部邮箱处理完后才把HAL_CAN_ERROR_TX_ALSTx/TERRx写入错误码并
+ *        回调错误。只按这些位判定失败，不按邮箱状态推断：其他中断进入错误回调时
+ *        (错误码中没有发送失败位)不会把尚未回调完成的邮箱当作失败。错误码在本次
+ *        错误回调末尾由错误统计清除。请求过中止的回到队列，其余按单次发送模式丢弃
+ */
+void CAN_TxArb_ProcessError(CAN_HandleTypeDef *hcan)
+{
+    CAN_TxArb_Context_t *ctx = CAN_TxArb_FindContext(hcan);
+    if (ctx == NULL) {
+        return;
+    }
+
+    uint32_t error = HAL_CAN_GetError(hcan);
+    uint32_t now_us = CAN_Timestamp_GetUs();
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    for (uint32_t index = 0; index < CAN_TXARB_MAILBOXES; index++) {
+        uint32_t mailbox = 1UL << index;
+        uint32_t fail_bits = (HAL_CAN_ERROR_TX_ALST0 | HAL_CAN_ERROR_TX_TERR0) << (2U * index);
+        CAN_TxArb_Mailbox_t *slot = &ctx->mailboxes[index];
+
+        if (!slot->owned || (error & fail_bits) == 0U) {
+            continue;
+        }
+
+        if ((ctx->aborting & mailbox) != 0U) {
+            ctx->aborting &= ~mailbox;
+            CAN_TxArb_Release(ctx, index, true);
+        } else {
+            ctx->counters[slot->tx_class].failed++;
+            CAN_TxArb_Confirm(ctx, slot, now_us, false);
+            CAN_TxArb_Release(ctx, index, false);
+        }
+    }
+
+    CAN_TxArb_Kick(ctx);
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 允许/禁止邮箱抢占
+ */
+CAN_TestBox_Status_t CAN_TxArb_SetPreemption(CAN_TestBox_ChannelId_t ch, bool enable)
+{
+    if (ch >= CAN_TXARB_CH_COUNT) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    g_contexts[ch].preempt = enable;
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 获取分类统计
+ */
+CAN_TestBox_Status_t CAN_TxArb_GetStats(CAN_TestBox_ChannelId_t ch, uint8_t tx_class, CAN_TxArb_ClassStats_t *stats)
+{
+    if (ch >= CAN_TXARB_CH_COUNT || tx_class >= CAN_TXARB_CLASS_COUNT || stats == NULL) {
+        return CAN_TESTBOX_INVALID_PARAM;
+    }
+
+    const CAN_TxArb_Context_t *ctx = &g_contexts[ch];
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    CAN_TxArb_Counters_t counters = ctx->counters[tx_class];
+    uint32_t queued = ctx->queues[tx_class].count;
+    __set_PRIMASK(primask);
+
+    stats->submitted = counters.submitted;
+    stats->sent = counters.sent;
+    stats->preempted = counters.preempted;
+    stats->replaced = counters.replaced;
+    stats->failed = counters.failed;
+    stats->dropped = counters.dropped;
+    stats->queued = queued;
+    stats->queue_peak = counters.queue_peak;
+    stats->latency_avg_us = (counters.sent > 0U) ? (uint32_t)(counters.latency_sum_us / counters.sent) : 0U;
+    stats->latency_max_us = counters.latency_max_us;
+
+    return CAN_TESTBOX_OK;
+}
+
+/**
+ * @brief 获取待发送帧数峰值
+ */
+uint32_t CAN_TxArb_GetDepthPeak(CAN_TestBox_ChannelId_t ch)
+{
+    if (ch >= CAN_TXARB_CH_COUNT) {
+        return 0;
+    }
+
+    return g_contexts[ch].depth_peak;
+}
+
+/**
+ * @brief 不经仲裁直接装入邮箱的模块可用的空闲邮箱数
+ * @note  装入报文会由硬件清除该邮箱的RQCP，邮箱的结束状态尚未被中断处理时
+ *        装入会使仲裁器丢失其持有报文的完成/失败；HAL装入的邮箱(TSR.CODE)
+ *        仍由仲裁器持有时同理。仲裁器有报文排队时为其保留一个邮箱，因为
+ *        仲裁器只能中止自己的报文
+ */
+uint32_t CAN_TxArb_ExternalFreeLevel(CAN_HandleTypeDef *hcan)
+{
+    uint32_t free_level = HAL_CAN_GetTxMailboxesFreeLevel(hcan);
+    CAN_TxArb_Context_t *ctx = CAN_TxArb_FindContext(hcan);
+
+    if (ctx == NULL || free_level == 0U) {
+        return free_level;
+    }
+
+    uint32_t tsr = hcan->Instance->TSR;
+    if ((tsr & CAN_TXARB_RQCP_ALL) != 0U || ctx->mailboxes[(tsr & CAN_TSR_CODE) >> CAN_TSR_CODE_Pos].owned) {
+        return 0;
+    }
+
+    for (uint8_t c = 0; c < CAN_TXARB_CLASS_COUNT; c++) {
+        if (ctx->queues[c].count > 0U) {
+            return free_level - 1U;
+        }
+    }
+
+    return free_level;
+}
+
+/**
+ * @brief 清空统计
+ */
+void CAN_TxArb_ResetStats(CAN_TestBox_ChannelId_t ch)
+{
+    if (ch >= CAN_TXARB_CH_COUNT) {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    memset(g_contexts[ch].counters, 0, sizeof(g_contexts[ch].counters));
+    g_contexts[ch].depth_peak = 0;
+    __set_PRIMASK(primask);
+}
+
+/* ========================= 私有函数实现 ========================= */
+
+/**
+ * @brief 按句柄查找仲裁上下文
+ */
+static CAN_TxArb_Context_t* CAN_TxArb_FindContext(CAN_HandleTypeDef *hcan)
+{
+    for (uint8_t ch = 0; ch < CAN_TXARB_CH_COUNT; ch++) {
+        if (g_contexts[ch].hcan == hcan) {
+            return &g_contexts[ch];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief 总线仲裁顺序键
+ * @note  按线上发送顺序排列仲裁段: 基本ID(11位)、RTR/SRR、IDE、扩展ID低18位、RTR，
+ *        相同基本ID时标准帧优先于扩展帧，数据帧优先于远程帧
+ */
+static uint32_t CAN_TxArb_Key(const CAN_TestBox_Frame_t *frame)
+{
+    uint32_t id = CAN_Frame_GetId(frame);
+    uint32_t rtr = CAN_Frame_IsRemote(frame) ? 1U : 0U;
+
+    if (!CAN_Frame_IsExtended(frame)) {
+        return (id << 21) | (rtr << 20);
+    }
+
+    return ((id >> 18) << 21) | (1UL << 20) | (1UL << 19) | ((id & 0x3FFFFU) << 1) | rtr;
+}
+
+/**
+ * @brief a是否优先于b(先比较分类，再比较仲裁顺序)
+ */
+static bool CAN_TxArb_Outranks(uint8_t class_a, uint32_t key_a, uint8_t class_b, uint32_t key_b)
+{
+    return (class_a < class_b) || (class_a == class_b && key_a < key_b);
+}
+
+/**
+ * @brief 按键插入分类队列
+ * @param requeue: true为被中止后重新排队，排在相同键的报文之前
+ */
+static void CAN_TxArb_Insert(CAN_TxArb_Queue_t *queue, const CAN_TxArb_Entry_t *entry, bool requeue)
+{
+    uint8_t i = queue->count;
+
+    // 降序存放，末尾先发: 把键更小(更优先)的项后移
+    while (i > 0U && (requeue ? (queue->entries[i - 1U].key <= entry->key) : (queue->entries[i - 1U].key < entry->key))) {
+        queue->entries[i] = queue->entries[i - 1U];
+        i--;
+    }
+
+    queue->entries[i] = *entry;
+    queue->count++;
+}
+
+/**
+ * @brief 替换同标签未发出的报文(须在临界区中调用)
+ * @return bool: true表示已替换或已请求中止邮箱待替换，本帧无需再入队
+ */
+static bool CAN_TxArb_Replace(CAN_TxArb_Context_t *ctx, uint8_t tx_class, const CAN_TxArb_Entry_t *entry)
+{
+    CAN_TxArb_Queue_t *queue = &ctx->queues[tx_class];
+
+    // 仍在队列中: 原位覆盖，仲裁键变化时重新排序
+    for (uint8_t i = 0; i < queue->count; i++) {
+        if (queue->entries[i].tag != entry->tag) {
+            continue;
+        }
+        if (queue->entries[i].key == entry->key) {
+            queue->entries[i] = *entry;
+        } else {
+            memmove(&queue->entries[i], &queue->entries[i + 1U], (queue->count - i - 1U) * sizeof(CAN_TxArb_Entry_t));
+            queue->count--;
+            CAN_TxArb_Insert(queue, entry, false);
+        }
+        ctx->counters[tx_class].replaced++;
+        return true;
+    }
+
+    // 已装入邮箱: 请求中止，中止成功时由新实例顶替；已开始发送则中止无效，
+    // 发送完成后新实例正常入队
+    for (uint32_t i = 0; i < CAN_TXARB_MAILBOXES; i++) {
+        CAN_TxArb_Mailbox_t *slot = &ctx->mailboxes[i];
+        if (!slot->owned || slot->tx_class != tx_class || slot->entry.tag != entry->tag) {
+            continue;
+        }
+        if (slot->has_replacement) {
+            // 等待中止期间又到期: 上一个顶替实例也未发出
+            ctx->counters[tx_class].replaced++;
+        }
+        slot->replacement = *entry;
+        slot->has_replacement = true;
+        if ((ctx->aborting & (1UL << i)) == 0U) {
+            ctx->aborting |= (1UL << i);
+            HAL_CAN_AbortTxRequest(ctx->hcan, 1UL << i);
+        }
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief 释放仲裁器持有的邮箱
+ * @param requeue: true表示报文未发送(已中止)，放回队列或由顶替实例取代
+ */
+static void CAN_TxArb_Release(CAN_TxArb_Context_t *ctx, uint32_t index, bool requeue)
+{
+    CAN_TxArb_Mailbox_t *slot = &ctx->mailboxes[index];
+    CAN_TxArb_Queue_t *queue = &ctx->queues[slot->tx_class];
+    CAN_TxArb_Counters_t *counters = &ctx->counters[slot->tx_class];
+
+    slot->owned = false;
+    queue->in_mailbox--;
+
+    // 容量按排队+邮箱计算，放回一定有空位
+    if (slot->has_replacement) {
+        slot->has_replacement = false;
+        if (requeue) {
+            counters->replaced++;
+        }
+        CAN_TxArb_Insert(queue, &slot->replacement, requeue);
+    } else if (requeue) {
+        counters->preempted++;
+        CAN_TxArb_Insert(queue, &slot->entry, true);
+    }
+}
+
+/**
+ * @brief 上报邮箱中报文的结束(须在临界区中、释放邮箱之前调用)
+ */
+static void CAN_TxArb_Confirm(const CAN_TxArb_Context_t *ctx, const CAN_TxArb_Mailbox_t *slot, uint32_t done_us, bool sent)
+{
+    for (uint8_t i = 0; i < CAN_TXARB_CONFIRM_MAX && g_confirm_callbacks[i] != NULL; i++) {
+        g_confirm_callbacks[i]((CAN_TestBox_ChannelId_t)(ctx - g_contexts), slot->tx_class, slot->entry.tag,
+                               &slot->entry.frame, slot->entry.enqueue_us, done_us, sent);
+    }
+}
+
+/**
+ * @brief 按优先级装入空闲邮箱，必要时中止低优先级邮箱(须在临界区中调用)
+ */
+static void CAN_TxArb_Kick(CAN_TxArb_Context_t *ctx)
+{
+    CAN_HandleTypeDef *hcan = ctx->hcan;
+
+    // 有邮箱的结束状态尚未被中断处理时暂不装入，避免该邮箱随后的回调
+    // 对应到新装入的报文；中断处理完成后会再次调用本函数
+    if ((hcan->Instance->TSR & CAN_TXARB_RQCP_ALL) != 0U) {
+        return;
+    }
+
+    for (;;) {
+        uint8_t best = CAN_TXARB_CLASS_COUNT;
+        for (uint8_t c = 0; c < CAN_TXARB_CLASS_COUNT; c++) {
+            if (ctx->queues[c].count > 0U) {
+                best = c;
+                break;
+            }
+        }
+        if (best == CAN_TXARB_CLASS_COUNT) {
+            return;
+        }
+
+        CAN_TxArb_Queue_t *queue = &ctx->queues[best];
+        const CAN_TxArb_Entry_t *entry = &queue->entries[queue->count - 1U];
+
+        if (HAL_CAN_GetTxMailboxesFreeLevel(hcan) == 0U) {
+            // 邮箱已满: 等待中的最优报文优先于仲裁器持有的最差邮箱时中止后者，
+            // 同一时刻只有一个中止请求
+            if (!ctx->preempt || ctx->aborting != 0U) {
+                return;
+            }
+
+            uint32_t worst = CAN_TXARB_MAILBOXES;
+            for (uint32_t i = 0; i < CAN_TXARB_MAILBOXES; i++) {
+                const CAN_TxArb_Mailbox_t *slot = &ctx->mailboxes[i];
+                if (slot->owned && (worst == CAN_TXARB_MAILBOXES ||
+                    CAN_TxArb_Outranks(ctx->mailboxes[worst].tx_class, ctx->mailboxes[worst].entry.key,
+                                       slot->tx_class, slot->entry.key))) {
+                    worst = i;
+                }
+            }
+
+            if (worst < CAN_TXARB_MAILBOXES &&
+                CAN_TxArb_Outranks(best, entry->key, ctx->mailboxes[worst].tx_class, ctx->mailboxes[worst].entry.key)) {
+                ctx->aborting |= (1UL << worst);
+                HAL_CAN_AbortTxRequest(hcan, 1UL << worst);
+            }
+            return;
+        }
+
+        // HAL装入TSR.CODE指示的空邮箱；该邮箱仍由仲裁器持有说明其失败结束尚未经
+        // 错误回调回收(错误回调在本次中断的全部邮箱回调之后)，此时装入会使随后的
+        // 失败判定落到新报文上，等错误回调回收后再装入
+        if (ctx->mailboxes[(hcan->Instance->TSR & CAN_TSR_CODE) >> CAN_TSR_CODE_Pos].owned) {
+            return;
+        }
+
+        CAN_TxHeaderTypeDef header;
+        uint32_t mailbox;
+
+        if (CAN_Frame_IsExtended(&entry->frame)) {
+            header.IDE = CAN_ID_EXT;
+            header.ExtId = CAN_Frame_GetId(&entry->frame);
+            header.StdId = 0;
+        } else {
+            header.IDE = CAN_ID_STD;
+            header.StdId = CAN_Frame_GetId(&entry->frame);
+            header.ExtId = 0;
+        }
+        header.RTR = CAN_Frame_IsRemote(&entry->frame) ? CAN_RTR_REMOTE : CAN_RTR_DATA;
+        header.DLC = CAN_Frame_GetDlc(&entry->frame);
+        header.TransmitGlobalTime = DISABLE;
+
+        if (HAL_CAN_AddTxMessage(hcan, &header, (uint8_t *)CAN_Frame_ConstData(&entry->frame), &mailbox) != HAL_OK) {
+            return;
+        }
+
+        CAN_TxArb_Mailbox_t *slot = &ctx->mailboxes[mailbox >> 1];
+        slot->entry = *entry;
+        slot->tx_class = best;
+        slot->owned = true;
+        slot->has_replacement = false;
+        queue->count--;
+        queue->in_mailbox++;
+    }
+}
+
+/**
+ * @brief 串口命令: 发送仲裁统计/配置
+ */
+static void CAN_TxArb_HandleCtrl(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    CAN_TxArb_ClassStats_t stats;
+
+    if (len < 2U || payload[1] >= CAN_TXARB_CH_COUNT) {
+        CAN_Cmd_SendResult(cmd, (len < 2U) ? CAN_CMD_RESULT_BAD_LENGTH : CAN_CMD_RESULT_BAD_PARAM);
+        return;
+    }
+
+    CAN_TestBox_ChannelId_t ch = (CAN_TestBox_ChannelId_t)payload[1];
+
+    switch (payload[0]) {
+        case CAN_TXARB_CTRL_STATUS:
+            // 应答: 抢占开关(u8)，随后按分类0~3各一组统计
+            CAN_Cmd_ResponseBegin(cmd, (uint16_t)(1U + CAN_TXARB_CLASS_COUNT * sizeof(stats)));
+            {
+                uint8_t preempt = g_contexts[ch].preempt ? 1U : 0U;
+                CAN_Cmd_ResponseWrite(&preempt, 1);
+            }
+            for (uint8_t c = 0; c < CAN_TXARB_CLASS_COUNT; c++) {
+                CAN_TxArb_GetStats(ch, c, &stats);
+                CAN_Cmd_ResponseWrite(&stats, sizeof(stats));
+            }
+            CAN_Cmd_ResponseEnd();
+            break;
+
+        case CAN_TXARB_CTRL_CLEAR:
+            CAN_TxArb_ResetStats(ch);
+            CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_OK);
+            break;
+
+        case CAN_TXARB_CTRL_CONFIG:
+            if (len != 3U) {
+                CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_LENGTH);
+                break;
+            }
+            CAN_TxArb_SetPreemption(ch, payload[2] != 0U);
+            CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_OK);
+            break;
+
+        default:
+            CAN_Cmd_SendResult(cmd, CAN_CMD_RESULT_BAD_PARAM);
+            break;
+    }
+}
@@ -27,6 +27,28 @@
 #include "can_testbox_api.h"  // CAN测试盒专业API
 #include "can_testbox_peps_helper.h"  // PEPS系统CAN测试辅助模块
 #include "can_testbox_peps_filter.h"  // PEPS系统CAN过滤器配置模块
+#include "can_testbox_timestamp.h"  // 硬件微秒时间戳
+#include "can_testbox_gateway.h"  // CAN1<->CAN2网关转发模块
+#include "can_testbox_monitor.h"  // CAN多通道监听与合并模块
+#include "can_testbox_mcp2515.h"  // MCP2515外部CAN通道(中断+DMA)
+#include "can_testbox_cmd.h"  // 串口帧命令通道
+#include "can_testbox_idstats.h"  // 按ID实时统计表
+#include "can_testbox_cyclemon.h"  // 按ID周期监控
+#include "can_testbox_errstats.h"  // 错误帧与错误计数器分析
+#include "can_testbox_format.h"  // 报文日志快速格式化
+#include "can_testbox_mem.h"  // 静态内存规划与内存报告
+#include "can_testbox_event.h"  // 测试盒任务事件通知
+#include "can_testbox_power.h"  // tickless低功耗空闲
+#include "can_testbox_rtstats.h"  // 任务运行时统计
+#include "can_testbox_latency.h"  // 接收链路时延直方图
+#include "can_testbox_seq.h"      // 测试序列虚拟机
+#include "can_testbox_peps_scenario.h"  // PEPS场景状态机
+#include "can_testbox_reqresp.h"  // 请求/应答匹配与往返时延
+#include "can_testbox_rlink.h"    // 双节点可靠链路
+#include "can_testbox_e2e.h"      // 周期报文E2E保护
+#include "can_testbox_gen.h"      // 周期/连续帧负载生成器
+#include "can_testbox_accept.h"   // 片内CAN软件接收过滤
+#include "can_testbox_txarb.h"    // 片内CAN发送优先级仲裁
 #include <stdio.h>
 /* USER CODE END Includes */
 
@@ -54,22 +76,26 @@ extern UART_HandleTypeDef huart2;
 
 /* Definitions for defaultTask */
 osThreadId_t defaultTaskHandle;
+CAN_TESTBOX_STATIC_TASK(defaultTask, CAN_TESTBOX_DEFAULT_TASK_STACK_WORDS);
 const osThreadAttr_t defaultTask_attributes = {
   .name = "defaultTask",
-  .stack_size = 128 * 4,
+  CAN_TESTBOX_STATIC_TASK_MEM(defaultTask),
   .priority = (osPriority_t) osPriorityNormal,
 };
 /* Definitions for CANTestBoxTask */
 osThreadId_t CANTestBoxTaskHandle;
+CAN_TESTBOX_STATIC_TASK(CANTestBoxTask, CAN_TESTBOX_TASK_STACK_WORDS);  // 栈大小见can_testbox_mem.h
 const osThreadAttr_t CANTestBoxTask_attributes = {
   .name = "CANTestBoxTask",
-  .stack_size = 1024 * 4,  // 增加堆栈大小以支持API功能
-  .priority = (osPriority_t) osPriorityNormal,
+  CAN_TESTBOX_STATIC_TASK_MEM(CANTestBoxTask),
+  .priority = (osPriority_t) osPriorityHigh,
 };
 /* Definitions for myQueue01 */
 osMessageQueueId_t myQueue01Handle;
+CAN_TESTBOX_STATIC_QUEUE(myQueue01, 10, 13);
 const osMessageQueueAttr_t myQueue01_attributes = {
-  .name = "myQueue01"
+  .name = "myQueue01",
+  CAN_TESTBOX_STATIC_QUEUE_MEM(myQueue01)
 };
 /* USER CODE BEGIN PV */
 
@@ -125,8 +151,13 @@ int main(void)
   MX_SPI1_Init();
   MX_USART2_UART_Init();
   MX_CAN1_Init();
-  // MX_CAN2_Init();  // 禁用CAN2初始化
+  MX_CAN2_Init();  // CAN2默认静默模式，网关启动时切换为正常模式
   /* USER CODE BEGIN 2 */
+  // 启动硬件微秒时间戳(TIM2)
+  if (CAN_Timestamp_Init() != HAL_OK) {
+    Error_Handler();
+  }
+  
   // 配置PEPS系统CAN过滤器，只接收指定报文
   // 注意：过滤器配置必须在CAN启动前完成
   // 配置PEPS过滤器，但不打印任何信息，避免乱码
@@ -139,12 +170,79 @@ int main(void)
     CAN_TestBox_Enable(true);
     // 不打印就绪信息 (Don't print ready information)
     
+    // 初始化串口帧命令通道，各模块在自身初始化时注册命令
+    CAN_Cmd_Init();
+    
+    // 初始化日志格式化模块(注册格式化基准测试命令)
+    CAN_Format_Init();
+    
+    // 初始化内存报告模块
+    CAN_Mem_Init();
+    
+    // 初始化低功耗模块(tickless空闲默认开启，注册低功耗控制命令)
+    CAN_Power_Init();
+    
+    // 初始化任务运行时统计(注册任务CPU占用与栈水位命令)
+    CAN_RtStats_Init();
+    
+    // 初始化接收链路时延直方图
+    CAN_Latency_Init();
+    
+    // 初始化请求/应答匹配与往返时延统计
+    CAN_ReqResp_Init();
+    
+    // 初始化双节点可靠链路(滑动窗口与重传)
+    CAN_RLink_Init();
+    
+    // 初始化E2E保护(计数器+CRC8)，由上位机按周期报文句柄绑定
+    CAN_E2E_Init();
+    
+    // 初始化负载生成器，由上位机配置生成器组并绑定周期报文
+    CAN_Gen_Init();
+    
+    // 初始化软件接收过滤，默认禁用，由上位机配置接收ID后启用
+    CAN_Accept_Init();
+    
+    // 初始化发送仲裁(分类排队与邮箱抢占)，注册分类时延统计命令
+    CAN_TxArb_Init();
+    
+    // 注册发送确认与周期报文相位命令(发送确认回调在通道打开时已注册)
+    CAN_TestBox_CmdInit();
+    
+    // 初始化按ID统计表
+    CAN_IdStats_Init();
+    
+    // 初始化周期监控，监控项由串口帧命令0x26添加
+    CAN_CycleMon_Init();
+    
+    // 初始化网关模块，路由与启停由串口帧命令0x24配置
+    CAN_Gateway_Init();
+    
+    // 初始化监听模块，各通道抓包与串口输出由串口帧命令0x25启动；
+    // CAN2不在上电时占用，由网关或CAN2监听按命令取得
+    CAN_Monitor_Init();
+    
+    // 打开CAN2测试盒通道，与CAN1共用调度和日志输出；CAN2静默时只接收，发送返回BUSY
+    CAN_TestBox_Channel_t can2_channel;
+    CAN_TestBox_ChannelOpen(CAN_TESTBOX_CH_CAN2, &hcan2, &can2_channel);
+    
+    // 错误帧与错误计数器分析(默认手动恢复总线关闭)
+    CAN_ErrStats_Init();
+    
+    // 初始化MCP2515通道，未连接模块时初始化失败不影响其他功能
+    if (CAN_MCP2515_Init() == CAN_TESTBOX_OK) {
+      CAN_MCP2515_AttachChannel(NULL);
+    }
+    
     // 初始化PEPS辅助模块 (Initialize PEPS helper module)
     status = PEPS_Helper_Init();
     if (status != CAN_TESTBOX_OK) {
       // 不打印初始化成功或失败信息 (Don't print initialization success or failure message)
       // 不阻断程序运行 (Don't block program execution)
     }
+    
+    // 初始化PEPS场景状态机(状态转移由TIM2比较闹钟定时)
+    PEPS_Scenario_Init();
   } else {
     printf("CAN TestBox: Initialization failed (Error: %d)\r\n", status);
     Error_Handler();
@@ -184,6 +282,11 @@ int main(void)
   CANTestBoxTaskHandle = osThreadNew(StartCANTestBoxTask, NULL, &CANTestBoxTask_attributes);
 
   /* USER CODE BEGIN RTOS_THREADS */
+  // 中断、串口命令和周期表变更通过线程标志唤醒测试盒任务
+  CAN_Event_Init(CANTestBoxTaskHandle);
+
+  // 测试序列执行任务(静态分配)，载入Flash中保存的脚本
+  CAN_Seq_Init();
   /* USER CODE END RTOS_THREADS */
 
   /* USER CODE BEGIN RTOS_EVENTS */
@@ -394,14 +497,43 @@ void StartCANTestBoxTask(void *argument)
   /* Infinite loop */
   for(;;)
   {
+    // 执行到期的PEPS场景状态转移，新报文在本轮调度中生效
+    PEPS_Scenario_Process();
+    
     // 调用CAN测试盒主任务 (Call CAN TestBox main task)
     CAN_TestBox_Task();
     
+    // 输出按时间排序的多通道合并报文流(默认关闭)
+    CAN_Monitor_Process();
+    
+    // 推进周期监控时间轮并分发事件
+    CAN_CycleMon_Process();
+    
+    // 错误状态回落检测与总线关闭恢复
+    CAN_ErrStats_Process();
+    
+    // 执行串口帧命令
+    CAN_Cmd_Process();
+    
+    // 上报已结束的测试序列结果
+    CAN_Seq_Process();
+    
+    // 回调已匹配/超时的请求
+    CAN_ReqResp_Process();
+    
+    // 可靠链路超时重传与合并确认
+    CAN_RLink_Process();
+    
     // 不显示统计信息 (Don't display statistics)
     ++task_counter;
     
-    // 任务延时 (Task delay)
-    osDelay(1);
+    // 阻塞到下一个到期时刻或事件通知 (Block until next deadline or event)
+    uint32_t idle_ms = CAN_TestBox_GetIdleTime(CAN_EVENT_IDLE_MAX_MS);
+    idle_ms = CAN_CycleMon_GetIdleTime(idle_ms);
+    idle_ms = CAN_ErrStats_GetIdleTime(idle_ms);
+    idle_ms = CAN_ReqResp_GetIdleTime(idle_ms);
+    idle_ms = CAN_RLink_GetIdleTime(idle_ms);
+    CAN_Event_Wait(idle_ms);
   }
   
   /* USER CODE END StartCANTestBoxTask */
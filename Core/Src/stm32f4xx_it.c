@@ -22,6 +22,10 @@
 #include "stm32f4xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "can_testbox_mcp2515.h"
+#include "can_testbox_rtstats.h"
+#include "can_testbox_latency.h"
+#include "can_testbox_timestamp.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -169,11 +173,11 @@ void DebugMon_Handler(void)
 void CAN1_TX_IRQHandler(void)
 {
   /* USER CODE BEGIN CAN1_TX_IRQn 0 */
-
+  uint32_t isr_start = CAN_RtStats_IsrEnter();
   /* USER CODE END CAN1_TX_IRQn 0 */
   HAL_CAN_IRQHandler(&hcan1);
   /* USER CODE BEGIN CAN1_TX_IRQn 1 */
-
+  CAN_RtStats_IsrExit(isr_start);
   /* USER CODE END CAN1_TX_IRQn 1 */
 }
 
@@ -183,11 +187,13 @@ void CAN1_TX_IRQHandler(void)
 void CAN1_RX0_IRQHandler(void)
 {
   /* USER CODE BEGIN CAN1_RX0_IRQn 0 */
-
+  uint32_t isr_start = CAN_RtStats_IsrEnter();
+  CAN_Latency_IrqEntry(CAN_TESTBOX_CH_CAN1);
   /* USER CODE END CAN1_RX0_IRQn 0 */
   HAL_CAN_IRQHandler(&hcan1);
   /* USER CODE BEGIN CAN1_RX0_IRQn 1 */
-
+  CAN_Latency_IrqExit(CAN_TESTBOX_CH_CAN1);
+  CAN_RtStats_IsrExit(isr_start);
   /* USER CODE END CAN1_RX0_IRQn 1 */
 }
 
@@ -197,11 +203,11 @@ void CAN1_RX0_IRQHandler(void)
 void CAN1_SCE_IRQHandler(void)
 {
   /* USER CODE BEGIN CAN1_SCE_IRQn 0 */
-
+  uint32_t isr_start = CAN_RtStats_IsrEnter();
   /* USER CODE END CAN1_SCE_IRQn 0 */
   HAL_CAN_IRQHandler(&hcan1);
   /* USER CODE BEGIN CAN1_SCE_IRQn 1 */
-
+  CAN_RtStats_IsrExit(isr_start);
   /* USER CODE END CAN1_SCE_IRQn 1 */
 }
 
@@ -211,11 +217,11 @@ void CAN1_SCE_IRQHandler(void)
 void TIM1_UP_TIM10_IRQHandler(void)
 {
   /* USER CODE BEGIN TIM1_UP_TIM10_IRQn 0 */
-
+  uint32_t isr_start = CAN_RtStats_IsrEnter();
   /* USER CODE END TIM1_UP_TIM10_IRQn 0 */
   HAL_TIM_IRQHandler(&htim1);
   /* USER CODE BEGIN TIM1_UP_TIM10_IRQn 1 */
-
+  CAN_RtStats_IsrExit(isr_start);
   /* USER CODE END TIM1_UP_TIM10_IRQn 1 */
 }
 
@@ -225,11 +231,11 @@ void TIM1_UP_TIM10_IRQHandler(void)
 void SPI1_IRQHandler(void)
 {
   /* USER CODE BEGIN SPI1_IRQn 0 */
-
+  uint32_t isr_start = CAN_RtStats_IsrEnter();
   /* USER CODE END SPI1_IRQn 0 */
   HAL_SPI_IRQHandler(&hspi1);
   /* USER CODE BEGIN SPI1_IRQn 1 */
-
+  CAN_RtStats_IsrExit(isr_start);
   /* USER CODE END SPI1_IRQn 1 */
 }
 
@@ -239,11 +245,11 @@ void SPI1_IRQHandler(void)
 void USART2_IRQHandler(void)
 {
   /* USER CODE BEGIN USART2_IRQn 0 */
-
+  uint32_t isr_start = CAN_RtStats_IsrEnter();
   /* USER CODE END USART2_IRQn 0 */
   HAL_UART_IRQHandler(&huart2);
   /* USER CODE BEGIN USART2_IRQn 1 */
-
+  CAN_RtStats_IsrExit(isr_start);
   /* USER CODE END USART2_IRQn 1 */
 }
 
@@ -253,11 +259,11 @@ void USART2_IRQHandler(void)
 void CAN2_TX_IRQHandler(void)
 {
   /* USER CODE BEGIN CAN2_TX_IRQn 0 */
-
+  uint32_t isr_start = CAN_RtStats_IsrEnter();
   /* USER CODE END CAN2_TX_IRQn 0 */
   HAL_CAN_IRQHandler(&hcan2);
   /* USER CODE BEGIN CAN2_TX_IRQn 1 */
-
+  CAN_RtStats_IsrExit(isr_start);
   /* USER CODE END CAN2_TX_IRQn 1 */
 }
 
@@ -267,11 +273,13 @@ void CAN2_TX_IRQHandler(void)
 void CAN2_RX0_IRQHandler(void)
 {
   /* USER CODE BEGIN CAN2_RX0_IRQn 0 */
-
+  uint32_t isr_start = CAN_RtStats_IsrEnter();
+  CAN_Latency_IrqEntry(CAN_TESTBOX_CH_CAN2);
   /* USER CODE END CAN2_RX0_IRQn 0 */
   HAL_CAN_IRQHandler(&hcan2);
   /* USER CODE BEGIN CAN2_RX0_IRQn 1 */
-
+  CAN_Latency_IrqExit(CAN_TESTBOX_CH_CAN2);
+  CAN_RtStats_IsrExit(isr_start);
   /* USER CODE END CAN2_RX0_IRQn 1 */
 }
 
@@ -281,11 +289,11 @@ void CAN2_RX0_IRQHandler(void)
 void CAN2_RX1_IRQHandler(void)
 {
   /* USER CODE BEGIN CAN2_RX1_IRQn 0 */
-
+  uint32_t isr_start = CAN_RtStats_IsrEnter();
   /* USER CODE END CAN2_RX1_IRQn 0 */
   HAL_CAN_IRQHandler(&hcan2);
   /* USER CODE BEGIN CAN2_RX1_IRQn 1 */
-
+  CAN_RtStats_IsrExit(isr_start);
   /* USER CODE END CAN2_RX1_IRQn 1 */
 }
 
@@ -295,14 +303,54 @@ void CAN2_RX1_IRQHandler(void)
 void CAN2_SCE_IRQHandler(void)
 {
   /* USER CODE BEGIN CAN2_SCE_IRQn 0 */
-
+  uint32_t isr_start = CAN_RtStats_IsrEnter();
   /* USER CODE END CAN2_SCE_IRQn 0 */
   HAL_CAN_IRQHandler(&hcan2);
   /* USER CODE BEGIN CAN2_SCE_IRQn 1 */
-
+  CAN_RtStats_IsrExit(isr_start);
   /* USER CODE END CAN2_SCE_IRQn 1 */
 }
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief This function handles DMA2 stream0 global interrupt (SPI1_RX, MCP2515).
+  */
+void DMA2_Stream0_IRQHandler(void)
+{
+  uint32_t isr_start = CAN_RtStats_IsrEnter();
+  HAL_DMA_IRQHandler(&hdma_spi1_rx);
+  CAN_RtStats_IsrExit(isr_start);
+}
+
+/**
+  * @brief This function handles DMA2 stream3 global interrupt (SPI1_TX, MCP2515).
+  */
+void DMA2_Stream3_IRQHandler(void)
+{
+  uint32_t isr_start = CAN_RtStats_IsrEnter();
+  HAL_DMA_IRQHandler(&hdma_spi1_tx);
+  CAN_RtStats_IsrExit(isr_start);
+}
+
+/**
+  * @brief This function handles EXTI line[15:10] interrupts (MCP2515 INT on PB10).
+  */
+void EXTI15_10_IRQHandler(void)
+{
+  uint32_t isr_start = CAN_RtStats_IsrEnter();
+  HAL_GPIO_EXTI_IRQHandler(CAN_MCP2515_INT_PIN);
+  CAN_RtStats_IsrExit(isr_start);
+}
+
+/**
+  * @brief This function handles TIM2 global interrupt (timestamp alarm, CC1).
+  */
+void TIM2_IRQHandler(void)
+{
+  uint32_t isr_start = CAN_RtStats_IsrEnter();
+  CAN_Timestamp_IRQHandler();
+  CAN_RtStats_IsrExit(isr_start);
+}
+
 /* USER CODE END 1 */
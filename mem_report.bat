@@ -0,0 +1,58 @@
+@echo off
+echo ========================================
+echo CAN_BOX Memory Map Report
+echo ========================================
+echo.
+
+REM 切换到项目目录
+cd /d "%~dp0"
+
+REM 默认分析Debug配置的输出，可通过参数指定其他elf
+set ELF=%1
+if "%ELF%"=="" set ELF=Debug\CAN_BOX.elf
+
+if not exist "%ELF%" (
+    echo [ERROR] %ELF% not found
+    echo [INFO] Please build the project first
+    pause
+    exit /b 1
+)
+
+REM 工具链需在PATH中(STM32CubeIDE自带的GNU Tools for STM32)
+where arm-none-eabi-size >nul 2>nul
+if %ERRORLEVEL% NEQ 0 (
+    echo [ERROR] arm-none-eabi-size not found in PATH
+    echo [INFO] Add STM32CubeIDE plugins\...gnu-tools-for-stm32...\tools\bin to PATH
+    pause
+    exit /b 1
+)
+
+echo [SECTIONS] RAM 0x20000000 128K / CCMRAM 0x10000000 64K
+arm-none-eabi-size -A -x "%ELF%" | findstr /R "section \.data \.bss \.rtos_pool \.ccmram \.ccmbss _user_heap_stack"
+echo.
+
+echo [RTOS POOL] static tasks and queues (.rtos_pool)
+arm-none-eabi-objdump -t "%ELF%" | findstr /C:" .rtos_pool"
+echo.
+
+echo [CCM] large statistics buffers (.ccmbss)
+arm-none-eabi-objdump -t "%ELF%" | findstr /C:" .ccmbss"
+echo.
+
+echo [TOP 20 .bss]
+arm-none-eabi-nm -S --size-sort -r "%ELF%" | findstr /R "^[0-9a-f]* [0-9a-f]* [bB] " > "%TEMP%\can_box_bss.txt"
+set /a N=0
+for /f "usebackq delims=" %%L in ("%TEMP%\can_box_bss.txt") do (
+    set /a N+=1
+    call :print_top "%%L"
+)
+del "%TEMP%\can_box_bss.txt" >nul 2>nul
+
+echo.
+echo ========================================
+pause
+exit /b 0
+
+:print_top
+if %N% LEQ 20 echo %~1
+exit /b 0